@@ -26,6 +26,7 @@
 #include "gpib_task.h"
 #include "amigo.h"
 #include "debug.h"
+#include "evlog.h"
 
 #ifdef AMIGO
 
@@ -231,8 +232,7 @@ int amigo_request_status()
 {
 /// @todo  dsj
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO request status]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_REQUEST_STATUS, 0, 0, 0);
 #endif
     AMIGOs->status[0] = 0x00;                     // Status 1
 ///TODO we do NOT support multiple units yet
@@ -288,8 +288,7 @@ int amigo_send_logical_address()
     UINT len;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO send logical address]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_SEND_LOGICAL_ADDRESS, 0, 0, 0);
 #endif
     status = EOI_FLAG;
     len = gpib_write_str(AMIGOs->logical_address,4,&status);
@@ -299,7 +298,7 @@ int amigo_send_logical_address()
         AMIGOs->Errors |= ERR_GPIB;
         AMIGOs->dsj = 1;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB write error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB write error]\n");
     }
     gpib_enable_PPR(AMIGOp->HEADER.PPR);
     return(status & ERROR_MASK);
@@ -320,8 +319,7 @@ int amigo_send_status()
     UINT len;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO send status]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_SEND_STATUS, 0, 0, 0);
 #endif
     status = EOI_FLAG;
     len = gpib_write_str(AMIGOs->status,4,&status);
@@ -330,7 +328,7 @@ int amigo_send_status()
         AMIGOs->Errors |= ERR_GPIB;
         AMIGOs->dsj = 1;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB write error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB write error]\n");
     }
     else
     {
@@ -359,7 +357,7 @@ static DWORD amigo_chs_to_logical(AMIGOStateType *p, char *msg)
 
 #if SDEBUG
     if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO %s, P:%08lxH, U:%d C:%d H:%d S:%d]\n",
+        EVLOG_PRINTF("[AMIGO %s, P:%08lxH, U:%d C:%d H:%d S:%d]\n",
             msg, pos, AMIGOs->unitNO, p->cyl, p->head, p->sector);
 #endif
     return(pos);
@@ -387,7 +385,7 @@ static int amigo_overflow_check(AMIGOStateType *p, char *msg)
             {
                 stat = 1;
                 if(debuglevel & GPIB_ERR && msg != NULL)
-                    printf("[AMIGO %s pos OVERFLOW]\n", msg);
+                    EVLOG_PRINTF("[AMIGO %s pos OVERFLOW]\n", msg);
             }
         }
     }
@@ -466,8 +464,7 @@ int amigo_verify(uint16_t sectors)
     pos = amigo_chs_to_logical(AMIGOs, "Verify Start");
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO verify P:%08lXH, sectors:%04XH]\n", pos, sectors);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_VERIFY_P_SECTORS, pos, sectors, 0);
 #endif
 
     while(sectors--)
@@ -480,7 +477,7 @@ int amigo_verify(uint16_t sectors)
 #endif
 
         // dbf_open_read sets error conditions like ERROR_READ, etc
-        len = dbf_open_read(AMIGOp->HEADER.NAME, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
+        len = dbf_open_read(AMIGOp->HEADER.NAME, &AMIGOp->HEADER.FORMAT, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
 
 #if SDEBUG
         if(debuglevel & GPIB_DISK_IO_TIMING)
@@ -525,8 +522,7 @@ int amigo_format(uint8_t db)
     memset((void *) gpib_iobuff, db, AMIGOp->GEOMETRY.BYTES_PER_SECTOR);
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO format]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_FORMAT, 0, 0, 0);
     if(debuglevel & GPIB_DISK_IO_TIMING)
         gpib_timer_elapsed_begin();
 #endif
@@ -535,7 +531,7 @@ int amigo_format(uint8_t db)
 ///@brief computer logical block
         pos = amigo_chs_to_logical(AMIGOs, "Format");
 
-        len = dbf_open_write(AMIGOp->HEADER.NAME,
+        len = dbf_open_write(AMIGOp->HEADER.NAME, &AMIGOp->HEADER.FORMAT,
             pos, gpib_iobuff,AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
 
         if(AMIGOs->Errors || len != AMIGOp->GEOMETRY.BYTES_PER_SECTOR)
@@ -562,8 +558,7 @@ int amigo_format(uint8_t db)
 #if SDEBUG
     if(debuglevel & GPIB_DISK_IO_TIMING)
         gpib_timer_elapsed_end("Format");
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Format Done]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_FORMAT_DONE, 0, 0, 0);
 #endif
     gpib_enable_PPR(AMIGOp->HEADER.PPR);
     return(stat);
@@ -586,13 +581,12 @@ int amigo_buffered_read()
 //READ SECTOR
     pos = amigo_chs_to_logical(AMIGOs, "Buffered Read");
 #if SDEBUG
-	if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-		printf("AMIGOs->state:%d\n", AMIGOs->state);
+	EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_STATE, AMIGOs->state, 0, 0);
     if(debuglevel & GPIB_DISK_IO_TIMING)
         gpib_timer_elapsed_begin();
 #endif
 
-    len = dbf_open_read(AMIGOp->HEADER.NAME, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
+    len = dbf_open_read(AMIGOp->HEADER.NAME, &AMIGOp->HEADER.FORMAT, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
 
 #if SDEBUG
     if(debuglevel & GPIB_DISK_IO_TIMING)
@@ -603,7 +597,7 @@ int amigo_buffered_read()
         // Any AMIGOs->Errors errors were set in the dbf_pen_read() call
         AMIGOs->dsj = 1;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB disk read error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB disk read error]\n");
         gpib_enable_PPR(AMIGOp->HEADER.PPR);
         return(0);
     }
@@ -625,7 +619,7 @@ int amigo_buffered_read()
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB bus write error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB bus write error]\n");
         gpib_enable_PPR(AMIGOp->HEADER.PPR);
         return(status & ERROR_MASK);
     }
@@ -659,13 +653,12 @@ int amigo_buffered_read_command()
 //READ SECTOR
     pos = amigo_chs_to_logical(AMIGOs, "Buffered Read");
 #if SDEBUG
-	if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-		printf("AMIGOs->state:%d\n", AMIGOs->state);
+	EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_STATE, AMIGOs->state, 0, 0);
     if(debuglevel & GPIB_DISK_IO_TIMING)
         gpib_timer_elapsed_begin();
 #endif
 
-    len = dbf_open_read(AMIGOp->HEADER.NAME, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
+    len = dbf_open_read(AMIGOp->HEADER.NAME, &AMIGOp->HEADER.FORMAT, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
 
 #if SDEBUG
     if(debuglevel & GPIB_DISK_IO_TIMING)
@@ -721,7 +714,7 @@ int amigo_buffered_read_execute()
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB write error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB write error]\n");
     }
 
     gpib_enable_PPR(AMIGOp->HEADER.PPR);
@@ -753,8 +746,7 @@ int amigo_buffered_write()
 
 
 #if SDEBUG
-	if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-		printf("AMIGOs->state:%d\n", AMIGOs->state);
+	EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_STATE, AMIGOs->state, 0, 0);
     if(debuglevel & GPIB_RW_STR_TIMING)
         gpib_timer_elapsed_end("GPIB read");
 #endif
@@ -764,7 +756,7 @@ int amigo_buffered_write()
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO Write GPIB read error]\n");
+            EVLOG_PRINTF("[AMIGO Write GPIB read error]\n");
         gpib_enable_PPR(AMIGOp->HEADER.PPR);
         return(status & ERROR_MASK);
     }
@@ -774,7 +766,7 @@ int amigo_buffered_write()
         gpib_timer_elapsed_begin();
 #endif
 
-    len = dbf_open_write(AMIGOp->HEADER.NAME, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
+    len = dbf_open_write(AMIGOp->HEADER.NAME, &AMIGOp->HEADER.FORMAT, pos, gpib_iobuff, AMIGOp->GEOMETRY.BYTES_PER_SECTOR, &AMIGOs->Errors);
 
 #if SDEBUG
     if(debuglevel & GPIB_DISK_IO_TIMING)
@@ -785,7 +777,7 @@ int amigo_buffered_write()
     {
         AMIGOs->dsj = 1;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO Write disk write error]\n");
+            EVLOG_PRINTF("[AMIGO Write disk write error]\n");
         gpib_enable_PPR(AMIGOp->HEADER.PPR);
         return(0);
     }
@@ -824,14 +816,13 @@ int amigo_cmd_dsj()
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AIMGO: DSJ send failed]\n");
+            EVLOG_PRINTF("[AIMGO: DSJ send failed]\n");
         return(status & ERROR_MASK);
     }
     else
     {
 #if SDEBUG
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[DSJ %02XH]\n", AMIGOs->dsj);
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_DSJ, AMIGOs->dsj, 0, 0);
 #endif
     }
     AMIGOs->dsj = 0;
@@ -854,8 +845,7 @@ int amigo_cmd_wakeup()
     UINT len;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Wakeup]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_WAKEUP, 0, 0, 0);
 #endif
     tmp[0] = AMIGOs->dsj;
     len = gpib_write_str(tmp, 1, &status);
@@ -864,7 +854,7 @@ int amigo_cmd_wakeup()
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO GPIB write error]\n");
+            EVLOG_PRINTF("[AMIGO GPIB write error]\n");
     }
 /// @todo FIXME
     gpib_enable_PPR(AMIGOp->HEADER.PPR);
@@ -882,8 +872,7 @@ int amigo_cmd_wakeup()
 int amigo_cmd_clear()
 {
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Clear]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_CLEAR, 0, 0, 0);
 #endif
     AMIGOs->sector = 0;
     AMIGOs->head = 0;
@@ -991,9 +980,7 @@ int Amigo_Command( int secondary )
     UINT len;                                     // Size of Data/Op Codes/Parameters read in bytes
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Command(%02XH): listen:%02XH, talk:%02XH]\n",
-            secondary, listening, talking);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_COMMAND_LISTEN_TALK, secondary, listening, talking);
 #endif
 
 ///  Reference: A14
@@ -1008,7 +995,7 @@ int Amigo_Command( int secondary )
             AMIGOs->dsj = 1;
             AMIGOs->Errors |= ERR_GPIB;
             if(debuglevel & GPIB_ERR)
-                printf("[AMIGO_Command:GPIB write error]\n");
+                EVLOG_PRINTF("[AMIGO_Command:GPIB write error]\n");
         }
         return(status & ERROR_MASK);
     }
@@ -1033,7 +1020,7 @@ int Amigo_Command( int secondary )
             AMIGOs->dsj = 1;
             AMIGOs->Errors |= ERR_GPIB;
             if(debuglevel & GPIB_ERR)
-                printf("[AMIGO Command:GPIB read error]\n");
+                EVLOG_PRINTF("[AMIGO Command:GPIB read error]\n");
         }
         return(status & ERROR_MASK);
     }
@@ -1053,13 +1040,11 @@ int Amigo_Command( int secondary )
         AMIGOs->dsj = 1;
         AMIGOs->Errors |= ERR_GPIB;
         if(debuglevel & GPIB_ERR)
-            printf("[AMIGO Command:GPIB read error]\n");
+            EVLOG_PRINTF("[AMIGO Command:GPIB read error]\n");
         return(status & ERROR_MASK);
     }
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Command(%02XH): GPIB read bytes:%02XH]\n",
-            secondary, len);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_COMMAND_GPIB_READ_BYTES, secondary, len, 0);
 #endif
     if(!len)
     {
@@ -1079,8 +1064,7 @@ int Amigo_Command( int secondary )
 
             AMIGOStateType tmp;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Cold Load Read Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_COLD_LOAD_READ_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do NOT support multiple units yet
             AMIGOs->unitNO = 0;
@@ -1105,8 +1089,7 @@ int Amigo_Command( int secondary )
 
             AMIGOStateType tmp;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Seek len=5]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_SEEK_LEN_5, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1129,8 +1112,7 @@ int Amigo_Command( int secondary )
 
             AMIGOStateType tmp;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Seek len=6]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_SEEK_LEN_6, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1149,8 +1131,7 @@ int Amigo_Command( int secondary )
         {
 ///  Reference: A15
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Request Status Buffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_REQUEST_STATUS_BUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1163,8 +1144,7 @@ int Amigo_Command( int secondary )
         {
 ///  Reference: A35
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Read Unbuffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_READ_UNBUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1182,8 +1162,7 @@ int Amigo_Command( int secondary )
         {
             uint16_t sectors;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Verify]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_VERIFY, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1195,8 +1174,7 @@ int Amigo_Command( int secondary )
         else if(op == 0x08 && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Write Unbuffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_WRITE_UNBUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1208,8 +1186,7 @@ int Amigo_Command( int secondary )
         else if((op == 0x0B || op == 0x2b) && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Initialize Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_INITIALIZE_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1221,8 +1198,7 @@ int Amigo_Command( int secondary )
         else if(op == 0x14 && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Request Logical Address Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_REQUEST_LOGICAL_ADDRESS_COMMAND, 0, 0, 0);
 #endif
             amigo_request_logical_address();
             AMIGOs->state = AMIGO_REQUEST_LOGICAL_ADDRESS;
@@ -1235,8 +1211,7 @@ int Amigo_Command( int secondary )
         if(op == 0x08 && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Write Buffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_WRITE_BUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1251,8 +1226,7 @@ int Amigo_Command( int secondary )
         if(op == 0x03 && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Request Status Unbuffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_REQUEST_STATUS_UNBUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1264,8 +1238,7 @@ int Amigo_Command( int secondary )
         if(op == 0x05 && len == 2)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Read Buffered Command]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_READ_BUFFERED_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1288,8 +1261,7 @@ int Amigo_Command( int secondary )
 
             uint8_t db;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[AMIGO Format]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_FORMAT_COMMAND, 0, 0, 0);
 #endif
 ///TODO we do not support multiple units yet
 ///FIXME Added unit error
@@ -1322,9 +1294,7 @@ int Amigo_Command( int secondary )
 int Amigo_Execute( int secondary )
 {
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[AMIGO Execute(%02XH): listen:%02XH, talk:%02XH]\n",
-            secondary, listening, talking);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_LISTEN_TALK, secondary, listening, talking);
 #endif
 
     if(talking == UNT)
@@ -1346,38 +1316,32 @@ int Amigo_Execute( int secondary )
                 return(0);
             case AMIGO_COLD_LOAD_READ:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Cold Load Read]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_COLD_LOAD_READ, 0, 0, 0);
 #endif
                 return ( amigo_buffered_read_execute() );
             case AMIGO_READ_UNBUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Read Unbuffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_READ_UNBUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_buffered_read_execute() );
             case AMIGO_READ_BUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Read Buffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_READ_BUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_buffered_read_execute() );
             case AMIGO_WRITE_UNBUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Write Unbuffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_WRITE_UNBUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_buffered_write() );
             case AMIGO_INITIALIZE:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Initialize]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_INITIALIZE, 0, 0, 0);
 #endif
                 return ( amigo_buffered_write() );
             case AMIGO_WRITE_BUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Write Buffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_WRITE_BUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_buffered_write() );
             default:
@@ -1393,20 +1357,17 @@ int Amigo_Execute( int secondary )
                 return(0);
             case AMIGO_REQUEST_STATUS_BUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Request Status Buffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_REQUEST_STATUS_BUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_send_status() );
             case AMIGO_REQUEST_STATUS_UNBUFFERED:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Exicute Request Status Unbuffered]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_REQUEST_STATUS_UNBUFFERED, 0, 0, 0);
 #endif
                 return ( amigo_send_status() );
             case AMIGO_REQUEST_LOGICAL_ADDRESS:
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[AMIGO Execute Request Logical Address]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_AMIGO_EXECUTE_REQUEST_LOGICAL_ADDRESS, 0, 0, 0);
 #endif
                 return ( amigo_send_logical_address() );
             default:
@@ -20,6 +20,7 @@
 #include "ss80.h"
 #include <time.h>
 #include "lifutils.h"
+#include "sparse.h"
 #include "debug.h"
 
 extern hpdir_t hpdir;
@@ -33,6 +34,7 @@ DeviceType Devices[MAX_DEVICES];
 
 ///@brief Active Printer Device
 PRINTERDeviceType *PRINTERp = NULL;
+PRINTERStateType *PRINTERs = NULL;
 
 ///@brief Active SS80 Device
 SS80DiskType *SS80p = NULL;
@@ -772,6 +774,335 @@ int Read_Config(char *name)
 }
 
 
+/// ===============================================
+/// @brief Configuration snapshot
+///
+/// Parsing hpdisk.cfg at power up reads the file one byte at a time and
+/// looks up every drive model in hpdir.ini. After a clean parse the
+/// resulting Devices[] table is saved as a binary snapshot next to the
+/// config file, hpdisk.snp for hpdisk.cfg, and later boots load that
+/// instead while hpdisk.cfg and hpdir.ini are unchanged.
+///
+///   ConfigSnapshotType header, see drives.h
+///   For each device
+///     TYPE, ADDRESS, PPR        1 byte each
+///     BLOCKS                    4 bytes
+///     Device structure          sizeof() the structure for TYPE
+///     HEADER.NAME, HEADER.model 1 byte length then the string, 0 = NULL
+///
+/// The snapshot holds raw firmware structures so it is only accepted by
+/// the firmware build that wrote it, see snapshot_layout()
+
+///@brief Running checksum of the snapshot device records
+static uint16_t snapshot_sum;
+
+/// @brief Add bytes to the snapshot checksum
+/// @param[in] buf: data
+/// @param[in] size: data size
+/// @return  void
+static void snapshot_update(uint8_t *buf, int size)
+{
+    while(size--)
+        snapshot_sum = ((snapshot_sum << 1) | (snapshot_sum >> 15)) + *buf++;
+}
+
+
+/// @brief Write bytes to the snapshot and update the checksum
+/// @return  1 on success, 0 on error
+static int snapshot_write(FILE *fp, void *buf, int size)
+{
+    snapshot_update((uint8_t *) buf, size);
+    return(fwrite(buf, 1, size, fp) == (size_t) size);
+}
+
+
+/// @brief Read bytes from the snapshot and update the checksum
+/// @return  1 on success, 0 on error
+static int snapshot_read(FILE *fp, void *buf, int size)
+{
+    if(fread(buf, 1, size, fp) != (size_t) size)
+        return(0);
+    snapshot_update((uint8_t *) buf, size);
+    return(1);
+}
+
+
+/// @brief Write a string to the snapshot, NULL is saved as length 0
+/// @return  1 on success, 0 on error
+static int snapshot_write_str(FILE *fp, char *str)
+{
+    uint8_t len = 0;
+
+    if(str != NULL)
+        len = strnlen(str, 255);
+    if(!snapshot_write(fp, &len, 1))
+        return(0);
+    return(len ? snapshot_write(fp, str, len) : 1);
+}
+
+
+/// @brief Read a string from the snapshot
+/// @param[out] *str: allocated string or NULL
+/// @return  1 on success, 0 on error
+static int snapshot_read_str(FILE *fp, char **str)
+{
+    uint8_t len;
+
+    *str = NULL;
+    if(!snapshot_read(fp, &len, 1))
+        return(0);
+    if(!len)
+        return(1);
+    *str = safecalloc(len+1, 1);
+    if(*str == NULL)
+        return(0);
+    return(snapshot_read(fp, *str, len));
+}
+
+
+/// @brief Size of the device structure saved for a device type
+/// @return  size or 0 if the type can not be saved
+static uint16_t snapshot_dev_size(uint8_t type)
+{
+    if(type == SS80_TYPE || type == SS80_DEFAULT_TYPE)
+        return(sizeof(SS80DiskType));
+#ifdef AMIGO
+    if(type == AMIGO_TYPE)
+        return(sizeof(AMIGODiskType));
+#endif
+    if(type == PRINTER_TYPE)
+        return(sizeof(PRINTERDeviceType));
+    return(0);
+}
+
+
+/// @brief Identify the firmware build and structure layout
+/// @return  layout value
+static uint16_t snapshot_layout()
+{
+    uint16_t size;
+
+    snapshot_sum = sizeof(ConfigSnapshotType);
+    size = sizeof(SS80DiskType);
+    snapshot_update((uint8_t *) &size, 2);
+#ifdef AMIGO
+    size = sizeof(AMIGODiskType);
+    snapshot_update((uint8_t *) &size, 2);
+#endif
+    size = sizeof(PRINTERDeviceType);
+    snapshot_update((uint8_t *) &size, 2);
+#ifdef LOCAL_MOD
+    snapshot_update((uint8_t *) LOCAL_MOD, strlen(LOCAL_MOD));
+#endif
+    return(snapshot_sum);
+}
+
+
+/// @brief Snapshot file name for a config file, /hpdisk.cfg -> /hpdisk.snp
+/// @param[in] name: config file name
+/// @param[out] snapshot: snapshot file name
+/// @param[in] size: size of snapshot
+/// @return  void
+void Config_Snapshot_Name(char *name, char *snapshot, int size)
+{
+    char *ptr;
+
+    strncpy(snapshot, name, size-5);
+    snapshot[size-5] = 0;
+    ptr = strrchr(snapshot, '.');
+    if(ptr != NULL && strchr(ptr, '/') == NULL)
+        *ptr = 0;
+    strcat(snapshot, ".snp");
+}
+
+
+/// @brief Build the snapshot header that matches the current files
+/// @param[in] name: config file name
+/// @param[out] *K: header with the file sizes, times and layout filled in
+/// @return  1 on success, 0 if the config file is missing
+int Config_Snapshot_Key(char *name, ConfigSnapshotType *K)
+{
+    struct stat st;
+
+    memset(K, 0, sizeof(ConfigSnapshotType));
+    memcpy(K->magic, CONFIG_SNAPSHOT_MAGIC, 8);
+    K->version = CONFIG_SNAPSHOT_VERSION;
+    K->layout = snapshot_layout();
+
+    if(stat(name, &st) != 0)
+        return(0);
+    K->cfg_size = st.st_size;
+    K->cfg_mtime = st.st_mtime;
+
+// Drive parameters come from hpdir.ini so it is part of the key
+    if(stat("/hpdir.ini", &st) == 0)
+    {
+        K->hpdir_size = st.st_size;
+        K->hpdir_mtime = st.st_mtime;
+    }
+    return(1);
+}
+
+
+/// ===============================================
+/// @brief Save the Devices[] table read from a config file
+/// Only call after Read_Config() succeeds without errors
+/// @param name: config file name
+/// @return  1 on success, 0 on error
+int Save_Config_Snapshot(char *name)
+{
+    ConfigSnapshotType H;
+    HeaderType *hp;
+    char snapshot[32];
+    FILE *fp;
+    int8_t i;
+    uint8_t b;
+    int ok = 1;
+
+    if(!Config_Snapshot_Key(name, &H))
+        return(0);
+    H.debuglevel = debuglevel;
+
+    for(i=0;i<MAX_DEVICES;++i)
+    {
+        if(Devices[i].TYPE == NO_TYPE)
+            continue;
+        if(!snapshot_dev_size(Devices[i].TYPE) || Devices[i].dev == NULL)
+            return(0);
+        H.devices++;
+    }
+
+    Config_Snapshot_Name(name, snapshot, sizeof(snapshot));
+    fp = fopen(snapshot, "wb");
+    if(fp == NULL)
+        return(0);
+
+// Header is written again once the checksum is known
+    ok = (fwrite(&H, 1, sizeof(H), fp) == sizeof(H));
+    snapshot_sum = 0;
+    for(i=0;ok && i<MAX_DEVICES;++i)
+    {
+        if(Devices[i].TYPE == NO_TYPE)
+            continue;
+        b = Devices[i].TYPE;
+        ok &= snapshot_write(fp, &b, 1);
+        ok &= snapshot_write(fp, &Devices[i].ADDRESS, 1);
+        ok &= snapshot_write(fp, &Devices[i].PPR, 1);
+        ok &= snapshot_write(fp, &Devices[i].BLOCKS, 4);
+        ok &= snapshot_write(fp, Devices[i].dev, snapshot_dev_size(b));
+        hp = (HeaderType *) Devices[i].dev;
+        ok &= snapshot_write_str(fp, hp->NAME);
+        ok &= snapshot_write_str(fp, hp->model);
+    }
+    H.sum = snapshot_sum;
+    if(ok)
+    {
+        fseek(fp, 0, SEEK_SET);
+        ok = (fwrite(&H, 1, sizeof(H), fp) == sizeof(H));
+    }
+    if(fclose(fp) == EOF)
+        ok = 0;
+    if(!ok)
+    {
+        unlink(snapshot);
+        printf("Save_Config_Snapshot: %s write failed\n", snapshot);
+        return(0);
+    }
+    printf("Saved configuration snapshot: %s\n", snapshot);
+    return(1);
+}
+
+
+/// ===============================================
+/// @brief Load the Devices[] table from a snapshot instead of parsing the config file
+/// The snapshot is only used if hpdisk.cfg and hpdir.ini have not changed
+/// @param name: config file name
+/// @return  1 on success, 0 if the config file must be parsed
+int Load_Config_Snapshot(char *name)
+{
+    ConfigSnapshotType H, K;
+    HeaderType *hp;
+    char snapshot[32];
+    FILE *fp;
+    int8_t index;
+    uint8_t i, type;
+    uint16_t size;
+    DeviceType D;
+    int ok;
+
+    if(!Config_Snapshot_Key(name, &K))
+        return(0);
+
+    Config_Snapshot_Name(name, snapshot, sizeof(snapshot));
+    fp = fopen(snapshot, "rb");
+    if(fp == NULL)
+        return(0);
+
+    ok = (fread(&H, 1, sizeof(H), fp) == sizeof(H));
+    if(ok)
+    {
+        K.debuglevel = H.debuglevel;
+        K.devices = H.devices;
+        K.sum = H.sum;
+        ok = (memcmp(&H, &K, sizeof(H)) == 0 && H.devices <= MAX_DEVICES);
+    }
+    if(!ok)
+    {
+        fclose(fp);
+        printf("Configuration snapshot %s is out of date\n", snapshot);
+        return(0);
+    }
+
+    init_Devices();
+    snapshot_sum = 0;
+    for(i=0;ok && i<H.devices;++i)
+    {
+        ok = snapshot_read(fp, &type, 1)
+            && snapshot_read(fp, &D.ADDRESS, 1)
+            && snapshot_read(fp, &D.PPR, 1)
+            && snapshot_read(fp, &D.BLOCKS, 4);
+        size = snapshot_dev_size(type);
+        if(!ok || !size)
+        {
+            ok = 0;
+            break;
+        }
+        index = alloc_device(type);
+        if(index == -1)
+        {
+            ok = 0;
+            break;
+        }
+        Devices[index].ADDRESS = D.ADDRESS;
+        Devices[index].PPR = D.PPR;
+        Devices[index].BLOCKS = D.BLOCKS;
+        ok = snapshot_read(fp, Devices[index].dev, size);
+// The saved pointers are not valid, free_device() must never see them
+        hp = (HeaderType *) Devices[index].dev;
+        hp->NAME = NULL;
+        hp->model = NULL;
+// The image may have been replaced since, format_drives() checks it again
+        hp->FORMAT = DBF_UNKNOWN;
+        if(ok)
+            ok = snapshot_read_str(fp, &hp->NAME) && snapshot_read_str(fp, &hp->model);
+    }
+    fclose(fp);
+
+    if(!ok || snapshot_sum != H.sum)
+    {
+        for(i=0;i<MAX_DEVICES;++i)
+            free_device(i);
+        init_Devices();
+        printf("Configuration snapshot %s is damaged\n", snapshot);
+        return(0);
+    }
+
+    debuglevel = H.debuglevel;
+    printf("Loaded configuration snapshot: %s, %d devices\n", snapshot, (int) H.devices);
+    return(1);
+}
+
+
 /// ===============================================
 /// @brief Display Configuration device address saummary
 /// @return  void
@@ -1136,6 +1467,7 @@ int8_t set_active_device(int8_t index)
     if(type == PRINTER_TYPE)
     {
         PRINTERp = (PRINTERDeviceType *) Devices[index].dev;
+        PRINTERs = (PRINTERStateType *) Devices[index].state;
         return(1);
     }
 
@@ -1220,7 +1552,7 @@ void SS80_Set_Defaults(int8_t index)
 void free_device(int8_t index)
 {
 	
-	extern void printer_close(void);
+	extern void printer_close(PRINTERStateType *P);
 
 	if(index < 0 || index >= MAX_DEVICES)
 		return;
@@ -1229,6 +1561,7 @@ void free_device(int8_t index)
     {
         SS80DiskType *SS80p = (SS80DiskType *) Devices[index].dev;
 		// Device Model Name
+		dbf_forget(SS80p->HEADER.NAME);
 		safefree(SS80p->HEADER.NAME);
 		// File
 		safefree(SS80p->HEADER.model);
@@ -1239,16 +1572,16 @@ void free_device(int8_t index)
     {
         AMIGODiskType *AMIGOp = (AMIGODiskType *) Devices[index].dev;
 		// Device Model Name
+		dbf_forget(AMIGOp->HEADER.NAME);
 		safefree(AMIGOp->HEADER.NAME);
 		// File
 		safefree(AMIGOp->HEADER.model);
 	}
 #endif
 
-	// FIXME use printer structure to permit multiple printers
     if(Devices[index].TYPE == PRINTER_TYPE)
     {
-		printer_close();
+		printer_close((PRINTERStateType *) Devices[index].state);
 	}
 
 	safefree(Devices[index].dev);
@@ -1307,7 +1640,7 @@ int8_t alloc_device(int type)
         case PRINTER_TYPE:
             Devices[ind].TYPE = type;
             Devices[ind].dev = safecalloc(sizeof(PRINTERDeviceType)+7,1);
-            Devices[ind].state = NULL;
+            Devices[ind].state = safecalloc(sizeof(PRINTERStateType)+7,1);
             index = ind;
             break;
         default:
@@ -1478,7 +1811,7 @@ void set_Config_Defaults()
             Devices[index].ADDRESS = PRINTERDeviceDefault.HEADER.ADDRESS;
             Devices[index].PPR = 0xff;
             Devices[index].dev = (void *) &PRINTERDeviceDefault;
-            Devices[index].state = NULL;
+            Devices[index].state = safecalloc(sizeof(PRINTERStateType)+7,1);
         }
     }
 #endif                                        // SET_DEFAULTS
@@ -1710,7 +2043,7 @@ void format_drives()
                 lif_create_image(SS80p->HEADER.NAME,
                     label,
                     lif_dir_count(sectors),
-                    sectors);
+                    sectors, 0);
 #else
                 printf("please create a SS80 LIF image with %ld sectors and 128 directory sectors\n", sectors);
 #endif
@@ -1718,6 +2051,7 @@ void format_drives()
                 ++ss80;
 
             }
+            SS80p->HEADER.FORMAT = dbf_format(SS80p->HEADER.NAME);
         }                                         // SS80_TYPE
 
 #ifdef AMIGO
@@ -1738,13 +2072,14 @@ void format_drives()
                 lif_create_image(AMIGOp->HEADER.NAME,
                     label,
                     lif_dir_count(sectors),
-                    sectors);
+                    sectors, 0);
 #else
                 printf("please create a AMIGO LIF image with %ld sectors and 15 directory sectors\n", sectors);
 #endif
                 ++count;
                 ++amigo;
             }
+            AMIGOp->HEADER.FORMAT = dbf_format(AMIGOp->HEADER.NAME);
         }
 #endif                                    // #ifdef AMIGO
     }
@@ -1772,10 +2107,17 @@ void drives_help(int8_t full)
 		"     Example: mount 9121  6 /amigo6.lif\n"
 		"     Example: mount 9134D 2 /amigo2.lif\n"
 		"     Note: drive model must exist in hpdir.ini [driveinfo] section\n"
+		"mount AMIGO|SS80 model address overlayfile basefile\n"
+		"     Example: mount 9134D 2 /station2.lif /master.lif\n"
+		"     Writes go to a copy on write overlay, the base file is only read\n"
+		"     The overlay is created when it does not exist\n"
+		"     An existing overlayfile must be an overlay of basefile\n"
 		"mount PRINTER address\n"
 		"     Example: mount PRINTER 5\n"
-		"umount address\n"
+		"umount address [commit|discard]\n"
 		"     Example: umount 6\n"
+		"     commit writes overlay changes into the base file\n"
+		"     discard throws overlay changes away\n"
 		"\n"
 		"addresses\n"
 		"   Display all device GPIB bus addresses and PPR values\n"
@@ -1924,12 +2266,14 @@ int8_t umount(int argc, char *argv[])
 
 	int8_t address;
 	int8_t index;
+	char *name = NULL;
 
-	if(argc != 2)
+	if(argc != 2 && argc != 3)
 	{
 		printf("Usage:\n");
-		printf("  umount address\n");
+		printf("  umount address [commit|discard]\n");
 		printf("  - address is the device address\n");
+		return(-1);
 	}
 	address = atoi(argv[1]);
 	index = index_address(address);
@@ -1938,6 +2282,37 @@ int8_t umount(int argc, char *argv[])
 		printf("umount address:[%d] NOT found\n", address);
 		return(-1);
 	}
+
+	if(Devices[index].TYPE == SS80_TYPE)
+		name = ((SS80DiskType *) Devices[index].dev)->HEADER.NAME;
+#ifdef AMIGO
+	if(Devices[index].TYPE == AMIGO_TYPE)
+		name = ((AMIGODiskType *) Devices[index].dev)->HEADER.NAME;
+#endif
+
+	if(argc == 3)
+	{
+		if(name == NULL)
+		{
+			printf("umount address:[%d] is not a disk\n", address);
+			return(-1);
+		}
+		if(MATCHI(argv[2], "commit"))
+		{
+			if(sparse_overlay_commit(name) < 0)
+				return(-1);
+		}
+		else if(MATCHI(argv[2], "discard"))
+		{
+			if(!sparse_overlay_discard(name))
+				return(-1);
+		}
+		else
+		{
+			printf("umount: expected commit or discard, got:[%s]\n", argv[2]);
+			return(-1);
+		}
+	}
 	free_device(index);
 	return(index);
 }
@@ -1989,18 +2364,28 @@ int8_t mount(int argc, char *argv[])
 				return( verify_device(index) );
 			}
 	}
-	else if(argc == 4)
+	else if(argc == 4 || argc == 5)
 	{
 		/*
 		argv[1] = 9121
 		argv[2] = 2
 		argv[3] = amigo2.lif
+		argv[4] = optional base image, argv[3] is then its overlay
 		*/
 		if(!hpdir_find_drive(argv[1],0,0) )
 		{
 			printf("WARNING: model NOT found in hpdir.ini!\n");
 			return(-1);
 		}
+		if(argc == 5 && sparse_check(argv[3]) < 0)
+		{
+			if(!sparse_overlay_create(argv[4], argv[3]))
+				return(-1);
+			printf("Created overlay:[%s] of:[%s]\n", argv[3], argv[4]);
+		}
+		// An existing image must already be an overlay of this base
+		else if(argc == 5 && !sparse_overlay_of(argv[3], argv[4]))
+			return(-1);
 		if(MATCHI(hpdir.TYPE, "SS80") || MATCHI(hpdir.TYPE,"CS80") )
 		{
 			// FIXME - do we want to have separtate address and ppr ?
@@ -2016,6 +2401,7 @@ int8_t mount(int argc, char *argv[])
 			if( !hpdir_set_parameters(index, argv[1] ) )
 				return(-1);
 			SS80p->HEADER.NAME = stralloc(argv[3]);
+			SS80p->HEADER.FORMAT = dbf_format(argv[3]);
 			SS80p->HEADER.ADDRESS  = address;
 			SS80p->HEADER.PPR = ppr;
 			Devices[index].ADDRESS = address;
@@ -2038,6 +2424,7 @@ int8_t mount(int argc, char *argv[])
 			if( !hpdir_set_parameters(index, argv[1] ) )
 				return(-1);
 			AMIGOp->HEADER.NAME = stralloc(argv[3]);
+			AMIGOp->HEADER.FORMAT = dbf_format(argv[3]);
 			AMIGOp->HEADER.ADDRESS  = address;
 			AMIGOp->HEADER.PPR = ppr;
 			Devices[index].ADDRESS = address;
@@ -43,6 +43,7 @@ typedef struct
     uint8_t PPR;                                  //< Parallel Poll Response Bit
 ///@brief Maximun lengh of device file name
     char     *NAME;                               // File name of emulated image
+    uint8_t  FORMAT;                              // Image format of NAME, see dbf_format()
     char     *model;                              // Model name of emulated device
 } HeaderType;
 
@@ -84,11 +85,19 @@ typedef struct
 typedef struct
 {
     uint32_t count;                               // total bytes
-    int16_t ind;                                  // buffer cache index
-    int16_t size;                                 // buffer size
+    uint32_t overflow;                            // bytes lost because the spool was full
+    uint32_t writes;                              // file writes
+    uint16_t stalls;                              // high water writes done while the talker waited
+    uint16_t peak;                                // most bytes ever held in the spool
+    uint16_t last;                                // printer_ticks() of the last byte
+    uint16_t synced;                              // printer_ticks() of the last syncfs
+    uint8_t address;                              // GPIB address, used in the file name
+    uint8_t slot;                                 // spool pool slot
+    uint8_t unlistened;                           // close after PRINTER_CLOSE_MS without data
+    uint8_t dirty;                                // data written since the last syncfs
     uint8_t error;                                // error status
     FILE *fp;
-    char *buf;
+    queue_t q;                                    // spool ring buffer, memory from the spool pool
 } PRINTERStateType;
 
 // =============================================
@@ -263,6 +272,24 @@ typedef struct
     void     *state;                              // Disk or Printer State Structure
 } DeviceType;
 
+///@brief Configuration snapshot header, see Save_Config_Snapshot()
+#define CONFIG_SNAPSHOT_MAGIC "HPCFGSNP"
+#define CONFIG_SNAPSHOT_VERSION 1
+typedef struct
+{
+    char     magic[8];
+    uint16_t version;
+    uint16_t layout;                              // Firmware build and structure sizes
+    uint32_t cfg_size;                            // hpdisk.cfg size
+    uint32_t cfg_mtime;                           // hpdisk.cfg modification time
+    uint32_t hpdir_size;                          // hpdir.ini size
+    uint32_t hpdir_mtime;                         // hpdir.ini modification time
+    uint16_t debuglevel;
+    uint8_t  devices;                             // Device records that follow
+    uint8_t  reserved;
+    uint16_t sum;                                 // Checksum of the device records
+} ConfigSnapshotType;
+
 // =============================================
 ///@convert print_var strings into __memx space
 #define print_var(format, args...) print_var_P(PSTR(format), ##args)
@@ -276,6 +303,7 @@ extern AMIGODiskType *AMIGOp;
 extern AMIGOStateType *AMIGOs;
 #endif
 extern PRINTERDeviceType *PRINTERp;
+extern PRINTERStateType *PRINTERs;
 extern DeviceType Devices[MAX_DEVICES];
 
 typedef union
@@ -353,6 +381,10 @@ void print_tok_val ( uint8_t tok , uint8_t spaces , uint32_t val );
 void print_tok_str ( uint8_t tok , uint8_t spaces , char *str );
 void print_tok ( uint8_t tok , uint8_t spaces );
 int Read_Config ( char *name );
+void Config_Snapshot_Name ( char *name , char *snapshot , int size );
+int Config_Snapshot_Key ( char *name , ConfigSnapshotType *K );
+int Save_Config_Snapshot ( char *name );
+int Load_Config_Snapshot ( char *name );
 void display_Addresses ( int verbose );
 void display_Config ( int verbose );
 int8_t find_type ( int type );
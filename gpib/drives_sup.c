@@ -71,15 +71,469 @@ long lif_dir_count(long blocks)
 
 
 /// ===============================================
-///@brief Find drive parameters in hpdir.ini file
+///@brief Parse the fields after the model name of a [driveinfo] entry
 ///
 ///@param[in] model: model string
+///@param[in] ptr: rest of the hpdir.ini line after the model
+///
+///@return void
+void hpdir_parse(char *model, char *ptr)
+{
+    char token[128];
+
+    hpdir_init();
+
+// 1 Model
+    strncpy(hpdir.model,model,sizeof(hpdir.model)-2);
+
+// =
+    ptr = get_token(ptr, token,     sizeof(token)-2);
+
+// 2 Comment
+    ptr = get_token(ptr, hpdir.comment, sizeof(hpdir.comment)-2);
+
+// 3 AMIGO/SS80/CS80
+    ptr = get_token(ptr, hpdir.TYPE,  sizeof(hpdir.TYPE)-2);
+
+// 4 Identify ID
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.ID = get_value(token);
+
+// 5 MASK STAT 2
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.mask_stat2 = get_value(token);
+
+// 6 STAT2
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.id_stat2 = get_value(token);
+
+// 7 BCD include model number
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.DEVICE_NUMBER = get_value(token);
+
+// 8 Units installed
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.UNITS_INSTALLED = get_value(token);
+
+// 9 Cylinders
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.CYLINDERS = get_value(token);
+
+// 10 Heads
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.HEADS = get_value(token);
+
+// 11 Sectors
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.SECTORS = get_value(token);
+
+// 12 Bytes Per Block/Sector
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.BYTES_PER_SECTOR = get_value(token);
+
+// 13 Interleave
+    ptr = get_token(ptr, token,         sizeof(token)-2);
+    hpdir.INTERLEAVE = get_value(token);
+
+// Computed values
+    hpdir.BLOCKS = ( hpdir.CYLINDERS * hpdir.HEADS * hpdir.SECTORS );
+}
+
+
+/// ===============================================
+///@brief Open a drive database file
+///
+/// Looks in the current directory then in the root directory, or
+/// for the stand alone utilities, the program install directory
+///
+///@param[in] name: file name, hpdir.ini or hpdir.bin
+///@param[in] mode: fopen mode
+///@param[out] path: path that was opened, or the path to use for a new file
+///@param[in] size: size of path
+///
+///@return FILE * or NULL
+FILE *hpdir_open(char *name, char *mode, char *path, int size)
+{
+    FILE *fp;
+
+    strncpy(path, name, size-1);
+    path[size-1] = 0;
+    fp = fopen(path, mode);
+
+#ifndef LIF_STAND_ALONE
+    if(fp == NULL)
+    {
+        snprintf(path, size, "/%s", name);
+        fp = fopen(path, mode);
+    }
+#else
+    if(fp == NULL)
+    {
+        char exe[2048];
+        int len;
+        len = readlink("/proc/self/exe", exe, sizeof(exe) -2);
+        if(len > 0)
+        {
+            exe[len] = 0;
+            snprintf(path, size, "%s/%s", dirname(exe), name);
+            fp = fopen(path, mode);
+        }
+    }
+#endif
+    return(fp);
+}
+
+
+/// ===============================================
+///@brief Compiled drive database
+///
+/// hpdir.bin holds the [driveinfo] section of hpdir.ini as fixed size
+/// records sorted by model so a lookup is a binary search instead of a
+/// parse of the whole text file. hpdir.ini stays the source of truth,
+/// the header records its size, time and checksum and the compiled file
+/// is ignored, and rebuilt by the stand alone utilities, when they differ.
+/// All values are stored LSB first
+///
+///    OFFSET  DESCRIPTION
+///      0-7   Magic "HPDIRBIN"
+///      8-9   Version
+///     10-11  Record size
+///     12-15  Number of records
+///     16-19  hpdir.ini size
+///     20-23  hpdir.ini modification time
+///     24-27  hpdir.ini checksum
+///    Records, one per model, first entry wins for duplicate models
+///      0-31  Model, 0 terminated
+///     32-95  Comment
+///     96-103 Type AMIGO/SS80/CS80
+///    104-147 Fields 4 to 14 of the hpdir.ini entry, 4 bytes each
+
+///@brief Store a value LSB first
+static void hpdir_put(uint8_t *B, int off, int size, uint32_t val)
+{
+    while(size--)
+    {
+        B[off++] = val & 0xff;
+        val >>= 8;
+    }
+}
+
+///@brief Fetch a value stored LSB first
+static uint32_t hpdir_get(uint8_t *B, int off, int size)
+{
+    uint32_t val = 0;
+    while(size--)
+        val = (val << 8) | B[off+size];
+    return(val);
+}
+
+
+/// ===============================================
+///@brief Checksum of a file, used to detect a changed hpdir.ini
+///
+///@param[in] fp: open file, read from the start
+///
+///@return checksum
+uint32_t hpdir_checksum(FILE *fp)
+{
+    uint8_t buf[128];
+    uint32_t sum = 0;
+    int i, len;
+
+    fseek(fp, 0, SEEK_SET);
+    while( (len = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        for(i=0;i<len;++i)
+            sum = (sum * 31) + buf[i];
+    }
+    return(sum);
+}
+
+
+/// ===============================================
+///@brief Check the compiled drive database against hpdir.ini
+///
+///@param[in] bin: open hpdir.bin file
+///@param[out] count: number of records
+///
+///@return 1 if hpdir.bin matches hpdir.ini, 0 if not
+int hpdir_bin_check(FILE *bin, long *count)
+{
+    uint8_t H[HPDIR_BIN_HEADER];
+    struct stat sb;
+    char path[HPDIR_PATH_SIZE];
+    FILE *ini;
+    int ret = 0;
+
+    fseek(bin, 0, SEEK_SET);
+    if(fread(H, 1, HPDIR_BIN_HEADER, bin) != HPDIR_BIN_HEADER)
+        return(0);
+    if(memcmp(H, HPDIR_BIN_MAGIC, 8) != 0
+            || hpdir_get(H, 8, 2) != HPDIR_BIN_VERSION
+            || hpdir_get(H, 10, 2) != HPDIR_BIN_RECORD)
+        return(0);
+    *count = hpdir_get(H, 12, 4);
+
+    ini = hpdir_open("hpdir.ini", "rb", path, sizeof(path));
+    if(ini == NULL)
+        return(0);
+    if(stat(path, &sb) == 0 && (uint32_t) sb.st_size == hpdir_get(H, 16, 4))
+    {
+// Size and time match, or the file was copied and the contents match
+        if((uint32_t) sb.st_mtime == hpdir_get(H, 20, 4))
+            ret = 1;
+        else if(hpdir_checksum(ini) == hpdir_get(H, 24, 4))
+            ret = 1;
+    }
+    fclose(ini);
+    return(ret);
+}
+
+
+///@brief hpdir_bin_check() result, -1 until checked
+/// Checked once, hpdir.ini does not change while the emulator runs, and
+/// reset when hpdir_compile() rewrites hpdir.bin
+static int8_t hpdir_bin_valid = -1;
+///@brief hpdir.bin record count, valid when hpdir_bin_valid is 1
+static long hpdir_bin_count = 0;
+
+
+/// ===============================================
+///@brief Find drive parameters with a binary search of hpdir.bin
+///
+///@param[in] model: model string
+///@param[in] verbose: display messages
+///
+///@return 1 found, 0 not found, -1 if hpdir.bin is missing or out of date
+int hpdir_bin_find(char *model, int verbose)
+{
+    uint8_t R[HPDIR_BIN_RECORD];
+    char path[HPDIR_PATH_SIZE];
+    FILE *bin;
+    long lo, hi, mid;
+    int cmp, i;
+    int found = -1;
+
+    bin = hpdir_open("hpdir.bin", "rb", path, sizeof(path));
+    if(bin == NULL)
+        return(-1);
+
+    if(hpdir_bin_valid < 0)
+        hpdir_bin_valid = hpdir_bin_check(bin, &hpdir_bin_count);
+
+    if(hpdir_bin_valid)
+    {
+        found = 0;
+        lo = 0;
+        hi = hpdir_bin_count - 1;
+        while(lo <= hi)
+        {
+            mid = (lo + hi) / 2;
+            if(fseek(bin, HPDIR_BIN_HEADER + mid * HPDIR_BIN_RECORD, SEEK_SET) != 0
+                    || fread(R, 1, HPDIR_BIN_RECORD, bin) != HPDIR_BIN_RECORD)
+            {
+                found = -1;
+                break;
+            }
+            R[MODEL_SIZE-1] = 0;
+            cmp = strcasecmp(model, (char *) R);
+            if(cmp < 0)
+            {
+                hi = mid - 1;
+                continue;
+            }
+            if(cmp > 0)
+            {
+                lo = mid + 1;
+                continue;
+            }
+
+            hpdir_init();
+            strncpy(hpdir.model, (char *) R, sizeof(hpdir.model)-2);
+            R[32+63] = 0;
+            strncpy(hpdir.comment, (char *) R+32, sizeof(hpdir.comment)-2);
+            R[96+7] = 0;
+            strncpy(hpdir.TYPE, (char *) R+96, sizeof(hpdir.TYPE)-2);
+            i = 104;
+            hpdir.ID = hpdir_get(R, i, 4); i += 4;
+            hpdir.mask_stat2 = hpdir_get(R, i, 4); i += 4;
+            hpdir.id_stat2 = hpdir_get(R, i, 4); i += 4;
+            hpdir.DEVICE_NUMBER = hpdir_get(R, i, 4); i += 4;
+            hpdir.UNITS_INSTALLED = hpdir_get(R, i, 4); i += 4;
+            hpdir.CYLINDERS = hpdir_get(R, i, 4); i += 4;
+            hpdir.HEADS = hpdir_get(R, i, 4); i += 4;
+            hpdir.SECTORS = hpdir_get(R, i, 4); i += 4;
+            hpdir.BYTES_PER_SECTOR = hpdir_get(R, i, 4); i += 4;
+            hpdir.INTERLEAVE = hpdir_get(R, i, 4); i += 4;
+            hpdir.FIXED = hpdir_get(R, i, 4);
+            hpdir.BLOCKS = ( hpdir.CYLINDERS * hpdir.HEADS * hpdir.SECTORS );
+            found = 1;
+            break;
+        }
+    }
+    fclose(bin);
+
+    if(verbose && found == 1)
+        printf("Model: %s found in hpdir.bin\n", model);
+    return(found);
+}
+
+
+#ifdef LIF_STAND_ALONE
+/// ===============================================
+///@brief Compile the [driveinfo] section of hpdir.ini into hpdir.bin
+///
+/// hpdir.bin is written next to hpdir.ini
+///@param[in] verbose: display messages
+///
+///@return number of records written, -1 on error
+long hpdir_compile(int verbose)
+{
+    uint8_t H[HPDIR_BIN_HEADER];
+    uint8_t R[HPDIR_BIN_RECORD];
+    struct stat sb;
+    char path[HPDIR_PATH_SIZE];
+    char str[256];
+    char token[128];
+    char *ptr;
+    hpdir_t *list = NULL;
+    hpdir_t tmp;
+    long count = 0, max = 0;
+    long i, j, out;
+    int driveinfo = 0;
+    FILE *ini, *bin;
+
+    ini = hpdir_open("hpdir.ini", "rb", path, sizeof(path) - 8);
+    if(ini == NULL)
+    {
+        if(verbose)
+            printf("Error: hpdir.ini not found!\n");
+        return(-1);
+    }
+
+    while( (ptr = fgets(str, sizeof(str)-2, ini)) != NULL)
+    {
+        trim_tail(ptr);
+        ptr = skipspaces(ptr);
+        if(!*ptr || *ptr == ';' || *ptr == '#' )
+            continue;
+        if(*ptr == '[' && driveinfo == 1 )
+            break;
+        ptr = get_token(ptr, token, sizeof(token)-2);
+        if(MATCHI(token,"[driveinfo]"))
+        {
+            driveinfo = 1;
+            continue;
+        }
+        if( driveinfo != 1)
+            continue;
+
+        if(count == max)
+        {
+            max = max ? max * 2 : 64;
+            list = realloc(list, max * sizeof(hpdir_t));
+            if(list == NULL)
+            {
+                printf("hpdir_compile: out of memory\n");
+                fclose(ini);
+                return(-1);
+            }
+        }
+        hpdir_parse(token, ptr);
+        list[count++] = hpdir;
+    }
+
+// Stable insertion sort by model so the first duplicate entry wins
+    for(i=1;i<count;++i)
+    {
+        tmp = list[i];
+        for(j=i;j>0 && strcasecmp(list[j-1].model, tmp.model) > 0;--j)
+            list[j] = list[j-1];
+        list[j] = tmp;
+    }
+
+    memset(H, 0, sizeof(H));
+    memcpy(H, HPDIR_BIN_MAGIC, 8);
+    hpdir_put(H, 8, 2, HPDIR_BIN_VERSION);
+    hpdir_put(H, 10, 2, HPDIR_BIN_RECORD);
+    if(fstat(fileno(ini), &sb) == 0)
+    {
+        hpdir_put(H, 16, 4, sb.st_size);
+        hpdir_put(H, 20, 4, sb.st_mtime);
+    }
+    hpdir_put(H, 24, 4, hpdir_checksum(ini));
+    fclose(ini);
+
+// hpdir.bin goes next to hpdir.ini
+    ptr = strrchr(path, '.');
+    if(ptr)
+        strcpy(ptr, ".bin");
+
+    bin = fopen(path, "wb");
+    if(bin == NULL)
+    {
+        if(verbose)
+            printf("Can not create: %s\n", path);
+        free(list);
+        return(-1);
+    }
+    fwrite(H, 1, HPDIR_BIN_HEADER, bin);
+// hpdir_bin_find() checks the new file on its next call
+    hpdir_bin_valid = -1;
+
+    out = 0;
+    for(i=0;i<count;++i)
+    {
+        if(i && strcasecmp(list[i-1].model, list[i].model) == 0)
+            continue;
+        memset(R, 0, sizeof(R));
+        strncpy((char *) R, list[i].model, MODEL_SIZE-1);
+        strncpy((char *) R+32, list[i].comment, 63);
+        strncpy((char *) R+96, list[i].TYPE, 7);
+        j = 104;
+        hpdir_put(R, j, 4, list[i].ID); j += 4;
+        hpdir_put(R, j, 4, list[i].mask_stat2); j += 4;
+        hpdir_put(R, j, 4, list[i].id_stat2); j += 4;
+        hpdir_put(R, j, 4, list[i].DEVICE_NUMBER); j += 4;
+        hpdir_put(R, j, 4, list[i].UNITS_INSTALLED); j += 4;
+        hpdir_put(R, j, 4, list[i].CYLINDERS); j += 4;
+        hpdir_put(R, j, 4, list[i].HEADS); j += 4;
+        hpdir_put(R, j, 4, list[i].SECTORS); j += 4;
+        hpdir_put(R, j, 4, list[i].BYTES_PER_SECTOR); j += 4;
+        hpdir_put(R, j, 4, list[i].INTERLEAVE); j += 4;
+        hpdir_put(R, j, 4, list[i].FIXED);
+        fwrite(R, 1, HPDIR_BIN_RECORD, bin);
+        ++out;
+    }
+    free(list);
+
+    hpdir_put(H, 12, 4, out);
+    fseek(bin, 0, SEEK_SET);
+    fwrite(H, 1, HPDIR_BIN_HEADER, bin);
+    if(fclose(bin) != 0)
+        return(-1);
+
+    if(verbose)
+        printf("Compiled %ld drives into %s\n", out, path);
+    return(out);
+}
+#endif
+
+
+/// ===============================================
+///@brief Find drive parameters
+///
+/// Uses hpdir.bin when it matches hpdir.ini, otherwise parses hpdir.ini
+/// The stand alone utilities rebuild hpdir.bin when it is out of date
+///
+///@param[in] model: model string
+///@param[in] list: list all drives in hpdir.ini
+///@param[in] verbose: display messages
 ///
 ///@return 1 on sucess or 0 on fail
 int hpdir_find_drive(char *model, int list, int verbose)
 {
     int len;
-    int errors = 0;
     int driveinfo=0;
     int found = 0;
     FILE *cfg;
@@ -89,21 +543,23 @@ int hpdir_find_drive(char *model, int list, int verbose)
 
     hpdir_init();
 
-    cfg = fopen("hpdir.ini","rb");
-
-#ifndef LIF_STAND_ALONE
-    if(cfg == NULL)
-        cfg = fopen("/hpdir.ini","rb");
-#else
-    if(cfg == NULL)
+    if(!list)
     {
-        char name[2048];
-        len = readlink("/proc/self/exe", name, sizeof(name) -2);
-        dirname (name);
-        strcat  (name, "/hpdir.ini");
-        cfg = fopen(name, "rb");
-    }
+        found = hpdir_bin_find(model, verbose);
+#ifdef LIF_STAND_ALONE
+        if(found < 0 && hpdir_compile(0) >= 0)
+            found = hpdir_bin_find(model, verbose);
 #endif
+        if(found >= 0)
+        {
+            if(verbose && !found)
+                printf("Model: %s NOT found in hpdir.bin\n", model);
+            return(found);
+        }
+        found = 0;
+    }
+
+    cfg = hpdir_open("hpdir.ini", "rb", str, sizeof(str));
 
     if(cfg == NULL)
     {
@@ -116,7 +572,6 @@ int hpdir_find_drive(char *model, int list, int verbose)
 
     while( (ptr = fgets(str, sizeof(str)-2, cfg)) != NULL)
     {
-        errors = 0;
         ptr = str;
 
         trim_tail(ptr);
@@ -154,78 +609,16 @@ int hpdir_find_drive(char *model, int list, int verbose)
         if ( ! MATCHI(model,token) )
             continue;
 
-        hpdir_init();
-
         if(verbose)
             printf("Model: %s found in hpdir.ini\n", model);
 
-// 1 Model
-        strncpy(hpdir.model,token,sizeof(hpdir.model)-2);
-
-// =
-        ptr = get_token(ptr, token,     sizeof(token)-2);
-
-// 2 Comment
-        ptr = get_token(ptr, hpdir.comment, sizeof(hpdir.comment)-2);
-
-// 3 AMIGO/SS80/CS80
-        ptr = get_token(ptr, hpdir.TYPE,  sizeof(hpdir.TYPE)-2);
-
-// 4 Identify ID
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.ID = get_value(token);
-
-// 5 MASK STAT 2
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.mask_stat2 = get_value(token);
-
-// 6 STAT2
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.id_stat2 = get_value(token);
-
-// 7 BCD include model number
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.DEVICE_NUMBER = get_value(token);
-
-// 8 Units installed
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.UNITS_INSTALLED = get_value(token);
-
-// 9 Cylinders
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.CYLINDERS = get_value(token);
-
-// 10 Heads
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.HEADS = get_value(token);
-
-// 11 Sectors
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.SECTORS = get_value(token);
-
-// 12 Bytes Per Block/Sector
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.BYTES_PER_SECTOR = get_value(token);
-
-// 13 Interleave
-        ptr = get_token(ptr, token,         sizeof(token)-2);
-        hpdir.INTERLEAVE = get_value(token);
-
-// Computed values
-        hpdir.BLOCKS = ( hpdir.CYLINDERS * hpdir.HEADS * hpdir.SECTORS );
-
-        if(errors)
-        {
-            if(verbose)
-                printf("Error /hpdir.ini parsing\n");
-            break;
-        }
+        hpdir_parse(token, ptr);
         found = 1;
         break;
 
     }                                             // while
     fclose(cfg);
-	if(verbose && !found)
+	if(verbose && !found && !list)
 		printf("Model: %s NOT found in hpdir.ini\n", model);
     return(found);
 }
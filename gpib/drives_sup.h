@@ -50,6 +50,17 @@ typedef struct
     long BLOCKS;
     long LIF_DIR_BLOCKS;
 } hpdir_t;
+
+///@brief Compiled hpdir.ini [driveinfo] section, see drives_sup.c
+#define HPDIR_BIN_MAGIC "HPDIRBIN"
+#define HPDIR_BIN_VERSION 1
+#define HPDIR_BIN_HEADER 32
+#define HPDIR_BIN_RECORD 148
+#ifdef LIF_STAND_ALONE
+#define HPDIR_PATH_SIZE 1024
+#else
+#define HPDIR_PATH_SIZE 32
+#endif
 // =============================================
 
 #endif
@@ -57,4 +68,10 @@ typedef struct
 /* drives_sup.c */
 void hpdir_init ( void );
 long lif_dir_count ( long blocks );
+void hpdir_parse ( char *model , char *ptr );
+FILE *hpdir_open ( char *name , char *mode , char *path , int size );
+uint32_t hpdir_checksum ( FILE *fp );
+int hpdir_bin_check ( FILE *bin , long *count );
+int hpdir_bin_find ( char *model , int verbose );
+long hpdir_compile ( int verbose );
 int hpdir_find_drive ( char *model , int list , int verbose );
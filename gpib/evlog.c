@@ -0,0 +1,234 @@
+/**
+ @file gpib/evlog.c
+
+ @brief Deferred binary event log for HP85 disk emulator project for AVR.
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ @par Notes
+   evlog_add() is called from the GPIB protocol code only, never from
+   an interrupt, so the ring needs no locking.
+   When the ring is full new records are dropped and counted.
+*/
+
+#include "user_config.h"
+
+#include "defines.h"
+#include "debug.h"
+#include "evlog.h"
+
+///@brief Event ring
+static evlog_t evlog_ring[EVLOG_SIZE];
+static uint8_t evlog_head = 0;
+static uint8_t evlog_tail = 0;
+///@brief Records dropped because the ring was full
+static uint16_t evlog_lost = 0;
+static uint8_t evlog_out = EVLOG_TEXT;
+
+/// @brief  Save an event record
+///
+/// - Use the EVLOG() macro so the debuglevel test is done first
+/// @param[in] id: event id from evlog_events.h
+/// @param[in] a,b,c: format arguments
+/// @return  void
+void evlog_add(uint8_t id, long a, long b, long c)
+{
+    evlog_t *E;
+    uint8_t next;
+
+    if(evlog_out == EVLOG_DIRECT)
+    {
+        evlog_t tmp;
+        tmp.time = uptime_ms();
+        tmp.id = id;
+        tmp.arg[0] = a;
+        tmp.arg[1] = b;
+        tmp.arg[2] = c;
+        evlog_print(&tmp);
+        return;
+    }
+
+    next = (evlog_head + 1) & EVLOG_MASK;
+    if(next == evlog_tail)
+    {
+        ++evlog_lost;
+        return;
+    }
+
+    E = &evlog_ring[evlog_head];
+    E->time = uptime_ms();
+    E->id = id;
+    E->arg[0] = a;
+    E->arg[1] = b;
+    E->arg[2] = c;
+    evlog_head = next;
+}
+
+
+/// @brief  Flash format string for an event id
+///
+/// - A switch keeps the strings and the table out of RAM
+/// @param[in] id: event id
+/// @return  format string, NULL if id is unknown
+__memx const char *evlog_format(uint8_t id)
+{
+    switch(id)
+    {
+#define EVLOG_EVENT(id, fmt) case id: return(PSTR_X(fmt));
+#include "evlog_events.h"
+#undef EVLOG_EVENT
+    }
+    return(NULL);
+}
+
+
+/// @brief  Display one record in the current mode
+///
+/// @param[in] E: record
+/// @return  void
+void evlog_print(evlog_t *E)
+{
+    __memx const char *fmt;
+
+    if(evlog_out == EVLOG_RAW)
+    {
+        printf("E,%d,%lu,%ld,%ld,%ld\n",
+            (int) E->id, (unsigned long) E->time,
+            E->arg[0], E->arg[1], E->arg[2]);
+        return;
+    }
+
+    fmt = evlog_format(E->id);
+    if(fmt == NULL)
+    {
+        printf("[EVLOG unknown id %d]\n", (int) E->id);
+        return;
+    }
+    if(debuglevel & GPIB_RW_STR_TIMING)
+        printf("%lu: ", (unsigned long) E->time);
+    printf_P(fmt, E->arg[0], E->arg[1], E->arg[2]);
+}
+
+
+/// @brief  Report and reset the dropped record count
+/// @return  void
+static void evlog_report_lost()
+{
+    if(evlog_lost)
+    {
+        printf("[EVLOG lost %u]\n", (unsigned int) evlog_lost);
+        evlog_lost = 0;
+    }
+}
+
+
+/// @brief  Format up to EVLOG_BATCH records
+///
+/// - Called from gpib_user_task() while waiting for the bus
+/// - Does nothing while the UART transmit queue is busy so it never
+///   waits for the UART inside the GPIB read loop
+/// @return  number of records displayed
+int evlog_task()
+{
+    int count = 0;
+
+    if(evlog_out == EVLOG_HOLD)
+        return(0);
+
+    while(evlog_tail != evlog_head && count < EVLOG_BATCH)
+    {
+        if(uart_tx_count(0) > EVLOG_TX_BUSY)
+            break;
+        evlog_print(&evlog_ring[evlog_tail]);
+        evlog_tail = (evlog_tail + 1) & EVLOG_MASK;
+        ++count;
+    }
+    if(evlog_tail == evlog_head)
+        evlog_report_lost();
+    return(count);
+}
+
+
+/// @brief  Set output mode
+///
+/// @param[in] mode: EVLOG_TEXT, EVLOG_RAW, EVLOG_HOLD or EVLOG_DIRECT
+/// @return  previous mode
+int evlog_mode(int mode)
+{
+    int old = evlog_out;
+    evlog_out = mode;
+    if(mode == EVLOG_DIRECT)
+        evlog_dump();
+    return(old);
+}
+
+
+/// @brief  Display all saved records now
+///
+/// - Held records are shown as text unless the mode is EVLOG_RAW
+/// @return  number of records displayed
+int evlog_dump()
+{
+    int count = 0;
+    uint8_t mode = evlog_out;
+
+    if(evlog_out == EVLOG_HOLD || evlog_out == EVLOG_DIRECT)
+        evlog_out = EVLOG_TEXT;
+
+    while(evlog_tail != evlog_head)
+    {
+        evlog_print(&evlog_ring[evlog_tail]);
+        evlog_tail = (evlog_tail + 1) & EVLOG_MASK;
+        ++count;
+    }
+    evlog_report_lost();
+    evlog_out = mode;
+    return(count);
+}
+
+
+/// @brief  Display saved records before a message that is printed at once
+///
+/// - Used by EVLOG_PRINTF() for GPIB_ERR and timing messages
+/// - Held records stay held in EVLOG_HOLD mode
+/// @return  void
+void evlog_flush()
+{
+    if(evlog_out == EVLOG_HOLD)
+        return;
+
+    while(evlog_tail != evlog_head)
+    {
+        evlog_print(&evlog_ring[evlog_tail]);
+        evlog_tail = (evlog_tail + 1) & EVLOG_MASK;
+    }
+    evlog_report_lost();
+}
+
+
+/// @brief  Discard all saved records
+/// @return  void
+void evlog_clear()
+{
+    evlog_tail = evlog_head;
+    evlog_lost = 0;
+}
+
+
+/// @brief  List event ids and formats, used to decode EVLOG_RAW output
+/// @return  void
+void evlog_list()
+{
+    uint8_t id;
+
+    for(id = 0; id < EVLOG_EVENTS; ++id)
+    {
+        printf("%d:", (int) id);
+        printf_P(evlog_format(id), 0L, 0L, 0L);
+    }
+}
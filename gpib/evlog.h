@@ -0,0 +1,85 @@
+/**
+ @file gpib/evlog.h
+
+ @brief Deferred binary event log for HP85 disk emulator project for AVR.
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ @par Overview
+   Protocol code saves a small record - event id, uptime_ms() and
+   EVLOG_ARGS integer arguments - instead of calling printf.
+   The records are formatted later from gpib_user_task() using the
+   format strings in evlog_events.h that live in flash.
+   The debuglevel bits still decide which events are recorded.
+*/
+
+#ifndef _EVLOG_H
+#define _EVLOG_H
+
+///@brief Number of records in the ring, MUST be a power of 2
+#define EVLOG_SIZE  32
+#define EVLOG_MASK  (EVLOG_SIZE-1)
+///@brief Integer arguments saved with each record
+#define EVLOG_ARGS  3
+///@brief Most records formatted by one evlog_task() call
+#define EVLOG_BATCH 4
+///@brief evlog_task() waits while more characters than this are queued to the UART
+#define EVLOG_TX_BUSY 32
+
+///@brief Output modes
+#define EVLOG_TEXT   0                            // Format in gpib_user_task()
+#define EVLOG_RAW    1                            // Raw records for decoding on a host
+#define EVLOG_HOLD   2                            // Keep records until evlog dump
+#define EVLOG_DIRECT 3                            // Format at once, like the old printf calls
+
+///@brief Event ids, in the order of evlog_events.h
+enum
+{
+#define EVLOG_EVENT(id, fmt) id,
+#include "evlog_events.h"
+#undef EVLOG_EVENT
+    EVLOG_EVENTS
+};
+
+///@brief Event record
+typedef struct
+{
+    uint32_t time;                                // uptime_ms() when recorded
+    long arg[EVLOG_ARGS];
+    uint8_t id;
+} evlog_t;
+
+///@brief printf for messages that are not deferred, such as GPIB_ERR and
+/// timing lines, shows the saved records first so the console stays in order
+#define EVLOG_PRINTF(format, args...) \
+    do \
+    { \
+        evlog_flush(); \
+        printf(format, ##args); \
+    } while(0)
+
+///@brief Record event id when any of the debuglevel bits in level are set
+#define EVLOG(level, id, a, b, c) \
+    do \
+    { \
+        if(debuglevel & (level)) \
+            evlog_add((id), (long)(a), (long)(b), (long)(c)); \
+    } while(0)
+
+/* evlog.c */
+void evlog_add ( uint8_t id , long a , long b , long c );
+__memx const char *evlog_format ( uint8_t id );
+void evlog_print ( evlog_t *E );
+int evlog_task ( void );
+int evlog_mode ( int mode );
+int evlog_dump ( void );
+void evlog_flush ( void );
+void evlog_clear ( void );
+void evlog_list ( void );
+
+#endif                                            // _EVLOG_H
@@ -0,0 +1,103 @@
+/**
+ @file gpib/evlog_events.h
+
+ @brief Deferred event log ids and format strings for HP85 disk emulator project for AVR.
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ @par Format
+   EVLOG_EVENT(id, format)
+   Every record has EVLOG_ARGS long arguments so conversions MUST use
+   the l modifier, %s is not allowed because only integers are saved.
+   New events are added at the end so ids in saved raw logs stay valid.
+
+ No include guard - this file is included several times with different
+ EVLOG_EVENT definitions, see evlog.h and evlog.c
+*/
+
+EVLOG_EVENT(EV_SS80_TEST,                               "[SS80 Test]\n")
+EVLOG_EVENT(EV_SS80_INIT,                               "[SS80 %02lXH INIT]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_READ_AT,                 "[SS80 Locate and Read at %08lXH(%lXH)]\n")
+EVLOG_EVENT(EV_SS80_DISK_READ_BYTES,                    "[SS80 Disk Read %02lXH bytes]\n")
+EVLOG_EVENT(EV_SS80_BUFFERED_READ_TOTAL_BYTES,          "[SS80 Buffered Read Total(%lXH) bytes]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_WRITE_AT,                "[SS80 Locate and Write at %08lXH(%lXH)]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_WRITE_WROTE,             "[SS80 Locate and Write wrote(%02lXH)]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_WRITE_WROTE_TOTAL,       "[SS80 Locate and Write Wrote Total(%lxH)]\n")
+EVLOG_EVENT(EV_SS80_SEND_STATUS,                        "[SS80 Send Status]\n")
+EVLOG_EVENT(EV_SS80_DESCRIBE,                           "[SS80 Describe]\n")
+EVLOG_EVENT(EV_SS80_SET_UNIT,                           "[SS80 Set Unit:(%ld)]\n")
+EVLOG_EVENT(EV_SS80_SET_VOLUME,                         "[SS80 Set Volume: (%ld)]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_READ,                    "[SS80 Locate and Read]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_WRITE,                   "[SS80 Locate and Write]\n")
+EVLOG_EVENT(EV_SS80_SET_ADDRESS,                        "[SS80 Set Address:(%08lXH)]\n")
+EVLOG_EVENT(EV_SS80_SET_LENGTH,                         "[SS80 Set Length:(%08lXH)]\n")
+EVLOG_EVENT(EV_SS80_NO_OP,                              "[SS80 NO-OP]\n")
+EVLOG_EVENT(EV_SS80_SET_RPS_NO_OP,                      "[SS80 Set RPS NO-OP]\n")
+EVLOG_EVENT(EV_SS80_SET_RELEASE_NO_OP,                  "[SS80 Set Release NO-OP]\n")
+EVLOG_EVENT(EV_SS80_SET_RETURN_ADDRESSING_TODO,         "[SS80 Set Return Addressing - TODO]\n")
+EVLOG_EVENT(EV_SS80_LOCATE_AND_VERIFY_TODO,             "[SS80 Locate and Verify - TODO]\n")
+EVLOG_EVENT(EV_SS80_RELEASE_NO_OP,                      "[SS80 Release NO-OP]\n")
+EVLOG_EVENT(EV_SS80_RELEASE_DENIED_NO_OP,               "[SS80 Release Denied NO-OP]\n")
+EVLOG_EVENT(EV_SS80_VALIDATE_KEY_TODO,                  "[SS80 Validate Key - TODO]\n")
+EVLOG_EVENT(EV_SS80_INITIALIZE_MEDIA_TODO,              "[SS80 Initialize Media TODO]\n")
+EVLOG_EVENT(EV_SS80_DOOR_UNLOCK_TODO,                   "[SS80 Door UnLock - TODO]\n")
+EVLOG_EVENT(EV_SS80_DOOR_LOCK_TODO,                     "[SS80 Door Lock - TODO]\n")
+EVLOG_EVENT(EV_SS80_REQUEST_STATUS,                     "[SS80 Request Status]\n")
+EVLOG_EVENT(EV_SS80_INITIATE_DIAGNOSTIC_TODO,           "[SS80 Initiate Diagnostic - TODO]\n")
+EVLOG_EVENT(EV_SS80_HP_IB_PARITY_CHECKING_TODO,         "[SS80 HP-IB Parity Checking - TODO]\n")
+EVLOG_EVENT(EV_SS80_READ_LOOPBACK_TODO,                 "[SS80 Read Loopback - TODO]\n")
+EVLOG_EVENT(EV_SS80_WRITE_LOOPBACK_TODO,                "[SS80 Write Loopback - TODO]\n")
+EVLOG_EVENT(EV_SS80_CHANNEL_INDEPENDENT_CLEAR,          "[SS80 Channel Independent Clear (%ld)]\n")
+EVLOG_EVENT(EV_SS80_CANCEL,                             "[SS80 Cancel (%ld)]\n")
+EVLOG_EVENT(EV_SS80_SEEK,                               "[SS80 Seek:%08lXH]\n")
+EVLOG_EVENT(EV_SS80_QSTAT,                              "[SS80 qstat %02lX]\n")
+EVLOG_EVENT(EV_SS80_SDC,                                "[SS80 SDC]\n")
+EVLOG_EVENT(EV_SS80_AMIGO_CLEAR,                        "[Amigo Clear]\n")
+EVLOG_EVENT(EV_SS80_INCREMENT_TO,                       "[SS80 Increment to (%lXH)]\n")
+EVLOG_EVENT(EV_SS80_COMMAND_STATE,                      "[SS80 Command State]\n")
+EVLOG_EVENT(EV_SS80_EXECUTE_STATE,                      "[SS80 Execute State]\n")
+EVLOG_EVENT(EV_SS80_REPORT_STATE,                       "[SS80 Report State]\n")
+EVLOG_EVENT(EV_SS80_TRANSPARENT,                        "[SS80 Transparent]\n")
+EVLOG_EVENT(EV_AMIGO_REQUEST_STATUS,                    "[AMIGO request status]\n")
+EVLOG_EVENT(EV_AMIGO_SEND_LOGICAL_ADDRESS,              "[AMIGO send logical address]\n")
+EVLOG_EVENT(EV_AMIGO_SEND_STATUS,                       "[AMIGO send status]\n")
+EVLOG_EVENT(EV_AMIGO_VERIFY_P_SECTORS,                  "[AMIGO verify P:%08lXH, sectors:%04lXH]\n")
+EVLOG_EVENT(EV_AMIGO_FORMAT,                            "[AMIGO format]\n")
+EVLOG_EVENT(EV_AMIGO_FORMAT_DONE,                       "[AMIGO Format Done]\n")
+EVLOG_EVENT(EV_AMIGO_STATE,                             "AMIGOs->state:%ld\n")
+EVLOG_EVENT(EV_AMIGO_DSJ,                               "[DSJ %02lXH]\n")
+EVLOG_EVENT(EV_AMIGO_WAKEUP,                            "[AMIGO Wakeup]\n")
+EVLOG_EVENT(EV_AMIGO_CLEAR,                             "[AMIGO Clear]\n")
+EVLOG_EVENT(EV_AMIGO_COMMAND_LISTEN_TALK,               "[AMIGO Command(%02lXH): listen:%02lXH, talk:%02lXH]\n")
+EVLOG_EVENT(EV_AMIGO_COMMAND_GPIB_READ_BYTES,           "[AMIGO Command(%02lXH): GPIB read bytes:%02lXH]\n")
+EVLOG_EVENT(EV_AMIGO_COLD_LOAD_READ_COMMAND,            "[AMIGO Cold Load Read Command]\n")
+EVLOG_EVENT(EV_AMIGO_SEEK_LEN_5,                        "[AMIGO Seek len=5]\n")
+EVLOG_EVENT(EV_AMIGO_SEEK_LEN_6,                        "[AMIGO Seek len=6]\n")
+EVLOG_EVENT(EV_AMIGO_REQUEST_STATUS_BUFFERED_COMMAND,   "[AMIGO Request Status Buffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_READ_UNBUFFERED_COMMAND,           "[AMIGO Read Unbuffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_VERIFY,                            "[AMIGO Verify]\n")
+EVLOG_EVENT(EV_AMIGO_WRITE_UNBUFFERED_COMMAND,          "[AMIGO Write Unbuffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_INITIALIZE_COMMAND,                "[AMIGO Initialize Command]\n")
+EVLOG_EVENT(EV_AMIGO_REQUEST_LOGICAL_ADDRESS_COMMAND,   "[AMIGO Request Logical Address Command]\n")
+EVLOG_EVENT(EV_AMIGO_WRITE_BUFFERED_COMMAND,            "[AMIGO Write Buffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_REQUEST_STATUS_UNBUFFERED_COMMAND, "[AMIGO Request Status Unbuffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_READ_BUFFERED_COMMAND,             "[AMIGO Read Buffered Command]\n")
+EVLOG_EVENT(EV_AMIGO_FORMAT_COMMAND,                    "[AMIGO Format]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_LISTEN_TALK,               "[AMIGO Execute(%02lXH): listen:%02lXH, talk:%02lXH]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_COLD_LOAD_READ,            "[AMIGO Execute Cold Load Read]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_READ_UNBUFFERED,           "[AMIGO Execute Read Unbuffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_READ_BUFFERED,             "[AMIGO Execute Read Buffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_WRITE_UNBUFFERED,          "[AMIGO Execute Write Unbuffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_INITIALIZE,                "[AMIGO Execute Initialize]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_WRITE_BUFFERED,            "[AMIGO Execute Write Buffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_REQUEST_STATUS_BUFFERED,   "[AMIGO Execute Request Status Buffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_REQUEST_STATUS_UNBUFFERED, "[AMIGO Execute Request Status Unbuffered]\n")
+EVLOG_EVENT(EV_AMIGO_EXECUTE_REQUEST_LOGICAL_ADDRESS,   "[AMIGO Execute Request Logical Address]\n")
+EVLOG_EVENT(EV_EPPR_BIT_MASK,                           "[EPPR bit:%ld, mask:%02lXH]\n")
+EVLOG_EVENT(EV_DPPR_BIT_MASK,                           "[DPPR bit:%ld, mask:%02lXH]\n")
+EVLOG_EVENT(EV_PPR_PIN_DDR,                             "[PPR:%02lXH, PIN:%02lXH, DDR:%02lXH]\n")
@@ -28,6 +28,7 @@
 #include "fatfs.h"
 #include "posix.h"
 #include "debug.h"
+#include "evlog.h"
 
 /// - References: Documenation and related sources of information
 ///  - Web Resources:
@@ -163,6 +164,8 @@ void gpib_timer_reset( void )
 /// @return  void
 void gpib_timer_elapsed_end( char *msg)
 {
+// Show the deferred records that came before this timing line
+    evlog_flush();
 #ifdef SYSTEM_ELAPSED_TIMER
     clock_elapsed_end( msg );
 #else
@@ -422,8 +425,7 @@ void gpib_enable_PPR(int bit)
     }
     ppr_bit_set(bit);
 #if SDEBUG
-    if(debuglevel & GPIB_PPR)
-        printf("[EPPR bit:%d, mask:%02XH]\n",0xff & bit , 0xff & ppr_reg());
+    EVLOG(GPIB_PPR, EV_EPPR_BIT_MASK, 0xff & bit, 0xff & ppr_reg(), 0);
 #endif
 }
 
@@ -442,8 +444,7 @@ void gpib_disable_PPR(int bit)
     }
     ppr_bit_clr(bit);
 #if SDEBUG
-    if(debuglevel & GPIB_PPR)
-        printf("[DPPR bit:%d, mask:%02XH]\n",0xff & bit, 0xff & ppr_reg());
+    EVLOG(GPIB_PPR, EV_DPPR_BIT_MASK, 0xff & bit, 0xff & ppr_reg(), 0);
 #endif
 }
 
@@ -490,9 +491,7 @@ uint8_t gpib_detect_PP()
 ///@brief debugging - read the ddr data direction bits to determine read/write state
             ddr = GPIB_PPR_DDR_RD();
 #if SDEBUG
-            if(debuglevel & GPIB_PPR)
-                printf("[PPR:%02XH, PIN:%02XH, DDR:%02XH]\n",
-                    0xff & ppr_reg(), 0xff & pins, 0xff & ddr );
+            EVLOG(GPIB_PPR, EV_PPR_PIN_DDR, 0xff & ppr_reg(), 0xff & pins, 0xff & ddr);
 #endif
         }
 		// Wait for the PPR state to end as there is no handshake
@@ -504,7 +503,7 @@ uint8_t gpib_detect_PP()
 			{
 #if 0
 				if(debuglevel & GPIB_ERR)
-					printf("gpib_detect_PP: ATN=0 EOI=0\n");
+					EVLOG_PRINTF("gpib_detect_PP: ATN=0 EOI=0\n");
 #endif
 				break;
 			}
@@ -517,7 +516,7 @@ uint8_t gpib_detect_PP()
 				// So not needed here
 				// gpib_bus_init();
 				if(debuglevel & GPIB_ERR)
-					printf("gpib_detect_PP: IFC\n");
+					EVLOG_PRINTF("gpib_detect_PP: IFC\n");
                 break;
             }
         }
@@ -551,7 +550,7 @@ uint16_t gpib_unread(uint16_t ch)
     else
     {
         if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-            printf("gpib_unread: error, can only be called once!\n");
+            EVLOG_PRINTF("gpib_unread: error, can only be called once!\n");
     }
     return(ch);
 }
@@ -676,7 +675,7 @@ uint16_t gpib_write_byte(uint16_t ch)
 		{
 #if 0
 			if(debuglevel & GPIB_ERR)
-				printf("gpib_write_byte: KEY state=%d\n", tx_state);
+				EVLOG_PRINTF("gpib_write_byte: KEY state=%d\n", tx_state);
 #endif
 			break;
 		}
@@ -695,7 +694,7 @@ uint16_t gpib_write_byte(uint16_t ch)
             ch |= IFC_FLAG;
             gpib_bus_init();
 			if(debuglevel & GPIB_ERR)
-				printf("gpib_write_byte: IFC state=%d\n", tx_state);
+				EVLOG_PRINTF("gpib_write_byte: IFC state=%d\n", tx_state);
             break;
         }
 
@@ -724,7 +723,7 @@ uint16_t gpib_write_byte(uint16_t ch)
 					{
 #ifdef SDEBUG
 						if(debuglevel & GPIB_ERR)
-							printf("gpib_write_byte: ATN = 0 while waiting for NRFD LOW state =%d\n",tx_state);
+							EVLOG_PRINTF("gpib_write_byte: ATN = 0 while waiting for NRFD LOW state =%d\n",tx_state);
 #endif
 					}
 					break;
@@ -732,7 +731,7 @@ uint16_t gpib_write_byte(uint16_t ch)
                 if (gpib_timeout_test())
                 {
                     if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-                        printf("<gpib_write_byte timeout waiting for NRFD==1 && NDAC == 0>\n");
+                        EVLOG_PRINTF("<gpib_write_byte timeout waiting for NRFD==1 && NDAC == 0>\n");
                     ch |= TIMEOUT_FLAG;
                     tx_state = GPIB_TX_ERROR;
                     break;
@@ -765,7 +764,7 @@ uint16_t gpib_write_byte(uint16_t ch)
                 if (gpib_timeout_test())
                 {
                     if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-                        printf("<gpib_write_byte timeout waiting for NRFD==1 && NDAC == 0>\n");
+                        EVLOG_PRINTF("<gpib_write_byte timeout waiting for NRFD==1 && NDAC == 0>\n");
                     ch |= TIMEOUT_FLAG;
                     tx_state = GPIB_TX_ERROR;
                     break;
@@ -791,7 +790,7 @@ uint16_t gpib_write_byte(uint16_t ch)
                     ch |= TIMEOUT_FLAG;
                     tx_state = GPIB_TX_ERROR;
                     if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-                        printf("<gpib_write_byte timeout waiting for NDAC==1>\n");
+                        EVLOG_PRINTF("<gpib_write_byte timeout waiting for NDAC==1>\n");
                 }
                 break;
 
@@ -812,7 +811,7 @@ uint16_t gpib_write_byte(uint16_t ch)
 				// Free BUS, BUSY on error
                 gpib_rx_init(1);
                 if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-                    printf("<GPIB TX TIMEOUT>\n");
+                    EVLOG_PRINTF("<GPIB TX TIMEOUT>\n");
                 tx_state = GPIB_TX_DONE;
                 break;
 
@@ -917,14 +916,16 @@ uint16_t gpib_read_byte(int trace)
     while(rx_state != GPIB_RX_DONE)
     {
 
-        // User task that is called while waiting for commands
-        gpib_user_task();
+        // User tasks run only while NRFD is still LOW from the previous
+        // byte and holds off the talker, never once NRFD has been released
+        if(rx_state == GPIB_RX_START)
+            gpib_user_task();
 
         if(uart_keyhit(0))
 		{
 #if 0
 			if(debuglevel & GPIB_ERR)
-				printf("gpib_read_byte: state=%d\n", rx_state);
+				EVLOG_PRINTF("gpib_read_byte: state=%d\n", rx_state);
 #endif
             break;
 		}
@@ -942,7 +943,7 @@ uint16_t gpib_read_byte(int trace)
         {
             ch |= IFC_FLAG;
 			if(debuglevel & GPIB_ERR)
-				printf("gpib_read_byte: IFC state=%d\n", rx_state);
+				EVLOG_PRINTF("gpib_read_byte: IFC state=%d\n", rx_state);
             gpib_bus_init();
             break;
         }
@@ -960,6 +961,13 @@ uint16_t gpib_read_byte(int trace)
 					GPIB_BUS_SETTLE();                // Let Data BUS settle
 					rx_state = GPIB_RX_WAIT_FOR_DAV_LOW;
 				}
+				// A talker that set DAV while we held NRFD LOW
+				else
+				{
+					GPIB_BUS_SETTLE();
+					rx_state = GPIB_RX_DAV_IS_LOW;
+					break;
+				}
                 if (gpib_timeout_test())
                 {
                     ch |= TIMEOUT_FLAG;
@@ -1314,7 +1322,7 @@ int gpib_read_str(uint8_t *buf, int size, uint16_t *status)
     if(!size)
     {
         if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES + GPIB_RW_STR_BUS_DECODE))
-            printf("gpib_read_str: size = 0\n");
+            EVLOG_PRINTF("gpib_read_str: size = 0\n");
     }
 
     while(ind < size)
@@ -1333,7 +1341,7 @@ int gpib_read_str(uint8_t *buf, int size, uint16_t *status)
         if((*status & ATN_FLAG) != (val & ATN_FLAG))
         {
             if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES + GPIB_RW_STR_BUS_DECODE))
-                printf("gpib_read_str(ind:%d): ATN %02XH unexpected\n",ind, 0xff & val);
+                EVLOG_PRINTF("gpib_read_str(ind:%d): ATN %02XH unexpected\n",ind, 0xff & val);
             gpib_unread(val);
             break;
         }
@@ -1358,7 +1366,7 @@ int gpib_read_str(uint8_t *buf, int size, uint16_t *status)
     if ( ind != size ) 
     {
         if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
-            printf("[gpib_read_str read(%d) expected(%d)]\n", ind , size);
+            EVLOG_PRINTF("[gpib_read_str read(%d) expected(%d)]\n", ind , size);
     }
     return(ind);
 }
@@ -1403,7 +1411,7 @@ int gpib_write_str(uint8_t *buf, int size, uint16_t *status)
     if(!size)
     {
         if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES + GPIB_RW_STR_BUS_DECODE))
-            printf("gpib_write_str: size = 0\n");
+            EVLOG_PRINTF("gpib_write_str: size = 0\n");
     }
 
 	// Start with NRFD and NDAC = 1 - ie off the OC BUS
@@ -1430,7 +1438,7 @@ int gpib_write_str(uint8_t *buf, int size, uint16_t *status)
 			{
 				gpib_rx_init(1);
 				if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-					printf("<gpib_write_str timeout waiting for ATN = 1>\n");
+					EVLOG_PRINTF("<gpib_write_str timeout waiting for ATN = 1>\n");
 				*status |= (TIMEOUT_FLAG | BUS_ERROR_FLAG);
 				return(ind);
 			}
@@ -1447,7 +1455,7 @@ int gpib_write_str(uint8_t *buf, int size, uint16_t *status)
 		if(gpib_timeout_test())
 		{
 			if(debuglevel & (GPIB_ERR + GPIB_BUS_OR_CMD_BYTE_MESSAGES))
-				printf("<BUS waiting for DAV==1>\n");
+				EVLOG_PRINTF("<BUS waiting for DAV==1>\n");
 			*status |= (TIMEOUT_FLAG | BUS_ERROR_FLAG);
 			return(ind);
 		}
@@ -1484,7 +1492,7 @@ int gpib_write_str(uint8_t *buf, int size, uint16_t *status)
     if ( ind != size )
     {
         if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES + GPIB_RW_STR_BUS_DECODE))
-            printf("[gpib_write_str sent(%d) expected(%d)]\n", ind,size);
+            EVLOG_PRINTF("[gpib_write_str sent(%d) expected(%d)]\n", ind,size);
     }
     return(ind);
 }
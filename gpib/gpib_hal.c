@@ -18,6 +18,8 @@
 #include "posix.h"
 #include "defines.h"
 #include "debug.h"
+#include "sparse.h"
+#include "zimage.h"
 
 gpib_t gpib_timer;
 
@@ -298,9 +300,52 @@ FRESULT dbf_close (FIL* fp)
 }
 
 
+/// @brief Find the disk image format of a device file.
+///
+/// - Needs an extra open and read, so the result is kept in the device
+///   HEADER.FORMAT when the device is mounted or formatted.
+///
+/// @param[in] name: File name.
+///
+/// @return DBF_FLAT, DBF_SPARSE or DBF_COMPRESSED.
+/// @return DBF_UNKNOWN if the file can not be opened.
+
+uint8_t dbf_format(char *name)
+{
+    int rc;
+
+    rc = sparse_check(name);
+    if(rc < 0)
+        return(DBF_UNKNOWN);
+    if(rc == 1)
+        return(DBF_SPARSE);
+    if(zimage_check(name) == 1)
+        return(DBF_COMPRESSED);
+    return(DBF_FLAT);
+}
+
+
+/// @brief Forget cached data of a device file.
+///
+/// - Must be called before a device file name is freed or the file is replaced.
+///
+/// @param[in] name: File name pointer, NULL forgets all.
+///
+/// @return  void
+
+void dbf_forget(char *name)
+{
+    zimage_forget(name);
+}
+
+
 /// @brief Open, Seek, Read data and Close FatFs functions.
 ///
+/// - Sparse images are mapped through their allocation bitmap.
+/// - Compressed images are decoded one group at a time.
+///
 /// @param[in] name: File name to open.
+/// @param[in,out] format: device image format, see dbf_format(), set if DBF_UNKNOWN.
 /// @param[in] pos: file offset.
 /// @param[out] buff: buffer to read data into.
 /// @param[in] size: bytes to read.
@@ -311,13 +356,43 @@ FRESULT dbf_close (FIL* fp)
 /// @see: ff.h.
 /// @return  FRESULT
 
-int dbf_open_read(char *name, uint32_t pos, void *buff, int size, int *errors)
+int dbf_open_read(char *name, uint8_t *format, uint32_t pos, void *buff, int size, int *errors)
 {
     int rc;
     FIL fp;
     int flags = 0;
     UINT bytes = 0;
 
+// The file was missing when the device was mounted
+    if(*format == DBF_UNKNOWN)
+        *format = dbf_format(name);
+
+    if(*format == DBF_SPARSE)
+    {
+        rc = sparse_open_read(name, pos, buff, size);
+        if(rc != size)
+        {
+            flags |= ERR_DISK;
+            flags |= ERR_READ;
+            *errors = flags;
+            return( -1 );
+        }
+        return(rc);
+    }
+
+    if(*format == DBF_COMPRESSED)
+    {
+        rc = zimage_open_read(name, pos, buff, size);
+        if(rc != size)
+        {
+            flags |= ERR_DISK;
+            flags |= ERR_READ;
+            *errors = flags;
+            return( -1 );
+        }
+        return(rc);
+    }
+
     rc = dbf_open(&fp, name, FA_OPEN_EXISTING | FA_READ | FA_WRITE);
     if( rc != FR_OK)
     {
@@ -366,7 +441,11 @@ int dbf_open_read(char *name, uint32_t pos, void *buff, int size, int *errors)
 
 /// @brief Open, Seek, Write data and Close FatFs functions.
 ///
+/// - Sparse images allocate blocks on first write.
+/// - Compressed images are read only.
+///
 /// @param[in] name: File name to open.
+/// @param[in,out] format: device image format, see dbf_format(), set if DBF_UNKNOWN.
 /// @param[in] pos: file offset.
 /// @param[in] buff: buffer to write.
 /// @param[in] size: bytes to write.
@@ -376,13 +455,40 @@ int dbf_open_read(char *name, uint32_t pos, void *buff, int size, int *errors)
 /// @return -1 on error.
 /// @see: ff.h.
 /// @return  FRESULT
-int dbf_open_write(char *name, uint32_t pos, void *buff, int size, int *errors)
+int dbf_open_write(char *name, uint8_t *format, uint32_t pos, void *buff, int size, int *errors)
 {
     int rc;
     FIL fp;
     int flags = 0;
     UINT bytes = 0;
 
+// The file was missing when the device was mounted
+    if(*format == DBF_UNKNOWN)
+        *format = dbf_format(name);
+
+    if(*format == DBF_SPARSE)
+    {
+        rc = sparse_open_write(name, pos, buff, size);
+        if(rc != size)
+        {
+            flags |= ERR_DISK;
+            flags |= ERR_WRITE;
+            *errors = flags;
+            return( -1 );
+        }
+        return(rc);
+    }
+
+    if(*format == DBF_COMPRESSED)
+    {
+        if(debuglevel & GPIB_ERR)
+            printf("Write error: [%s] compressed images are read only\n", name);
+        flags |= ERR_WP;
+        flags |= ERR_WRITE;
+        *errors = flags;
+        return( -1 );
+    }
+
     rc = dbf_open(&fp, name, FA_OPEN_EXISTING | FA_READ | FA_WRITE);
     if( rc != FR_OK)
     {
@@ -32,6 +32,12 @@ typedef struct _gpib_t
 } gpib_t;
 
 extern gpib_t gpib_timer;
+
+///@brief Disk image formats, see dbf_format()
+#define DBF_UNKNOWN 0                             /* Not checked yet or missing file */
+#define DBF_FLAT   1                              /* Plain sector image */
+#define DBF_SPARSE 2                              /* Sparse image, see sparse.h */
+#define DBF_COMPRESSED 3                          /* Read only compressed image, see zimage.h */
 void gpib_clock_task( void );
 
 ///  Notes:
@@ -201,6 +207,8 @@ FRESULT dbf_read ( FIL *fp , void *buff , UINT btr , UINT *br );
 FRESULT dbf_write ( FIL *fp , const void *buff , UINT btw , UINT *bw );
 FRESULT dbf_lseek ( FIL *fp , DWORD ofs );
 FRESULT dbf_close ( FIL *fp );
-int dbf_open_read ( char *name , uint32_t pos , void *buff , int size , int *errors );
-int dbf_open_write ( char *name , uint32_t pos , void *buff , int size , int *errors );
+uint8_t dbf_format ( char *name );
+void dbf_forget ( char *name );
+int dbf_open_read ( char *name , uint8_t *format , uint32_t pos , void *buff , int size , int *errors );
+int dbf_open_write ( char *name , uint8_t *format , uint32_t pos , void *buff , int size , int *errors );
 #endif                                            // #ifndef _GPIB_HAL_H_
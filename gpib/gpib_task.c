@@ -35,18 +35,31 @@ int debuglevel = 1;
 /// @brief GPIB log file handel
 FILE *gpib_log_fp = NULL;
 
+///@brief uptime_ms() when one of our devices was first addressed, 0 = not yet
+static uint32_t gpib_first_ms = 0;
+///@brief gpib_first_ms has been displayed
+static uint8_t gpib_first_shown = 0;
+
 ///@brief Read Configuration File
+/// Uses the binary snapshot of the configuration when hpdisk.cfg is unchanged
 void gpib_file_init()
 {
-    int errors;
+    int errors = 0;
+    uint32_t start = uptime_ms();
 
     debuglevel = 0;
 
-    errors = Read_Config(cfgfile);
-    if(errors > 0)
-        printf("%s had %d errors\n", cfgfile, errors);
-    if(errors < 0)
-        printf("%s open failure\n", cfgfile);
+    if(!Load_Config_Snapshot(cfgfile))
+    {
+        errors = Read_Config(cfgfile);
+        if(errors > 0)
+            printf("%s had %d errors\n", cfgfile, errors);
+        if(errors < 0)
+            printf("%s open failure\n", cfgfile);
+        if(errors == 0)
+            Save_Config_Snapshot(cfgfile);
+    }
+    printf("Configuration time: %ld ms\n", (long) (uptime_ms() - start));
 
 ///@brief set any compile time defaults - but only those NOT already set by the config file
     set_Config_Defaults();
@@ -56,6 +69,29 @@ void gpib_file_init()
 }
 
 
+/// @brief  Record the time one of our devices was first addressed
+/// Called from the *_is_MLA, *_is_MTA and *_is_MSA tests when they match
+/// @return  void
+void gpib_boot_time()
+{
+    if(!gpib_first_ms)
+        gpib_first_ms = uptime_ms() | 1;
+}
+
+
+/// @brief  Display the time from reset to the first GPIB response
+/// Called from gpib_user_task() so the display does not delay the response
+/// @return  void
+void gpib_boot_report()
+{
+    if(!gpib_first_ms || gpib_first_shown)
+        return;
+    gpib_first_shown = 1;
+    printf("First GPIB response: %ld ms after timer start, %ld ms after reset\n",
+        (long) gpib_first_ms, (long) gpib_first_ms + GPIB_BOOT_DELAY_MS);
+}
+
+
 /// @brief  Log GPIB transactions
 ///
 /// @param str: message to log
@@ -76,6 +112,7 @@ int SS80_is_MLA(int address)
     int index = find_device(SS80_TYPE, address, BASE_MLA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -89,6 +126,7 @@ int SS80_is_MTA(int address)
     int index = find_device(SS80_TYPE, address, BASE_MTA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -102,6 +140,7 @@ int SS80_is_MSA(int address)
     int index = find_device(SS80_TYPE, address, BASE_MSA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -116,6 +155,7 @@ int AMIGO_is_MLA(int address)
     int index = find_device(AMIGO_TYPE, address, BASE_MLA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -129,6 +169,7 @@ int AMIGO_is_MTA(int address)
     int index = find_device(AMIGO_TYPE, address, BASE_MTA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -142,6 +183,7 @@ int AMIGO_is_MSA(int address)
     int index = find_device(AMIGO_TYPE, address, BASE_MSA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 #endif                                            // #ifdef AMIGO
@@ -155,6 +197,7 @@ int PRINTER_is_MLA(int address)
     int index = find_device(PRINTER_TYPE, address, BASE_MLA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -168,6 +211,7 @@ int PRINTER_is_MTA(int address)
     int index = find_device(PRINTER_TYPE, address, BASE_MTA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -181,6 +225,7 @@ int PRINTER_is_MSA(int address)
     int index = find_device(PRINTER_TYPE, address, BASE_MSA);
     if(index == -1)
         return(0);
+    gpib_boot_time();
     return(set_active_device(index));
 }
 
@@ -351,7 +396,7 @@ void gpib_init_devices(void)
     amigo_init();                                 // AMIGO state init
 #endif
 
-    printer_close();                              // Close any open fprinter files
+    printer_close_all();                          // Close any open fprinter files
 }
 
 
@@ -543,7 +588,7 @@ void gpib_task(void)
         {
             if ( PRINTER_is_MLA(listening) )
             {
-                printer_buffer( 0xff & val );
+                printer_buffer( PRINTERs, 0xff & val );
                 continue;
             }
 
@@ -713,8 +758,7 @@ int GPIB(uint8_t ch)
         amigo_cmd_clear();
 #endif
 
-/// @todo Fixme
-        printer_close();
+        printer_close_all();
         return( 0 );
     }
 
@@ -785,9 +829,8 @@ int GPIB_LISTEN(uint8_t ch)
 #endif
         if(talking != UNT)
         {
-///@brief NULL creates a file named based on date and time
-// FIXME use printer structure to permit multiple printers
-            printer_open(NULL);
+///@brief NULL creates a file named based on date, time and address
+            printer_open(PRINTERs, PRINTERp->HEADER.ADDRESS, NULL);
         }
         return(0);
     }
@@ -866,7 +909,7 @@ int GPIB_TALK(uint8_t ch)
     {
         if(debuglevel & (GPIB_BUS_OR_CMD_BYTE_MESSAGES + GPIB_DEVICE_STATE_MESSAGES))
             printf("[PRINTER OPEN]\n");
-        printer_open(NULL);
+        printer_open(PRINTERs, PRINTERp->HEADER.ADDRESS, NULL);
         return(0);
     }
 
@@ -945,11 +988,10 @@ void listen_cleanup()
         if(index == -1)
             return;
 
-//We should not set the active device globally
-//FIXME if we have to then printer close should temprarily do so
+// The file stays open for PRINTER_CLOSE_MS so plots to several printers can interleave
         if(debuglevel & (GPIB_BUS_OR_CMD_BYTE_MESSAGES + GPIB_DEVICE_STATE_MESSAGES))
-            printf("[PRINTER close]\n");
-        printer_close();
+            printf("[PRINTER unlisten]\n");
+        printer_unlisten((PRINTERStateType *) Devices[index].state);
     }
 }
 
@@ -18,8 +18,13 @@
 #include <user_config.h>
 #include "drives.h"
 
+///@brief Power up delay in main() before the timers start, see uptime_ms()
+#define GPIB_BOOT_DELAY_MS 200
+
 /* gpib_task.c */
 void gpib_file_init ( void );
+void gpib_boot_time ( void );
+void gpib_boot_report ( void );
 void gpib_log ( char *str );
 int SS80_is_MLA ( int address );
 int SS80_is_MTA ( int address );
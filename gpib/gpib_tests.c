@@ -25,6 +25,7 @@
 #include "printer.h"
 #include "lifutils.h"
 #include "debug.h"
+#include "evlog.h"
 
 /// @brief
 ///  Help Menu for User invoked GPIB functions and tasks
@@ -39,6 +40,10 @@ void gpib_help(int full)
             "gpib debug N\n"
             "   debug message reporting see hpdisk.cfg for details\n"
             "gpib elapsed\n"
+            "gpib evlog [text|raw|hold|direct|dump|clear|list]\n"
+            "   deferred debug messages, default text\n"
+            "   error and timing messages print the saved records first\n"
+            "   raw - E,id,ms,arg1,arg2,arg3 records, see list\n"
             "gpib elapsed_reset\n"
             "gpib ifc\n"
             "gpib task\n"
@@ -92,6 +97,28 @@ int gpib_tests(int argc, char * argv[])
         return(1);
     }
 
+    if (MATCHI(ptr,"evlog") )
+    {
+        ptr = argv[ind];
+        if(!ptr || MATCHI(ptr,"text"))
+            evlog_mode(EVLOG_TEXT);
+        else if(MATCHI(ptr,"raw"))
+            evlog_mode(EVLOG_RAW);
+        else if(MATCHI(ptr,"hold"))
+            evlog_mode(EVLOG_HOLD);
+        else if(MATCHI(ptr,"direct"))
+            evlog_mode(EVLOG_DIRECT);
+        else if(MATCHI(ptr,"dump"))
+            printf("evlog: %d records\n", evlog_dump());
+        else if(MATCHI(ptr,"clear"))
+            evlog_clear();
+        else if(MATCHI(ptr,"list"))
+            evlog_list();
+        else
+            printf("evlog: unknown option %s\n", ptr);
+        return(1);
+    }
+
     if (MATCHI(ptr,"elapsed_reset") )
     {
         gpib_timer_elapsed_begin();
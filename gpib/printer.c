@@ -26,36 +26,192 @@
 #include "delay.h"
 #include "debug.h"
 
-///@brief Plotter file data structure used for saving plot data.
-PRINTERStateType plot = { 0 };
-
 ///@brief Plotter GPIB test vector.
 uint8_t plot_str[] = { 0x3f, 0x5f, 0x47, 0x21 };
 
+///@brief Millisecond tick counter, see printer_timer_task()
+static volatile uint16_t printer_ms = 0;
+///@brief printer_ticks() when any printer last received a byte
+static uint16_t printer_last = 0;
+///@brief Number of open plot captures
+static uint8_t printer_active = 0;
+
+///@brief Spool pool shared by all printers, one slot per printer
+static char *printer_pool = NULL;
+static uint16_t printer_slot_size = 0;
+static uint8_t printer_slots = 0;
+static uint16_t printer_slot_used = 0;
+
+/// @brief  Printer timer task, millisecond tick counter
+///
+/// - Called every millisecond by the system timer interrupt
+/// @return  void
+
+void printer_timer_task()
+{
+    printer_ms++;
+}
+
+
+/// @brief  Read the printer millisecond tick counter
+/// @return  ticks, differences are valid for about 65 seconds
+uint16_t printer_ticks()
+{
+    uint16_t ticks;
+    uint8_t sreg = SREG;
+
+    cli();
+    ticks = printer_ms;
+    SREG = sreg;
+    return(ticks);
+}
+
+
+/// @brief  Allocate the spool pool shared by all printers
+///
+/// - The pool is split into one slot per PRINTER device
+/// - Sized to free RAM less PRINTER_RAM_RESERVE, at most PRINTER_POOL_SIZE
+/// - Slots are whole sectors, at most PRINTER_SPOOL_SIZE
+/// @return  1 on success, 0 on error
+
+static int printer_pool_alloc()
+{
+    int8_t i;
+    uint8_t printers = 0;
+    size_t size;
+
+    if(printer_pool)
+        return(1);
+
+    for(i=0;i<MAX_DEVICES;++i)
+    {
+        if(Devices[i].TYPE == PRINTER_TYPE)
+            ++printers;
+    }
+    if(printers == 0)
+        printers = 1;
+    if(printers > 16)
+        printers = 16;
+
+    size = freeRam();
+    size = (size > PRINTER_RAM_RESERVE) ? (size - PRINTER_RAM_RESERVE) : 0;
+    if(size > PRINTER_POOL_SIZE)
+        size = PRINTER_POOL_SIZE;
+
+    size = (size / printers) & ~((size_t) PRINTER_SECTOR - 1);
+    if(size > PRINTER_SPOOL_SIZE)
+        size = PRINTER_SPOOL_SIZE;
+    if(size < PRINTER_SECTOR)
+    {
+        if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
+            printf("printer_pool_alloc: not enough free memory for %d printers\n", (int) printers);
+        return(0);
+    }
+
+    printer_pool = safecalloc(size * printers, 1);
+    if(printer_pool == NULL)
+        return(0);
+    printer_slot_size = size;
+    printer_slots = printers;
+    printer_slot_used = 0;
+
+    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
+        printf("Plot spool pool: %d x %u bytes\n", (int) printers, (unsigned) size);
+    return(1);
+}
+
+
+/// @brief  Give a printer a spool slot from the pool
+/// @param[in] *P: printer state
+/// @return  1 on success, 0 on error
+
+static int printer_slot_get(PRINTERStateType *P)
+{
+    uint8_t i;
+
+    if(!printer_pool_alloc())
+        return(0);
+
+    for(i=0;i<printer_slots;++i)
+    {
+        if(!(printer_slot_used & (1U << i)))
+        {
+            printer_slot_used |= (1U << i);
+            P->slot = i;
+            P->q.buf = printer_pool + (size_t) i * printer_slot_size;
+            P->q.size = printer_slot_size;
+            queue_flush(&P->q);
+            return(1);
+        }
+    }
+    if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
+        printf("printer_slot_get: all %d spool slots in use\n", (int) printer_slots);
+    return(0);
+}
+
+
+/// @brief  Return a printer spool slot, frees the pool after the last one
+/// @param[in] *P: printer state
+/// @return  void
+
+static void printer_slot_put(PRINTERStateType *P)
+{
+    if(P->q.buf == NULL)
+        return;
+
+    printer_slot_used &= ~(1U << P->slot);
+    P->q.buf = NULL;
+    P->q.size = 0;
+
+    if(printer_slot_used == 0 && printer_pool)
+    {
+        safefree(printer_pool);
+        printer_pool = NULL;
+        printer_slots = 0;
+        printer_slot_size = 0;
+    }
+}
+
+
 /// @brief  Open a file to receive plot data using POSIX functions.
 ///
 /// - Uses POSIX FatFs wrappers.
+/// - Each printer address has its own state, file and spool.
+/// - If the capture is still open, after an unlisten, it continues.
 ///
+/// @param[in] *P: printer state, see set_active_device()
+/// @param[in] address: printer GPIB address, used in the file name
+/// @param[in] *name: file name or NULL to use the date, time and address
 /// @see posix.c
 /// @see posix.h
 /// @return  void
 
-void printer_open(char *name)
+void printer_open(PRINTERStateType *P, uint8_t address, char *name)
 {
 
     char *ptr;
+    char fname[64];
+
+    if(P == NULL)
+        return;
+
+    if(P->fp)
+    {
+        P->unlistened = 0;
+        return;
+    }
 
     if(!name)
     {
         time_t seconds;
         tm_t *tc;
         ts_t ts;
-        char fname[64];
 
         clock_gettime(0, (ts_t *) &ts);
         seconds = ts.tv_sec;
         tc = gmtime(&seconds);
-        sprintf(fname,"/plot-%02d%s%04d-%02d%02d%02d.plt",
+        sprintf(fname,"/plot%d-%02d%s%04d-%02d%02d%02d.plt",
+            (int) address,
             tc->tm_mday,
             tm_mon_to_ascii(tc->tm_mon),
             tc->tm_year + 1900,
@@ -72,148 +228,325 @@ void printer_open(char *name)
     if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
         printf("Capturing plot to:%s\n", ptr);
 
-    plot.fp = fopen(ptr,"wb");
-    if(plot.fp == NULL)
+    printer_state_clear(P);
+    if(!printer_slot_get(P))
+        return;
+
+    P->fp = fopen(ptr,"wb");
+    if(P->fp == NULL)
     {
         if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
         {
             perror("open failed");
             printf("exiting...\n");
         }
+        printer_slot_put(P);
         return;
     }
+    P->address = address;
+    P->last = printer_ticks();
+    P->synced = P->last;
+    ++printer_active;
+}
 
-    plot.buf = calloc(512+1,1);
-    if(plot.buf == NULL)
-        printer_close();
-    plot.size = 512;
+
+/// @brief  Clear plotter state and counters
+/// @param[in] *P: printer state
+/// @return  void
+
+void printer_state_clear(PRINTERStateType *P)
+{
+    memset(P, 0, sizeof(PRINTERStateType));
 }
 
 
 /// @brief  Initialize plotter structures and state.
 ///
 /// - Only called once after power on by main().
+/// - Printer states are allocated with the PRINTER device, see alloc_device()
 /// @return  void
 
 void printer_init()
 {
-    plot.error = 0;
-    plot.count = 0;
-    plot.ind = 0;
-    plot.fp = NULL;
-    plot.buf = NULL;
+    if(set_timers(printer_timer_task,1) == -1)
+        printf("Printer timer task init failed\n");
 }
 
 
-/// @brief  Close current plot file and reset states.
+/// @brief  Close a plot file and reset states.
 ///
 /// - Verify that polt file is open before attempting close.
 /// - Uses POSIX FatFs wrappers.
 ///
+/// @param[in] *P: printer state
 /// @see posix.c
 /// @see posix.h
 /// @return  void
 /// FYI: for the HP54645D plots end with: pd;pu;pu;sp0;
 /// This gets called
-void printer_close()
+void printer_close(PRINTERStateType *P)
 {
-    if( receive_plot_flush() < 0 )
-        plot.error = 1;
+    if(P == NULL)
+        return;
+
+    if( receive_plot_flush(P) < 0 )
+        P->error = 1;
 
     if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
     {
-        if(plot.error)
+        if(P->error)
             printf("ERROR durring write\n");
+        if(P->overflow)
+            printf("ERROR spool overflow, lost: %ld bytes\n", (long) P->overflow);
     }
 
-    if(plot.fp)
+    if(P->fp)
     {
-        fclose(plot.fp);
+        fclose(P->fp);
+        if(printer_active)
+            --printer_active;
         if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("\nDONE: %08ld\n",plot.count);
+        {
+            printf("\nDONE: %08ld, printer: %d\n",P->count, (int) P->address);
+            printf("Spool writes: %ld, stalls: %u, peak: %u bytes\n",
+                (long) P->writes, (unsigned) P->stalls, (unsigned) P->peak);
+        }
     }
 
-    if(plot.buf)
-        safefree(plot.buf);
-    printer_init();
+    printer_slot_put(P);
+    printer_state_clear(P);
+}
+
+
+/// @brief  Close all plot files
+///
+/// - Used at power up, Bus IFC, device clear or user aborts
+/// @return  void
+void printer_close_all()
+{
+    int8_t i;
+
+    for(i=0;i<MAX_DEVICES;++i)
+    {
+        if(Devices[i].TYPE == PRINTER_TYPE)
+            printer_close((PRINTERStateType *) Devices[i].state);
+    }
 }
 
 
-/// @brief Write Plotter data and flush.
+/// @brief  Printer was unlistened
 ///
+/// - The file is closed by printer_task() after PRINTER_CLOSE_MS without data
+/// so several instruments plotting to different printers can take turns
+/// on the bus without splitting their plots into many files.
+/// @param[in] *P: printer state
+/// @return  void
+void printer_unlisten(PRINTERStateType *P)
+{
+    if(P == NULL || P->fp == NULL)
+        return;
+    P->unlistened = 1;
+}
+
+
+/// @brief Write spooled Plotter data to the plot file
+///
+/// - Writes whole sectors directly from the spool ring buffer.
+/// - The spool size is a multiple of the sector size so writes stay aligned.
+/// - A partial sector written by receive_plot_flush() leaves the spool
+/// unaligned, the short run up to the end of the ring is then written so
+/// the next write starts on a sector boundary again.
 /// - Uses POSIX FatFs wrappers.
 ///
+/// @param[in] *P: printer state
+/// @param[in] all: 0 = whole sectors only, 1 = also write any partial sector
 /// @see posix.c
 /// @see posix.h
 /// @see printer_buffer()
-/// @return  file handle
+/// @return  bytes written, -1 on error
 
-int receive_plot_flush()
+int printer_spool_write(PRINTERStateType *P, int all)
 {
+    uint8_t *ptr;
+    size_t len;
     int ret;
-    int fno;
+    int total = 0;
 
-    if(plot.fp == NULL || plot.ind == 0)
+    if(P == NULL || P->fp == NULL)
         return(0);
 
-    ret  = fwrite(plot.buf, 1, plot.ind , plot.fp);
-    if(ret != plot.ind)
+    while(1)
     {
-        if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
+        len = queue_contiguous(&P->q, &ptr);
+        if(len > PRINTER_SECTOR)
+            len = PRINTER_SECTOR;
+        if(len == 0)
+            break;
+// A short run that does not end at the ring wrap point waits for more data
+        if(len < PRINTER_SECTOR && !all && len == queue_used(&P->q))
+            break;
+
+        ret = fwrite(ptr, 1, len, P->fp);
+        if(ret != (int) len)
         {
-            perror("receive_plot_flush");
-            printf("write failed: wanted %d, got:%d\n", plot.ind, ret);
+            if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
+            {
+                perror("printer_spool_write");
+                printf("write failed: wanted %d, got:%d\n", (int) len, ret);
+            }
+            return(-1);
         }
-        return(-1);
+        queue_drop(&P->q, len);
+        P->writes++;
+        P->dirty = 1;
+        total += len;
     }
+    return(total);
+}
+
+
+/// @brief Write all spooled Plotter data and sync the file system.
+///
+/// - Uses POSIX FatFs wrappers.
+///
+/// @param[in] *P: printer state
+/// @see posix.c
+/// @see posix.h
+/// @see printer_buffer()
+/// @return  bytes written, -1 on error
+
+int receive_plot_flush(PRINTERStateType *P)
+{
+    int ret;
+    int fno;
+
+    if(P == NULL || P->fp == NULL)
+        return(0);
+
+    ret = printer_spool_write(P, 1);
+    if(ret < 0)
+        return(-1);
 
-    fno = fileno( plot.fp );
+    if(!P->dirty)
+        return(ret);
+
+    fno = fileno( P->fp );
     if(fno < 0)
         return(-1);
-///@brief sync filesystem after every write
     syncfs( fno );
+    P->dirty = 0;
+    P->synced = printer_ticks();
     return (ret);
 }
 
 
-/// @brief  Buffer Plotter data and flush when buffer is full
+/// @brief  Write spooled Plotter data while the printers are idle
 ///
-/// - Uses POSIX FatFs wrappers.
+/// - Called from the GPIB read loop, see gpib_user_task().
+/// - Nothing is written until no printer has received a byte for PRINTER_IDLE_MS.
+/// - Whole sectors are written first, one printer per call.
+/// - syncfs only runs PRINTER_SYNC_MS after the last syncfs, or at plot close.
+/// - Unlistened printers are closed after PRINTER_CLOSE_MS without data.
+/// @return  void
+
+void printer_task()
+{
+    int8_t i;
+    uint16_t now;
+    PRINTERStateType *P;
+
+    if(!printer_active)
+        return;
+
+    now = printer_ticks();
+    if((uint16_t)(now - printer_last) < PRINTER_IDLE_MS)
+        return;
+
+    for(i=0;i<MAX_DEVICES;++i)
+    {
+        if(Devices[i].TYPE != PRINTER_TYPE)
+            continue;
+        P = (PRINTERStateType *) Devices[i].state;
+        if(P == NULL || P->fp == NULL)
+            continue;
+
+        if(P->unlistened && (uint16_t)(now - P->last) >= PRINTER_CLOSE_MS)
+        {
+            if(debuglevel & (GPIB_BUS_OR_CMD_BYTE_MESSAGES + GPIB_DEVICE_STATE_MESSAGES))
+                printf("[PRINTER close]\n");
+            printer_close(P);
+            return;
+        }
+
+        if(queue_used(&P->q) >= PRINTER_SECTOR)
+        {
+            if(printer_spool_write(P, 0) < 0)
+                P->error = 1;
+            return;
+        }
+
+        if((uint16_t)(now - P->synced) >= PRINTER_SYNC_MS && (P->dirty || !queue_empty(&P->q)))
+        {
+            if(receive_plot_flush(P) < 0)
+                P->error = 1;
+            return;
+        }
+    }
+}
+
+
+/// @brief  Buffer Plotter data in the printer spool
 ///
-/// @see posix.c
-/// @see posix.h
+/// - Bytes are only written to the file here when the spool
+/// reaches PRINTER_HIGH_WATER, otherwise printer_task() writes them.
+/// - Bytes that do not fit are counted in P->overflow.
+/// @param[in] *P: printer state, see set_active_device()
+/// @param[in] val: data byte and control flags
+/// @see printer_task()
 /// @return  void
-void printer_buffer( uint16_t val )
+void printer_buffer( PRINTERStateType *P, uint16_t val )
 {
 
     uint16_t ch;
+    size_t used;
+
+    if(P == NULL || P->q.buf == NULL)
+        return;
+
+    P->last = printer_ticks();
+    printer_last = P->last;
 
     if(debuglevel & (GPIB_ERR + GPIB_DEVICE_STATE_MESSAGES))
     {
-        if( ( plot.count & 255L ) == 0)
-            printf("%08ld\r",plot.count);
+        if( ( P->count & 255L ) == 0)
+            printf("%08ld\r",P->count);
     }
 
-    ch = val & 0xff;
     if(val & (0xff00 & ~REN_FLAG))
     {
-        if( receive_plot_flush() )
-            plot.error = 1;
+// End of message, let printer_task() write the spool right away
+        printer_last = P->last - PRINTER_IDLE_MS;
 
-//fprintf(plot.fp,"%s\n", ptr);
-//plot.count += strlen(ptr);
+//fprintf(P->fp,"%s\n", ptr);
+//P->count += strlen(ptr);
     }
     else
     {
         ch  = val & 0xff;
-        plot.buf[plot.ind++] = ch;
-        plot.count++;
+        if(queue_pushc(&P->q, ch))
+            P->count++;
+        else
+            P->overflow++;
+
+        used = queue_used(&P->q);
+        if(used > P->peak)
+            P->peak = used;
 
-        if(plot.ind >= plot.size)
+        if(used >= PRINTER_HIGH_WATER(P->q.size))
         {
-            if( receive_plot_flush() < 0 )
-                plot.error = 1;
-            plot.ind  = 0;
+            P->stalls++;
+            if( printer_spool_write(P, 0) < 0 )
+                P->error = 1;
         }
     }
 }
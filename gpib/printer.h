@@ -16,13 +16,44 @@
 #define _PRINTER_H
 
 #include <user_config.h>
+#include "drives.h"
+
+///@brief Largest spool per printer
+/// Multiples of PRINTER_SECTOR keep spool writes on sector boundaries
+#ifndef PRINTER_SPOOL_SIZE
+#define PRINTER_SPOOL_SIZE 4096
+#endif
+///@brief Largest spool pool shared by all printers
+#ifndef PRINTER_POOL_SIZE
+#define PRINTER_POOL_SIZE 8192
+#endif
+///@brief Free memory the spool pool leaves for the stack and other users
+#ifndef PRINTER_RAM_RESERVE
+#define PRINTER_RAM_RESERVE 2048
+#endif
+#define PRINTER_SECTOR 512
+///@brief Write to the file while the talker waits above this spool level
+#define PRINTER_HIGH_WATER(size) ((size) - ((size) >> 2))
+///@brief Printer pause, in milliseconds, before spools are written from the idle loop
+#define PRINTER_IDLE_MS 20
+///@brief Longest time, in milliseconds, written plot data waits for syncfs
+#define PRINTER_SYNC_MS 2000
+///@brief Time, in milliseconds, without data before an unlistened printer is closed
+#define PRINTER_CLOSE_MS 2000
 
 /* printer.c */
-void printer_open ( char *name );
+void printer_timer_task ( void );
+uint16_t printer_ticks ( void );
+void printer_open ( PRINTERStateType *P , uint8_t address , char *name );
+void printer_state_clear ( PRINTERStateType *P );
 void printer_init ( void );
-void printer_close ( void );
-int receive_plot_flush ( void );
-void printer_buffer ( uint16_t val );
+void printer_close ( PRINTERStateType *P );
+void printer_close_all ( void );
+void printer_unlisten ( PRINTERStateType *P );
+int printer_spool_write ( PRINTERStateType *P , int all );
+int receive_plot_flush ( PRINTERStateType *P );
+void printer_task ( void );
+void printer_buffer ( PRINTERStateType *P , uint16_t val );
 int PRINTER_COMMANDS ( uint8_t ch );
 void plot_echo ( int gpib_address );
 #endif                                            // #ifndef _PRINTER_H
@@ -0,0 +1,941 @@
+/**
+ @file gpib/sparse.c
+ @brief Thin provisioned sparse disk image support for HP85 disk emulator project for AVR.
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ A sparse image holds a small header, a block allocation bitmap, a block map
+ and ONLY the blocks that have been written. Reads of blocks that were never
+ written return the fill byte without touching the data area.
+ Overlays are sparse images that read unwritten blocks from a base image.
+ See sparse.h for the layout.
+
+ These functions only use stdio so they are shared by the emulator, via posix.c,
+ and the stand alone lif utility.
+*/
+
+#include "user_config.h"
+
+#include "vector.h"
+#include "sparse.h"
+#include "zimage.h"
+
+/// @brief Seek and read from a sparse image file
+/// @param[in] *fp: FILE pointer
+/// @param[in] offset: file offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_seek_read(FILE *fp, uint32_t offset, void *buf, int size)
+{
+    if(fseek(fp, (long) offset, SEEK_SET) < 0)
+        return(0);
+    if((int) fread(buf, 1, size, fp) != size)
+        return(0);
+    return(1);
+}
+
+
+/// @brief Seek and write to a sparse image file
+/// @param[in] *fp: FILE pointer
+/// @param[in] offset: file offset
+/// @param[in] *buf: write buffer
+/// @param[in] size: bytes to write
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_seek_write(FILE *fp, uint32_t offset, void *buf, int size)
+{
+    if(fseek(fp, (long) offset, SEEK_SET) < 0)
+        return(0);
+    if((int) fwrite(buf, 1, size, fp) != size)
+        return(0);
+    return(1);
+}
+
+
+/// @brief Read and unpack a sparse image header
+/// @param[in] *fp: FILE pointer
+/// @param[out] *S: sparse header
+/// @return 1 if this is a sparse image, 0 if not
+MEMSPACE
+int sparse_read_header(FILE *fp, sparse_t *S)
+{
+    uint8_t B[36];
+
+    if(!sparse_seek_read(fp, 0, B, sizeof(B)))
+        return(0);
+
+    if(memcmp(B, SPARSE_MAGIC, SPARSE_MAGIC_SIZE) != 0)
+        return(0);
+
+    S->version   = B2V_LSB(B, 8, 2);
+    S->blocksize = B2V_LSB(B, 10, 2);
+    S->blocks    = B2V_LSB(B, 12, 4);
+    S->used      = B2V_LSB(B, 16, 4);
+    S->bitmap    = B2V_LSB(B, 20, 4);
+    S->map       = B2V_LSB(B, 24, 4);
+    S->data      = B2V_LSB(B, 28, 4);
+    S->fill      = B[32];
+    S->flags     = B[33];
+    S->base      = NULL;
+
+    if(S->version != SPARSE_VERSION || S->blocksize == 0)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("sparse_read_header: unsupported version:[%d] block size:[%d]\n",
+                (int) S->version, (int) S->blocksize);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Pack and write a sparse image header
+/// @param[in] *fp: FILE pointer
+/// @param[in] *S: sparse header
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_write_header(FILE *fp, sparse_t *S)
+{
+    uint8_t B[36];
+
+    memset(B, 0, sizeof(B));
+    memcpy(B, SPARSE_MAGIC, SPARSE_MAGIC_SIZE);
+    V2B_LSB(B, 8, 2, S->version);
+    V2B_LSB(B, 10, 2, S->blocksize);
+    V2B_LSB(B, 12, 4, S->blocks);
+    V2B_LSB(B, 16, 4, S->used);
+    V2B_LSB(B, 20, 4, S->bitmap);
+    V2B_LSB(B, 24, 4, S->map);
+    V2B_LSB(B, 28, 4, S->data);
+    B[32] = S->fill;
+    B[33] = S->flags;
+
+    return(sparse_seek_write(fp, 0, B, sizeof(B)));
+}
+
+
+/// @brief Initialize an empty sparse image on an open file
+/// Only the header and allocation bitmap are written
+/// @param[in] *fp: FILE pointer opened for writing
+/// @param[out] *S: sparse header
+/// @param[in] blocks: image size in blocks
+/// @param[in] fill: fill byte for unwritten blocks
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_init(FILE *fp, sparse_t *S, uint32_t blocks, uint8_t fill)
+{
+    uint8_t zero[64];
+    uint32_t size;
+    uint32_t offset;
+    int len;
+
+    S->version = SPARSE_VERSION;
+    S->blocksize = SPARSE_BLOCK_SIZE;
+    S->blocks = blocks;
+    S->used = 0;
+    S->fill = fill;
+    S->flags = 0;
+    S->base = NULL;
+
+// Round each area up to a whole block
+    S->bitmap = SPARSE_HEADER_SIZE;
+    size = ((blocks + 7) >> 3);
+    size = ((size + S->blocksize - 1) / S->blocksize) * S->blocksize;
+    S->map = S->bitmap + size;
+    size = blocks * 4;
+    size = ((size + S->blocksize - 1) / S->blocksize) * S->blocksize;
+    S->data = S->map + size;
+
+    if(!sparse_write_header(fp, S))
+    {
+        printf("sparse_init: header write failed\n");
+        return(0);
+    }
+
+// Pad the header and clear the bitmap
+    memset(zero, 0, sizeof(zero));
+    offset = 36;
+    while(offset < S->map)
+    {
+        len = sizeof(zero);
+        if(offset + len > S->map)
+            len = S->map - offset;
+        if(!sparse_seek_write(fp, offset, zero, len))
+        {
+            printf("sparse_init: bitmap write failed\n");
+            return(0);
+        }
+        offset += len;
+    }
+    return(1);
+}
+
+
+/// @brief Read the base image name of an overlay
+/// @param[in] *fp: FILE pointer
+/// @param[in,out] *S: sparse header, S->base is set to base on success
+/// @param[out] *base: base image name buffer
+/// @param[in] size: base buffer size, at least SPARSE_BASE_SIZE
+/// @return 1 if this is an overlay, 0 if not or on error
+MEMSPACE
+int sparse_read_base_name(FILE *fp, sparse_t *S, char *base, int size)
+{
+    if(!(S->flags & SPARSE_OVERLAY) || size < SPARSE_BASE_SIZE)
+        return(0);
+    if(!sparse_seek_read(fp, SPARSE_BASE_OFFSET, base, SPARSE_BASE_SIZE))
+        return(0);
+    base[SPARSE_BASE_SIZE-1] = 0;
+    if(!*base)
+        return(0);
+    S->base = base;
+    return(1);
+}
+
+
+/// @brief Read from the base image of an overlay
+/// The base may be a flat or sparse image, reads past the end of a flat image return 0
+/// @param[in] *base: base image name
+/// @param[in] pos: flat image offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return bytes read, -1 on error
+MEMSPACE
+int sparse_base_read(char *base, uint32_t pos, void *buf, int size)
+{
+    FILE *fp;
+    sparse_t S;
+    int len = -1;
+
+    fp = fopen(base, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_base_read: Can't open base:[%s]\n", base);
+        return(-1);
+    }
+    if(sparse_read_header(fp, &S))
+    {
+// Overlays of overlays are not supported
+        if(!(S.flags & SPARSE_OVERLAY))
+            len = sparse_read(fp, &S, pos, buf, size);
+    }
+    else if(fseek(fp, (long) pos, SEEK_SET) >= 0)
+    {
+        len = fread(buf, 1, size, fp);
+        if(len >= 0 && len < size)
+        {
+            memset((uint8_t *) buf + len, 0, size - len);
+            len = size;
+        }
+    }
+    fclose(fp);
+    return(len);
+}
+
+
+/// @brief Lookup the data slot for a block
+/// @param[in] *fp: FILE pointer
+/// @param[in] *S: sparse header
+/// @param[in] block: block number
+/// @param[out] *slot: data slot number if allocated
+/// @return 1 if allocated, 0 if not allocated, -1 on error
+MEMSPACE
+int sparse_lookup(FILE *fp, sparse_t *S, uint32_t block, uint32_t *slot)
+{
+    uint8_t B[4];
+
+    if(block >= S->blocks)
+        return(-1);
+
+    if(!sparse_seek_read(fp, S->bitmap + (block >> 3), B, 1))
+        return(-1);
+
+    if( (B[0] & (1 << (block & 7))) == 0)
+        return(0);
+
+    if(!sparse_seek_read(fp, S->map + block * 4, B, 4))
+        return(-1);
+
+    *slot = B2V_LSB(B, 0, 4);
+    return(1);
+}
+
+
+/// @brief Read from a sparse image as if it were a flat image
+/// @param[in] *fp: FILE pointer
+/// @param[in] *S: sparse header
+/// @param[in] pos: flat image offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return bytes read, -1 on error
+MEMSPACE
+long sparse_read(FILE *fp, sparse_t *S, uint32_t pos, void *buf, long size)
+{
+    uint8_t *ptr = (uint8_t *) buf;
+    uint32_t block, slot;
+    long count = 0;
+    int offset, len, rc;
+
+    while(count < size)
+    {
+        block = pos / S->blocksize;
+        offset = pos % S->blocksize;
+        len = S->blocksize - offset;
+        if(len > size - count)
+            len = size - count;
+
+        rc = sparse_lookup(fp, S, block, &slot);
+        if(rc < 0)
+            return(-1);
+
+        if(rc == 0)
+        {
+            if(!S->base)
+                memset(ptr, S->fill, len);
+            else if(sparse_base_read(S->base, pos, ptr, len) != len)
+                return(-1);
+        }
+        else if(!sparse_seek_read(fp, S->data + slot * S->blocksize + offset, ptr, len))
+            return(-1);
+
+        ptr += len;
+        pos += len;
+        count += len;
+    }
+    return(count);
+}
+
+
+/// @brief Write fill bytes to a sparse image file
+/// @param[in] *fp: FILE pointer
+/// @param[in] *S: sparse header
+/// @param[in] offset: file offset
+/// @param[in] size: bytes to write
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_write_fill(FILE *fp, sparse_t *S, uint32_t offset, long size)
+{
+    uint8_t fill[32];
+    int len;
+
+    memset(fill, S->fill, sizeof(fill));
+    while(size > 0)
+    {
+        len = sizeof(fill);
+        if(len > size)
+            len = size;
+        if(!sparse_seek_write(fp, offset, fill, len))
+            return(0);
+        offset += len;
+        size -= len;
+    }
+    return(1);
+}
+
+
+/// @brief Write to a sparse image as if it were a flat image
+/// Blocks are allocated on first write and appended to the data area
+/// Update order is data, header used count, map, bitmap so an interrupted write
+/// never leaves an allocated block pointing at missing data and a slot is
+/// never given out twice, at worst an unused slot is lost
+/// Overlays copy the unwritten part of a new block from the base image
+/// @param[in] *fp: FILE pointer
+/// @param[in] *S: sparse header
+/// @param[in] pos: flat image offset
+/// @param[in] *buf: write buffer
+/// @param[in] size: bytes to write
+/// @return bytes written, -1 on error
+MEMSPACE
+long sparse_write(FILE *fp, sparse_t *S, uint32_t pos, void *buf, long size)
+{
+    uint8_t *ptr = (uint8_t *) buf;
+    uint8_t B[4];
+    uint8_t copy[SPARSE_BLOCK_SIZE];
+    uint32_t block, slot, base;
+    long count = 0;
+    int offset, len, rc;
+
+    while(count < size)
+    {
+        block = pos / S->blocksize;
+        offset = pos % S->blocksize;
+        len = S->blocksize - offset;
+        if(len > size - count)
+            len = size - count;
+
+        rc = sparse_lookup(fp, S, block, &slot);
+        if(rc < 0)
+            return(-1);
+
+        if(rc == 0)
+        {
+// Allocate a new data block, fill any part of the block we are not writing
+            slot = S->used;
+            base = S->data + slot * S->blocksize;
+            if(S->base && (offset || len < S->blocksize))
+            {
+                if(S->blocksize > SPARSE_BLOCK_SIZE)
+                    return(-1);
+                if(sparse_base_read(S->base, block * S->blocksize, copy, S->blocksize) != S->blocksize)
+                    return(-1);
+                memcpy(copy + offset, ptr, len);
+                if(!sparse_seek_write(fp, base, copy, S->blocksize))
+                    return(-1);
+            }
+            else
+            {
+                if(offset && !sparse_write_fill(fp, S, base, offset))
+                    return(-1);
+                if(!sparse_seek_write(fp, base + offset, ptr, len))
+                    return(-1);
+                if(offset + len < S->blocksize &&
+                        !sparse_write_fill(fp, S, base + offset + len, S->blocksize - offset - len))
+                    return(-1);
+            }
+
+// Reserve the slot before the map and bitmap make the block visible
+            S->used++;
+            V2B_LSB(B, 0, 4, S->used);
+            if(!sparse_seek_write(fp, 16, B, 4))
+                return(-1);
+
+            V2B_LSB(B, 0, 4, slot);
+            if(!sparse_seek_write(fp, S->map + block * 4, B, 4))
+                return(-1);
+
+            if(!sparse_seek_read(fp, S->bitmap + (block >> 3), B, 1))
+                return(-1);
+            B[0] |= (1 << (block & 7));
+            if(!sparse_seek_write(fp, S->bitmap + (block >> 3), B, 1))
+                return(-1);
+        }
+        else
+        {
+            if(!sparse_seek_write(fp, S->data + slot * S->blocksize + offset, ptr, len))
+                return(-1);
+        }
+
+        ptr += len;
+        pos += len;
+        count += len;
+    }
+    return(count);
+}
+
+
+/// @brief Test if a file is a sparse image
+/// @param[in] *name: file name
+/// @return 1 if sparse, 0 if not, -1 if the file can not be opened
+MEMSPACE
+int sparse_check(char *name)
+{
+    FILE *fp;
+    sparse_t S;
+    int ret;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+        return(-1);
+    ret = sparse_read_header(fp, &S);
+    fclose(fp);
+    return(ret);
+}
+
+
+/// @brief Open, Read and Close a sparse image
+/// Used by the disk emulation layer
+/// @see dbf_open_read()
+/// @param[in] *name: sparse image name
+/// @param[in] pos: flat image offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return bytes read, -1 on error
+MEMSPACE
+int sparse_open_read(char *name, uint32_t pos, void *buf, int size)
+{
+    FILE *fp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+    long len = -1;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_open_read: Can't open:[%s]\n", name);
+        return(-1);
+    }
+    if(sparse_read_header(fp, &S))
+    {
+        sparse_read_base_name(fp, &S, base, sizeof(base));
+        len = sparse_read(fp, &S, pos, buf, size);
+    }
+    fclose(fp);
+
+    if(len != size)
+    {
+        printf("sparse_open_read:[%s] read error at:[%lu]\n", name, (unsigned long) pos);
+        return(-1);
+    }
+    return(len);
+}
+
+
+/// @brief Open, Write and Close a sparse image
+/// Used by the disk emulation layer
+/// @see dbf_open_write()
+/// @param[in] *name: sparse image name
+/// @param[in] pos: flat image offset
+/// @param[in] *buf: write buffer
+/// @param[in] size: bytes to write
+/// @return bytes written, -1 on error
+MEMSPACE
+int sparse_open_write(char *name, uint32_t pos, void *buf, int size)
+{
+    FILE *fp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+    long len = -1;
+
+    fp = fopen(name, "rb+");
+    if(fp == NULL)
+    {
+        printf("sparse_open_write: Can't open:[%s]\n", name);
+        return(-1);
+    }
+    if(sparse_read_header(fp, &S))
+    {
+        sparse_read_base_name(fp, &S, base, sizeof(base));
+        len = sparse_write(fp, &S, pos, buf, size);
+    }
+    fclose(fp);
+
+    if(len != size)
+    {
+        printf("sparse_open_write:[%s] write error at:[%lu]\n", name, (unsigned long) pos);
+        return(-1);
+    }
+    return(len);
+}
+
+
+#ifdef LIF_STAND_ALONE
+/// @brief Convert a flat image into a sparse image
+/// Blocks that only contain the fill byte, 0, are not stored
+/// @param[in] *flatname: flat image name
+/// @param[in] *sparsename: sparse image name to create
+/// @return allocated blocks, -1 on error
+MEMSPACE
+long sparse_from_flat(char *flatname, char *sparsename)
+{
+    FILE *ifp, *ofp;
+    sparse_t S;
+    struct stat sb;
+    uint8_t buf[SPARSE_BLOCK_SIZE];
+    uint32_t blocks, block;
+    int i, len;
+
+    if(stat(flatname, &sb) < 0)
+    {
+        printf("sparse_from_flat: Can't stat:[%s]\n", flatname);
+        return(-1);
+    }
+    blocks = (sb.st_size + SPARSE_BLOCK_SIZE - 1) / SPARSE_BLOCK_SIZE;
+
+    ifp = fopen(flatname, "rb");
+    if(ifp == NULL)
+    {
+        printf("sparse_from_flat: Can't open:[%s]\n", flatname);
+        return(-1);
+    }
+    ofp = fopen(sparsename, "wb+");
+    if(ofp == NULL)
+    {
+        printf("sparse_from_flat: Can't create:[%s]\n", sparsename);
+        fclose(ifp);
+        return(-1);
+    }
+
+    if(!sparse_init(ofp, &S, blocks, 0))
+    {
+        fclose(ifp);
+        fclose(ofp);
+        return(-1);
+    }
+
+    for(block = 0; block < blocks; ++block)
+    {
+        memset(buf, S.fill, sizeof(buf));
+        len = fread(buf, 1, sizeof(buf), ifp);
+        if(len <= 0)
+            break;
+
+        for(i = 0; i < (int) sizeof(buf); ++i)
+        {
+            if(buf[i] != S.fill)
+                break;
+        }
+        if(i == (int) sizeof(buf))
+            continue;
+
+        if(sparse_write(ofp, &S, block * SPARSE_BLOCK_SIZE, buf, sizeof(buf)) != sizeof(buf))
+        {
+            printf("sparse_from_flat: write failed:[%s] block:[%lu]\n", sparsename, (unsigned long) block);
+            fclose(ifp);
+            fclose(ofp);
+            return(-1);
+        }
+        if((block % 1000) == 0)
+            printf("\tBlock: %lu\r", (unsigned long) block);
+    }
+
+    fclose(ifp);
+    fclose(ofp);
+    sync();
+
+    printf("\t%s: %lu blocks, %lu allocated\n",
+        sparsename, (unsigned long) S.blocks, (unsigned long) S.used);
+    return(S.used);
+}
+
+
+/// @brief Convert a sparse image into a flat image
+/// Overlays are flattened together with their base image
+/// @param[in] *sparsename: sparse image name
+/// @param[in] *flatname: flat image name to create
+/// @return blocks written, -1 on error
+MEMSPACE
+long sparse_to_flat(char *sparsename, char *flatname)
+{
+    FILE *ifp, *ofp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+    uint8_t buf[SPARSE_BLOCK_SIZE];
+    uint32_t block;
+
+    ifp = fopen(sparsename, "rb");
+    if(ifp == NULL)
+    {
+        printf("sparse_to_flat: Can't open:[%s]\n", sparsename);
+        return(-1);
+    }
+    if(!sparse_read_header(ifp, &S) || S.blocksize != SPARSE_BLOCK_SIZE)
+    {
+        printf("sparse_to_flat: [%s] is not a sparse image\n", sparsename);
+        fclose(ifp);
+        return(-1);
+    }
+    sparse_read_base_name(ifp, &S, base, sizeof(base));
+    ofp = fopen(flatname, "wb");
+    if(ofp == NULL)
+    {
+        printf("sparse_to_flat: Can't create:[%s]\n", flatname);
+        fclose(ifp);
+        return(-1);
+    }
+
+    for(block = 0; block < S.blocks; ++block)
+    {
+        if(sparse_read(ifp, &S, block * SPARSE_BLOCK_SIZE, buf, sizeof(buf)) != sizeof(buf)
+                || fwrite(buf, 1, sizeof(buf), ofp) != sizeof(buf))
+        {
+            printf("sparse_to_flat: failed at block:[%lu]\n", (unsigned long) block);
+            fclose(ifp);
+            fclose(ofp);
+            return(-1);
+        }
+        if((block % 1000) == 0)
+            printf("\tBlock: %lu\r", (unsigned long) block);
+    }
+
+    fclose(ifp);
+    fclose(ofp);
+    sync();
+
+    printf("\t%s: wrote %lu blocks\n", flatname, (unsigned long) S.blocks);
+    return(S.blocks);
+}
+
+
+/// @brief Display sparse image header and allocation
+/// @param[in] *name: sparse image name
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_info(char *name)
+{
+    FILE *fp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_info: Can't open:[%s]\n", name);
+        return(0);
+    }
+    if(!sparse_read_header(fp, &S))
+    {
+        printf("sparse_info: [%s] is not a sparse image\n", name);
+        fclose(fp);
+        return(0);
+    }
+    sparse_read_base_name(fp, &S, base, sizeof(base));
+    fclose(fp);
+
+    printf("Sparse image:  %s\n", name);
+    printf("  Block size:  %u\n", (unsigned) S.blocksize);
+    printf("  Blocks:      %lu\n", (unsigned long) S.blocks);
+    printf("  Allocated:   %lu\n", (unsigned long) S.used);
+    printf("  Bitmap:      %lu\n", (unsigned long) S.bitmap);
+    printf("  Map:         %lu\n", (unsigned long) S.map);
+    printf("  Data:        %lu\n", (unsigned long) S.data);
+    printf("  Fill:        0x%02x\n", (unsigned) S.fill);
+    if(S.base)
+        printf("  Overlay of:  %s\n", S.base);
+    return(1);
+}
+#endif                                            // LIF_STAND_ALONE
+
+
+/// @brief Image size in blocks of a flat or sparse image
+/// @param[in] *name: image name
+/// @return blocks, -1 on error
+MEMSPACE
+long sparse_image_blocks(char *name)
+{
+    FILE *fp;
+    sparse_t S;
+    struct stat sb;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+        return(-1);
+    if(sparse_read_header(fp, &S))
+    {
+        fclose(fp);
+        return(S.blocks);
+    }
+    fclose(fp);
+
+    if(stat(name, &sb) < 0)
+        return(-1);
+    return((sb.st_size + SPARSE_BLOCK_SIZE - 1) / SPARSE_BLOCK_SIZE);
+}
+
+
+/// @brief Create an empty copy on write overlay of a base image
+/// Any existing overlay file is replaced
+/// @param[in] *basename: read only base image, flat or sparse
+/// @param[in] *deltaname: overlay image to create
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_overlay_create(char *basename, char *deltaname)
+{
+    FILE *fp;
+    sparse_t S;
+    zimage_t Z;
+    char base[SPARSE_BASE_SIZE];
+    long blocks;
+
+    if(strlen(basename) >= SPARSE_BASE_SIZE)
+    {
+        printf("sparse_overlay_create: base name too long:[%s]\n", basename);
+        return(0);
+    }
+
+    fp = fopen(basename, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_overlay_create: Can't open base:[%s]\n", basename);
+        return(0);
+    }
+    if(sparse_read_header(fp, &S) && (S.flags & SPARSE_OVERLAY))
+    {
+        printf("sparse_overlay_create: base:[%s] is already an overlay\n", basename);
+        fclose(fp);
+        return(0);
+    }
+    if(zimage_read_header(fp, &Z))
+    {
+        printf("sparse_overlay_create: base:[%s] is a compressed image\n", basename);
+        fclose(fp);
+        return(0);
+    }
+    fclose(fp);
+
+    blocks = sparse_image_blocks(basename);
+    if(blocks <= 0)
+    {
+        printf("sparse_overlay_create: base:[%s] is empty\n", basename);
+        return(0);
+    }
+
+    fp = fopen(deltaname, "wb+");
+    if(fp == NULL)
+    {
+        printf("sparse_overlay_create: Can't create:[%s]\n", deltaname);
+        return(0);
+    }
+    if(!sparse_init(fp, &S, blocks, 0))
+    {
+        fclose(fp);
+        return(0);
+    }
+    S.flags = SPARSE_OVERLAY;
+    memset(base, 0, sizeof(base));
+    strcpy(base, basename);
+    if(!sparse_write_header(fp, &S) || !sparse_seek_write(fp, SPARSE_BASE_OFFSET, base, sizeof(base)))
+    {
+        printf("sparse_overlay_create: header write failed:[%s]\n", deltaname);
+        fclose(fp);
+        return(0);
+    }
+    fclose(fp);
+    sync();
+    return(1);
+}
+
+
+/// @brief Discard all changes held in an overlay
+/// @param[in] *deltaname: overlay image
+/// @return 1 on success, 0 on error
+MEMSPACE
+int sparse_overlay_discard(char *deltaname)
+{
+    FILE *fp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+    int ret = 0;
+
+    fp = fopen(deltaname, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_overlay_discard: Can't open:[%s]\n", deltaname);
+        return(0);
+    }
+    if(sparse_read_header(fp, &S))
+        ret = sparse_read_base_name(fp, &S, base, sizeof(base));
+    fclose(fp);
+
+    if(!ret)
+    {
+        printf("sparse_overlay_discard: [%s] is not an overlay\n", deltaname);
+        return(0);
+    }
+    return(sparse_overlay_create(base, deltaname));
+}
+
+
+/// @brief Test that an existing image is an overlay of a given base image
+/// @param[in] *deltaname: overlay image
+/// @param[in] *basename: expected base image
+/// @return 1 if it is, 0 if not or on error
+MEMSPACE
+int sparse_overlay_of(char *deltaname, char *basename)
+{
+    FILE *fp;
+    sparse_t S;
+    char base[SPARSE_BASE_SIZE];
+    int ret = 0;
+
+    fp = fopen(deltaname, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_overlay_of: Can't open:[%s]\n", deltaname);
+        return(0);
+    }
+    if(sparse_read_header(fp, &S))
+        ret = sparse_read_base_name(fp, &S, base, sizeof(base));
+    fclose(fp);
+
+    if(!ret)
+    {
+        printf("sparse_overlay_of: [%s] is not an overlay\n", deltaname);
+        return(0);
+    }
+    if(strcmp(base, basename) != 0)
+    {
+        printf("sparse_overlay_of: [%s] is an overlay of:[%s] not:[%s]\n", deltaname, base, basename);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Write all changes held in an overlay into its base image
+/// The overlay is emptied afterwards
+/// @param[in] *deltaname: overlay image
+/// @return blocks written to the base image, -1 on error
+MEMSPACE
+long sparse_overlay_commit(char *deltaname)
+{
+    FILE *fp, *bfp;
+    sparse_t S, B;
+    char base[SPARSE_BASE_SIZE];
+    uint8_t buf[SPARSE_BLOCK_SIZE];
+    uint32_t block, slot;
+    long count = 0;
+    int rc, bsparse;
+
+    fp = fopen(deltaname, "rb");
+    if(fp == NULL)
+    {
+        printf("sparse_overlay_commit: Can't open:[%s]\n", deltaname);
+        return(-1);
+    }
+    if(!sparse_read_header(fp, &S) || !sparse_read_base_name(fp, &S, base, sizeof(base))
+            || S.blocksize != SPARSE_BLOCK_SIZE)
+    {
+        printf("sparse_overlay_commit: [%s] is not an overlay\n", deltaname);
+        fclose(fp);
+        return(-1);
+    }
+
+    bfp = fopen(base, "rb+");
+    if(bfp == NULL)
+    {
+        printf("sparse_overlay_commit: Can't open base:[%s]\n", base);
+        fclose(fp);
+        return(-1);
+    }
+    bsparse = sparse_read_header(bfp, &B);
+
+// Only blocks present in the overlay are copied
+    for(block = 0; block < S.blocks; ++block)
+    {
+        rc = sparse_lookup(fp, &S, block, &slot);
+        if(rc == 0)
+            continue;
+        if(rc < 0 || !sparse_seek_read(fp, S.data + slot * S.blocksize, buf, sizeof(buf)))
+        {
+            printf("sparse_overlay_commit: read failed at block:[%lu]\n", (unsigned long) block);
+            count = -1;
+            break;
+        }
+        if(bsparse)
+            rc = (sparse_write(bfp, &B, block * SPARSE_BLOCK_SIZE, buf, sizeof(buf)) == sizeof(buf));
+        else
+            rc = sparse_seek_write(bfp, block * SPARSE_BLOCK_SIZE, buf, sizeof(buf));
+        if(!rc)
+        {
+            printf("sparse_overlay_commit: write failed:[%s] block:[%lu]\n", base, (unsigned long) block);
+            count = -1;
+            break;
+        }
+        ++count;
+    }
+
+    fclose(bfp);
+    fclose(fp);
+    sync();
+
+    if(count < 0)
+        return(-1);
+    if(!sparse_overlay_create(base, deltaname))
+        return(-1);
+    printf("\t%s: committed %ld blocks to %s\n", deltaname, count, base);
+    return(count);
+}
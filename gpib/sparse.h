@@ -0,0 +1,96 @@
+/**
+ @file gpib/sparse.h
+ @brief Thin provisioned sparse disk image support for HP85 disk emulator project for AVR.
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+*/
+
+#ifndef _SPARSE_H
+#define _SPARSE_H
+
+/**
+  @brief Sparse image layout
+  All values are stored LSB first
+
+    OFFSET  DESCRIPTION
+    ------  -----------------------------------------------------------
+    header sector (SPARSE_HEADER_SIZE bytes)
+      0-7   Magic "HPSPARSE"
+      8-9   Version
+     10-11  Block size in bytes
+     12-15  Image size in blocks as seen by the emulator
+     16-19  Number of allocated data blocks
+     20-23  File offset of the allocation bitmap, one bit per block
+     24-27  File offset of the block map, 4 bytes per block, LSB first
+     28-31  File offset of the first data block
+       32   Fill byte returned for blocks that have never been written
+       33   Flags, SPARSE_OVERLAY
+     64-127 Base image name for overlays, 0 terminated
+
+    bitmap  Must be cleared when the image is created
+    map     Only valid for blocks with their bitmap bit set
+            so it does not have to be written at create time
+    data    Blocks in the order they were first written
+
+  @brief Copy on write overlays
+    An overlay is a sparse image with the SPARSE_OVERLAY flag set.
+    Blocks that have never been written are read from the base image
+    instead of returning the fill byte, the base image is never written.
+    Partial writes copy the rest of the block from the base image.
+    The base image may be a flat or sparse image but not another overlay.
+*/
+
+#define SPARSE_MAGIC "HPSPARSE"
+#define SPARSE_MAGIC_SIZE 8
+#define SPARSE_VERSION 1
+#define SPARSE_BLOCK_SIZE 256
+#define SPARSE_HEADER_SIZE 256
+#define SPARSE_OVERLAY 1
+#define SPARSE_BASE_OFFSET 64
+#define SPARSE_BASE_SIZE 64
+
+///@brief Sparse image header
+typedef struct _sparse
+{
+    uint16_t version;                             // 8
+    uint16_t blocksize;                           // 10
+    uint32_t blocks;                              // 12
+    uint32_t used;                                // 16
+    uint32_t bitmap;                              // 20
+    uint32_t map;                                 // 24
+    uint32_t data;                                // 28
+    uint8_t  fill;                                // 32
+    uint8_t  flags;                               // 33
+    char     *base;                               // Overlay base image name, NULL if not loaded
+} sparse_t;
+
+/* sparse.c */
+MEMSPACE int sparse_seek_read ( FILE *fp , uint32_t offset , void *buf , int size );
+MEMSPACE int sparse_seek_write ( FILE *fp , uint32_t offset , void *buf , int size );
+MEMSPACE int sparse_read_header ( FILE *fp , sparse_t *S );
+MEMSPACE int sparse_write_header ( FILE *fp , sparse_t *S );
+MEMSPACE int sparse_init ( FILE *fp , sparse_t *S , uint32_t blocks , uint8_t fill );
+MEMSPACE int sparse_read_base_name ( FILE *fp , sparse_t *S , char *base , int size );
+MEMSPACE int sparse_base_read ( char *base , uint32_t pos , void *buf , int size );
+MEMSPACE int sparse_lookup ( FILE *fp , sparse_t *S , uint32_t block , uint32_t *slot );
+MEMSPACE long sparse_read ( FILE *fp , sparse_t *S , uint32_t pos , void *buf , long size );
+MEMSPACE int sparse_write_fill ( FILE *fp , sparse_t *S , uint32_t offset , long size );
+MEMSPACE long sparse_write ( FILE *fp , sparse_t *S , uint32_t pos , void *buf , long size );
+MEMSPACE int sparse_check ( char *name );
+MEMSPACE int sparse_open_read ( char *name , uint32_t pos , void *buf , int size );
+MEMSPACE int sparse_open_write ( char *name , uint32_t pos , void *buf , int size );
+#ifdef LIF_STAND_ALONE
+MEMSPACE long sparse_from_flat ( char *flatname , char *sparsename );
+MEMSPACE long sparse_to_flat ( char *sparsename , char *flatname );
+MEMSPACE int sparse_info ( char *name );
+#endif
+MEMSPACE long sparse_image_blocks ( char *name );
+MEMSPACE int sparse_overlay_create ( char *basename , char *deltaname );
+MEMSPACE long sparse_overlay_commit ( char *deltaname );
+MEMSPACE int sparse_overlay_discard ( char *deltaname );
+MEMSPACE int sparse_overlay_of ( char *deltaname , char *basename );
+
+#endif                                            // _SPARSE_H
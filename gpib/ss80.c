@@ -26,6 +26,7 @@
 #include "ss80.h"
 #include "vector.h"
 #include "debug.h"
+#include "evlog.h"
 
 /// @verbatim
 ///  See LIF filesystem Reference
@@ -123,13 +124,12 @@ int TD[] =
 void SS80_Test(void)
 {
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Test]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_TEST, 0, 0, 0);
 #endif
 #if SDEBUG
     if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
     {
-        printf("[SS80 Test Done]\n");
+        EVLOG_PRINTF("[SS80 Test Done]\n");
         sep();
     }
 #endif
@@ -286,8 +286,7 @@ void SS80_init(void)
 // Power On State
             SS80s->qstat = 2;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 %02XH INIT]\n", Devices[i].ADDRESS);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_INIT, Devices[i].ADDRESS, 0, 0);
 #endif
 /// @todo FIXME
             gpib_disable_PPR(SS80p->HEADER.PPR);
@@ -330,7 +329,7 @@ int SS80_Execute_State(void)
             break;
         default:
             if(debuglevel & GPIB_ERR)
-                printf("[SS80 EXEC state:%d error]\n", SS80s->estate);
+                EVLOG_PRINTF("[SS80 EXEC state:%d error]\n", SS80s->estate);
             SS80s->estate = EXEC_IDLE;
             break;
     }
@@ -392,9 +391,7 @@ int SS80_locate_and_read( void )
 ///  For now we will assume the controller will never do this
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Locate and Read at %08lXH(%lXH)]\n",
-            (long) Address, (long) SS80s->Length);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_READ_AT, (long) Address, (long) SS80s->Length, 0);
 #endif
 
     if( SS80_cmd_seek() )
@@ -428,20 +425,19 @@ int SS80_locate_and_read( void )
 #endif
 
 // FIXME len != chunk
-        len = dbf_open_read(SS80p->HEADER.NAME, Address, gpib_iobuff, chunk, &SS80s->Errors);
+        len = dbf_open_read(SS80p->HEADER.NAME, &SS80p->HEADER.FORMAT, Address, gpib_iobuff, chunk, &SS80s->Errors);
 
 #if SDEBUG
         if(debuglevel & GPIB_DISK_IO_TIMING)
             gpib_timer_elapsed_end("disk READ ");
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[SS80 Disk Read %02XH bytes]\n", len);
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_DISK_READ_BYTES, len, 0, 0);
 #endif
         if(len < 0)
         {
             SS80s->qstat = 1;
 /// @return Return
             if(debuglevel & GPIB_ERR)
-                printf("[SS80 Disk Read Error]\n");
+                EVLOG_PRINTF("[SS80 Disk Read Error]\n");
             return( SS80_error_return() );
         }
 
@@ -458,7 +454,7 @@ int SS80_locate_and_read( void )
         {
             SS80s->qstat = 1;
             if(debuglevel & GPIB_ERR)
-                printf("[SS80 GPIB Write Error]\n");
+                EVLOG_PRINTF("[SS80 GPIB Write Error]\n");
             if(status & ERROR_MASK)
             {
                 SS80s->Errors |= ERR_GPIB;
@@ -474,13 +470,12 @@ int SS80_locate_and_read( void )
     if(count > 0)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Buffered Read DID NOT FINISH]\n");
+            EVLOG_PRINTF("[SS80 Buffered Read DID NOT FINISH]\n");
     }
     else
     {
 #if SDEBUG
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[SS80 Buffered Read Total(%lXH) bytes]\n", (long) total_bytes);
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_BUFFERED_READ_TOTAL_BYTES, (long) total_bytes, 0, 0);
 #endif
     }
 
@@ -514,8 +509,7 @@ int SS80_locate_and_write(void)
     io_skip = 0;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Locate and Write at %08lXH(%lXH)]\n", (long)Address, (long)SS80s->Length);
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_WRITE_AT, (long)Address, (long)SS80s->Length, 0);
 #endif
 
     SS80s->qstat = 0;
@@ -564,7 +558,7 @@ int SS80_locate_and_write(void)
             if(status & ERROR_MASK)
             {
                 if(debuglevel & GPIB_ERR)
-                    printf("[GPIB Read Error]\n");
+                    EVLOG_PRINTF("[GPIB Read Error]\n");
                 SS80s->Errors |= ERR_WRITE;
                 SS80s->qstat = 1;
                 break;
@@ -582,7 +576,7 @@ int SS80_locate_and_write(void)
                 if(debuglevel & GPIB_DISK_IO_TIMING)
                     gpib_timer_elapsed_begin();
 #endif
-                len2 = dbf_open_write(SS80p->HEADER.NAME, Address, gpib_iobuff, len, &SS80s->Errors);
+                len2 = dbf_open_write(SS80p->HEADER.NAME, &SS80p->HEADER.FORMAT, Address, gpib_iobuff, len, &SS80s->Errors);
 #if SDEBUG
                 if(debuglevel & GPIB_DISK_IO_TIMING)
                     gpib_timer_elapsed_end("disk WRITE");
@@ -595,13 +589,12 @@ int SS80_locate_and_write(void)
                     SS80s->qstat = 1;
                     io_skip = 1;                  // Stop writing
                     if(debuglevel & GPIB_ERR)
-                        printf("[Disk Write Error]\n");
+                        EVLOG_PRINTF("[Disk Write Error]\n");
                 }
                 else
                 {
 #if SDEBUG
-                    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                        printf("[SS80 Locate and Write wrote(%02XH)]\n", len2);
+                    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_WRITE_WROTE, len2, 0, 0);
 #endif
                     Address += len;
                 }
@@ -622,13 +615,12 @@ int SS80_locate_and_write(void)
     if(count > 0)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Locate and Write DID NOT FINISH]\n");
+            EVLOG_PRINTF("[SS80 Locate and Write DID NOT FINISH]\n");
     }
     else
     {
 #if SDEBUG
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[SS80 Locate and Write Wrote Total(%lxH)]\n", total_bytes);
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_WRITE_WROTE_TOTAL, total_bytes, 0, 0);
 #endif
     }
     SS80s->AddressBlocks = SS80_Bytes_to_Blocks(Address);
@@ -726,7 +718,7 @@ void SS80_display_extended_status(uint8_t *p, char *message)
 // Display all of the messages
     if(status)
     {
-        printf("%s:\n",message);
+        EVLOG_PRINTF("%s:\n",message);
         for(i=0;faults[i].index != -1;++i)
         {
             bit = faults[i].index;
@@ -857,8 +849,7 @@ int SS80_send_status( void )
     uint16_t status;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Send Status]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SEND_STATUS, 0, 0, 0);
 #endif
 
     Mem_Clear(tmp);
@@ -910,7 +901,7 @@ int SS80_send_status( void )
     if(gpib_write_str(tmp, sizeof(tmp), &status) != sizeof(tmp))
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Send Status FAILED]\n");
+            EVLOG_PRINTF("[SS80 Send Status FAILED]\n");
     }
 
     return ( status & ERROR_MASK );
@@ -934,8 +925,7 @@ int SS80_describe( void )
     int size;
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Describe]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_DESCRIBE, 0, 0, 0);
 #endif
 
     status = 0;
@@ -944,7 +934,7 @@ int SS80_describe( void )
     if(gpib_write_str(B,size, &status) != size)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Describe Controller FAILED]\n");
+            EVLOG_PRINTF("[SS80 Describe Controller FAILED]\n");
         return(status & ERROR_MASK);
     }
 
@@ -954,7 +944,7 @@ int SS80_describe( void )
     if(gpib_write_str(B,size, &status) != size)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Describe Unit FAILED]\n");
+            EVLOG_PRINTF("[SS80 Describe Unit FAILED]\n");
         return(status & ERROR_MASK);
     }
 
@@ -963,7 +953,7 @@ int SS80_describe( void )
     if(gpib_write_str(B,size,&status) != size)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Describe Volume FAILED]\n");
+            EVLOG_PRINTF("[SS80 Describe Volume FAILED]\n");
         return(status & ERROR_MASK);
     }
 
@@ -980,7 +970,7 @@ void SS80_Check_Unit(uint8_t unit)
     {
         SS80s->Errors |= ERR_UNIT;
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 UNIT:%d invalid]\n", (int) unit);
+            EVLOG_PRINTF("[SS80 UNIT:%d invalid]\n", (int) unit);
     }
     else
     {
@@ -998,7 +988,7 @@ void SS80_Check_Volume(uint8_t volume)
     {
         SS80s->Errors |= ERR_UNIT;
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Volume:%d invalid]\n", (int) volume);
+            EVLOG_PRINTF("[SS80 Volume:%d invalid]\n", (int) volume);
     }
     else
     {
@@ -1059,7 +1049,7 @@ int SS80_Command_State( void )
     {
 /// @todo FIXME
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Command State GPIB Read ERROR]\n");
+            EVLOG_PRINTF("[SS80 Command State GPIB Read ERROR]\n");
         return(status & ERROR_MASK);
     }
 
@@ -1069,7 +1059,7 @@ int SS80_Command_State( void )
     if( !(status & EOI_FLAG) )
     {
         if(debuglevel & GPIB_ERR)
-            printf("[GPIB buffer OVERFLOW!]\n");
+            EVLOG_PRINTF("[GPIB buffer OVERFLOW!]\n");
     }
 
     ind = 0;
@@ -1085,8 +1075,7 @@ int SS80_Command_State( void )
 // TODO unit support
 
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set Unit:(%d)]\n", SS80s->unitNO);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_UNIT, SS80s->unitNO, 0, 0);
 #endif
             continue;
         }
@@ -1097,8 +1086,7 @@ int SS80_Command_State( void )
         {
             SS80_Check_Volume(ch - 0x40);
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set Volume: (%d)]\n", SS80s->volNO);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_VOLUME, SS80s->volNO, 0, 0);
 #endif
             continue;
         }
@@ -1109,8 +1097,7 @@ int SS80_Command_State( void )
 ///  In Execute state calls  SS80_locate_and_read();
             SS80s->estate = EXEC_LOCATE_AND_READ;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Locate and Read]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_READ, 0, 0, 0);
 #endif
             break;
         }
@@ -1121,8 +1108,7 @@ int SS80_Command_State( void )
 ///  SS80_locate_and_write();
             SS80s->estate = EXEC_LOCATE_AND_WRITE;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Locate and Write]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_WRITE, 0, 0, 0);
 #endif
             break;
         }
@@ -1150,9 +1136,7 @@ int SS80_Command_State( void )
             SS80s->AddressBlocks = B2V_MSB(gpib_iobuff,ind,6);
             ind += 6;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set Address:(%08lXH)]\n",
-                    (long)SS80_Blocks_to_Bytes(SS80s->AddressBlocks));
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_ADDRESS, (long)SS80_Blocks_to_Bytes(SS80s->AddressBlocks), 0, 0);
 #endif
             continue;
         }
@@ -1165,8 +1149,7 @@ int SS80_Command_State( void )
             SS80s->Length = B2V_MSB(gpib_iobuff,ind,4);
             ind += 4;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set Length:(%08lXH)]\n", (long)SS80s->Length);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_LENGTH, (long)SS80s->Length, 0, 0);
 #endif
             continue;
         }
@@ -1176,8 +1159,7 @@ int SS80_Command_State( void )
         if(ch == 0x34)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 NO-OP]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_NO_OP, 0, 0, 0);
 #endif
             continue;
         }
@@ -1187,8 +1169,7 @@ int SS80_Command_State( void )
         {
             ind += 2;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set RPS NO-OP]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_RPS_NO_OP, 0, 0, 0);
 #endif
             continue;
         }
@@ -1199,8 +1180,7 @@ int SS80_Command_State( void )
         {
             ind++;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Set Release NO-OP]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_RELEASE_NO_OP, 0, 0, 0);
 #endif
             continue;
         }
@@ -1217,8 +1197,7 @@ int SS80_Command_State( void )
 ///  Skip Parameters
             ind++;
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Set Return Addressing - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SET_RETURN_ADDRESSING_TODO, 0, 0, 0);
 #endif
             continue;
         }
@@ -1233,8 +1212,7 @@ int SS80_Command_State( void )
 /// @todo FIXME
 ///  Execute NOW
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Locate and Verify - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_LOCATE_AND_VERIFY_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1242,8 +1220,7 @@ int SS80_Command_State( void )
         if(ch == 0x0E)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Release NO-OP]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_RELEASE_NO_OP, 0, 0, 0);
 #endif
 /// @todo FIXME
 ///  The class GENERAL PURPOSE suggests yes
@@ -1252,8 +1229,7 @@ int SS80_Command_State( void )
         if(ch == 0x0F)
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Release Denied NO-OP]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_RELEASE_DENIED_NO_OP, 0, 0, 0);
 #endif
 /// @todo FIXME
 ///  The class GENERAL PURPOSE suggests yes
@@ -1273,8 +1249,7 @@ int SS80_Command_State( void )
 ///  Skip Parameters
             ind += 2;
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Validate Key - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_VALIDATE_KEY_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1283,8 +1258,7 @@ int SS80_Command_State( void )
         {
             SS80s->estate = EXEC_DESCRIBE;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Describe]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_DESCRIBE, 0, 0, 0);
 #endif
             break;
         }
@@ -1302,8 +1276,7 @@ int SS80_Command_State( void )
 /// @todo TODO
 /// @todo FIXME
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Initialize Media TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_INITIALIZE_MEDIA_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1321,7 +1294,7 @@ int SS80_Command_State( void )
 #if SDEBUG
             if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
             {
-                printf("[SS80 Set Status Mask - TODO]\n");
+                EVLOG_PRINTF("[SS80 Set Status Mask - TODO]\n");
                 SS80_display_extended_status(gpib_iobuff+ind, "TODO Mask these Status Bits");
             }
 #endif
@@ -1333,8 +1306,7 @@ int SS80_Command_State( void )
         {
 /// @todo TODO
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Door UnLock - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_DOOR_UNLOCK_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1343,8 +1315,7 @@ int SS80_Command_State( void )
         {
 /// @todo TODO
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Door Lock - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_DOOR_LOCK_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1353,8 +1324,7 @@ int SS80_Command_State( void )
         {
             SS80s->estate = EXEC_SEND_STATUS;
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Request Status]\n");
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_REQUEST_STATUS, 0, 0, 0);
 #endif
             break;
         }
@@ -1371,14 +1341,13 @@ int SS80_Command_State( void )
 /// @todo TODO
             ind += 3;
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Initiate Diagnostic - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_INITIATE_DIAGNOSTIC_TODO, 0, 0, 0);
 #endif
             break;
         }
 
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Invalid OP Code (%02XH)]\n", ch & 0xff);
+            EVLOG_PRINTF("[SS80 Invalid OP Code (%02XH)]\n", ch & 0xff);
 
         break;
     }
@@ -1386,7 +1355,7 @@ int SS80_Command_State( void )
     if( ind != len)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Execute Command, Error at (%d) of (%d) OP Codes]\n",
+            EVLOG_PRINTF("[SS80 Execute Command, Error at (%d) of (%d) OP Codes]\n",
                 ind, len);
     }
 
@@ -1460,7 +1429,7 @@ int SS80_Transparent_State( void )
     {
 /// @todo FIXME
         if(debuglevel & GPIB_ERR)
-            printf("[GPIB Read ERROR]\n");
+            EVLOG_PRINTF("[GPIB Read ERROR]\n");
         return(status & ERROR_MASK);
     }
 
@@ -1470,7 +1439,7 @@ int SS80_Transparent_State( void )
     if( !(status & EOI_FLAG) )
     {
         if(debuglevel & GPIB_ERR)
-            printf("[GPIB buffer OVERFLOW!]\n");
+            EVLOG_PRINTF("[GPIB buffer OVERFLOW!]\n");
     }
 
     ind = 0;
@@ -1492,8 +1461,7 @@ int SS80_Transparent_State( void )
 ///  Skip Paramter
             ind++;
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 HP-IB Parity Checking - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_HP_IB_PARITY_CHECKING_TODO, 0, 0, 0);
 #endif
             gpib_enable_PPR(SS80p->HEADER.PPR);
             break;
@@ -1509,8 +1477,7 @@ int SS80_Transparent_State( void )
 /// @todo TODO
 ///  DO NOT EPPR
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Read Loopback - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_READ_LOOPBACK_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1525,8 +1492,7 @@ int SS80_Transparent_State( void )
 /// @todo TODO
 ///  DO NOT EPPR
 #if SDEBUG
-            if(debuglevel & (GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES))
-                printf("[SS80 Write Loopback - TODO]\n");
+            EVLOG(GPIB_TODO + GPIB_DEVICE_STATE_MESSAGES, EV_SS80_WRITE_LOOPBACK_TODO, 0, 0, 0);
 #endif
             break;
         }
@@ -1541,8 +1507,7 @@ int SS80_Transparent_State( void )
         if(ch == 0x08)                            // 0x08 OP Code
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Channel Independent Clear (%d)]\n", SS80s->unitNO);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_CHANNEL_INDEPENDENT_CLEAR, SS80s->unitNO, 0, 0);
 #endif
             return(SS80_Channel_Independent_Clear( SS80s->unitNO ));
         }
@@ -1556,8 +1521,7 @@ int SS80_Transparent_State( void )
         if(ch == 0x09)                            // 0x09 OP Code
         {
 #if SDEBUG
-            if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                printf("[SS80 Cancel (%d)]\n", SS80s->unitNO);
+            EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_CANCEL, SS80s->unitNO, 0, 0);
 #endif
             return(SS80_Cancel( ) );
 
@@ -1565,14 +1529,14 @@ int SS80_Transparent_State( void )
         }
 
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Invalid OP Code (%02XH)]\n", ch & 0xff);
+            EVLOG_PRINTF("[SS80 Invalid OP Code (%02XH)]\n", ch & 0xff);
         break;
     }
 
     if( ind != len)
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Transparent Command, Error at (%d) of (%d) OP Codes]\n",
+            EVLOG_PRINTF("[SS80 Transparent Command, Error at (%d) of (%d) OP Codes]\n",
                 ind,len);
     }
 
@@ -1601,14 +1565,13 @@ int SS80_cmd_seek( void )
         SS80s->Errors |= ERR_SEEK;
 
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 Seek OVERFLOW at %08lXH]\n",
+            EVLOG_PRINTF("[SS80 Seek OVERFLOW at %08lXH]\n",
                 (long) SS80_Blocks_to_Bytes(SS80s->AddressBlocks));
         return(1);
     }
 
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Seek:%08lXH]\n", (long)SS80_Blocks_to_Bytes(SS80s->AddressBlocks));
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SEEK, (long)SS80_Blocks_to_Bytes(SS80s->AddressBlocks), 0, 0);
 #endif
     return (0);
 }
@@ -1649,14 +1612,13 @@ int SS80_Report( void )
     if( gpib_write_str(tmp, sizeof(tmp), &status) != sizeof(tmp))
     {
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 qstat send FAILED]\n");
+            EVLOG_PRINTF("[SS80 qstat send FAILED]\n");
         return(status & ERROR_MASK);
     }
     else
     {
 #if SDEBUG
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[SS80 qstat %02X]\n", SS80s->qstat);
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_QSTAT, SS80s->qstat, 0, 0);
 #endif
     }
     SS80s->qstat = 0;
@@ -1811,8 +1773,7 @@ int SS80_Universal_Device_Clear(void)
 int SS80_Selected_Device_Clear( int u )
 {
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 SDC]\n");
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_SDC, 0, 0, 0);
 #endif
     Clear_Common( u );
     gpib_enable_PPR(SS80p->HEADER.PPR);
@@ -1837,14 +1798,13 @@ int SS80_Amigo_Clear( void )
     if( gpib_read_str(parity, sizeof(parity), &status) != sizeof(parity))
     {
         if(debuglevel & GPIB_ERR)
-            printf("[GPIB Read Error]\n");
+            EVLOG_PRINTF("[GPIB Read Error]\n");
         return(status & ERROR_MASK);
     }
     else
     {
 #if SDEBUG
-        if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-            printf("[Amigo Clear]\n");
+        EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_AMIGO_CLEAR, 0, 0, 0);
 #endif
     }
     Clear_Common(15);
@@ -1881,9 +1841,7 @@ int SS80_increment( void )
 {
     SS80s->AddressBlocks += 1L;
 #if SDEBUG
-    if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-        printf("[SS80 Increment to (%lXH)]\n",
-            (long) SS80_Blocks_to_Bytes(SS80s->AddressBlocks));
+    EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_INCREMENT_TO, (long) SS80_Blocks_to_Bytes(SS80s->AddressBlocks), 0, 0);
 #endif
     return(0);
 }
@@ -1907,7 +1865,7 @@ int SS80_error_return( void )
     if( gpib_write_str(tmp,sizeof(tmp), &status) != sizeof(tmp))
     {
         if(debuglevel & GPIB_ERR)
-            printf("[GPIB Error Return - Write ERROR]\n");
+            EVLOG_PRINTF("[GPIB Error Return - Write ERROR]\n");
         return(status & ERROR_MASK);
     }
     SS80s->qstat = 0;
@@ -1935,8 +1893,7 @@ int SS80_COMMANDS(uint8_t ch)
             if(SS80_is_MLA(listening))
             {
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[SS80 Command State]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_COMMAND_STATE, 0, 0, 0);
 #endif
                 return ( SS80_Command_State() );
             }
@@ -1947,8 +1904,7 @@ int SS80_COMMANDS(uint8_t ch)
         {
             if(SS80_is_MLA(listening)  || SS80_is_MTA(talking))
             {
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[SS00 Execute State]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_EXECUTE_STATE, 0, 0, 0);
                 return ( SS80_Execute_State() );
 
             }
@@ -1960,8 +1916,7 @@ int SS80_COMMANDS(uint8_t ch)
             if(SS80_is_MTA(talking) )
             {
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[SS80 Report State]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_REPORT_STATE, 0, 0, 0);
 #endif
                 return( SS80_Report() );
             }
@@ -1969,8 +1924,7 @@ int SS80_COMMANDS(uint8_t ch)
             if(SS80_is_MLA(listening))
             {
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[Amigo Clear]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_AMIGO_CLEAR, 0, 0, 0);
 #endif
                 gpib_disable_PPR(SS80p->HEADER.PPR);
                 return( SS80_Amigo_Clear() );
@@ -1982,20 +1936,19 @@ int SS80_COMMANDS(uint8_t ch)
             if(SS80_is_MLA(listening) )
             {
 #if SDEBUG
-                if(debuglevel & GPIB_DEVICE_STATE_MESSAGES)
-                    printf("[SS80 Transparent]\n");
+                EVLOG(GPIB_DEVICE_STATE_MESSAGES, EV_SS80_TRANSPARENT, 0, 0, 0);
 #endif
                 return( SS80_Transparent_State() );
             }
         }
         if(debuglevel & GPIB_ERR)
-            printf("[SS80 SC Unknown: %02XH, listen:%02XH, talk:%02XH]\n",
+            EVLOG_PRINTF("[SS80 SC Unknown: %02XH, listen:%02XH, talk:%02XH]\n",
                 0xff & ch, 0xff & listening, 0xff & talking);
         return(0);
     }
 
     if(debuglevel & GPIB_ERR)
-        printf("[SS80 Unknown SC: %02XH, listen:%02XH, talk:%02XH]\n",
+        EVLOG_PRINTF("[SS80 Unknown SC: %02XH, listen:%02XH, talk:%02XH]\n",
             0xff & ch, 0xff & listening, 0xff & talking);
     return(0);
 }
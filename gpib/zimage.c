@@ -0,0 +1,790 @@
+/**
+ @file gpib/zimage.c
+ @brief Read only block compressed disk image support for HP85 disk emulator project for AVR.
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ Compressed images are made of independently compressed groups with an index
+ so any sector can be read without decoding the whole image.
+ The decoder streams with a small history ring, see zimage.h for the layout.
+
+ These functions only use stdio so they are shared by the emulator, via posix.c,
+ and the stand alone lif utility.
+*/
+
+#include "user_config.h"
+
+#include "vector.h"
+#include "sparse.h"
+#include "zimage.h"
+
+///@brief Decoder state cache, each entry is allocated on first use
+zimage_cache_t *zimage_cache_p[ZIMAGE_CACHE_ENTRIES];
+
+///@brief Incremented on every lookup, entries remember when they were last used
+uint16_t zimage_cache_tick = 0;
+
+/// @brief Read and unpack a compressed image header
+/// @param[in] *fp: FILE pointer
+/// @param[out] *Z: compressed image header
+/// @return 1 if this is a compressed image, 0 if not
+MEMSPACE
+int zimage_read_header(FILE *fp, zimage_t *Z)
+{
+    uint8_t B[32];
+
+    if(!sparse_seek_read(fp, 0, B, sizeof(B)))
+        return(0);
+
+    if(memcmp(B, ZIMAGE_MAGIC, ZIMAGE_MAGIC_SIZE) != 0)
+        return(0);
+
+    Z->version   = B2V_LSB(B, 8, 2);
+    Z->blocksize = B2V_LSB(B, 10, 2);
+    Z->groupsize = B2V_LSB(B, 12, 2);
+    Z->blocks    = B2V_LSB(B, 14, 4);
+    Z->groups    = B2V_LSB(B, 18, 4);
+    Z->index     = B2V_LSB(B, 22, 4);
+    Z->data      = B2V_LSB(B, 26, 4);
+    Z->fill      = B[30];
+
+    if(Z->version != ZIMAGE_VERSION || Z->blocksize == 0 || Z->groupsize == 0)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("zimage_read_header: unsupported version:[%d] group size:[%d]\n",
+                (int) Z->version, (int) Z->groupsize);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Pack and write a compressed image header
+/// @param[in] *fp: FILE pointer
+/// @param[in] *Z: compressed image header
+/// @return 1 on success, 0 on error
+MEMSPACE
+int zimage_write_header(FILE *fp, zimage_t *Z)
+{
+    uint8_t B[32];
+
+    memset(B, 0, sizeof(B));
+    memcpy(B, ZIMAGE_MAGIC, ZIMAGE_MAGIC_SIZE);
+    V2B_LSB(B, 8, 2, Z->version);
+    V2B_LSB(B, 10, 2, Z->blocksize);
+    V2B_LSB(B, 12, 2, Z->groupsize);
+    V2B_LSB(B, 14, 4, Z->blocks);
+    V2B_LSB(B, 18, 4, Z->groups);
+    V2B_LSB(B, 22, 4, Z->index);
+    V2B_LSB(B, 26, 4, Z->data);
+    B[30] = Z->fill;
+
+    return(sparse_seek_write(fp, 0, B, sizeof(B)));
+}
+
+
+/// @brief Test if a file is a compressed image
+/// @param[in] *name: file name
+/// @return 1 if compressed, 0 if not, -1 if the file can not be opened
+MEMSPACE
+int zimage_check(char *name)
+{
+    FILE *fp;
+    zimage_t Z;
+    int ret;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+        return(-1);
+    ret = zimage_read_header(fp, &Z);
+    fclose(fp);
+    return(ret);
+}
+
+
+/// @brief Compress one group
+/// Greedy encoder, the search is brute force over the small window
+/// @param[in] *in: group data
+/// @param[in] size: group size
+/// @param[out] *out: compressed data
+/// @param[in] max: size of out
+/// @return compressed size, -1 if it does not fit in max bytes
+MEMSPACE
+int zimage_compress(uint8_t *in, int size, uint8_t *out, int max)
+{
+    int i = 0;
+    int o = 0;
+    int lit = 0;
+    int run, best, dist, d, len;
+
+    while(i <= size)
+    {
+// Flush pending literals before a run, copy, the literal limit or the end
+        if(lit && (i == size || lit == ZIMAGE_MAX_LITERAL))
+        {
+            if(o + 1 + lit > max)
+                return(-1);
+            out[o++] = lit - 1;
+            memcpy(out + o, in + i - lit, lit);
+            o += lit;
+            lit = 0;
+        }
+        if(i == size)
+            break;
+
+        run = 1;
+        while(i + run < size && run < ZIMAGE_MAX_MATCH && in[i + run] == in[i])
+            ++run;
+
+        best = 0;
+        dist = 0;
+        for(d = 1; d <= ZIMAGE_WINDOW && d <= i && best < ZIMAGE_MAX_MATCH; ++d)
+        {
+            len = 0;
+            while(i + len < size && len < ZIMAGE_MAX_MATCH && in[i + len] == in[i + len - d])
+                ++len;
+            if(len > best)
+            {
+                best = len;
+                dist = d;
+            }
+        }
+
+        if(run < ZIMAGE_MIN_MATCH && best < ZIMAGE_MIN_MATCH)
+        {
+            ++lit;
+            ++i;
+            continue;
+        }
+
+        if(lit)
+        {
+            if(o + 1 + lit > max)
+                return(-1);
+            out[o++] = lit - 1;
+            memcpy(out + o, in + i - lit, lit);
+            o += lit;
+            lit = 0;
+        }
+
+        if(o + 2 > max)
+            return(-1);
+
+        if(run >= best)
+        {
+            out[o++] = 0x80 | (run - ZIMAGE_MIN_MATCH);
+            out[o++] = in[i];
+            i += run;
+        }
+        else
+        {
+            out[o++] = 0xc0 | (best - ZIMAGE_MIN_MATCH);
+            out[o++] = dist - 1;
+            i += best;
+        }
+    }
+    return(o);
+}
+
+
+/// @brief Get the next compressed byte of the current group
+/// @param[in] *C: decoder state
+/// @param[in] *fp: FILE pointer
+/// @return byte, -1 at end of group or on error
+MEMSPACE
+int zimage_getc(zimage_cache_t *C, FILE *fp)
+{
+    uint32_t len;
+
+    if(C->bufpos >= C->buflen)
+    {
+        if(C->in >= C->end)
+            return(-1);
+        len = C->end - C->in;
+        if(len > ZIMAGE_INBUF)
+            len = ZIMAGE_INBUF;
+        if(!sparse_seek_read(fp, C->in, C->buf, len))
+            return(-1);
+        C->in += len;
+        C->bufpos = 0;
+        C->buflen = len;
+    }
+    return(C->buf[C->bufpos++]);
+}
+
+
+/// @brief Decode the current group up to start + len
+/// Bytes in [start, start + len) of the group are stored in dst
+/// @param[in] *C: decoder state, C->out <= start
+/// @param[in] *fp: FILE pointer
+/// @param[out] *dst: output buffer
+/// @param[in] start: group offset of first byte wanted
+/// @param[in] len: bytes wanted
+/// @return 1 on success, 0 on error
+MEMSPACE
+int zimage_decode(zimage_cache_t *C, FILE *fp, uint8_t *dst, uint16_t start, uint16_t len)
+{
+    uint16_t end = start + len;
+    int c;
+    uint8_t b;
+
+    while(C->out < end)
+    {
+        if(C->count == 0)
+        {
+            c = zimage_getc(C, fp);
+            if(c < 0)
+                return(0);
+            if(c < 0x80)
+            {
+                C->op = ZIMAGE_OP_LITERAL;
+                C->count = c + 1;
+            }
+            else
+            {
+                C->op = (c & 0x40) ? ZIMAGE_OP_COPY : ZIMAGE_OP_RUN;
+                C->count = (c & 0x3f) + ZIMAGE_MIN_MATCH;
+                c = zimage_getc(C, fp);
+                if(c < 0)
+                    return(0);
+                C->arg = c;
+            }
+        }
+
+        if(C->op == ZIMAGE_OP_LITERAL)
+        {
+            c = zimage_getc(C, fp);
+            if(c < 0)
+                return(0);
+            b = c;
+        }
+        else if(C->op == ZIMAGE_OP_RUN)
+            b = C->arg;
+        else
+            b = C->ring[(uint8_t) (C->out - C->arg - 1)];
+
+        C->ring[(uint8_t) C->out] = b;
+        if(C->out >= start)
+            *dst++ = b;
+        C->out++;
+        C->count--;
+    }
+    return(1);
+}
+
+
+/// @brief Position the decoder at the start of a group
+/// @param[in] *C: decoder state
+/// @param[in] *fp: FILE pointer
+/// @param[in] group: group number
+/// @return 1 on success, 0 on error
+MEMSPACE
+int zimage_seek_group(zimage_cache_t *C, FILE *fp, uint32_t group)
+{
+    uint8_t B[8];
+
+    if(group >= C->Z.groups)
+        return(0);
+    if(!sparse_seek_read(fp, C->Z.index + group * 4, B, 8))
+        return(0);
+
+    C->group = group;
+    C->start = B2V_LSB(B, 0, 4);
+    C->end = B2V_LSB(B, 4, 4);
+    C->in = C->start;
+    C->out = 0;
+    C->op = ZIMAGE_OP_LITERAL;
+    C->count = 0;
+    C->bufpos = 0;
+    C->buflen = 0;
+    return(1);
+}
+
+
+/// @brief Read from a compressed image as if it were a flat image
+/// @param[in] *C: decoder state with image header
+/// @param[in] *fp: FILE pointer
+/// @param[in] pos: flat image offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return bytes read, -1 on error
+MEMSPACE
+long zimage_read(zimage_cache_t *C, FILE *fp, uint32_t pos, void *buf, long size)
+{
+    uint8_t *ptr = (uint8_t *) buf;
+    uint32_t group, glen;
+    long count = 0;
+    uint16_t offset, len;
+
+    while(count < size)
+    {
+        group = pos / C->Z.groupsize;
+        offset = pos % C->Z.groupsize;
+        len = C->Z.groupsize - offset;
+        if(len > size - count)
+            len = size - count;
+
+// Restart the group unless we are reading forward in the cached group
+        if(group != C->group || offset < C->out)
+        {
+            if(!zimage_seek_group(C, fp, group))
+                return(-1);
+        }
+
+// The buffered input must be refetched after the file was reopened
+        C->in -= (C->buflen - C->bufpos);
+        C->bufpos = 0;
+        C->buflen = 0;
+
+        glen = C->end - C->start;
+        if(glen == 0)
+            memset(ptr, C->Z.fill, len);
+        else if(glen == C->Z.groupsize)
+        {
+            if(!sparse_seek_read(fp, C->start + offset, ptr, len))
+                return(-1);
+        }
+        else if(!zimage_decode(C, fp, ptr, offset, len))
+        {
+            C->group = 0xffffffffUL;
+            return(-1);
+        }
+
+        ptr += len;
+        pos += len;
+        count += len;
+    }
+    return(count);
+}
+
+
+/// @brief Get the decoder state for a read from an image
+/// An entry already decoding the group holding pos is reused, otherwise the
+/// least recently used entry is taken so two drives, or directory and file
+/// reads on one drive, keep their own groups
+/// @param[in] *name: image name pointer
+/// @param[in] *fp: open image FILE pointer
+/// @param[in] pos: flat image offset of the read
+/// @return decoder state, NULL on error
+MEMSPACE
+zimage_cache_t *zimage_cache(char *name, FILE *fp, uint32_t pos)
+{
+    zimage_cache_t *C, *same = NULL;
+    uint16_t age, oldest = 0;
+    int i, slot = 0;
+
+    ++zimage_cache_tick;
+    for(i = 0; i < ZIMAGE_CACHE_ENTRIES; ++i)
+    {
+        C = zimage_cache_p[i];
+        if(C == NULL || C->name == NULL)
+            age = 0xffff;
+        else
+        {
+            if(C->name == name)
+            {
+                if(C->group == pos / C->Z.groupsize)
+                {
+                    C->used = zimage_cache_tick;
+                    return(C);
+                }
+                same = C;
+            }
+            age = zimage_cache_tick - C->used;
+        }
+        if(age > oldest)
+        {
+            oldest = age;
+            slot = i;
+        }
+    }
+
+    C = zimage_cache_p[slot];
+    if(C == NULL)
+    {
+        C = safecalloc(sizeof(zimage_cache_t), 1);
+        if(C == NULL)
+        {
+            printf("zimage_cache: not enough free memory\n");
+            return(NULL);
+        }
+        zimage_cache_p[slot] = C;
+    }
+
+// Copy the header if another entry already has this image
+    C->name = NULL;
+    C->group = 0xffffffffUL;
+    if(same)
+        C->Z = same->Z;
+    else if(!zimage_read_header(fp, &C->Z))
+        return(NULL);
+    C->name = name;
+    C->used = zimage_cache_tick;
+    return(C);
+}
+
+
+/// @brief Forget the decoder state for an image
+/// @param[in] *name: image name pointer, NULL forgets any image
+/// @return void
+MEMSPACE
+void zimage_forget(char *name)
+{
+    int i;
+
+    for(i = 0; i < ZIMAGE_CACHE_ENTRIES; ++i)
+    {
+        if(zimage_cache_p[i] && (name == NULL || zimage_cache_p[i]->name == name))
+            zimage_cache_p[i]->name = NULL;
+    }
+}
+
+
+/// @brief Open, Read and Close a compressed image
+/// Used by the disk emulation layer
+/// @see dbf_open_read()
+/// @param[in] *name: compressed image name
+/// @param[in] pos: flat image offset
+/// @param[out] *buf: read buffer
+/// @param[in] size: bytes to read
+/// @return bytes read, -1 on error
+MEMSPACE
+int zimage_open_read(char *name, uint32_t pos, void *buf, int size)
+{
+    FILE *fp;
+    zimage_cache_t *C;
+    long len = -1;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+    {
+        printf("zimage_open_read: Can't open:[%s]\n", name);
+        return(-1);
+    }
+    C = zimage_cache(name, fp, pos);
+    if(C)
+        len = zimage_read(C, fp, pos, buf, size);
+    fclose(fp);
+
+    if(len != size)
+    {
+        printf("zimage_open_read:[%s] read error at:[%lu]\n", name, (unsigned long) pos);
+        return(-1);
+    }
+    return(len);
+}
+
+
+#ifdef LIF_STAND_ALONE
+/// @brief Convert a flat image into a compressed image
+/// @param[in] *flatname: flat image name
+/// @param[in] *zname: compressed image name to create
+/// @return compressed image size in bytes, -1 on error
+MEMSPACE
+long zimage_from_flat(char *flatname, char *zname)
+{
+    FILE *ifp, *ofp;
+    zimage_t Z;
+    struct stat sb;
+    uint8_t *in = NULL, *out = NULL;
+    uint8_t B[4];
+    uint32_t group, offset;
+    int i, len;
+    long ret = -1;
+
+    if(stat(flatname, &sb) < 0)
+    {
+        printf("zimage_from_flat: Can't stat:[%s]\n", flatname);
+        return(-1);
+    }
+
+    Z.version = ZIMAGE_VERSION;
+    Z.blocksize = ZIMAGE_BLOCK_SIZE;
+    Z.groupsize = ZIMAGE_GROUP_SIZE;
+    Z.blocks = (sb.st_size + ZIMAGE_BLOCK_SIZE - 1) / ZIMAGE_BLOCK_SIZE;
+    Z.groups = ((uint32_t) Z.blocks * ZIMAGE_BLOCK_SIZE + ZIMAGE_GROUP_SIZE - 1) / ZIMAGE_GROUP_SIZE;
+    Z.index = ZIMAGE_HEADER_SIZE;
+    Z.data = Z.index + (Z.groups + 1) * 4;
+    Z.fill = 0;
+
+    ifp = fopen(flatname, "rb");
+    if(ifp == NULL)
+    {
+        printf("zimage_from_flat: Can't open:[%s]\n", flatname);
+        return(-1);
+    }
+    ofp = fopen(zname, "wb+");
+    if(ofp == NULL)
+    {
+        printf("zimage_from_flat: Can't create:[%s]\n", zname);
+        fclose(ifp);
+        return(-1);
+    }
+
+    in = safecalloc(ZIMAGE_GROUP_SIZE, 1);
+    out = safecalloc(ZIMAGE_GROUP_SIZE, 1);
+    if(in == NULL || out == NULL)
+    {
+        printf("zimage_from_flat: not enough free memory\n");
+        goto done;
+    }
+
+    if(!zimage_write_header(ofp, &Z))
+        goto done;
+
+    offset = Z.data;
+    for(group = 0; group < Z.groups; ++group)
+    {
+        V2B_LSB(B, 0, 4, offset);
+        if(!sparse_seek_write(ofp, Z.index + group * 4, B, 4))
+            goto done;
+
+        memset(in, Z.fill, ZIMAGE_GROUP_SIZE);
+        if(fread(in, 1, ZIMAGE_GROUP_SIZE, ifp) == 0)
+            break;
+
+        for(i = 0; i < ZIMAGE_GROUP_SIZE; ++i)
+        {
+            if(in[i] != Z.fill)
+                break;
+        }
+// Fill only groups take no space
+        if(i == ZIMAGE_GROUP_SIZE)
+            continue;
+
+        len = zimage_compress(in, ZIMAGE_GROUP_SIZE, out, ZIMAGE_GROUP_SIZE - 1);
+        if(len < 0)
+        {
+// Store groups that do not compress
+            if(!sparse_seek_write(ofp, offset, in, ZIMAGE_GROUP_SIZE))
+                goto done;
+            offset += ZIMAGE_GROUP_SIZE;
+        }
+        else
+        {
+            if(!sparse_seek_write(ofp, offset, out, len))
+                goto done;
+            offset += len;
+        }
+        if((group % 100) == 0)
+            printf("\tGroup: %lu\r", (unsigned long) group);
+    }
+
+    V2B_LSB(B, 0, 4, offset);
+    if(!sparse_seek_write(ofp, Z.index + Z.groups * 4, B, 4))
+        goto done;
+
+    ret = offset;
+    printf("\t%s: %lu groups, %lu bytes of %lu bytes\n",
+        zname, (unsigned long) Z.groups, (unsigned long) offset,
+        (unsigned long) Z.blocks * ZIMAGE_BLOCK_SIZE);
+
+done:
+    if(ret < 0)
+        printf("zimage_from_flat: write failed:[%s]\n", zname);
+    if(in)
+        safefree(in);
+    if(out)
+        safefree(out);
+    fclose(ifp);
+    fclose(ofp);
+    sync();
+    return(ret);
+}
+
+
+/// @brief Convert a compressed image into a flat image
+/// @param[in] *zname: compressed image name
+/// @param[in] *flatname: flat image name to create
+/// @return blocks written, -1 on error
+MEMSPACE
+long zimage_to_flat(char *zname, char *flatname)
+{
+    FILE *ifp, *ofp;
+    zimage_cache_t *C;
+    uint8_t buf[ZIMAGE_BLOCK_SIZE];
+    uint32_t block;
+
+    ifp = fopen(zname, "rb");
+    if(ifp == NULL)
+    {
+        printf("zimage_to_flat: Can't open:[%s]\n", zname);
+        return(-1);
+    }
+    C = zimage_cache(zname, ifp, 0);
+    if(C == NULL || C->Z.blocksize != ZIMAGE_BLOCK_SIZE)
+    {
+        printf("zimage_to_flat: [%s] is not a compressed image\n", zname);
+        fclose(ifp);
+        return(-1);
+    }
+    ofp = fopen(flatname, "wb");
+    if(ofp == NULL)
+    {
+        printf("zimage_to_flat: Can't create:[%s]\n", flatname);
+        fclose(ifp);
+        return(-1);
+    }
+
+    for(block = 0; block < C->Z.blocks; ++block)
+    {
+        if(zimage_read(C, ifp, block * ZIMAGE_BLOCK_SIZE, buf, sizeof(buf)) != sizeof(buf)
+                || fwrite(buf, 1, sizeof(buf), ofp) != sizeof(buf))
+        {
+            printf("zimage_to_flat: failed at block:[%lu]\n", (unsigned long) block);
+            zimage_forget(zname);
+            fclose(ifp);
+            fclose(ofp);
+            return(-1);
+        }
+        if((block % 1000) == 0)
+            printf("\tBlock: %lu\r", (unsigned long) block);
+    }
+    zimage_forget(zname);
+
+    fclose(ifp);
+    fclose(ofp);
+    sync();
+
+    printf("\t%s: wrote %lu blocks\n", flatname, (unsigned long) block);
+    return(block);
+}
+
+
+/// @brief Display compressed image header
+/// @param[in] *name: compressed image name
+/// @return 1 on success, 0 on error
+MEMSPACE
+int zimage_info(char *name)
+{
+    FILE *fp;
+    zimage_t Z;
+    struct stat sb;
+
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+    {
+        printf("zimage_info: Can't open:[%s]\n", name);
+        return(0);
+    }
+    if(!zimage_read_header(fp, &Z))
+    {
+        printf("zimage_info: [%s] is not a compressed image\n", name);
+        fclose(fp);
+        return(0);
+    }
+    fclose(fp);
+
+    if(stat(name, &sb) < 0)
+        sb.st_size = 0;
+
+    printf("Compressed image: %s\n", name);
+    printf("  Block size:     %u\n", (unsigned) Z.blocksize);
+    printf("  Group size:     %u\n", (unsigned) Z.groupsize);
+    printf("  Blocks:         %lu\n", (unsigned long) Z.blocks);
+    printf("  Groups:         %lu\n", (unsigned long) Z.groups);
+    printf("  Index:          %lu\n", (unsigned long) Z.index);
+    printf("  Data:           %lu\n", (unsigned long) Z.data);
+    printf("  File size:      %lu\n", (unsigned long) sb.st_size);
+    printf("  Image size:     %lu\n", (unsigned long) Z.blocks * Z.blocksize);
+    return(1);
+}
+
+
+/// @brief Compare sector read latency of a flat image and its compressed image
+/// Each read opens, seeks, reads and closes the image the same way the
+/// emulator does for every disk transfer
+/// @param[in] *flatname: flat image name
+/// @param[in] *zname: compressed image name made from flatname
+/// @param[in] reads: number of sector reads per test
+/// @return 1 on success, 0 on error or data mismatch
+MEMSPACE
+int zimage_bench(char *flatname, char *zname, long reads)
+{
+    FILE *fp;
+    zimage_t Z;
+    struct timespec start;
+    uint8_t fbuf[ZIMAGE_BLOCK_SIZE];
+    uint8_t zbuf[ZIMAGE_BLOCK_SIZE];
+    uint32_t seed, block;
+    long i, errors = 0;
+    long us;
+    int pass;
+
+    fp = fopen(zname, "rb");
+    if(fp == NULL || !zimage_read_header(fp, &Z))
+    {
+        printf("zimage_bench: [%s] is not a compressed image\n", zname);
+        if(fp)
+            fclose(fp);
+        return(0);
+    }
+    fclose(fp);
+
+    if(reads <= 0)
+        reads = 1000;
+
+    zimage_forget(NULL);
+
+// pass 0 sequential, pass 1 random
+    for(pass = 0; pass < 2; ++pass)
+    {
+        seed = 1;
+        clock_gettime(0, &start);
+        for(i = 0; i < reads; ++i)
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            block = pass ? (seed >> 8) % Z.blocks : i % Z.blocks;
+            fp = fopen(flatname, "rb");
+            if(fp == NULL)
+            {
+                printf("zimage_bench: Can't open:[%s]\n", flatname);
+                return(0);
+            }
+            sparse_seek_read(fp, block * ZIMAGE_BLOCK_SIZE, fbuf, sizeof(fbuf));
+            fclose(fp);
+        }
+        us = lif_elapsed_us(&start);
+        printf("%-10s flat:       %8ld reads, %8ld us, %6ld us/read\n",
+            pass ? "random" : "sequential", reads, us, us / reads);
+
+        seed = 1;
+        clock_gettime(0, &start);
+        for(i = 0; i < reads; ++i)
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            block = pass ? (seed >> 8) % Z.blocks : i % Z.blocks;
+            if(zimage_open_read(zname, block * ZIMAGE_BLOCK_SIZE, zbuf, sizeof(zbuf)) != sizeof(zbuf))
+                ++errors;
+        }
+        us = lif_elapsed_us(&start);
+        printf("%-10s compressed: %8ld reads, %8ld us, %6ld us/read\n",
+            pass ? "random" : "sequential", reads, us, us / reads);
+
+// Verify outside of the timed loops
+        seed = 1;
+        for(i = 0; i < reads; ++i)
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            block = pass ? (seed >> 8) % Z.blocks : i % Z.blocks;
+            fp = fopen(flatname, "rb");
+            if(fp == NULL)
+                return(0);
+            memset(fbuf, 0, sizeof(fbuf));
+            sparse_seek_read(fp, block * ZIMAGE_BLOCK_SIZE, fbuf, sizeof(fbuf));
+            fclose(fp);
+            if(zimage_open_read(zname, block * ZIMAGE_BLOCK_SIZE, zbuf, sizeof(zbuf)) != sizeof(zbuf)
+                    || memcmp(fbuf, zbuf, sizeof(fbuf)) != 0)
+                ++errors;
+        }
+    }
+    zimage_forget(NULL);
+
+    if(errors)
+        printf("zimage_bench: %ld data errors\n", errors);
+    return(errors ? 0 : 1);
+}
+#endif                                            // LIF_STAND_ALONE
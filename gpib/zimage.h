@@ -0,0 +1,119 @@
+/**
+ @file gpib/zimage.h
+ @brief Read only block compressed disk image support for HP85 disk emulator project for AVR.
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+*/
+
+#ifndef _ZIMAGE_H
+#define _ZIMAGE_H
+
+/**
+  @brief Compressed image layout
+  All values are stored LSB first
+
+    OFFSET  DESCRIPTION
+    ------  -----------------------------------------------------------
+    header sector (ZIMAGE_HEADER_SIZE bytes)
+      0-7   Magic "HPZIMAGE"
+      8-9   Version
+     10-11  Block size in bytes
+     12-13  Group size in bytes
+     14-17  Image size in blocks as seen by the emulator
+     18-21  Number of groups
+     22-25  File offset of the group index
+     26-29  File offset of the first group
+       30   Fill byte
+
+    index   groups + 1 file offsets, group N is [index[N], index[N+1])
+            A group of length 0 only contains the fill byte
+            A group of length group size is stored uncompressed
+    data    Independently compressed groups
+
+  @brief Group encoding - one control byte followed by its arguments
+    0x00-0x7f  Literal  (c + 1) bytes follow
+    0x80-0xbf  Run      repeat next byte (c & 0x3f) + 3 times
+    0xc0-0xff  Copy     (c & 0x3f) + 3 bytes from distance next byte + 1
+  Copies reach back at most ZIMAGE_WINDOW bytes so the decoder only needs
+  a ZIMAGE_WINDOW byte history ring and never a whole group in RAM
+*/
+
+#define ZIMAGE_MAGIC "HPZIMAGE"
+#define ZIMAGE_MAGIC_SIZE 8
+#define ZIMAGE_VERSION 1
+#define ZIMAGE_BLOCK_SIZE 256
+#define ZIMAGE_GROUP_SIZE 4096
+#define ZIMAGE_HEADER_SIZE 256
+#define ZIMAGE_WINDOW 256
+#define ZIMAGE_MIN_MATCH 3
+#define ZIMAGE_MAX_MATCH (0x3f + ZIMAGE_MIN_MATCH)
+#define ZIMAGE_MAX_LITERAL 128
+#define ZIMAGE_INBUF 32
+
+///@brief Decoder states kept, about 330 bytes each, allocated as images are read
+#ifndef ZIMAGE_CACHE_ENTRIES
+#define ZIMAGE_CACHE_ENTRIES 4
+#endif
+
+///@brief decoder operations
+#define ZIMAGE_OP_LITERAL 0
+#define ZIMAGE_OP_RUN     1
+#define ZIMAGE_OP_COPY    2
+
+///@brief Compressed image header
+typedef struct _zimage
+{
+    uint16_t version;                             // 8
+    uint16_t blocksize;                           // 10
+    uint16_t groupsize;                           // 12
+    uint32_t blocks;                              // 14
+    uint32_t groups;                              // 18
+    uint32_t index;                               // 22
+    uint32_t data;                                // 26
+    uint8_t  fill;                                // 30
+} zimage_t;
+
+///@brief Decoder state for a recently read group, see zimage_cache()
+/// Sequential reads inside a group continue where the last read stopped
+typedef struct
+{
+    char *name;                                   // Image name pointer, cache key
+    zimage_t Z;                                   // Image header
+    uint32_t group;                               // Group being decoded
+    uint16_t used;                                // zimage_cache_tick of last use
+    uint32_t start;                               // Group file offset
+    uint32_t end;                                 // Group end file offset
+    uint32_t in;                                  // File offset of next input byte
+    uint16_t out;                                 // Bytes decoded in this group
+    uint8_t  op;                                  // Current operation
+    uint8_t  count;                               // Bytes left in current operation
+    uint8_t  arg;                                 // Run byte or copy distance - 1
+    uint8_t  bufpos;                              // Input buffer index
+    uint8_t  buflen;                              // Input buffer length
+    uint8_t  buf[ZIMAGE_INBUF];                   // Input buffer
+    uint8_t  ring[ZIMAGE_WINDOW];                 // History ring
+} zimage_cache_t;
+
+/* zimage.c */
+MEMSPACE int zimage_read_header ( FILE *fp , zimage_t *Z );
+MEMSPACE int zimage_write_header ( FILE *fp , zimage_t *Z );
+MEMSPACE int zimage_check ( char *name );
+MEMSPACE int zimage_compress ( uint8_t *in , int size , uint8_t *out , int max );
+MEMSPACE int zimage_getc ( zimage_cache_t *C , FILE *fp );
+MEMSPACE int zimage_decode ( zimage_cache_t *C , FILE *fp , uint8_t *dst , uint16_t start , uint16_t len );
+MEMSPACE int zimage_seek_group ( zimage_cache_t *C , FILE *fp , uint32_t group );
+MEMSPACE long zimage_read ( zimage_cache_t *C , FILE *fp , uint32_t pos , void *buf , long size );
+MEMSPACE zimage_cache_t *zimage_cache ( char *name , FILE *fp , uint32_t pos );
+MEMSPACE void zimage_forget ( char *name );
+MEMSPACE int zimage_open_read ( char *name , uint32_t pos , void *buf , int size );
+#ifdef LIF_STAND_ALONE
+MEMSPACE long zimage_from_flat ( char *flatname , char *zname );
+MEMSPACE long zimage_to_flat ( char *zname , char *flatname );
+MEMSPACE int zimage_info ( char *name );
+MEMSPACE int zimage_bench ( char *flatname , char *zname , long reads );
+#endif
+
+#endif                                            // _ZIMAGE_H
@@ -26,9 +26,7 @@ void uart_rx_flush(uint8_t uart)
 
     cli();
 
-    uarts[uart].rx_count = 0;
-    uarts[uart].rx_head = 0;
-    uarts[uart].rx_tail = 0;
+    ring_init(&uarts[uart].rx, uarts[uart].rx_buf, RX_BUF_SIZE);
     uarts[uart].rx_flow = 0;
     uarts[uart].rx_error = 0;
 
@@ -128,6 +126,7 @@ uint32_t uart_init(uint8_t uart, uint32_t baud)
     if(uart == 0)                                 /* uart == 0( first serial ) */
     {
         uart_rx_flush(0);
+        uart_tx_init(0);
 
         cli();
 
@@ -153,6 +152,7 @@ uint32_t uart_init(uint8_t uart, uint32_t baud)
     if(uart == 1)                                 /* uart == 0( first serial ) */
     {
         uart_rx_flush(1);
+        uart_tx_init(1);
 
         cli();
 
@@ -206,18 +206,226 @@ ISR(USART1_RX_vect)
 /// @return void.
 void uart_rx_interrupt(uint8_t uart, uint8_t data)
 {
-    if (uarts[uart].rx_count < RX_BUF_SIZE )
-    {
 // MG 10 June 2020 mask off bit 7
-        uarts[uart].rx_buf[uarts[uart].rx_head++] = data & 0x7f;
-        uarts[uart].rx_count++;
-        if (uarts[uart].rx_head >= RX_BUF_SIZE )
-            uarts[uart].rx_head = 0;
+    if( !ring_putc(&uarts[uart].rx, data & 0x7f) )
+        uarts[uart].rx_error |= RX_OVERFLOW;      // Overflow
+}
+
+
+/// @brief  Reset the transmit ring buffer for specified uart.
+///
+/// - Characters not yet sent are discarded.
+///
+/// @return  void
+void uart_tx_init(uint8_t uart)
+{
+    uint8_t sreg;
+
+    if(uart >= UARTS)
+        return;
+
+    sreg = SREG;
+    cli();
+
+    ring_init(&uarts[uart].tx, uarts[uart].tx_buf, TX_BUF_SIZE);
+    uarts[uart].tx_dropped = 0;
+    uarts[uart].tx_policy = TX_POLICY;
+
+    SREG = sreg;
+}
+
+
+/// @brief  Enable the transmit data register empty interrupt.
+///
+/// - UCSRnB is outside the sbi range so save and restore the interrupt state.
+///
+/// @param[in] uart: uart number.
+///
+/// @return  void
+void uart_tx_enable(uint8_t uart)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    if(uart == 0)
+        BIT_SET(UCSR0B, UDRIE0);
+#if UARTS > 1
+    if(uart == 1)
+        BIT_SET(UCSR1B, UDRIE1);
+#endif
+    SREG = sreg;
+}
+
+
+/// @brief  UART 0 Transmit Interrupt runction
+/// @see uart_tx_interrupt().
+ISR(USART0_UDRE_vect)
+{
+    uart_tx_interrupt(0);
+}
+
+
+#if UARTS > 1
+/// @brief  UART 1 Transmit Interrupt runction.
+/// @see uart_tx_interrupt().
+ISR(USART1_UDRE_vect)
+{
+    uart_tx_interrupt(1);
+}
+#endif
+
+/// @brief  UART Transmit Interrupt task.
+///  - Send the next character from the transmit ring buffer.
+///  - Disable the interrupt when the ring buffer is empty.
+///
+/// @param[in] uart: uart number.
+///
+/// @return void.
+void uart_tx_interrupt(uint8_t uart)
+{
+    int c = ring_getc(&uarts[uart].tx);
+
+    if(c == EOF)
+    {
+        if(uart == 0)
+            BIT_CLR(UCSR0B, UDRIE0);
+#if UARTS > 1
+        if(uart == 1)
+            BIT_CLR(UCSR1B, UDRIE1);
+#endif
+        return;
     }
-    else                                          // Overflow
+
+// Clear TXC, write one to clear, so uart_tx_flush() can wait for this character
+    if(uart == 0)
+    {
+        UCSR0A = (UCSR0A & (1<<U2X0)) | (1<<TXC0);
+        UDR0 = c;
+    }
+#if UARTS > 1
+    if(uart == 1)
     {
-        uarts[uart].rx_error |= RX_OVERFLOW;
+        UCSR1A = (UCSR1A & (1<<U2X1)) | (1<<TXC1);
+        UDR1 = c;
     }
+#endif
+    uarts[uart].tx_sent = 1;
+}
+
+
+/// @brief  Send one character from the transmit ring buffer without interrupts.
+///
+/// - Only called with interrupts disabled, so the interrupt can not run.
+///
+/// @param[in] uart: uart number.
+///
+/// @return void.
+void uart_tx_poll(uint8_t uart)
+{
+    if(!ring_used(&uarts[uart].tx))
+        return;
+
+    if(uart == 0)
+    {
+        if(!BIT_TST(UCSR0A, UDRE0))
+            return;
+    }
+#if UARTS > 1
+    if(uart == 1)
+    {
+        if(!BIT_TST(UCSR1A, UDRE1))
+            return;
+    }
+#endif
+    uart_tx_interrupt(uart);
+}
+
+
+/// @brief  return count of characters waiting in UART transmit ring buffer.
+///
+/// @param[in] uart: uart number to check count for.
+///
+/// @return  Character count in transmit ring buffer.
+int uart_tx_count(uint8_t uart)
+{
+    if(uart >= UARTS)
+        return(EOF);
+
+    return( ring_used(&uarts[uart].tx) );
+}
+
+
+/// @brief  Wait for all queued characters to be sent.
+///
+/// - Works with interrupts enabled or disabled.
+/// - Call before a reset or a long section with interrupts disabled.
+///
+/// @param[in] uart: uart number.
+///
+/// @return void.
+void uart_tx_flush(uint8_t uart)
+{
+    if(uart >= UARTS)
+        return;
+
+    while(ring_used(&uarts[uart].tx))
+    {
+        if(!BIT_TST(SREG, SREG_I))
+            uart_tx_poll(uart);
+    }
+
+// Wait for the last character to leave the shift register
+// TXC is only set once a character has been sent
+    if(!uarts[uart].tx_sent)
+        return;
+    if(uart == 0)
+    {
+        while (!BIT_TST(UCSR0A, TXC0))
+            ;
+    }
+#if UARTS > 1
+    if(uart == 1)
+    {
+        while (!BIT_TST(UCSR1A, TXC1))
+            ;
+    }
+#endif
+    uarts[uart].tx_sent = 0;
+}
+
+
+/// @brief  Set the transmit overflow policy.
+///
+/// @param[in] uart: uart number.
+/// @param[in] policy: TX_BLOCK, TX_DROP or -1 to only return the current policy.
+///
+/// @return  previous policy.
+/// @return  EOF on error.
+int uart_tx_policy(uint8_t uart, int policy)
+{
+    int old;
+
+    if(uart >= UARTS)
+        return(EOF);
+
+    old = uarts[uart].tx_policy;
+    if(policy == TX_BLOCK || policy == TX_DROP)
+        uarts[uart].tx_policy = policy;
+    return(old);
+}
+
+
+/// @brief  Characters discarded because the transmit ring buffer was full.
+///
+/// @param[in] uart: uart number.
+///
+/// @return  dropped character count.
+uint16_t uart_tx_dropped(uint8_t uart)
+{
+    if(uart >= UARTS)
+        return(0);
+
+    return(uarts[uart].tx_dropped);
 }
 
 
@@ -226,15 +434,10 @@ void uart_rx_interrupt(uint8_t uart, uint8_t data)
 /// @return 0 on error.
 int uart_peek_tail(uint8_t uart)
 {
-    uint8_t c;
-
     if(uart >= UARTS)
         return(EOF);
 
-    cli();
-    c = uarts[uart].rx_buf[uarts[uart].rx_tail];
-    sei();
-    return (c & 0xff);
+    return ( ring_peek(&uarts[uart].rx) & 0xff );
 }
 
 
@@ -258,12 +461,7 @@ int uart_get_tail(uint8_t uart)
     while(uart_rx_count(uart) < 1)
         ;
 
-    cli();
-    c = uarts[uart].rx_buf[uarts[uart].rx_tail++];
-    if (uarts[uart].rx_tail >= RX_BUF_SIZE)
-        uarts[uart].rx_tail = 0;
-    uarts[uart].rx_count--;
-    sei();
+    c = ring_getc(&uarts[uart].rx);
 
     return (c & 0xff);
 }
@@ -276,18 +474,10 @@ int uart_get_tail(uint8_t uart)
 /// @return  Character count in ring buffer.
 int uart_rx_count(uint8_t uart)
 {
-    int count;
-
     if(uart >= UARTS)
         return(EOF);
 
-    cli();
-
-    count = uarts[uart].rx_count;
-
-    sei();
-
-    return (count );
+    return ( ring_used(&uarts[uart].rx) );
 }
 
 
@@ -338,31 +528,36 @@ int uart_getchar(uint8_t uart)
 }
 
 
-/// @brief Transmit 1 byte on uart.
+/// @brief Queue 1 byte for transmit on uart.
+///
+/// - Returns as soon as the byte is in the transmit ring buffer.
+/// - When the ring buffer is full the uart tx_policy decides:
+///   TX_BLOCK waits for room, TX_DROP discards the byte and counts it.
+/// - With interrupts disabled we send the oldest bytes ourselves to make room.
 ///
 /// @param[in] c: transmit character.
 /// @param[in] uart: uart number.
 ///
-/// @return void.
+/// @return c.
+/// @return EOF on error or when the byte was dropped.
 int uart_tx_byte(int c, uint8_t uart)
 {
-    if(uart == 0)
-    {
-        while (!BIT_TST(UCSR0A, UDRE0))
-            ;
-        UDR0 = c & 0x7f;
-        return(c);
-    }
-#ifdef UARTS > 1
-    if(uart == 1)
+    if(uart >= UARTS)
+        return(EOF);
+
+    while( !ring_putc(&uarts[uart].tx, c & 0x7f) )
     {
-        while (!BIT_TST(UCSR1A, UDRE1))
-            ;
-        UDR1 = c & 0x7f;
-        return(c);
+        if(uarts[uart].tx_policy == TX_DROP)
+        {
+            uarts[uart].tx_dropped++;
+            return(EOF);
+        }
+        if(!BIT_TST(SREG, SREG_I))
+            uart_tx_poll(uart);
     }
-#endif
-    return(EOF);
+
+    uart_tx_enable(uart);
+    return(c);
 }
 
 
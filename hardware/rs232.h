@@ -15,11 +15,24 @@
 
 #include "user_config.h"
 
-#define RX_BUF_SIZE 80
+///@brief Receive ring buffer size, MUST be a power of 2 no larger than RING_SIZE_MAX
+#define RX_BUF_SIZE 128
 #define RX_FLOW_WINDOW 20
 
 #define RX_OVERFLOW 1
 
+///@brief Transmit ring buffer size, MUST be a power of 2 no larger than RING_SIZE_MAX
+#define TX_BUF_SIZE 128
+
+///@brief Transmit overflow policy when the ring buffer is full
+/// TX_BLOCK: wait for the interrupt to make room, nothing is lost
+/// TX_DROP:  discard the character and count it, never waits
+#define TX_BLOCK 0
+#define TX_DROP  1
+#ifndef TX_POLICY
+#define TX_POLICY TX_BLOCK
+#endif
+
 #define XON_CHAR    0x11
 #define XOFF_CHAR   0x13
 
@@ -33,12 +46,17 @@
 
 struct _uart
 {
-    uint8_t rx_head;
-    uint8_t rx_tail;
+// Receive ring, producer the RX interrupt and consumer uart_get_tail()
+    ring_t  rx;
     uint8_t rx_flow;
-    int     rx_count;
     uint8_t rx_error;
-    uint8_t rx_buf[RX_BUF_SIZE+1];
+    uint8_t rx_buf[RX_BUF_SIZE];
+// Transmit ring, producer uart_tx_byte() and consumer the UDRE interrupt
+    ring_t  tx;
+    uint8_t tx_policy;                            // TX_BLOCK or TX_DROP
+    uint16_t tx_dropped;                          // Characters discarded by TX_DROP
+    uint8_t tx_sent;                              // Character written since uart_tx_flush()
+    uint8_t tx_buf[TX_BUF_SIZE];
 };
 
 #define UARTS 1
@@ -53,6 +71,14 @@ int uart0_putchar ( int c , void *f );
 uint16_t uart_ubr ( uint32_t baud , int *u2x , uint32_t *actual );
 uint32_t uart_init ( uint8_t uart , uint32_t baud );
 void uart_rx_interrupt ( uint8_t uart , uint8_t data );
+void uart_tx_interrupt ( uint8_t uart );
+void uart_tx_init ( uint8_t uart );
+void uart_tx_enable ( uint8_t uart );
+void uart_tx_poll ( uint8_t uart );
+int uart_tx_count ( uint8_t uart );
+void uart_tx_flush ( uint8_t uart );
+int uart_tx_policy ( uint8_t uart , int policy );
+uint16_t uart_tx_dropped ( uint8_t uart );
 int uart_peek_tail ( uint8_t uart );
 int uart_get_tail ( uint8_t uart );
 int uart_rx_count ( uint8_t uart );
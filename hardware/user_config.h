@@ -76,7 +76,9 @@ void copyright( void );
 
 #include "lib/time.h"
 #include "lib/timer.h"
+#include "lib/sched.h"
 #include "lib/queue.h"
+#include "lib/ring.h"
 #include "hardware/rtc.h"
 
 #include "fatfs.sup/fatfs.h"
@@ -265,3 +265,47 @@ int queue_popc(queue_t *q)
     }
     return(0);
 }
+
+
+/**
+  @brief Find the largest block of queued data that does not wrap
+     Lets the caller write directly from the ring buffer without a copy.
+     Use queue_drop() to remove the bytes once they have been used.
+  @param[in] *q: ring buffer pointer
+  @param[out] **ptr: start of the data
+  @return number of contiguous bytes at *ptr
+*/
+size_t queue_contiguous(queue_t *q, uint8_t **ptr)
+{
+    size_t bytes;
+
+    if(!q || !q->buf || !q->bytes)
+        return(0);
+
+    bytes = q->size - q->out;
+    if(bytes > q->bytes)
+        bytes = q->bytes;
+    *ptr = (uint8_t *) q->buf + q->out;
+    return(bytes);
+}
+
+
+/**
+  @brief Remove bytes from the ring buffer without copying them
+  @param[in] *q: ring buffer pointer
+  @param[in] size: bytes to remove
+  @return number of bytes actually removed - may not be size!
+*/
+size_t queue_drop(queue_t *q, size_t size)
+{
+    if(!q || !q->buf)
+        return(0);
+
+    if(size > q->bytes)
+        size = q->bytes;
+    q->out += size;
+    if(q->out >= q->size)
+        q->out -= q->size;
+    q->bytes -= size;
+    return(size);
+}
@@ -54,4 +54,6 @@ size_t queue_push_buffer ( queue_t *q , uint8_t *src , size_t size );
 size_t queue_pop_buffer ( queue_t *q , uint8_t *dst , size_t size );
 int queue_pushc ( queue_t *q , uint8_t c );
 int queue_popc ( queue_t *q );
+size_t queue_contiguous ( queue_t *q , uint8_t **ptr );
+size_t queue_drop ( queue_t *q , size_t size );
 #endif
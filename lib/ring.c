@@ -0,0 +1,365 @@
+/**
+ @file ring.c
+
+ @brief Single producer single consumer ring buffer
+ @par Copyright &copy; 2015 Mike Gore, GPL License
+ @par You are free to use this code under the terms of GPL
+  Please retain a copy of this notice in any code you use it in.
+
+  This is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or (at your option)
+any later version.
+
+This software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "user_config.h"
+
+#ifdef AVR
+#include <stdlib.h>
+#endif
+
+#include "ring.h"
+
+/// @brief Read or write the index owned by the other side of the ring
+/// A 16 bit access is two instructions on AVR so an interrupt could see
+/// half an update - this only costs a few cycles
+#if defined(AVR) && RING_INDEX_BITS != 8
+static inline ring_index_t ring_load(volatile ring_index_t *p)
+{
+    ring_index_t v;
+    uint8_t sreg = SREG;
+
+    cli();
+    v = *p;
+    SREG = sreg;
+    return(v);
+}
+
+static inline void ring_store(volatile ring_index_t *p, ring_index_t v)
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    *p = v;
+    SREG = sreg;
+}
+#else
+#define ring_load(p) (*(p))
+#define ring_store(p,v) (*(p) = (ring_index_t) (v))
+#endif
+
+
+/**
+  @brief Set up a ring buffer using caller supplied memory
+     Use this for rings shared with interrupts so no memory is allocated
+  @param[in] *r: ring buffer pointer
+  @param[in] *buf: ring buffer memory, size bytes
+  @param[in] size: size of ring buffer, a power of 2 no larger than RING_SIZE_MAX
+  @return 0 on success, -1 if size is not valid
+*/
+int ring_init(ring_t *r, uint8_t *buf, uint16_t size)
+{
+    if(!r || !buf || !size || size > RING_SIZE_MAX || (size & (size-1)))
+        return(-1);
+    r->buf = buf;
+    r->mask = size - 1;
+    r->head = 0;
+    r->tail = 0;
+    return(0);
+}
+
+
+/**
+  @brief Create a ring buffer of a given size
+  @param[in] size: size of ring buffer, a power of 2 no larger than RING_SIZE_MAX
+  @return pointer to ring buffer structure, NULL on error
+*/
+ring_t *ring_new(uint16_t size)
+{
+    uint8_t *buf;
+    ring_t *r = safecalloc( sizeof(ring_t),1);
+    if(!r)
+        return(NULL);
+    buf = safecalloc(size,1);
+    if(!buf || ring_init(r, buf, size) < 0)
+    {
+        if(buf)
+            safefree(buf);
+        safefree(r);
+        return(NULL);
+    }
+    return(r);
+}
+
+
+/**
+  @brief Delete a ring buffer made by ring_new() and free memory
+  @param[in] *r: ring buffer pointer
+  @return void
+*/
+void ring_del(ring_t *r)
+{
+    if(!r)
+        return;
+    if(r->buf)
+    {
+        safefree(r->buf);
+        r->buf = NULL;
+    }
+    safefree(r);
+}
+
+
+/**
+  @brief Size of the ring buffer
+  @param[in] *r: ring buffer pointer
+  @return size in bytes
+*/
+uint16_t ring_size(ring_t *r)
+{
+    return( (uint16_t) r->mask + 1 );
+}
+
+
+/**
+  @brief Find the number of bytes used by the ring buffer
+     Safe from either side - the result may already be stale
+  @param[in] *r: ring buffer pointer
+  @return the number of bytes used in the ring buffer
+*/
+uint16_t ring_used(ring_t *r)
+{
+    return( (ring_index_t) (ring_load(&r->head) - ring_load(&r->tail)) );
+}
+
+
+/**
+  @brief Find the amount of free space remaining in the ring buffer
+  @param[in] *r: ring buffer pointer
+  @return bytes remaining in ring buffer
+*/
+uint16_t ring_space(ring_t *r)
+{
+    return( ring_size(r) - ring_used(r) );
+}
+
+
+/**
+  @brief Discard all data in the ring buffer
+     Consumer side only
+  @param[in] *r: ring buffer pointer
+  @return void
+*/
+void ring_flush(ring_t *r)
+{
+    ring_store(&r->tail, ring_load(&r->head));
+}
+
+
+/**
+  @brief Add a byte to the ring buffer
+     Producer side only, does not wait for space
+  @param[in] *r: ring buffer pointer
+  @param[in] c: byte to add
+  @return 1 if added, 0 if the ring buffer was full
+*/
+int ring_putc(ring_t *r, uint8_t c)
+{
+    ring_index_t head = r->head;
+
+    if( (ring_index_t) (head - ring_load(&r->tail)) > r->mask )
+        return(0);
+    r->buf[head & r->mask] = c;
+    RING_BARRIER();
+    ring_store(&r->head, head + 1);
+    return(1);
+}
+
+
+/**
+  @brief Remove a byte from the ring buffer
+     Consumer side only, does not wait for data
+  @param[in] *r: ring buffer pointer
+  @return byte, or EOF if the ring buffer was empty
+*/
+int ring_getc(ring_t *r)
+{
+    ring_index_t tail = r->tail;
+    uint8_t c;
+
+    if(tail == ring_load(&r->head))
+        return(EOF);
+    RING_BARRIER();
+    c = r->buf[tail & r->mask];
+    RING_BARRIER();
+    ring_store(&r->tail, tail + 1);
+    return(c);
+}
+
+
+/**
+  @brief Return the next byte without removing it
+     Consumer side only
+  @param[in] *r: ring buffer pointer
+  @return byte, or EOF if the ring buffer was empty
+*/
+int ring_peek(ring_t *r)
+{
+    ring_index_t tail = r->tail;
+
+    if(tail == ring_load(&r->head))
+        return(EOF);
+    RING_BARRIER();
+    return(r->buf[tail & r->mask]);
+}
+
+
+/**
+  @brief Find the largest free block that does not wrap
+     Lets the producer fill the ring buffer directly without a copy.
+     Use ring_write_commit() to add the bytes once they are written.
+     Producer side only
+  @param[in] *r: ring buffer pointer
+  @param[out] **ptr: start of the free block
+  @return number of contiguous free bytes at *ptr
+*/
+uint16_t ring_write_span(ring_t *r, uint8_t **ptr)
+{
+    ring_index_t head = r->head;
+    uint16_t size = ring_size(r);
+    uint16_t space = size - (ring_index_t) (head - ring_load(&r->tail));
+    uint16_t pos = head & r->mask;
+    uint16_t len = size - pos;
+
+    if(len > space)
+        len = space;
+    *ptr = r->buf + pos;
+    return(len);
+}
+
+
+/**
+  @brief Add bytes written into the span from ring_write_span()
+     Producer side only
+  @param[in] *r: ring buffer pointer
+  @param[in] size: bytes to add, no more than the span size
+  @return void
+*/
+void ring_write_commit(ring_t *r, uint16_t size)
+{
+    RING_BARRIER();
+    ring_store(&r->head, r->head + size);
+}
+
+
+/**
+  @brief Find the largest block of data that does not wrap
+     Lets the consumer use data directly from the ring buffer without a copy.
+     Use ring_read_commit() to remove the bytes once they have been used.
+     Consumer side only
+  @param[in] *r: ring buffer pointer
+  @param[out] **ptr: start of the data
+  @return number of contiguous bytes at *ptr
+*/
+uint16_t ring_read_span(ring_t *r, uint8_t **ptr)
+{
+    ring_index_t tail = r->tail;
+    uint16_t used = (ring_index_t) (ring_load(&r->head) - tail);
+    uint16_t pos = tail & r->mask;
+    uint16_t len = ring_size(r) - pos;
+
+    RING_BARRIER();
+    if(len > used)
+        len = used;
+    *ptr = r->buf + pos;
+    return(len);
+}
+
+
+/**
+  @brief Remove bytes used from the span from ring_read_span()
+     Consumer side only
+  @param[in] *r: ring buffer pointer
+  @param[in] size: bytes to remove, no more than the span size
+  @return void
+*/
+void ring_read_commit(ring_t *r, uint16_t size)
+{
+    RING_BARRIER();
+    ring_store(&r->tail, r->tail + size);
+}
+
+
+/**
+  @brief Add a data buffer to the ring buffer
+     Copies at most two spans, does not wait for space.
+     So you must check that the return value matches the size.
+     Producer side only
+  @param[in] *r: ring buffer pointer
+  @param[in] *src: input buffer
+  @param[in] size: size of input buffer
+  @return number of bytes actually added to the buffer - may not be size!
+*/
+uint16_t ring_write(ring_t *r, const uint8_t *src, uint16_t size)
+{
+    uint8_t *ptr;
+    uint16_t len;
+    uint16_t bytes = 0;
+
+    while(size)
+    {
+        len = ring_write_span(r, &ptr);
+        if(!len)
+            break;
+        if(len > size)
+            len = size;
+        memcpy(ptr, src, len);
+        ring_write_commit(r, len);
+        src += len;
+        size -= len;
+        bytes += len;
+    }
+    return(bytes);
+}
+
+
+/**
+  @brief Get a data buffer from the ring buffer
+     Copies at most two spans, does not wait for data.
+     So you must check that the return value matches the size.
+     Consumer side only
+  @param[in] *r: ring buffer pointer
+  @param[out] *dst: output buffer
+  @param[in] size: size of output buffer
+  @return number of bytes actually removed from the buffer - may not be size!
+*/
+uint16_t ring_read(ring_t *r, uint8_t *dst, uint16_t size)
+{
+    uint8_t *ptr;
+    uint16_t len;
+    uint16_t bytes = 0;
+
+    while(size)
+    {
+        len = ring_read_span(r, &ptr);
+        if(!len)
+            break;
+        if(len > size)
+            len = size;
+        memcpy(dst, ptr, len);
+        ring_read_commit(r, len);
+        dst += len;
+        size -= len;
+        bytes += len;
+    }
+    return(bytes);
+}
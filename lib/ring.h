@@ -0,0 +1,87 @@
+/**
+ @file ring.h
+
+ @brief Single producer single consumer ring buffer
+ @par Copyright &copy; 2015 Mike Gore, GPL License
+ @par You are free to use this code under the terms of GPL
+  Please retain a copy of this notice in any code you use it in.
+
+  This is free software: you can redistribute it and/or modify it under the
+  terms of the GNU General Public License as published by the Free Software
+  Foundation, either version 3 of the License, or (at your option)
+any later version.
+
+This software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ @par Notes
+  One producer and one consumer may use the ring at the same time without
+  disabling interrupts - for example a receive interrupt and the main loop.
+  - head is written only by the producer, tail only by the consumer
+  - Indexes run freely and are masked on use, so the whole buffer is usable
+  - The size MUST be a power of 2 no larger than RING_SIZE_MAX
+  - Data is stored before head moves and read before tail moves
+  - On AVR 16 bit indexes are read and written with interrupts off for
+    two instructions, 8 bit indexes need no protection at all
+*/
+
+#ifndef _RING_H_
+#define _RING_H_
+
+// Named address space
+#ifndef MEMSPACE
+#define MEMSPACE                                  /**/
+#endif
+
+///@brief Index size, 8 bit indexes limit the ring size to 128 bytes
+#ifndef RING_INDEX_BITS
+#define RING_INDEX_BITS 16
+#endif
+
+#if RING_INDEX_BITS == 8
+typedef uint8_t ring_index_t;
+#define RING_SIZE_MAX 128U
+#else
+typedef uint16_t ring_index_t;
+#define RING_SIZE_MAX 32768U
+#endif
+
+///@brief Compiler and CPU ordering between data and index updates
+#ifdef AVR
+#define RING_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+#else
+#define RING_BARRIER() __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#endif
+
+/// @brief ring structure
+typedef struct
+{
+    uint8_t *buf;                                 /* Ring buffer */
+    ring_index_t mask;                            /* size - 1 */
+    volatile ring_index_t head;                   /* Producer index, written only by the producer */
+    volatile ring_index_t tail;                   /* Consumer index, written only by the consumer */
+} ring_t;
+
+/* ring.c */
+int ring_init ( ring_t *r , uint8_t *buf , uint16_t size );
+ring_t *ring_new ( uint16_t size );
+void ring_del ( ring_t *r );
+uint16_t ring_size ( ring_t *r );
+uint16_t ring_used ( ring_t *r );
+uint16_t ring_space ( ring_t *r );
+void ring_flush ( ring_t *r );
+int ring_putc ( ring_t *r , uint8_t c );
+int ring_getc ( ring_t *r );
+int ring_peek ( ring_t *r );
+uint16_t ring_write ( ring_t *r , const uint8_t *src , uint16_t size );
+uint16_t ring_read ( ring_t *r , uint8_t *dst , uint16_t size );
+uint16_t ring_write_span ( ring_t *r , uint8_t **ptr );
+void ring_write_commit ( ring_t *r , uint16_t size );
+uint16_t ring_read_span ( ring_t *r , uint8_t **ptr );
+void ring_read_commit ( ring_t *r , uint16_t size );
+#endif
@@ -0,0 +1,313 @@
+/**
+ @file lib/sched.c
+
+ @brief Cooperative task scheduler with a hashed timer wheel
+
+ @par Copyright &copy; 2015 Mike Gore, GPL License
+
+ @par You are free to use this code under the terms of GPL
+   please retain a copy of this notice in any code you use it in.
+
+This is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option)
+any later version.
+
+This software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "user_config.h"
+
+#include "time.h"
+#include "timer.h"
+#include "sched.h"
+
+///@brief Tasks
+static sched_task_t sched_tasks[SCHED_TASKS];
+static uint8_t sched_count = 0;
+
+///@brief Timer wheel, one list of tasks per slot
+static sched_task_t *sched_wheel[SCHED_WHEEL];
+///@brief Next millisecond whose wheel slot has not been checked
+static uint32_t sched_tick = 0;
+///@brief Set while sched_run() is running tasks
+static uint8_t sched_busy = 0;
+///@brief Calls that stopped early because of SCHED_SLICE_US
+static uint32_t sched_slices = 0;
+
+
+/// @brief  Microsecond time stamp for run time statistics
+///
+/// - Uses the free running hardware counter, see uptime_us(), so setting
+///   the clock does not change run times
+/// - Only differences are used so the 32 bit wrap does not matter
+/// @return  microseconds
+static uint32_t sched_us()
+{
+    return(uptime_us());
+}
+
+
+/// @brief  Add a task to the wheel slot of its due time
+///
+/// @param[in] T: task
+/// @return  void
+static void sched_link(sched_task_t *T)
+{
+    uint8_t slot = T->due & SCHED_WHEEL_MASK;
+
+    T->next = sched_wheel[slot];
+    sched_wheel[slot] = T;
+    T->flags |= SCHED_QUEUED;
+}
+
+
+/// @brief  Remove a task from its wheel slot
+///
+/// @param[in] T: task
+/// @return  void
+static void sched_unlink(sched_task_t *T)
+{
+    sched_task_t **p = &sched_wheel[T->due & SCHED_WHEEL_MASK];
+
+    while(*p)
+    {
+        if(*p == T)
+        {
+            *p = T->next;
+            break;
+        }
+        p = &(*p)->next;
+    }
+    T->next = NULL;
+    T->flags &= ~SCHED_QUEUED;
+}
+
+
+/// @brief  Remove all tasks
+///
+/// @return  void
+MEMSPACE
+void sched_init()
+{
+    memset(sched_tasks, 0, sizeof(sched_tasks));
+    memset(sched_wheel, 0, sizeof(sched_wheel));
+    sched_count = 0;
+    sched_tick = uptime_ms();
+    sched_slices = 0;
+}
+
+
+/// @brief  Add a task
+///
+/// @param[in] name: task name for sched_stats()
+/// @param[in] fn: task function
+/// @param[in] period: milliseconds between runs, at least 1
+/// @param[in] budget: expected worst case run time in microseconds
+///
+/// @return task number on success.
+/// @return -1 on error.
+MEMSPACE
+int sched_add(const char *name, void (*fn)(void), uint16_t period, uint16_t budget)
+{
+    sched_task_t *T;
+
+    if(!fn || sched_count >= SCHED_TASKS)
+    {
+        printf("sched_add: No more tasks!\n");
+        return(-1);
+    }
+
+    T = &sched_tasks[sched_count];
+    T->name = name;
+    T->fn = fn;
+    T->period = period ? period : 1;
+    T->budget = budget;
+    T->due = uptime_ms() + T->period;
+    T->flags = SCHED_ENABLED;
+    sched_link(T);
+    return(sched_count++);
+}
+
+
+/// @brief  Enable or disable a task
+///
+/// @param[in] task: task number from sched_add()
+/// @param[in] enable: 1 to enable, 0 to disable
+///
+/// @return task on success.
+/// @return -1 on error.
+MEMSPACE
+int sched_enable(int task, int enable)
+{
+    sched_task_t *T;
+
+    if(task < 0 || task >= sched_count)
+        return(-1);
+
+    T = &sched_tasks[task];
+    if(T->flags & SCHED_QUEUED)
+        sched_unlink(T);
+    T->flags &= ~SCHED_ENABLED;
+    if(enable)
+    {
+        T->flags |= SCHED_ENABLED;
+        T->due = uptime_ms() + T->period;
+        sched_link(T);
+    }
+    return(task);
+}
+
+
+/// @brief  Run one task, update its statistics and queue its next run
+///
+/// @param[in] T: task, already removed from the wheel
+/// @param[in] now: current uptime_ms()
+/// @return  microseconds used
+static uint32_t sched_call(sched_task_t *T, uint32_t now)
+{
+    uint32_t start, us;
+
+    if((uint32_t)(now - T->due) > T->late_ms)
+        T->late_ms = (uint16_t) ((now - T->due) > 0xffffUL ? 0xffffUL : (now - T->due));
+
+    start = sched_us();
+    T->fn();
+    us = sched_us() - start;
+
+    T->runs++;
+    T->total_us += us;
+    if(us > T->max_us)
+        T->max_us = (uint16_t) (us > 0xffffUL ? 0xffffUL : us);
+    if(T->budget && us > T->budget)
+        T->overruns++;
+
+// Keep the period phase, but skip runs that were missed entirely
+    T->due += T->period;
+    if((int32_t)(now - T->due) >= 0)
+        T->due = now + T->period;
+    sched_link(T);
+    return(us);
+}
+
+
+/// @brief  Run tasks that are due
+///
+/// - Called from gpib_user_task() where the GPIB code is at a safe point
+///   with no byte transfer in progress
+/// - Checks only the wheel slots for the milliseconds since the last call
+/// - Stops after SCHED_SLICE_US, the remaining due tasks run next call
+///
+/// @return  number of tasks run
+int sched_run()
+{
+    uint32_t now;
+    uint32_t start;
+    sched_task_t *T, *next;
+    uint8_t slot;
+    uint8_t steps = 0;
+    int count = 0;
+
+    if(sched_busy)
+        return(0);
+
+    now = uptime_ms();
+    if((int32_t)(now - sched_tick) < 0)
+        return(0);
+
+    sched_busy = 1;
+    start = sched_us();
+
+    while((int32_t)(now - sched_tick) >= 0 && steps < SCHED_WHEEL)
+    {
+        slot = sched_tick & SCHED_WHEEL_MASK;
+        T = sched_wheel[slot];
+        while(T)
+        {
+            next = T->next;
+// Tasks more than one turn of the wheel away stay in the slot
+            if((int32_t)(now - T->due) >= 0)
+            {
+                sched_unlink(T);
+                sched_call(T, now);
+                ++count;
+                if((uint32_t)(sched_us() - start) >= SCHED_SLICE_US)
+                {
+                    sched_slices++;
+                    sched_busy = 0;
+                    return(count);
+                }
+            }
+            T = next;
+        }
+        ++sched_tick;
+        ++steps;
+    }
+
+// More than one turn since the last call - every slot has been checked
+    if(steps >= SCHED_WHEEL)
+        sched_tick = now + 1;
+
+    sched_busy = 0;
+    return(count);
+}
+
+
+/// @brief  Clear task run time statistics
+///
+/// @return  void
+MEMSPACE
+void sched_stats_reset()
+{
+    int i;
+    sched_task_t *T;
+
+    for(i = 0; i < sched_count; ++i)
+    {
+        T = &sched_tasks[i];
+        T->runs = 0;
+        T->total_us = 0;
+        T->max_us = 0;
+        T->overruns = 0;
+        T->late_ms = 0;
+    }
+    sched_slices = 0;
+}
+
+
+/// @brief  Display task run time statistics
+///
+/// @return  void
+MEMSPACE
+void sched_stats()
+{
+    int i;
+    sched_task_t *T;
+
+    printf("%-10s %6s %6s %8s %6s %6s %6s %6s\n",
+        "task", "period", "budget", "runs", "avg", "max", "over", "late");
+    for(i = 0; i < sched_count; ++i)
+    {
+        T = &sched_tasks[i];
+        printf("%-10s %6u %6u %8lu %6lu %6u %6u %6u%s\n",
+            T->name,
+            (unsigned int) T->period,
+            (unsigned int) T->budget,
+            (unsigned long) T->runs,
+            (unsigned long) (T->runs ? T->total_us / T->runs : 0),
+            (unsigned int) T->max_us,
+            (unsigned int) T->overruns,
+            (unsigned int) T->late_ms,
+            (T->flags & SCHED_ENABLED) ? "" : " disabled");
+    }
+    printf("period ms, budget/avg/max us, late ms, %lu calls stopped at %ld us\n",
+        (unsigned long) sched_slices, (long) SCHED_SLICE_US);
+    printf("run times measured with %lu us resolution\n",
+        (unsigned long) uptime_us_res());
+}
@@ -0,0 +1,76 @@
+/**
+ @file lib/sched.h
+
+ @brief Cooperative task scheduler with a hashed timer wheel
+
+ @par Copyright &copy; 2015 Mike Gore, GPL License
+
+ @par You are free to use this code under the terms of GPL
+   please retain a copy of this notice in any code you use it in.
+
+This is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option)
+any later version.
+
+This software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ @par Notes
+  Tasks run in the foreground from sched_run(), never from an interrupt.
+  The 1000HZ interrupt timers, see set_timers(), are still used for work
+  that must keep time such as clock_task() and mmc_disk_timerproc().
+  - Each task has a period in milliseconds and a budget in microseconds
+  - Tasks are kept on a wheel of SCHED_WHEEL one millisecond slots
+    hashed by their due time, so sched_run() only looks at the slots
+    that have passed since the last call instead of every task
+  - sched_run() stops after SCHED_SLICE_US so one call never holds the
+    caller for long, tasks still due run on the next call
+  - A task that runs longer than its budget is counted as an overrun
+*/
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+///@brief Maximum number of tasks
+#define SCHED_TASKS 8
+///@brief Timer wheel slots, MUST be a power of 2, one millisecond per slot
+#define SCHED_WHEEL 16
+#define SCHED_WHEEL_MASK (SCHED_WHEEL-1)
+///@brief Time limit for one sched_run() call in microseconds
+#define SCHED_SLICE_US 1000L
+
+///@brief Task flags
+#define SCHED_ENABLED 1
+#define SCHED_QUEUED  2
+
+///@brief Task and its run time statistics
+typedef struct _sched_task
+{
+    const char *name;
+    void (*fn)(void);
+    struct _sched_task *next;                     // Next task in the same wheel slot
+    uint32_t due;                                 // uptime_ms() of the next run
+    uint16_t period;                              // Milliseconds between runs
+    uint16_t budget;                              // Expected worst case run time in microseconds
+    uint8_t  flags;
+    uint32_t runs;                                // Number of runs
+    uint32_t total_us;                            // Total run time
+    uint16_t max_us;                              // Longest run time
+    uint16_t overruns;                            // Runs longer than budget
+    uint16_t late_ms;                             // Worst delay past the due time
+} sched_task_t;
+
+/* sched.c */
+MEMSPACE void sched_init ( void );
+MEMSPACE int sched_add ( const char *name , void (*fn )(void ), uint16_t period , uint16_t budget );
+MEMSPACE int sched_enable ( int task , int enable );
+int sched_run ( void );
+MEMSPACE void sched_stats_reset ( void );
+MEMSPACE void sched_stats ( void );
+#endif                                            // __SCHED_H__
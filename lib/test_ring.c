@@ -0,0 +1,422 @@
+/**
+ @file test_ring.c
+
+ @brief Test and benchmark for the single producer single consumer ring buffer
+
+ @par Copyright &copy; 2015 Mike Gore, All rights reserved. GPL  License
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for specific Copyright details
+
+ @par You are free to use this code under the terms of GPL
+   please retain a copy of this notice in any code you use it in.
+
+This is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option)
+any later version.
+
+This software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// only used when testing standalone on linux
+#ifdef RING_TEST
+
+#include "user_config.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "queue.h"
+#include "ring.h"
+
+long tr_good = 0;                                 //@brief total good tests
+long tr_bad = 0;                                  //@brief total bad tests
+
+/// @brief Record a test result
+/// @param[in] ok: test passed
+/// @param[in] name: test name
+/// @return void
+void check(int ok, char *name)
+{
+    if(ok)
+    {
+        ++tr_good;
+        return;
+    }
+    ++tr_bad;
+    printf("FAIL: %s\n", name);
+}
+
+
+/// @brief print seperator
+void sep()
+{
+    printf("==============================\n");
+}
+
+
+/// @brief Elapsed time in microseconds
+/// @param[in] *start: start time from clock_gettime()
+/// @return microseconds since start
+long elapsed_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return( (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L );
+}
+
+
+/// @brief Display a throughput result
+/// @param[in] name: test name
+/// @param[in] bytes: bytes moved
+/// @param[in] us: elapsed time in microseconds
+/// @return void
+void rate(char *name, long bytes, long us)
+{
+    if(us < 1)
+        us = 1;
+    printf("%-28s %10ld bytes %8ld us %8.1f MB/s\n", name, bytes, us, (double) bytes / (double) us);
+}
+
+
+/// @brief Single thread tests of the ring API
+/// @return void
+void unit_tests()
+{
+    ring_t R;
+    ring_t *rp;
+    uint8_t buf[64];
+    uint8_t src[200], dst[200];
+    uint8_t *ptr;
+    uint16_t len;
+    long i;
+    int c, j;
+    int ok;
+
+    sep();
+    printf("Start of unit tests\n");
+
+    check(ring_init(&R, buf, 0) < 0, "init size 0");
+    check(ring_init(&R, buf, 48) < 0, "init size not a power of 2");
+    check(ring_init(&R, buf, sizeof(buf)) == 0, "init");
+    check(ring_size(&R) == sizeof(buf), "size");
+    check(ring_used(&R) == 0 && ring_space(&R) == sizeof(buf), "empty");
+    check(ring_getc(&R) == EOF && ring_peek(&R) == EOF, "getc empty");
+
+// Fill the whole buffer, no slot is wasted
+    for(j = 0; j < (int) sizeof(buf); ++j)
+        check(ring_putc(&R, j) == 1, "putc");
+    check(ring_putc(&R, 0xff) == 0, "putc full");
+    check(ring_used(&R) == sizeof(buf) && ring_space(&R) == 0, "full");
+    check(ring_peek(&R) == 0, "peek");
+    ok = 1;
+    for(j = 0; j < (int) sizeof(buf); ++j)
+        if(ring_getc(&R) != j)
+            ok = 0;
+    check(ok, "getc order");
+    check(ring_getc(&R) == EOF, "getc after drain");
+
+// Run the free running indexes through several wraps of ring_index_t
+    ok = 1;
+    for(i = 0; i < 300000L; ++i)
+    {
+        ring_putc(&R, i & 0xff);
+        if(i & 1)
+            ring_putc(&R, (i >> 8) & 0xff);
+        c = ring_getc(&R);
+        if(c == EOF)
+            ok = 0;
+        if(ring_used(&R) > 2)
+            ring_getc(&R);
+    }
+    check(ok, "index wrap");
+    ring_flush(&R);
+    check(ring_used(&R) == 0, "flush");
+
+// Bulk copies across the end of the buffer
+    for(j = 0; j < (int) sizeof(src); ++j)
+        src[j] = j * 7 + 3;
+    ok = 1;
+    for(i = 0; i < 1000; ++i)
+    {
+        int n = 1 + (i * 13) % sizeof(buf);
+        memset(dst, 0, sizeof(dst));
+        if(ring_write(&R, src, n) != n)
+            ok = 0;
+        if(ring_read(&R, dst, sizeof(dst)) != n)
+            ok = 0;
+        if(memcmp(src, dst, n) != 0)
+            ok = 0;
+    }
+    check(ok, "bulk write/read wrap");
+    check(ring_write(&R, src, sizeof(src)) == sizeof(buf), "bulk write full");
+    check(ring_read(&R, dst, sizeof(dst)) == sizeof(buf) && memcmp(src, dst, sizeof(buf)) == 0, "bulk read full");
+
+// Zero copy spans never cross the end of the buffer
+    ring_init(&R, buf, sizeof(buf));
+    ring_write(&R, src, 40);
+    ring_read(&R, dst, 40);
+    len = ring_write_span(&R, &ptr);
+    check(len == sizeof(buf) - 40 && ptr == buf + 40, "write span to end");
+    memcpy(ptr, src, len);
+    ring_write_commit(&R, len);
+    len = ring_write_span(&R, &ptr);
+    check(len == 40 && ptr == buf, "write span wrapped");
+    memcpy(ptr, src + sizeof(buf) - 40, len);
+    ring_write_commit(&R, len);
+    check(ring_space(&R) == 0, "spans filled");
+    len = ring_read_span(&R, &ptr);
+    check(len == sizeof(buf) - 40 && ptr == buf + 40 && memcmp(ptr, src, len) == 0, "read span to end");
+    ring_read_commit(&R, len);
+    len = ring_read_span(&R, &ptr);
+    check(len == 40 && ptr == buf && memcmp(ptr, src + sizeof(buf) - 40, len) == 0, "read span wrapped");
+    ring_read_commit(&R, len);
+    check(ring_used(&R) == 0 && ring_read_span(&R, &ptr) == 0, "spans drained");
+
+    rp = ring_new(RING_SIZE_MAX);
+    check(rp != NULL && ring_size(rp) == RING_SIZE_MAX, "new max size");
+    ring_del(rp);
+    check(ring_new(100) == NULL, "new bad size");
+
+    printf("Good:%ld, Bad:%ld\n", tr_good, tr_bad);
+    sep();
+}
+
+
+///@brief Two thread test settings
+typedef struct
+{
+    ring_t *r;
+    long bytes;
+    int mode;                                     // 0 = putc/getc, 1 = bulk, 2 = spans
+    long errors;
+} spsc_t;
+
+/// @brief Producer thread - writes the byte sequence i & 0xff
+/// Threads yield when the ring is full or empty so the test also runs on one CPU
+void *producer(void *arg)
+{
+    spsc_t *T = (spsc_t *) arg;
+    uint8_t tmp[256];
+    uint8_t *ptr;
+    long i = 0;
+    uint16_t len, n, k;
+
+    while(i < T->bytes)
+    {
+        if(T->mode == 0)
+        {
+            if(ring_putc(T->r, i & 0xff))
+                ++i;
+            else
+                sched_yield();
+            continue;
+        }
+        if(T->mode == 1)
+        {
+            n = 1 + (i % 251);
+            if(n > T->bytes - i)
+                n = T->bytes - i;
+            for(k = 0; k < n; ++k)
+                tmp[k] = (i + k) & 0xff;
+            len = ring_write(T->r, tmp, n);
+            if(!len)
+                sched_yield();
+            i += len;
+            continue;
+        }
+        len = ring_write_span(T->r, &ptr);
+        if(len > T->bytes - i)
+            len = T->bytes - i;
+        for(k = 0; k < len; ++k)
+            ptr[k] = (i + k) & 0xff;
+        ring_write_commit(T->r, len);
+        if(!len)
+            sched_yield();
+        i += len;
+    }
+    return(NULL);
+}
+
+
+/// @brief Consumer thread - checks the byte sequence
+void *consumer(void *arg)
+{
+    spsc_t *T = (spsc_t *) arg;
+    uint8_t tmp[256];
+    uint8_t *ptr;
+    long i = 0;
+    int c;
+    uint16_t len, k;
+
+    while(i < T->bytes)
+    {
+        if(T->mode == 0)
+        {
+            c = ring_getc(T->r);
+            if(c == EOF)
+            {
+                sched_yield();
+                continue;
+            }
+            if(c != (i & 0xff))
+                T->errors++;
+            ++i;
+            continue;
+        }
+        if(T->mode == 1)
+        {
+            len = ring_read(T->r, tmp, 1 + (i % 199));
+            ptr = tmp;
+        }
+        else
+            len = ring_read_span(T->r, &ptr);
+        for(k = 0; k < len; ++k)
+            if(ptr[k] != ((i + k) & 0xff))
+                T->errors++;
+        if(T->mode == 2)
+            ring_read_commit(T->r, len);
+        if(!len)
+            sched_yield();
+        i += len;
+    }
+    return(NULL);
+}
+
+
+/// @brief Run a producer and a consumer thread on one ring
+/// @param[in] size: ring size
+/// @param[in] bytes: bytes to move
+/// @param[in] mode: 0 = putc/getc, 1 = bulk, 2 = spans
+/// @return void
+void spsc_test(uint16_t size, long bytes, int mode)
+{
+    static char *names[] = { "threads putc/getc", "threads write/read", "threads spans" };
+    pthread_t p, c;
+    struct timespec start;
+    spsc_t T;
+    char name[64];
+
+    T.r = ring_new(size);
+    T.bytes = bytes;
+    T.mode = mode;
+    T.errors = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&c, NULL, consumer, &T);
+    pthread_create(&p, NULL, producer, &T);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+    snprintf(name, sizeof(name), "%s %u", names[mode], (unsigned) size);
+    rate(name, bytes, elapsed_us(&start));
+
+    check(T.errors == 0, name);
+    if(T.errors)
+        printf("%s: %ld bytes out of sequence\n", name, T.errors);
+    ring_del(T.r);
+}
+
+
+/// @brief Single thread throughput of ring compared with lib/queue
+/// @param[in] bytes: bytes to move per test
+/// @return void
+void bench(long bytes)
+{
+    ring_t *r;
+    queue_t *q;
+    uint8_t tmp[64];
+    uint8_t *ptr;
+    struct timespec start;
+    long i;
+    uint16_t len;
+    volatile long sum = 0;
+
+    sep();
+    printf("Start of throughput benchmark, single thread, 256 byte rings\n");
+
+    q = queue_new(256);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < bytes; ++i)
+    {
+        queue_pushc(q, i);
+        sum += queue_popc(q);
+    }
+    rate("queue pushc/popc", bytes, elapsed_us(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < bytes; i += sizeof(tmp))
+    {
+        queue_push_buffer(q, tmp, sizeof(tmp));
+        queue_pop_buffer(q, tmp, sizeof(tmp));
+    }
+    rate("queue push/pop_buffer 64", bytes, elapsed_us(&start));
+    queue_del(q);
+
+    r = ring_new(256);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < bytes; ++i)
+    {
+        ring_putc(r, i);
+        sum += ring_getc(r);
+    }
+    rate("ring putc/getc", bytes, elapsed_us(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < bytes; i += sizeof(tmp))
+    {
+        ring_write(r, tmp, sizeof(tmp));
+        ring_read(r, tmp, sizeof(tmp));
+    }
+    rate("ring write/read 64", bytes, elapsed_us(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < bytes; i += len)
+    {
+        len = ring_write_span(r, &ptr);
+        ring_write_commit(r, len);
+        len = ring_read_span(r, &ptr);
+        sum += ptr[0];
+        ring_read_commit(r, len);
+    }
+    rate("ring spans, no copy", bytes, elapsed_us(&start));
+    ring_del(r);
+    sep();
+}
+
+
+/// @brief main ring test program
+/// test_ring [bench [bytes]]
+/// @return 0 if all tests passed
+int main(int argc, char *argv[])
+{
+    long bytes = 10000000L;
+
+    if(argc > 2)
+        bytes = atol(argv[2]);
+
+    unit_tests();
+
+    sep();
+    printf("Start of two thread tests\n");
+    spsc_test(16, 1000000L, 0);
+    spsc_test(16, 1000000L, 1);
+    spsc_test(16, 1000000L, 2);
+    spsc_test(4096, bytes, 0);
+    spsc_test(4096, bytes, 1);
+    spsc_test(4096, bytes, 2);
+    printf("Good:%ld, Bad:%ld\n", tr_good, tr_bad);
+    sep();
+
+    if(argc > 1 && strcmp(argv[1],"bench") == 0)
+        bench(bytes * 10);
+
+    return(tr_bad ? 1 : 0);
+}
+#endif
@@ -37,6 +37,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /// @brief  System Clock Time
 volatile ts_t __clock;
 
+/// @brief  Milliseconds since the timers were started, never set by the RTC
+volatile uint32_t __uptime_ms;
+
 /// @brief  System Time Zone
 tz_t __tzone;
 
@@ -212,6 +215,27 @@ void clock_elapsed_end(char *msg)
 }
 
 
+/// @brief  Milliseconds since the timers were started
+///
+/// - Unlike clock_gettime() this is not changed when the clock is set.
+///
+/// @return  milliseconds
+MEMSPACE
+uint32_t uptime_ms()
+{
+    uint32_t ms;
+
+    while(1)
+    {
+        ms = __uptime_ms;
+        if(ms != __uptime_ms)
+            continue;
+        break;
+    }
+    return(ms);
+}
+
+
 /// @brief  clear time and timezone to 0.
 ///
 /// @see clock_settime().
@@ -280,6 +304,7 @@ void execute_timers()
 */
 void clock_task(void)
 {
+    __uptime_ms++;
     __clock.tv_nsec += 1000000;
     if(__clock.tv_nsec >= 1000000000L)
     {
@@ -64,6 +64,7 @@ MEMSPACE char *ts_to_str ( ts_t *val );
 MEMSPACE void display_ts ( ts_t *val );
 MEMSPACE void clock_elapsed_begin ( void );
 MEMSPACE void clock_elapsed_end ( char *msg );
+MEMSPACE uint32_t uptime_ms ( void );
 MEMSPACE void clock_clear ( void );
 MEMSPACE void disable_timers ( void );
 MEMSPACE void enable_timers ( void );
@@ -79,4 +80,6 @@ extern MEMSPACE int clock_gettime ( clockid_t clk_id , struct timespec *ts );
 MEMSPACE void disable_system_task ( void );
 MEMSPACE void enable_system_task ( void );
 MEMSPACE void install_timers_isr ( void );
+uint32_t uptime_us ( void );
+MEMSPACE uint32_t uptime_us_res ( void );
 #endif                                            // _TIMER_H_
@@ -57,6 +57,23 @@ MEMSPACE void install_timers_isr()
     os_timer_disarm(&task_1ms);
     os_timer_setfn(&task_1ms, ( os_timer_func_t *) execute_timers, NULL );
 }
+
+
+/// @brief Free running microsecond counter for run time measurements
+/// @return microseconds since boot, wraps after about 71 minutes
+uint32_t uptime_us()
+{
+    return(system_get_time());
+}
+
+
+/// @brief Resolution of uptime_us()
+/// @return microseconds
+MEMSPACE
+uint32_t uptime_us_res()
+{
+    return(1);
+}
 #endif                                            // ifdef ESP8266
 // =============================================
 
@@ -76,6 +93,16 @@ MEMSPACE void install_timers_isr()
 ///@brief Computer AVR count time in Nanoseconds per counter increment.
 #define TIMER1_COUNTER_RES (SYSTEM_TASK_TIC_NS/TIMER1_COUNTS_PER_TIC)
 
+///@brief Computer AVR counts per Microsecond, used by uptime_us()
+#define TIMER1_COUNTS_PER_US (F_CPU/TIMER1_PRESCALE/1000000L)
+
+#if TIMER1_COUNTS_PER_US < 1
+#error TIMER1_COUNTS_PER_US is 0 -- decrease TIMER1 Prescale
+#endif
+
+///@brief Incremented by clock_task() every system task tic, see timer.c
+extern volatile uint32_t __uptime_ms;
+
 #if TIMER1_COUNTS_PER_TIC >= 65535L
 #error TIMER1_COUNTS_PER_TIC too big -- increase TIMER1 Prescale
 #endif
@@ -199,6 +226,45 @@ int clock_gettime(clockid_t clk_id  __attribute__((unused)), struct timespec *ts
     }
     return(errorf);
 }
+
+
+/// @brief Free running microsecond counter for run time measurements
+///
+///  - Made from the uptime_ms() count and the TIMER1 count so, unlike
+///    clock_gettime(), it does not jump when the clock is set
+///  - Only differences should be used, wraps after about 71 minutes
+///
+/// @return microseconds
+uint32_t uptime_us()
+{
+    uint16_t count1,count2;                       // must be same size as timer register
+    uint32_t ms, offset = 0;
+    uint8_t sreg = SREG;
+
+    cli();
+
+    count1 = TCNT1;
+    ms = __uptime_ms;
+    count2 = TCNT1;
+
+// See clock_gettime(), a pending interrupt has not counted this tic yet
+    if( (count2 < count1) || (TIFR1 & (1<<OCF1A)) )
+        offset = TIMER1_COUNTS_PER_TIC;
+    offset += count2;
+
+    SREG = sreg;
+
+    return( ms * 1000UL + offset / TIMER1_COUNTS_PER_US );
+}
+
+
+/// @brief Resolution of uptime_us()
+/// @return microseconds
+MEMSPACE
+uint32_t uptime_us_res()
+{
+    return(1);
+}
 #endif                                            // ifdef HAVE_HIRES_TIMER
 #endif                                            // ifdef AVR
 // =============================================
@@ -0,0 +1,1449 @@
+/**
+ @file lif/hpgl.c
+
+ @brief HP-GL plot capture renderer for the HP85 disk emulator project.
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ Renders the raw HP-GL plot files captured by gpib/printer.c to SVG or PNG.
+ - The plot is parsed one byte at a time and drawn as it is parsed so
+   memory use does not depend on the size of the plot.
+ - SVG output is streamed, PNG output uses a fixed size raster and a
+   built in deflate encoder so no other libraries are needed.
+ - Batch mode renders a whole directory using one process per core.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "hpgl.h"
+
+///@brief Pen colors, index 0 is the page
+static const uint8_t hpgl_palette[HPGL_PENS+1][3] =
+{
+    { 0xff, 0xff, 0xff },                         // page
+    { 0x00, 0x00, 0x00 },                         // 1 black
+    { 0xd0, 0x00, 0x00 },                         // 2 red
+    { 0x00, 0x90, 0x00 },                         // 3 green
+    { 0x00, 0x00, 0xd0 },                         // 4 blue
+    { 0xc0, 0x00, 0xc0 },                         // 5 magenta
+    { 0x00, 0xa0, 0xa0 },                         // 6 cyan
+    { 0xe0, 0x80, 0x00 },                         // 7 orange
+    { 0x80, 0x50, 0x20 },                         // 8 brown
+};
+
+///@brief 5x7 font for PNG labels, ASCII 0x20 .. 0x7e
+/// Five columns per character, bit 0 is the top row
+static const uint8_t hpgl_font[95][5] =
+{
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5f,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7f,0x14,0x7f,0x14},
+    {0x24,0x2a,0x7f,0x2a,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1c,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1c,0x00}, {0x08,0x2a,0x1c,0x2a,0x08}, {0x08,0x08,0x3e,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3e,0x51,0x49,0x45,0x3e}, {0x00,0x42,0x7f,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4b,0x31},
+    {0x18,0x14,0x12,0x7f,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3c,0x4a,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1e}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3e}, {0x7e,0x11,0x11,0x11,0x7e}, {0x7f,0x49,0x49,0x49,0x36}, {0x3e,0x41,0x41,0x41,0x22},
+    {0x7f,0x41,0x41,0x22,0x1c}, {0x7f,0x49,0x49,0x49,0x41}, {0x7f,0x09,0x09,0x09,0x01}, {0x3e,0x41,0x49,0x49,0x7a},
+    {0x7f,0x08,0x08,0x08,0x7f}, {0x00,0x41,0x7f,0x41,0x00}, {0x20,0x40,0x41,0x3f,0x01}, {0x7f,0x08,0x14,0x22,0x41},
+    {0x7f,0x40,0x40,0x40,0x40}, {0x7f,0x02,0x0c,0x02,0x7f}, {0x7f,0x04,0x08,0x10,0x7f}, {0x3e,0x41,0x41,0x41,0x3e},
+    {0x7f,0x09,0x09,0x09,0x06}, {0x3e,0x41,0x51,0x21,0x5e}, {0x7f,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7f,0x01,0x01}, {0x3f,0x40,0x40,0x40,0x3f}, {0x1f,0x20,0x40,0x20,0x1f}, {0x3f,0x40,0x38,0x40,0x3f},
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7f,0x41,0x41,0x00},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7f,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7f,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+    {0x38,0x44,0x44,0x48,0x7f}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7e,0x09,0x01,0x02}, {0x0c,0x52,0x52,0x52,0x3e},
+    {0x7f,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7d,0x40,0x00}, {0x20,0x40,0x44,0x3d,0x00}, {0x7f,0x10,0x28,0x44,0x00},
+    {0x00,0x41,0x7f,0x40,0x00}, {0x7c,0x04,0x18,0x04,0x78}, {0x7c,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+    {0x7c,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7c}, {0x7c,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+    {0x04,0x3f,0x44,0x40,0x20}, {0x3c,0x40,0x40,0x20,0x7c}, {0x1c,0x20,0x40,0x20,0x1c}, {0x3c,0x40,0x30,0x40,0x3c},
+    {0x44,0x28,0x10,0x28,0x44}, {0x0c,0x50,0x50,0x50,0x3c}, {0x44,0x64,0x54,0x4c,0x44}, {0x00,0x08,0x36,0x41,0x00},
+    {0x00,0x00,0x7f,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x02,0x01,0x02,0x04,0x02},
+};
+
+// =============================================
+// SVG back end
+// =============================================
+
+/// @brief Close the SVG path being written
+/// @param[in] *H: renderer state
+/// @return  void
+static void svg_path_end(hpgl_t *H)
+{
+    if(H->path_open)
+        fprintf(H->out,"\"/>\n");
+    H->path_open = 0;
+}
+
+
+/// @brief Write the SVG header
+/// @param[in] *H: renderer state
+/// @return  1 on success
+static int svg_begin(hpgl_t *H)
+{
+    fprintf(H->out,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.1fmm\" height=\"%.1fmm\" viewBox=\"0 0 %d %d\">\n"
+        "<rect width=\"%d\" height=\"%d\" fill=\"white\"/>\n"
+        "<g fill=\"none\" stroke-width=\"12\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n",
+        HPGL_PAGE_W * 0.025, HPGL_PAGE_H * 0.025,
+        HPGL_PAGE_W, HPGL_PAGE_H, HPGL_PAGE_W, HPGL_PAGE_H);
+    return(1);
+}
+
+
+/// @brief Draw a line, connected lines of one pen share one SVG path
+/// @param[in] *H: renderer state
+/// @param[in] x0,y0,x1,y1: end points in plotter units
+/// @return  void
+static void svg_line(hpgl_t *H, double x0, double y0, double x1, double y1)
+{
+    const uint8_t *c = hpgl_palette[H->pen];
+
+    if(!H->path_open || H->path_pen != H->pen || x0 != H->path_x || y0 != H->path_y)
+    {
+        svg_path_end(H);
+        fprintf(H->out,"<path stroke=\"#%02x%02x%02x\" d=\"M%.0f %.0f",
+            c[0], c[1], c[2], x0, HPGL_PAGE_H - y0);
+        H->path_open = 1;
+        H->path_pen = H->pen;
+    }
+    fprintf(H->out," L%.0f %.0f", x1, HPGL_PAGE_H - y1);
+    H->path_x = x1;
+    H->path_y = y1;
+}
+
+
+/// @brief Draw a filled rectangle
+/// @param[in] *H: renderer state
+/// @param[in] x0,y0,x1,y1: corners in plotter units
+/// @return  void
+static void svg_rect(hpgl_t *H, double x0, double y0, double x1, double y1)
+{
+    const uint8_t *c = hpgl_palette[H->pen];
+
+    svg_path_end(H);
+    fprintf(H->out,"<rect x=\"%.0f\" y=\"%.0f\" width=\"%.0f\" height=\"%.0f\" fill=\"#%02x%02x%02x\"/>\n",
+        fmin(x0,x1), HPGL_PAGE_H - fmax(y0,y1), fabs(x1-x0), fabs(y1-y0), c[0], c[1], c[2]);
+}
+
+
+/// @brief Draw a label
+/// @param[in] *H: renderer state
+/// @param[in] x,y: label origin in plotter units
+/// @param[in] *str: label text
+/// @return  void
+static void svg_label(hpgl_t *H, double x, double y, char *str)
+{
+    const uint8_t *c = hpgl_palette[H->pen];
+    double angle = -atan2(H->diry, H->dirx) * 180.0 / M_PI;
+
+    svg_path_end(H);
+    fprintf(H->out,"<text x=\"%.0f\" y=\"%.0f\" font-family=\"monospace\" font-size=\"%.0f\""
+        " textLength=\"%.0f\" lengthAdjust=\"spacingAndGlyphs\" fill=\"#%02x%02x%02x\"",
+        x, HPGL_PAGE_H - y, H->ch * 1.4, H->cw * 1.5 * strlen(str), c[0], c[1], c[2]);
+    if(angle != 0.0)
+        fprintf(H->out," transform=\"rotate(%.1f %.0f %.0f)\"", angle, x, HPGL_PAGE_H - y);
+    fprintf(H->out,">");
+    for(;*str;++str)
+    {
+        if(*str == '<')
+            fprintf(H->out,"&lt;");
+        else if(*str == '>')
+            fprintf(H->out,"&gt;");
+        else if(*str == '&')
+            fprintf(H->out,"&amp;");
+        else if((uint8_t) *str < ' ' || (uint8_t) *str > '~')
+            fputc('?', H->out);
+        else
+            fputc(*str, H->out);
+    }
+    fprintf(H->out,"</text>\n");
+}
+
+
+/// @brief Write the SVG trailer
+/// @param[in] *H: renderer state
+/// @return  1 on success, 0 on write error
+static int svg_end(hpgl_t *H)
+{
+    svg_path_end(H);
+    fprintf(H->out,"</g>\n</svg>\n");
+    return(ferror(H->out) ? 0 : 1);
+}
+
+static hpgl_backend_t svg_backend = { svg_begin, svg_line, svg_rect, svg_label, svg_end };
+
+// =============================================
+// PNG back end
+// =============================================
+
+/// @brief Convert plotter units to a pixel position
+/// @param[in] *H: renderer state
+/// @param[in] x,y: plotter units
+/// @param[out] *px,*py: pixel position, y down
+/// @return  void
+static void png_pixel(hpgl_t *H, double x, double y, int *px, int *py)
+{
+    *px = (int) floor(x * H->R.w / HPGL_PAGE_W + 0.5);
+    *py = (int) floor((HPGL_PAGE_H - y) * H->R.h / HPGL_PAGE_H + 0.5);
+}
+
+
+/// @brief Paint a square brush centered on a pixel
+/// @param[in] *R: raster
+/// @param[in] x,y: pixel position
+/// @param[in] size: brush size in pixels
+/// @param[in] color: palette index
+/// @return  void
+static void png_dot(hpgl_raster_t *R, int x, int y, int size, uint8_t color)
+{
+    int i, j;
+    int x0 = x - (size - 1) / 2;
+    int y0 = y - (size - 1) / 2;
+
+    for(j=y0;j<y0+size;++j)
+    {
+        if(j < 0 || j >= R->h)
+            continue;
+        for(i=x0;i<x0+size;++i)
+        {
+            if(i >= 0 && i < R->w)
+                R->pix[(size_t) j * R->w + i] = color;
+        }
+    }
+}
+
+
+/// @brief Allocate and clear the raster
+/// @param[in] *H: renderer state
+/// @return  1 on success, 0 on error
+static int png_begin(hpgl_t *H)
+{
+    if(H->R.pix == NULL)
+    {
+        H->R.pix = calloc((size_t) H->R.w * H->R.h, 1);
+        if(H->R.pix == NULL)
+        {
+            printf("hpgl: no memory for %d x %d raster\n", H->R.w, H->R.h);
+            return(0);
+        }
+    }
+    else
+    {
+        memset(H->R.pix, 0, (size_t) H->R.w * H->R.h);
+    }
+    H->R.brush = 1 + H->R.w / 1500;
+    return(1);
+}
+
+
+/// @brief Draw a line with Bresenham's algorithm
+/// @param[in] *H: renderer state
+/// @param[in] x0,y0,x1,y1: end points in plotter units
+/// @return  void
+static void png_line(hpgl_t *H, double x0, double y0, double x1, double y1)
+{
+    int ax, ay, bx, by;
+    int dx, dy, sx, sy, err, e2;
+
+    png_pixel(H, x0, y0, &ax, &ay);
+    png_pixel(H, x1, y1, &bx, &by);
+
+    dx = abs(bx - ax);
+    dy = -abs(by - ay);
+    sx = ax < bx ? 1 : -1;
+    sy = ay < by ? 1 : -1;
+    err = dx + dy;
+
+    while(1)
+    {
+        png_dot(&H->R, ax, ay, H->R.brush, H->pen);
+        if(ax == bx && ay == by)
+            break;
+        e2 = 2 * err;
+        if(e2 >= dy)
+        {
+            err += dy;
+            ax += sx;
+        }
+        if(e2 <= dx)
+        {
+            err += dx;
+            ay += sy;
+        }
+    }
+}
+
+
+/// @brief Draw a filled rectangle
+/// @param[in] *H: renderer state
+/// @param[in] x0,y0,x1,y1: corners in plotter units
+/// @return  void
+static void png_rect(hpgl_t *H, double x0, double y0, double x1, double y1)
+{
+    int ax, ay, bx, by, t, j;
+
+    png_pixel(H, x0, y0, &ax, &ay);
+    png_pixel(H, x1, y1, &bx, &by);
+    if(ax > bx)
+    {
+        t = ax; ax = bx; bx = t;
+    }
+    if(ay > by)
+    {
+        t = ay; ay = by; by = t;
+    }
+    if(ax < 0)
+        ax = 0;
+    if(bx >= H->R.w)
+        bx = H->R.w - 1;
+    for(j=ay;j<=by;++j)
+    {
+        if(j < 0 || j >= H->R.h || ax > bx)
+            continue;
+        memset(H->R.pix + (size_t) j * H->R.w + ax, H->pen, bx - ax + 1);
+    }
+}
+
+
+/// @brief Draw a label with the built in 5x7 dot font
+/// Each dot is placed along the label direction so rotated labels work
+/// @param[in] *H: renderer state
+/// @param[in] x,y: label origin in plotter units
+/// @param[in] *str: label text
+/// @return  void
+static void png_label(hpgl_t *H, double x, double y, char *str)
+{
+    int col, row, px, py, size;
+    double dx, dy, ox, oy;
+    uint8_t c;
+
+// Dot spacing along and across the label direction
+    double sw = H->cw / 5.0;
+    double sh = H->ch / 7.0;
+
+    size = (int) floor(fmin(sw * H->R.w / HPGL_PAGE_W, sh * H->R.h / HPGL_PAGE_H) + 0.5);
+    if(size < 1)
+        size = 1;
+
+    for(;*str;++str)
+    {
+        c = (uint8_t) *str;
+        if(c >= ' ' && c <= '~')
+        {
+            for(col=0;col<5;++col)
+            {
+                for(row=0;row<7;++row)
+                {
+                    if(!(hpgl_font[c - ' '][col] & (1 << row)))
+                        continue;
+                    dx = (col + 0.5) * sw;
+                    dy = (6 - row + 0.5) * sh;
+                    ox = x + dx * H->dirx - dy * H->diry;
+                    oy = y + dx * H->diry + dy * H->dirx;
+                    png_pixel(H, ox, oy, &px, &py);
+                    png_dot(&H->R, px, py, size, H->pen);
+                }
+            }
+        }
+        x += H->cw * 1.5 * H->dirx;
+        y += H->cw * 1.5 * H->diry;
+    }
+}
+
+///@brief CRC32 lookup table
+static uint32_t hpgl_crc_table[256];
+
+/// @brief Update a PNG CRC32
+/// @param[in] crc: CRC so far, start with 0
+/// @param[in] *buf: data
+/// @param[in] len: data size
+/// @return  updated CRC
+uint32_t hpgl_crc32(uint32_t crc, uint8_t *buf, size_t len)
+{
+    uint32_t c;
+    int i, k;
+
+    if(hpgl_crc_table[1] == 0)
+    {
+        for(i=0;i<256;++i)
+        {
+            c = i;
+            for(k=0;k<8;++k)
+                c = (c & 1) ? (0xedb88320UL ^ (c >> 1)) : (c >> 1);
+            hpgl_crc_table[i] = c;
+        }
+    }
+    crc ^= 0xffffffffUL;
+    while(len--)
+        crc = hpgl_crc_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    return(crc ^ 0xffffffffUL);
+}
+
+///@brief Deflate output buffer and bit writer
+typedef struct
+{
+    uint8_t *buf;
+    size_t len;
+    size_t size;
+    uint32_t bits;
+    int nbits;
+} png_zbuf_t;
+
+/// @brief Append bits, least significant bit first
+/// @param[in] *Z: deflate buffer
+/// @param[in] val: bits
+/// @param[in] n: number of bits
+/// @return  void
+static void png_bits(png_zbuf_t *Z, uint32_t val, int n)
+{
+    Z->bits |= val << Z->nbits;
+    Z->nbits += n;
+    while(Z->nbits >= 8)
+    {
+        if(Z->len < Z->size)
+            Z->buf[Z->len++] = Z->bits & 0xff;
+        Z->bits >>= 8;
+        Z->nbits -= 8;
+    }
+}
+
+
+/// @brief Append a Huffman code, codes are sent most significant bit first
+/// @param[in] *Z: deflate buffer
+/// @param[in] code: Huffman code
+/// @param[in] n: code length
+/// @return  void
+static void png_code(png_zbuf_t *Z, uint32_t code, int n)
+{
+    uint32_t rev = 0;
+    int i;
+
+    for(i=0;i<n;++i)
+    {
+        rev = (rev << 1) | (code & 1);
+        code >>= 1;
+    }
+    png_bits(Z, rev, n);
+}
+
+
+/// @brief Append a fixed Huffman literal or length symbol
+/// @param[in] *Z: deflate buffer
+/// @param[in] sym: symbol 0 .. 287
+/// @return  void
+static void png_symbol(png_zbuf_t *Z, int sym)
+{
+    if(sym < 144)
+        png_code(Z, 0x30 + sym, 8);
+    else if(sym < 256)
+        png_code(Z, 0x190 + sym - 144, 9);
+    else if(sym < 280)
+        png_code(Z, sym - 256, 7);
+    else
+        png_code(Z, 0xc0 + sym - 280, 8);
+}
+
+///@brief Deflate length codes 257 .. 285
+static const uint16_t png_len_base[29] =
+{
+    3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258
+};
+static const uint8_t png_len_extra[29] =
+{
+    0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+};
+
+/// @brief Append a run of the previous byte as a distance 1 match
+/// @param[in] *Z: deflate buffer
+/// @param[in] len: run length 3 .. 258
+/// @return  void
+static void png_run(png_zbuf_t *Z, int len)
+{
+    int i;
+
+    for(i=28;i>0;--i)
+    {
+        if(len >= png_len_base[i])
+            break;
+    }
+    png_symbol(Z, 257 + i);
+    if(png_len_extra[i])
+        png_bits(Z, len - png_len_base[i], png_len_extra[i]);
+// Distance code 0 = distance 1, 5 bits
+    png_code(Z, 0, 5);
+}
+
+
+/// @brief Write a PNG chunk
+/// @param[in] *fp: output file
+/// @param[in] *type: chunk type
+/// @param[in] *data: chunk data
+/// @param[in] len: chunk data size
+/// @return  void
+static void png_chunk(FILE *fp, char *type, uint8_t *data, uint32_t len)
+{
+    uint8_t b[4];
+    uint32_t crc;
+
+    b[0] = len >> 24; b[1] = len >> 16; b[2] = len >> 8; b[3] = len;
+    fwrite(b, 1, 4, fp);
+    fwrite(type, 1, 4, fp);
+    if(len)
+        fwrite(data, 1, len, fp);
+    crc = hpgl_crc32(0, (uint8_t *) type, 4);
+    crc = hpgl_crc32(crc, data, len);
+    b[0] = crc >> 24; b[1] = crc >> 16; b[2] = crc >> 8; b[3] = crc;
+    fwrite(b, 1, 4, fp);
+}
+
+
+/// @brief Compress the raster and write the PNG file
+/// One fixed Huffman deflate block, runs are coded as distance 1 matches
+/// which suits mostly blank plot pages well
+/// @param[in] *H: renderer state
+/// @return  1 on success, 0 on error
+static int png_end(hpgl_t *H)
+{
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+    uint8_t hdr[13];
+    uint8_t plte[(HPGL_PENS+1)*3];
+    png_zbuf_t Z;
+    size_t total, i, j;
+    uint32_t a = 1, b = 0;
+    int w = H->R.w, row, col, prev = -1, run;
+    uint8_t c;
+
+    total = (size_t) (w + 1) * H->R.h;
+    memset(&Z, 0, sizeof(Z));
+    Z.size = total + total / 8 + 64;
+    Z.buf = malloc(Z.size);
+    if(Z.buf == NULL)
+    {
+        printf("hpgl: no memory for PNG encoder\n");
+        return(0);
+    }
+
+// zlib header, deflate with a 32K window, no dictionary
+    Z.buf[Z.len++] = 0x78;
+    Z.buf[Z.len++] = 0x01;
+// Final block, fixed Huffman codes
+    png_bits(&Z, 1, 1);
+    png_bits(&Z, 1, 2);
+
+// Each row is a filter byte, 0 = none, followed by the pixels
+#define PNG_BYTE(n) ( ((n) % (w + 1)) == 0 ? 0 : H->R.pix[((n) / (w + 1)) * (size_t) w + ((n) % (w + 1)) - 1] )
+    i = 0;
+    while(i < total)
+    {
+        c = PNG_BYTE(i);
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+
+        if(c == prev)
+        {
+            run = 1;
+            j = i + 1;
+            while(j < total && run < 258 && PNG_BYTE(j) == c)
+            {
+                a = (a + c) % 65521;
+                b = (b + a) % 65521;
+                ++run;
+                ++j;
+            }
+            if(run >= 3)
+            {
+                png_run(&Z, run);
+                i = j;
+                continue;
+            }
+// Short runs are sent as literals, undo the extra checksum bytes
+            for(j=1;j<(size_t)run;++j)
+            {
+                b = (b + 65521 - a) % 65521;
+                a = (a + 65521 - c) % 65521;
+            }
+        }
+        png_symbol(&Z, c);
+        prev = c;
+        ++i;
+    }
+#undef PNG_BYTE
+    png_symbol(&Z, 256);
+    if(Z.nbits)
+        png_bits(&Z, 0, 8 - Z.nbits);
+    Z.buf[Z.len++] = b >> 8;
+    Z.buf[Z.len++] = b;
+    Z.buf[Z.len++] = a >> 8;
+    Z.buf[Z.len++] = a;
+
+    if(Z.len >= Z.size)
+    {
+        printf("hpgl: PNG encoder buffer overflow\n");
+        free(Z.buf);
+        return(0);
+    }
+
+    hdr[0] = w >> 24; hdr[1] = w >> 16; hdr[2] = w >> 8; hdr[3] = w;
+    row = H->R.h;
+    hdr[4] = row >> 24; hdr[5] = row >> 16; hdr[6] = row >> 8; hdr[7] = row;
+    hdr[8] = 8;                                   // bit depth
+    hdr[9] = 3;                                   // palette
+    hdr[10] = 0;
+    hdr[11] = 0;
+    hdr[12] = 0;
+    for(col=0;col<=HPGL_PENS;++col)
+        memcpy(plte + col * 3, hpgl_palette[col], 3);
+
+    fwrite(sig, 1, sizeof(sig), H->out);
+    png_chunk(H->out, "IHDR", hdr, sizeof(hdr));
+    png_chunk(H->out, "PLTE", plte, sizeof(plte));
+    png_chunk(H->out, "IDAT", Z.buf, Z.len);
+    png_chunk(H->out, "IEND", NULL, 0);
+    free(Z.buf);
+    return(ferror(H->out) ? 0 : 1);
+}
+
+static hpgl_backend_t png_backend = { png_begin, png_line, png_rect, png_label, png_end };
+
+// =============================================
+// HP-GL interpreter
+// =============================================
+
+/// @brief Convert user units to plotter units
+/// @param[in] *H: renderer state
+/// @param[in] ux,uy: user units, plotter units if SC is not active
+/// @param[out] *px,*py: plotter units
+/// @return  void
+void hpgl_user_to_plotter(hpgl_t *H, double ux, double uy, double *px, double *py)
+{
+    if(H->scaled)
+    {
+        *px = H->p1x + (ux - H->xmin) * (H->p2x - H->p1x) / (H->xmax - H->xmin);
+        *py = H->p1y + (uy - H->ymin) * (H->p2y - H->p1y) / (H->ymax - H->ymin);
+    }
+    else
+    {
+        *px = ux;
+        *py = uy;
+    }
+}
+
+
+/// @brief Convert a relative move in user units to plotter units
+/// @param[in] *H: renderer state
+/// @param[in] ux,uy: user units
+/// @param[out] *px,*py: plotter units
+/// @return  void
+void hpgl_scale_delta(hpgl_t *H, double ux, double uy, double *px, double *py)
+{
+    if(H->scaled)
+    {
+        *px = ux * (H->p2x - H->p1x) / (H->xmax - H->xmin);
+        *py = uy * (H->p2y - H->p1y) / (H->ymax - H->ymin);
+    }
+    else
+    {
+        *px = ux;
+        *py = uy;
+    }
+}
+
+
+/// @brief Set the plotter defaults, IN and DF
+/// @param[in] *H: renderer state
+/// @return  void
+void hpgl_reset(hpgl_t *H)
+{
+    H->down = 0;
+    H->relative = 0;
+    H->scaled = 0;
+    H->p1x = HPGL_P1X;
+    H->p1y = HPGL_P1Y;
+    H->p2x = HPGL_P2X;
+    H->p2y = HPGL_P2Y;
+    H->dirx = 1.0;
+    H->diry = 0.0;
+    H->cw = HPGL_CHAR_W;
+    H->ch = HPGL_CHAR_H;
+    H->term = HPGL_ETX;
+}
+
+
+/// @brief Move the pen, drawing if the pen is down
+/// @param[in] *H: renderer state
+/// @param[in] x,y: new position in plotter units
+/// @return  void
+void hpgl_move(hpgl_t *H, double x, double y)
+{
+    if(H->down && H->pen)
+    {
+        H->be->line(H, H->x, H->y, x, y);
+        H->segments++;
+    }
+    H->x = x;
+    H->y = y;
+    H->lx = x;
+    H->ly = y;
+}
+
+
+/// @brief Draw an arc around a center point, the pen ends at the end of the arc
+/// @param[in] *H: renderer state
+/// @param[in] cx,cy: center in plotter units
+/// @param[in] sweep: degrees, positive is counter clockwise
+/// @param[in] chord: degrees per segment
+/// @return  void
+void hpgl_arc(hpgl_t *H, double cx, double cy, double sweep, double chord)
+{
+    double r, a0, a;
+    int i, n;
+
+    if(chord < 0.5)
+        chord = 0.5;
+    r = hypot(H->x - cx, H->y - cy);
+    a0 = atan2(H->y - cy, H->x - cx);
+    n = (int) ceil(fabs(sweep) / chord);
+    if(n < 1)
+        n = 1;
+    for(i=1;i<=n;++i)
+    {
+        a = a0 + (sweep * i / n) * M_PI / 180.0;
+        hpgl_move(H, cx + r * cos(a), cy + r * sin(a));
+    }
+}
+
+
+/// @brief Execute one HP-GL command
+/// @param[in] *H: renderer state
+/// @param[in] *cmd: two letter command, upper case
+/// @param[in] *p: numeric parameters
+/// @param[in] n: number of parameters
+/// @return  void
+void hpgl_execute(hpgl_t *H, char *cmd, double *p, int n)
+{
+    double x, y, x2, y2, r, a;
+    int i, down;
+
+    H->commands++;
+
+    if(!strcmp(cmd,"IN") || !strcmp(cmd,"DF"))
+    {
+        hpgl_reset(H);
+        if(cmd[0] == 'I')
+        {
+            H->x = H->y = 0;
+            H->pen = 0;
+        }
+    }
+    else if(!strcmp(cmd,"IP"))
+    {
+        if(n >= 4)
+        {
+            H->p1x = p[0];
+            H->p1y = p[1];
+            H->p2x = p[2];
+            H->p2y = p[3];
+        }
+        else
+        {
+            H->p1x = HPGL_P1X;
+            H->p1y = HPGL_P1Y;
+            H->p2x = HPGL_P2X;
+            H->p2y = HPGL_P2Y;
+        }
+    }
+    else if(!strcmp(cmd,"SC"))
+    {
+        H->scaled = (n >= 4 && p[1] != p[0] && p[3] != p[2]);
+        if(H->scaled)
+        {
+            H->xmin = p[0];
+            H->xmax = p[1];
+            H->ymin = p[2];
+            H->ymax = p[3];
+        }
+    }
+    else if(!strcmp(cmd,"SP"))
+    {
+        H->pen = (n >= 1) ? (int) p[0] : 0;
+        if(H->pen < 0 || H->pen > HPGL_PENS)
+            H->pen = 1 + (abs(H->pen) - 1) % HPGL_PENS;
+    }
+    else if(!strcmp(cmd,"PU") || !strcmp(cmd,"PD") || !strcmp(cmd,"PA") || !strcmp(cmd,"PR"))
+    {
+        if(cmd[1] == 'U')
+            H->down = 0;
+        else if(cmd[1] == 'D')
+            H->down = 1;
+        else
+            H->relative = (cmd[1] == 'R');
+
+        for(i=0;i+1<n;i+=2)
+        {
+            if(H->relative)
+            {
+                hpgl_scale_delta(H, p[i], p[i+1], &x, &y);
+                x += H->x;
+                y += H->y;
+            }
+            else
+            {
+                hpgl_user_to_plotter(H, p[i], p[i+1], &x, &y);
+            }
+            hpgl_move(H, x, y);
+        }
+    }
+    else if(!strcmp(cmd,"CI"))
+    {
+        if(n >= 1 && H->pen)
+        {
+            hpgl_scale_delta(H, p[0], p[0], &r, &y);
+            x = H->x;
+            y = H->y;
+            down = H->down;
+            H->down = 0;
+            hpgl_move(H, x + r, y);
+            H->down = 1;
+            hpgl_arc(H, x, y, 360.0, (n >= 2) ? p[1] : 5.0);
+            H->down = 0;
+            hpgl_move(H, x, y);
+            H->down = down;
+        }
+    }
+    else if(!strcmp(cmd,"AA") || !strcmp(cmd,"AR"))
+    {
+        if(n >= 3)
+        {
+            if(cmd[1] == 'R')
+            {
+                hpgl_scale_delta(H, p[0], p[1], &x, &y);
+                x += H->x;
+                y += H->y;
+            }
+            else
+            {
+                hpgl_user_to_plotter(H, p[0], p[1], &x, &y);
+            }
+            hpgl_arc(H, x, y, p[2], (n >= 4) ? p[3] : 5.0);
+        }
+    }
+    else if(!strcmp(cmd,"EA") || !strcmp(cmd,"ER") || !strcmp(cmd,"RA") || !strcmp(cmd,"RR"))
+    {
+        if(n >= 2 && H->pen)
+        {
+            x = H->x;
+            y = H->y;
+            if(cmd[1] == 'R')
+            {
+                hpgl_scale_delta(H, p[0], p[1], &x2, &y2);
+                x2 += x;
+                y2 += y;
+            }
+            else
+            {
+                hpgl_user_to_plotter(H, p[0], p[1], &x2, &y2);
+            }
+            if(cmd[0] == 'R')
+            {
+                H->be->rect(H, x, y, x2, y2);
+            }
+            else
+            {
+                H->be->line(H, x, y, x2, y);
+                H->be->line(H, x2, y, x2, y2);
+                H->be->line(H, x2, y2, x, y2);
+                H->be->line(H, x, y2, x, y);
+                H->segments += 4;
+            }
+        }
+    }
+    else if(!strcmp(cmd,"DI") || !strcmp(cmd,"DR"))
+    {
+        x = (n >= 2) ? p[0] : 1.0;
+        y = (n >= 2) ? p[1] : 0.0;
+        if(cmd[1] == 'R')
+        {
+            x *= (H->p2x - H->p1x);
+            y *= (H->p2y - H->p1y);
+        }
+        a = hypot(x, y);
+        if(a > 0.0)
+        {
+            H->dirx = x / a;
+            H->diry = y / a;
+        }
+    }
+    else if(!strcmp(cmd,"SI"))
+    {
+        H->cw = (n >= 2) ? p[0] * 400.0 : HPGL_CHAR_W;
+        H->ch = (n >= 2) ? p[1] * 400.0 : HPGL_CHAR_H;
+    }
+    else if(!strcmp(cmd,"SR"))
+    {
+        H->cw = ((n >= 2) ? p[0] : 0.75) * fabs(H->p2x - H->p1x) / 100.0;
+        H->ch = ((n >= 2) ? p[1] : 1.5) * fabs(H->p2y - H->p1y) / 100.0;
+    }
+// Everything else, LT, VS, PG, ... does not change the drawing
+}
+
+
+/// @brief Draw a label and advance the pen, CR and LF move the pen
+/// @param[in] *H: renderer state
+/// @param[in] *str: label text
+/// @return  void
+void hpgl_label(hpgl_t *H, char *str)
+{
+    char *ptr = str;
+    char *start = str;
+    char save;
+
+    H->commands++;
+    while(1)
+    {
+        if(*ptr == 0 || *ptr == '\r' || *ptr == '\n')
+        {
+            save = *ptr;
+            *ptr = 0;
+            if(*start && H->pen)
+                H->be->label(H, H->x, H->y, start);
+            H->x += strlen(start) * H->cw * 1.5 * H->dirx;
+            H->y += strlen(start) * H->cw * 1.5 * H->diry;
+            *ptr = save;
+            if(save == 0)
+                break;
+            if(save == '\r')
+            {
+                H->x = H->lx;
+                H->y = H->ly;
+            }
+            else
+            {
+                H->x += H->ch * 2.0 * H->diry;
+                H->y -= H->ch * 2.0 * H->dirx;
+                H->lx += H->ch * 2.0 * H->diry;
+                H->ly -= H->ch * 2.0 * H->dirx;
+            }
+            start = ptr + 1;
+        }
+        ++ptr;
+    }
+}
+
+
+/// @brief Read a number
+/// @param[in] *in: input file
+/// @param[in] c: first character
+/// @param[out] *val: number
+/// @return  first character after the number
+int hpgl_number(FILE *in, int c, double *val)
+{
+    char buf[32];
+    int len = 0;
+
+    while(c != EOF && (isdigit(c) || c == '.' || ((c == '-' || c == '+') && len == 0)))
+    {
+        if(len < (int) sizeof(buf) - 1)
+            buf[len++] = c;
+        c = getc(in);
+    }
+    buf[len] = 0;
+    *val = atof(buf);
+    return(c);
+}
+
+
+/// @brief Parse and draw a plot, one character at a time
+/// Numeric parameters are processed in pairs as they are read so long
+/// PA/PD lists do not need any extra memory
+/// @param[in] *H: renderer state
+/// @return  1 on success, 0 on error
+int hpgl_parse(hpgl_t *H)
+{
+    char cmd[3];
+    char label[HPGL_LABEL_MAX+1];
+    double p[HPGL_PARAMS];
+    int c, n, len;
+
+    c = getc(H->in);
+    while(c != EOF)
+    {
+// Device control escape sequences, ESC . x [params] [:]
+        if(c == 0x1b)
+        {
+            c = getc(H->in);
+            if(c == '.')
+            {
+                getc(H->in);
+                while((c = getc(H->in)) != EOF && !isalpha(c) && c != ':' && c != 0x1b)
+                    ;
+                if(c == ':')
+                    c = getc(H->in);
+            }
+            continue;
+        }
+
+        if(!isalpha(c))
+        {
+            c = getc(H->in);
+            continue;
+        }
+
+        cmd[0] = toupper(c);
+        c = getc(H->in);
+        if(c == EOF || !isalpha(c))
+            continue;
+        cmd[1] = toupper(c);
+        cmd[2] = 0;
+
+        if(!strcmp(cmd,"LB"))
+        {
+            len = 0;
+            while((c = getc(H->in)) != EOF && c != H->term)
+            {
+                if(len < HPGL_LABEL_MAX)
+                    label[len++] = c;
+            }
+            label[len] = 0;
+            hpgl_label(H, label);
+            c = getc(H->in);
+            continue;
+        }
+
+        if(!strcmp(cmd,"DT"))
+        {
+            c = getc(H->in);
+            if(c != EOF && c != ';')
+                H->term = c;
+            else
+                H->term = HPGL_ETX;
+            c = getc(H->in);
+            continue;
+        }
+
+// Numeric parameters up to the next command
+        n = 0;
+        c = getc(H->in);
+        while(c != EOF && c != ';' && !isalpha(c) && c != 0x1b)
+        {
+            if(isdigit(c) || c == '.' || c == '-' || c == '+')
+            {
+                c = hpgl_number(H->in, c, &p[n++]);
+// Keep lists of points streaming, a pair at a time
+                if(n == HPGL_PARAMS && (cmd[0] == 'P'))
+                {
+                    hpgl_execute(H, cmd, p, n);
+                    n = 0;
+                }
+                else if(n == HPGL_PARAMS)
+                {
+                    --n;
+                }
+                continue;
+            }
+            c = getc(H->in);
+        }
+        hpgl_execute(H, cmd, p, n);
+    }
+    return(1);
+}
+
+
+/// @brief Render one plot file
+/// @param[in] *inname: HP-GL file
+/// @param[in] *outname: SVG or PNG file to create
+/// @param[in] format: HPGL_SVG or HPGL_PNG
+/// @param[in] width: PNG width in pixels
+/// @param[out] *bytes: plot file size, may be NULL
+/// @return  1 on success, 0 on error
+int hpgl_render_file(char *inname, char *outname, int format, int width, uint32_t *bytes)
+{
+    static hpgl_t H;
+    static char *inbuf = NULL;
+    struct stat sb;
+    int ret;
+    uint8_t *pix;
+    int w, h;
+
+// Reuse the raster between files in batch mode
+    pix = H.R.pix;
+    w = H.R.w;
+    h = H.R.h;
+    memset(&H, 0, sizeof(H));
+    H.R.w = (width > 0) ? width : HPGL_PNG_WIDTH;
+    H.R.h = (int) ((long) H.R.w * HPGL_PAGE_H / HPGL_PAGE_W);
+    if(pix && w == H.R.w && h == H.R.h)
+        H.R.pix = pix;
+    else if(pix)
+        free(pix);
+
+    if(inbuf == NULL)
+        inbuf = malloc(65536);
+
+    H.in = fopen(inname, "rb");
+    if(H.in == NULL)
+    {
+        printf("hpgl: Can't open:[%s]\n", inname);
+        return(0);
+    }
+    if(inbuf)
+        setvbuf(H.in, inbuf, _IOFBF, 65536);
+    if(bytes)
+        *bytes = (fstat(fileno(H.in), &sb) == 0) ? sb.st_size : 0;
+
+    H.out = fopen(outname, "wb");
+    if(H.out == NULL)
+    {
+        printf("hpgl: Can't create:[%s]\n", outname);
+        fclose(H.in);
+        return(0);
+    }
+
+    H.format = format;
+    H.be = (format == HPGL_PNG) ? &png_backend : &svg_backend;
+    hpgl_reset(&H);
+
+    ret = H.be->begin(&H);
+    if(ret)
+        ret = hpgl_parse(&H);
+    if(ret)
+        ret = H.be->end(&H);
+
+    fclose(H.in);
+    if(fclose(H.out) != 0)
+        ret = 0;
+    if(!ret)
+        printf("hpgl: [%s] render failed\n", inname);
+    return(ret);
+}
+
+
+/// @brief Test for a plot file name, *.plt or *.hpgl
+/// @param[in] *name: file name
+/// @return  1 if a plot file, 0 if not
+static int hpgl_is_plot(char *name)
+{
+    char *ext = strrchr(name, '.');
+
+    if(ext == NULL)
+        return(0);
+    return(!strcasecmp(ext, ".plt") || !strcasecmp(ext, ".hpgl") || !strcasecmp(ext, ".hpg"));
+}
+
+
+/// @brief Sort helper for directory names
+static int hpgl_name_cmp(const void *a, const void *b)
+{
+    return(strcmp(*(char **) a, *(char **) b));
+}
+
+
+/// @brief Elapsed time in seconds
+/// @param[in] *start: start time
+/// @return  seconds
+static double hpgl_elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return((now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+
+/// @brief Render the plots of one hpgl_batch() job
+/// Job k renders files k, k + jobs, k + 2 * jobs ...
+/// @param[in] **names: plot file names
+/// @param[in] count: number of names
+/// @param[in] *indir: directory of plot files
+/// @param[in] *outdir: output directory, NULL discards output for benchmarks
+/// @param[in] format: HPGL_SVG or HPGL_PNG
+/// @param[in] width: PNG width in pixels
+/// @param[in] jobs: number of jobs
+/// @param[in] k: this job
+/// @param[in] repeat: times to render each file
+/// @param[out] *result: result[0] bytes of plots rendered, result[1] failed plots
+/// @return  void
+static void hpgl_batch_job(char **names, int count, char *indir, char *outdir, int format, int width,
+    int jobs, int k, int repeat, uint64_t *result)
+{
+    char inname[4096], outname[4096];
+    uint32_t size;
+    char *base, *ext;
+    int i, j;
+
+    for(i=k;i<count;i+=jobs)
+    {
+        snprintf(inname, sizeof(inname), "%s/%s", indir, names[i]);
+        if(outdir)
+        {
+            base = strdup(names[i]);
+            ext = strrchr(base, '.');
+            if(ext)
+                *ext = 0;
+            snprintf(outname, sizeof(outname), "%s/%s.%s", outdir, base,
+                (format == HPGL_PNG) ? "png" : "svg");
+            free(base);
+        }
+        else
+        {
+            strcpy(outname, "/dev/null");
+        }
+        for(j=0;j<repeat;++j)
+        {
+            if(hpgl_render_file(inname, outname, format, width, &size))
+                result[0] += size;
+            else
+                result[1]++;
+        }
+    }
+}
+
+
+/// @brief Render every plot in a directory using several processes
+/// Files are split between jobs round robin, each job is a forked process
+/// Jobs that can not be forked run in this process, the plots of a job
+/// that exits without a result are counted as failed
+/// @param[in] *indir: directory of plot files
+/// @param[in] *outdir: output directory, NULL discards output for benchmarks
+/// @param[in] format: HPGL_SVG or HPGL_PNG
+/// @param[in] width: PNG width in pixels
+/// @param[in] jobs: processes, 0 = one per core
+/// @param[in] repeat: times to render each file, for benchmarks
+/// @return  number of failed plots, -1 on error
+int hpgl_batch(char *indir, char *outdir, int format, int width, int jobs, int repeat)
+{
+    DIR *dir;
+    struct dirent *de;
+    char **names = NULL;
+    int count = 0, max = 0;
+    int i, k, status, started, failed = 0;
+    uint64_t bytes = 0;
+    uint64_t result[3];
+    char *done;
+    struct timespec start;
+    double secs;
+    pid_t pid;
+    int fd[2];
+
+    dir = opendir(indir);
+    if(dir == NULL)
+    {
+        printf("hpgl: Can't open directory:[%s]\n", indir);
+        return(-1);
+    }
+    while((de = readdir(dir)) != NULL)
+    {
+        if(!hpgl_is_plot(de->d_name))
+            continue;
+        if(count == max)
+        {
+            max = max ? max * 2 : 64;
+            names = realloc(names, max * sizeof(char *));
+            if(names == NULL)
+            {
+                printf("hpgl: out of memory\n");
+                closedir(dir);
+                return(-1);
+            }
+        }
+        names[count++] = strdup(de->d_name);
+    }
+    closedir(dir);
+
+    if(count == 0)
+    {
+        printf("hpgl: no plot files in:[%s]\n", indir);
+        free(names);
+        return(0);
+    }
+    qsort(names, count, sizeof(char *), hpgl_name_cmp);
+
+    if(jobs <= 0)
+        jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if(jobs <= 0)
+        jobs = 1;
+    if(jobs > count)
+        jobs = count;
+    if(repeat < 1)
+        repeat = 1;
+
+    done = calloc(jobs, 1);
+    if(done == NULL)
+    {
+        printf("hpgl: out of memory\n");
+        return(-1);
+    }
+
+// Each job reports its number, bytes processed and failures through a pipe
+    if(pipe(fd) < 0)
+    {
+        perror("hpgl: pipe");
+        free(done);
+        return(-1);
+    }
+
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(started=0;started<jobs;++started)
+    {
+        pid = fork();
+        if(pid < 0)
+        {
+            perror("hpgl: fork");
+            break;
+        }
+        if(pid == 0)
+        {
+            close(fd[0]);
+            result[0] = started;
+            result[1] = 0;
+            result[2] = 0;
+            hpgl_batch_job(names, count, indir, outdir, format, width, jobs, started, repeat, result + 1);
+            if(write(fd[1], result, sizeof(result)) != sizeof(result))
+                _exit(1);
+            _exit(0);
+        }
+    }
+    close(fd[1]);
+
+// Jobs that could not be forked keep their share of the files
+    for(k=started;k<jobs;++k)
+    {
+        result[1] = 0;
+        result[2] = 0;
+        hpgl_batch_job(names, count, indir, outdir, format, width, jobs, k, repeat, result + 1);
+        bytes += result[1];
+        failed += (int) result[2];
+        done[k] = 1;
+    }
+
+// Read until every child has closed the pipe
+    while(read(fd[0], result, sizeof(result)) == sizeof(result))
+    {
+        k = (int) result[0];
+        if(k < 0 || k >= jobs)
+            continue;
+        bytes += result[1];
+        failed += (int) result[2];
+        done[k] = 1;
+    }
+    close(fd[0]);
+    while(wait(&status) > 0)
+        ;
+    secs = hpgl_elapsed(&start);
+
+    for(k=0;k<jobs;++k)
+    {
+        if(done[k])
+            continue;
+        printf("hpgl: job %d exited without a result\n", k);
+        for(i=k;i<count;i+=jobs)
+            failed += repeat;
+    }
+    free(done);
+
+    printf("%d plots x %d, %d jobs, %s, %.3f seconds\n",
+        count, repeat, jobs, (format == HPGL_PNG) ? "PNG" : "SVG", secs);
+    if(secs > 0.0)
+        printf("%.1f plots/sec, %.2f MB/sec of HP-GL\n",
+            (double) count * repeat / secs, (double) bytes / secs / 1e6);
+    if(failed)
+        printf("%d plots failed\n", failed);
+
+    for(i=0;i<count;++i)
+        free(names[i]);
+    free(names);
+    return(failed);
+}
+
+
+/// @brief Display usage
+/// @param[in] *name: program name
+/// @return  void
+void hpgl_usage(char *name)
+{
+    printf("Usage:\n"
+        "%s svg plotfile svgfile\n"
+        "%s png [-w width] plotfile pngfile\n"
+        "    render one HP-GL plot captured by the emulator\n"
+        "%s batch [-f svg|png] [-w width] [-j jobs] plotdir outdir\n"
+        "    render every *.plt file in plotdir, jobs defaults to one per core\n"
+        "%s bench [-f svg|png] [-w width] [-j jobs] [-n repeat] plotdir\n"
+        "    batch render without saving output and report plots/sec\n",
+        name, name, name, name);
+}
+
+
+/// @brief HP-GL renderer main
+/// @param[in] argc: argument count
+/// @param[in] *argv[]: arguments
+/// @return  0 on success, 1 on error
+int main(int argc, char *argv[])
+{
+    char *args[4];
+    int nargs = 0;
+    int format = HPGL_SVG;
+    int width = HPGL_PNG_WIDTH;
+    int jobs = 0;
+    int repeat = 1;
+    char *cmd;
+    int i;
+
+    if(argc < 2)
+    {
+        hpgl_usage(basename(argv[0]));
+        return(1);
+    }
+    cmd = argv[1];
+    if(!strcmp(cmd,"png"))
+        format = HPGL_PNG;
+
+    for(i=2;i<argc;++i)
+    {
+        if(!strcmp(argv[i],"-f") && i + 1 < argc)
+            format = strcasecmp(argv[++i],"png") ? HPGL_SVG : HPGL_PNG;
+        else if(!strcmp(argv[i],"-w") && i + 1 < argc)
+            width = atoi(argv[++i]);
+        else if(!strcmp(argv[i],"-j") && i + 1 < argc)
+            jobs = atoi(argv[++i]);
+        else if(!strcmp(argv[i],"-n") && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else if(nargs < 4)
+            args[nargs++] = argv[i];
+    }
+    if(width < 16)
+        width = 16;
+
+    if((!strcmp(cmd,"svg") || !strcmp(cmd,"png")) && nargs == 2)
+        return(hpgl_render_file(args[0], args[1], format, width, NULL) ? 0 : 1);
+
+    if(!strcmp(cmd,"batch") && nargs == 2)
+        return(hpgl_batch(args[0], args[1], format, width, jobs, 1) ? 1 : 0);
+
+    if(!strcmp(cmd,"bench") && nargs == 1)
+        return(hpgl_batch(args[0], NULL, format, width, jobs, repeat) ? 1 : 0);
+
+    hpgl_usage(basename(argv[0]));
+    return(1);
+}
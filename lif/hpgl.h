@@ -0,0 +1,110 @@
+/**
+ @file lif/hpgl.h
+
+ @brief HP-GL plot capture renderer for the HP85 disk emulator project.
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+*/
+
+#ifndef _HPGL_H
+#define _HPGL_H
+
+///@brief Plotter hard clip limits in plotter units, HP 7475A A size
+/// 1 plotter unit = 0.025 mm
+#define HPGL_PAGE_W 10365
+#define HPGL_PAGE_H 7962
+///@brief Default scaling points P1 and P2
+#define HPGL_P1X 250
+#define HPGL_P1Y 596
+#define HPGL_P2X 10250
+#define HPGL_P2Y 7796
+///@brief Default character size, SI 0.19,0.27 cm, in plotter units
+#define HPGL_CHAR_W 76.0
+#define HPGL_CHAR_H 108.0
+///@brief Pens 1 .. HPGL_PENS, pen 0 is no pen
+#define HPGL_PENS 8
+///@brief Longest label kept, longer labels are truncated
+#define HPGL_LABEL_MAX 256
+///@brief Most numeric parameters kept for one command
+#define HPGL_PARAMS 8
+///@brief Default PNG width in pixels
+#define HPGL_PNG_WIDTH 1024
+///@brief ETX, default label terminator
+#define HPGL_ETX 0x03
+
+///@brief Output formats
+#define HPGL_SVG 0
+#define HPGL_PNG 1
+
+struct _hpgl;
+
+///@brief Renderer back end
+typedef struct
+{
+    int (*begin)(struct _hpgl *H);
+    void (*line)(struct _hpgl *H, double x0, double y0, double x1, double y1);
+    void (*rect)(struct _hpgl *H, double x0, double y0, double x1, double y1);
+    void (*label)(struct _hpgl *H, double x, double y, char *str);
+    int (*end)(struct _hpgl *H);
+} hpgl_backend_t;
+
+///@brief PNG raster, one palette index per pixel
+typedef struct
+{
+    int w;
+    int h;
+    int brush;                                    // Pen width in pixels
+    uint8_t *pix;
+} hpgl_raster_t;
+
+///@brief Renderer state, memory use does not depend on the plot size
+typedef struct _hpgl
+{
+    FILE *in;
+    FILE *out;
+    hpgl_backend_t *be;
+    int format;
+    int pen;                                      // Selected pen, 0 = none
+    int down;                                     // Pen down
+    int relative;                                 // PR mode
+    double x, y;                                  // Pen position, plotter units
+    double p1x, p1y, p2x, p2y;                    // Scaling points
+    int scaled;                                   // SC active
+    double xmin, xmax, ymin, ymax;                // SC user units
+    double dirx, diry;                            // Label direction, unit vector
+    double cw, ch;                                // Character size, plotter units
+    double lx, ly;                                // Label line start for CR
+    int term;                                     // Label terminator
+    uint32_t commands;                            // Commands parsed
+    uint32_t segments;                            // Line segments drawn
+// SVG path being written
+    int path_open;
+    int path_pen;
+    double path_x, path_y;
+// PNG raster
+    hpgl_raster_t R;
+} hpgl_t;
+
+/* hpgl.c */
+uint32_t hpgl_crc32 ( uint32_t crc , uint8_t *buf , size_t len );
+void hpgl_user_to_plotter ( hpgl_t *H , double ux , double uy , double *px , double *py );
+void hpgl_scale_delta ( hpgl_t *H , double ux , double uy , double *px , double *py );
+void hpgl_reset ( hpgl_t *H );
+void hpgl_move ( hpgl_t *H , double x , double y );
+void hpgl_arc ( hpgl_t *H , double cx , double cy , double sweep , double chord );
+void hpgl_execute ( hpgl_t *H , char *cmd , double *p , int n );
+void hpgl_label ( hpgl_t *H , char *str );
+int hpgl_number ( FILE *in , int c , double *val );
+int hpgl_parse ( hpgl_t *H );
+int hpgl_render_file ( char *inname , char *outname , int format , int width , uint32_t *bytes );
+int hpgl_batch ( char *indir , char *outdir , int format , int width , int jobs , int repeat );
+void hpgl_usage ( char *name );
+int main ( int argc , char *argv []);
+
+#endif                                            // #ifndef _HPGL_H
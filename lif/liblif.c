@@ -0,0 +1,393 @@
+/**
+ @file lif/liblif.c
+
+ @brief LIF image library API, built into liblif.a and liblif.so
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ * Thin layer over lifutils.c, see liblif.h
+ * Functions return -1 and print the reason on errors like the rest of
+ * the lif utility, success paths print nothing
+
+*/
+
+#ifdef LIF_STAND_ALONE
+
+#include "user_config.h"
+#include "lifsup.h"
+#include "lifutils.h"
+#include "liblif.h"
+
+extern int lif_quiet;
+
+///@brief Largest lif_read() or lif_write() call, they take an int size
+#define LIBLIF_CHUNK (LIF_SECTOR_SIZE * 256L)
+
+///@brief Open LIF image
+struct liblif
+{
+    lif_t *LIF;
+    int   writable;
+};
+
+
+/// @brief liblif API version the library was built with
+/// @return LIBLIF_API_VERSION
+MEMSPACE
+int liblif_version(void)
+{
+    return(LIBLIF_API_VERSION);
+}
+
+
+/// @brief Open a LIF image
+/// @param[in] *image: LIF image file name
+/// @param[in] writable: 1 to allow liblif_write(), liblif_add() and liblif_delete()
+/// @return handle or NULL on error
+MEMSPACE
+liblif_t *liblif_open(const char *image, int writable)
+{
+    liblif_t *H;
+
+    lif_quiet = 1;
+    H = calloc(1, sizeof(liblif_t));
+    if(H == NULL)
+        return(NULL);
+    H->LIF = lif_open_volume((char *) image, writable ? "rb+" : "rb");
+    if(H->LIF == NULL)
+    {
+        free(H);
+        return(NULL);
+    }
+    H->writable = writable;
+    return(H);
+}
+
+
+/// @brief Create an empty LIF image and open it for writing
+/// @param[in] *image: LIF image file name
+/// @param[in] *label: volume label
+/// @param[in] dirsectors: directory size in sectors
+/// @param[in] sectors: image size in sectors
+/// @return handle or NULL on error
+MEMSPACE
+liblif_t *liblif_create(const char *image, const char *label, uint32_t dirsectors, uint32_t sectors)
+{
+    lif_quiet = 1;
+    if(lif_create_image((char *) image, (char *) label, dirsectors, sectors, 0) < 0)
+        return(NULL);
+    return(liblif_open(image, 1));
+}
+
+
+/// @brief Close a LIF image, writing any changed directory records
+/// @param[in] *H: handle, freed
+/// @return 1 on success, -1 on error
+MEMSPACE
+int liblif_close(liblif_t *H)
+{
+    if(H == NULL)
+        return(-1);
+    lif_close_volume(H->LIF);
+    free(H);
+    return(1);
+}
+
+
+/// @brief Volume information
+/// @param[in] *H: handle
+/// @param[out] *V: volume information
+/// @return 1 on success, -1 on error
+MEMSPACE
+int liblif_volume(liblif_t *H, liblif_volume_t *V)
+{
+    lif_t *LIF = H->LIF;
+
+    if(lif_updatefree(LIF) == NULL)
+        return(-1);
+    memset(V, 0, sizeof(liblif_volume_t));
+    memcpy(V->label, LIF->VOL.Label, 6);
+    V->sectors = LIF->sectors;
+    V->dirstart = LIF->VOL.DirStartSector;
+    V->dirsectors = LIF->VOL.DirSectors;
+    V->filestart = LIF->filestart;
+    V->filesectors = LIF->filesectors;
+    V->usedsectors = LIF->usedsectors;
+    V->freesectors = LIF->freesectors;
+    V->files = LIF->files;
+    V->date = lif_lifbcd2time(LIF->VOL.date);
+    return(1);
+}
+
+
+/// @brief Directory entry by index
+/// @param[in] *H: handle
+/// @param[in] index: directory record index
+/// @param[out] *E: directory entry
+/// @return 1 if the record is a file, 0 if it is purged or the end of the directory, -1 on error
+MEMSPACE
+int liblif_entry(liblif_t *H, int index, liblif_entry_t *E)
+{
+    lif_t *LIF = H->LIF;
+    int i;
+
+    if(index < 0 || index >= (int) (LIF->VOL.DirSectors * LIF_DIR_RECORDS_PER_SECTOR))
+        return(-1);
+    if(!lif_readdirindex(LIF, index))
+        return(-1);
+    if(LIF->DIR.FileType == 0 || LIF->DIR.FileType == 0xffff)
+        return(0);
+
+    E->index = index;
+    memcpy(E->name, LIF->DIR.filename, 10);
+    E->name[10] = 0;
+    for(i = 9; i >= 0 && E->name[i] == ' '; --i)
+        E->name[i] = 0;
+    E->type = LIF->DIR.FileType;
+    E->start = LIF->DIR.FileStartSector;
+    E->sectors = LIF->DIR.FileSectors;
+    E->bytes = LIF->DIR.FileBytes;
+    E->date = lif_lifbcd2time(LIF->DIR.date);
+    return(1);
+}
+
+
+/// @brief Iterate the files in the directory
+/// @param[in] *H: handle
+/// @param[in,out] *cursor: set to 0 before the first call
+/// @param[out] *E: directory entry
+/// @return 1 for each file, 0 at the end of the directory, -1 on error
+MEMSPACE
+int liblif_next(liblif_t *H, int *cursor, liblif_entry_t *E)
+{
+    lif_t *LIF = H->LIF;
+    int records = LIF->VOL.DirSectors * LIF_DIR_RECORDS_PER_SECTOR;
+    int index, ret;
+
+    while(*cursor >= 0 && *cursor < records)
+    {
+        index = (*cursor)++;
+        ret = liblif_entry(H, index, E);
+        if(ret)
+            return(ret);
+        if(LIF->DIR.FileType == 0xffff)
+            break;
+    }
+    *cursor = records;
+    return(0);
+}
+
+
+/// @brief Find a file by name
+/// @param[in] *H: handle
+/// @param[in] *name: LIF file name
+/// @return directory record index, -1 if not found
+MEMSPACE
+int liblif_find(liblif_t *H, const char *name)
+{
+    return(lif_find_file(H->LIF, (char *) name));
+}
+
+
+/// @brief Check a file index and offset for liblif_read() and liblif_write()
+/// @param[in] *H: handle
+/// @param[in] index: directory record index
+/// @param[in] offset: offset in the file
+/// @return file size in bytes, -1 on error
+static long liblif_bounds(liblif_t *H, int index, long offset)
+{
+    liblif_entry_t E;
+    long size;
+
+    if(liblif_entry(H, index, &E) != 1)
+    {
+        printf("liblif:[%s] index:[%d] is not a file\n", H->LIF->name, index);
+        return(-1);
+    }
+    size = E.sectors * (long) LIF_SECTOR_SIZE;
+    if(offset < 0 || offset > size)
+    {
+        printf("liblif:[%s] file:[%s] offset:[%ld] is past the end\n", H->LIF->name, E.name, offset);
+        return(-1);
+    }
+    return(size);
+}
+
+
+/// @brief Read from a file by index
+/// @param[in] *H: handle
+/// @param[in] index: directory record index
+/// @param[in] offset: offset in the file
+/// @param[out] *buf: data
+/// @param[in] size: bytes to read
+/// @return bytes read, less than size at the end of the file, -1 on error
+MEMSPACE
+long liblif_read(liblif_t *H, int index, long offset, void *buf, long size)
+{
+    long filesize, start, done, len;
+
+    filesize = liblif_bounds(H, index, offset);
+    if(filesize < 0)
+        return(-1);
+    if(size > filesize - offset)
+        size = filesize - offset;
+
+    start = H->LIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE + offset;
+    for(done = 0; done < size; done += len)
+    {
+        len = size - done;
+        if(len > LIBLIF_CHUNK)
+            len = LIBLIF_CHUNK;
+        if(lif_read(H->LIF, (uint8_t *) buf + done, start + done, len) != len)
+            return(-1);
+    }
+    return(done);
+}
+
+
+/// @brief Write to a file by index, the file size does not change
+/// @param[in] *H: handle opened writable
+/// @param[in] index: directory record index
+/// @param[in] offset: offset in the file
+/// @param[in] *buf: data
+/// @param[in] size: bytes to write, must fit in the file sectors
+/// @return bytes written, -1 on error
+MEMSPACE
+long liblif_write(liblif_t *H, int index, long offset, const void *buf, long size)
+{
+    long filesize, start, done, len;
+
+    if(!H->writable)
+    {
+        printf("liblif:[%s] is not open for writing\n", H->LIF->name);
+        return(-1);
+    }
+    filesize = liblif_bounds(H, index, offset);
+    if(filesize < 0)
+        return(-1);
+    if(size > filesize - offset)
+    {
+        printf("liblif:[%s] index:[%d] write of %ld bytes at:[%ld] does not fit in %ld bytes\n",
+            H->LIF->name, index, size, offset, filesize);
+        return(-1);
+    }
+
+    start = H->LIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE + offset;
+    for(done = 0; done < size; done += len)
+    {
+        len = size - done;
+        if(len > LIBLIF_CHUNK)
+            len = LIBLIF_CHUNK;
+        if(lif_write(H->LIF, (uint8_t *) buf + done, start + done, len) != len)
+            return(-1);
+    }
+    return(done);
+}
+
+
+/// @brief Add a new file
+/// The last sector is padded with zeros
+/// @param[in] *H: handle opened writable
+/// @param[in] *name: LIF file name
+/// @param[in] type: LIF file type
+/// @param[in] *buf: file contents
+/// @param[in] size: file size in bytes
+/// @return directory record index, -1 on error
+MEMSPACE
+int liblif_add(liblif_t *H, const char *name, uint16_t type, const void *buf, long size)
+{
+    lif_t *LIF = H->LIF;
+    uint8_t pad[LIF_SECTOR_SIZE];
+    long offset, done, len;
+    uint32_t sectors;
+    int index;
+
+    if(!H->writable)
+    {
+        printf("liblif:[%s] is not open for writing\n", LIF->name);
+        return(-1);
+    }
+    if(!*name || strlen(name) > 10 || !lif_checkname((char *) name))
+    {
+        printf("liblif:[%s] invalid LIF name:[%s]\n", LIF->name, name);
+        return(-1);
+    }
+    if(type == 0 || type == 0xffff || size < 0)
+    {
+        printf("liblif:[%s] file:[%s] invalid type or size\n", LIF->name, name);
+        return(-1);
+    }
+
+    sectors = lif_bytes2sectors(size);
+    index = lif_newdir(LIF, sectors);
+    if(index == -1)
+        return(-1);
+
+    lif_fixname(LIF->DIR.filename, (char *) name, 10);
+    LIF->DIR.FileType = type;
+    lif_time2lifbcd(time(NULL), LIF->DIR.date);
+    LIF->DIR.VolNumber = 0x8001;
+    LIF->DIR.FileBytes = size;
+    LIF->DIR.SectorSize = 0x100;
+
+    offset = LIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE;
+    for(done = 0; done < size; done += len)
+    {
+        len = size - done;
+        if(len > LIBLIF_CHUNK)
+            len = LIBLIF_CHUNK;
+        if(lif_write(LIF, (uint8_t *) buf + done, offset + done, len) != len)
+            return(-1);
+    }
+    len = sectors * (long) LIF_SECTOR_SIZE - size;
+    if(len > 0)
+    {
+        memset(pad, 0, len);
+        if(lif_write(LIF, pad, offset + size, len) != len)
+            return(-1);
+    }
+
+// lif_newdir() has already written the new EOF record
+    if( !lif_writedirindex(LIF,index))
+        return(-1);
+    return(index);
+}
+
+
+/// @brief Delete a file by index
+/// @param[in] *H: handle opened writable
+/// @param[in] index: directory record index
+/// @return 1 on success, -1 on error
+MEMSPACE
+int liblif_delete(liblif_t *H, int index)
+{
+    lif_t *LIF = H->LIF;
+    liblif_entry_t E;
+
+    if(!H->writable)
+    {
+        printf("liblif:[%s] is not open for writing\n", LIF->name);
+        return(-1);
+    }
+    if(liblif_entry(H, index, &E) != 1)
+    {
+        printf("liblif:[%s] index:[%d] is not a file\n", LIF->name, index);
+        return(-1);
+    }
+
+// The same rule as lif_del(), a last file becomes the EOF record
+    if(index >= LIF->EOFindex-1)
+        LIF->DIR.FileType = 0xffff;
+    else
+        LIF->DIR.FileType = 0;
+    if( !lif_writedirindex(LIF,index) )
+        return(-1);
+    lif_updatefree(LIF);
+    return(1);
+}
+#endif                                            // LIF_STAND_ALONE
@@ -0,0 +1,100 @@
+/**
+ @file lif/liblif.h
+
+ @brief LIF image library API for programs that link against liblif.a or liblif.so
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ * Only this header is needed to use the library, the lif_t structures in
+ * lifutils.h are not part of the API and may change.
+ * Images are used through a handle returned by liblif_open() or liblif_create()
+ * and files are addressed by directory record index.
+ * All data goes to and from caller supplied buffers.
+ * Nothing is printed unless an operation fails.
+ * A handle must only be used by one thread at a time, and images should be
+ * opened and created from one thread.
+
+ * Example - list the files in an image
+ *   liblif_t *H = liblif_open("amigo1.lif", 0);
+ *   liblif_entry_t E;
+ *   int cursor = 0;
+ *   while(liblif_next(H, &cursor, &E) == 1)
+ *       printf("%-10s %04X %ld\n", E.name, E.type, (long) E.sectors);
+ *   liblif_close(H);
+*/
+
+#ifndef _LIBLIF_H
+#define _LIBLIF_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@brief Incremented only when existing functions or structures change
+/// also the liblif.so SONAME major number in the Makefile
+#define LIBLIF_API_VERSION 1
+
+///@brief liblif is built with -fvisibility=hidden, only these functions are exported
+#if defined(__GNUC__) && !defined(_WIN32)
+#define LIBLIF_API __attribute__((visibility("default")))
+#else
+#define LIBLIF_API
+#endif
+
+///@brief Open LIF image, see liblif.c
+typedef struct liblif liblif_t;
+
+///@brief Volume information
+typedef struct
+{
+    char     label[6+1];                          // Volume label
+    uint32_t sectors;                             // Image size in sectors
+    uint32_t dirstart;                            // Directory start sector
+    uint32_t dirsectors;                          // Directory size in sectors
+    uint32_t filestart;                           // File area start sector
+    uint32_t filesectors;                         // File area size in sectors
+    uint32_t usedsectors;                         // Sectors used by files
+    uint32_t freesectors;                         // Free sectors
+    int      files;                               // Files
+    time_t   date;                                // Volume creation time
+} liblif_volume_t;
+
+///@brief Directory entry
+typedef struct
+{
+    int      index;                               // Directory record index
+    char     name[10+1];                          // File name, trailing spaces removed
+    uint16_t type;                                // File type, 0xE010 for ASCII
+    uint32_t start;                               // Start sector
+    uint32_t sectors;                             // Size in sectors
+    uint32_t bytes;                               // Directory bytes field, implementation dependent
+    time_t   date;                                // File time
+} liblif_entry_t;
+
+/* liblif.c */
+LIBLIF_API int liblif_version ( void );
+LIBLIF_API liblif_t *liblif_open ( const char *image , int writable );
+LIBLIF_API liblif_t *liblif_create ( const char *image , const char *label , uint32_t dirsectors , uint32_t sectors );
+LIBLIF_API int liblif_close ( liblif_t *H );
+LIBLIF_API int liblif_volume ( liblif_t *H , liblif_volume_t *V );
+LIBLIF_API int liblif_entry ( liblif_t *H , int index , liblif_entry_t *E );
+LIBLIF_API int liblif_next ( liblif_t *H , int *cursor , liblif_entry_t *E );
+LIBLIF_API int liblif_find ( liblif_t *H , const char *name );
+LIBLIF_API long liblif_read ( liblif_t *H , int index , long offset , void *buf , long size );
+LIBLIF_API long liblif_write ( liblif_t *H , int index , long offset , const void *buf , long size );
+LIBLIF_API int liblif_add ( liblif_t *H , const char *name , uint16_t type , const void *buf , long size );
+LIBLIF_API int liblif_delete ( liblif_t *H , int index );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                            // _LIBLIF_H
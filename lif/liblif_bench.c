@@ -0,0 +1,232 @@
+/**
+ @file lif/liblif_bench.c
+
+ @brief liblif benchmark, directory iteration and file read and write throughput
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ * liblif_bench image [files] [bytes] [loops]
+ * Creates image with files of bytes each through liblif_add(), then times
+ * loops passes of directory iteration, whole file reads and in place writes.
+ * Every read is checked against the data that was written.
+ * Only liblif.h is used so this also checks that the API stands on its own.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "liblif.h"
+
+///@brief Defaults
+#define BENCH_FILES 256
+#define BENCH_BYTES 16384
+#define BENCH_LOOPS 20
+
+/// @brief Microseconds since start
+/// @param[in] *start: start time
+/// @return elapsed microseconds
+static long bench_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return( (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L );
+}
+
+
+/// @brief Fill a buffer with data that depends on the file number and pass
+/// @param[out] *buf: data
+/// @param[in] size: bytes
+/// @param[in] file: file number
+/// @param[in] pass: pass number
+/// @return void
+static void bench_fill(unsigned char *buf, long size, int file, int pass)
+{
+    long i;
+
+    for(i = 0; i < size; ++i)
+        buf[i] = (unsigned char) (i * 31 + file * 7 + pass);
+}
+
+
+/// @brief Display one result line
+/// @param[in] *what: operation
+/// @param[in] ops: operations
+/// @param[in] bytes: bytes moved, 0 for directory operations
+/// @param[in] us: time
+/// @return void
+static void bench_line(char *what, long ops, long bytes, long us)
+{
+    if(us <= 0)
+        us = 1;
+    printf("%-10s %9ld ops %10ld us %8.2f us/op", what, ops, us, (double) us / (ops ? ops : 1));
+    if(bytes)
+        printf(" %9.1f MB/s", (double) bytes / (double) us);
+    printf("\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    liblif_t *H;
+    liblif_entry_t E;
+    liblif_volume_t V;
+    struct timespec start;
+    unsigned char *buf, *check;
+    char name[16];
+    char *image;
+    long files = BENCH_FILES, bytes = BENCH_BYTES, loops = BENCH_LOOPS;
+    long sectors, dirsectors, ops, moved, us;
+    int cursor, i, loop, errors = 0;
+
+    if(argc < 2)
+    {
+        printf("usage: %s image [files] [bytes] [loops]\n", argv[0]);
+        printf("    defaults %d files of %d bytes, %d loops, image is overwritten\n",
+            BENCH_FILES, BENCH_BYTES, BENCH_LOOPS);
+        return(1);
+    }
+    image = argv[1];
+    if(argc > 2)
+        files = atol(argv[2]);
+    if(argc > 3)
+        bytes = atol(argv[3]);
+    if(argc > 4)
+        loops = atol(argv[4]);
+    if(files <= 0 || files > 99999 || bytes <= 0 || loops <= 0)
+    {
+        printf("%s: files must be 1 .. 99999, bytes and loops more than 0\n", argv[0]);
+        return(1);
+    }
+
+    buf = malloc(bytes);
+    check = malloc(bytes);
+    if(buf == NULL || check == NULL)
+    {
+        printf("%s: out of memory\n", argv[0]);
+        return(1);
+    }
+
+    printf("liblif API version %d, %ld files of %ld bytes, %ld loops\n",
+        liblif_version(), files, bytes, loops);
+
+// Directory records are 32 bytes, 8 per sector, plus one for the EOF record
+    dirsectors = (files + 1 + 7) / 8;
+    sectors = 2 + dirsectors + files * ((bytes + 255) / 256);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    H = liblif_create(image, "BENCH", dirsectors, sectors);
+    if(H == NULL)
+        return(1);
+    us = bench_us(&start);
+    bench_line("create", 1, sectors * 256L, us);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < files; ++i)
+    {
+        snprintf(name, sizeof(name), "F%05d", i);
+        bench_fill(buf, bytes, i, 0);
+        if(liblif_add(H, name, 0xE008, buf, bytes) < 0)
+        {
+            liblif_close(H);
+            return(1);
+        }
+    }
+    liblif_close(H);
+    bench_line("add", files, files * bytes, bench_us(&start));
+
+    H = liblif_open(image, 0);
+    if(H == NULL)
+        return(1);
+    if(liblif_volume(H, &V) == 1)
+        printf("Volume:[%s] %u sectors, %d files, %u free\n",
+            V.label, (unsigned) V.sectors, V.files, (unsigned) V.freesectors);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ops = 0;
+    for(loop = 0; loop < loops; ++loop)
+    {
+        cursor = 0;
+        while(liblif_next(H, &cursor, &E) == 1)
+            ++ops;
+    }
+    bench_line("dir", ops, 0, bench_us(&start));
+    if(ops != files * loops)
+    {
+        printf("dir: expected %ld entries, found %ld\n", files * loops, ops);
+        ++errors;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ops = 0;
+    moved = 0;
+    for(loop = 0; loop < loops; ++loop)
+    {
+        cursor = 0;
+        while(liblif_next(H, &cursor, &E) == 1)
+        {
+            if(liblif_read(H, E.index, 0, buf, bytes) != bytes)
+                ++errors;
+            moved += bytes;
+            ++ops;
+// Check the first pass, later passes read the same data
+            if(loop == 0)
+            {
+                bench_fill(check, bytes, atoi(E.name + 1), 0);
+                if(memcmp(buf, check, bytes) != 0)
+                {
+                    printf("read: %s does not match what was written\n", E.name);
+                    ++errors;
+                }
+            }
+        }
+    }
+    bench_line("read", ops, moved, bench_us(&start));
+    liblif_close(H);
+
+    H = liblif_open(image, 1);
+    if(H == NULL)
+        return(1);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ops = 0;
+    moved = 0;
+    for(loop = 0; loop < loops; ++loop)
+    {
+        cursor = 0;
+        while(liblif_next(H, &cursor, &E) == 1)
+        {
+            bench_fill(buf, bytes, atoi(E.name + 1), loop + 1);
+            if(liblif_write(H, E.index, 0, buf, bytes) != bytes)
+                ++errors;
+            moved += bytes;
+            ++ops;
+        }
+    }
+    bench_line("write", ops, moved, bench_us(&start));
+
+// The last pass must be what reads back
+    cursor = 0;
+    while(liblif_next(H, &cursor, &E) == 1)
+    {
+        bench_fill(check, bytes, atoi(E.name + 1), loops);
+        if(liblif_read(H, E.index, 0, buf, bytes) != bytes || memcmp(buf, check, bytes) != 0)
+        {
+            printf("write: %s does not match what was written\n", E.name);
+            ++errors;
+        }
+    }
+    liblif_close(H);
+
+    free(buf);
+    free(check);
+    printf("%d errors\n", errors);
+    return(errors != 0);
+}
@@ -0,0 +1,1313 @@
+/**
+ @file lif/lifindex.c
+
+ @brief Searchable catalog of the files in a library of LIF images, stand alone lif utility only
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+ * lif index build directory [jobs]
+ * Scans every .lif image under directory, one process per image, and
+ * writes the catalog to directory/lif.idx
+ * Images with the same modification time and size as in the existing
+ * catalog are not scanned again
+
+ * lif index query directory|indexfile name|type|hash value
+ * Lists files by name prefix, file type or content hash
+ * Examples
+ * lif index query /library name TREK
+ * lif index query /library type E010
+ * lif index query /library hash 8f2a6b1c0d9e4f37
+
+ * lif dedup report directory [jobs]
+ * Lists sets of files with the same content hash and the space they waste
+
+ * lif dedup store directory storedir [jobs]
+ * Writes each distinct file content once to storedir/objects and
+ * storedir/manifest, a lif build manifest that rebuilds every image
+
+*/
+
+#ifdef LIF_STAND_ALONE
+
+#include "user_config.h"
+#include "lifsup.h"
+#include "lifutils.h"
+#include "lifindex.h"
+
+#ifdef LIF_PARALLEL
+
+extern int debuglevel;
+
+/// @brief Hash data with FNV-1a 64
+/// @param[in] hash: LIF_INDEX_HASH_INIT or the result of the previous call
+/// @param[in] *buf: data
+/// @param[in] len: data size
+/// @return hash
+MEMSPACE
+uint64_t lif_index_hash(uint64_t hash, uint8_t *buf, long len)
+{
+    while(len-- > 0)
+    {
+        hash ^= *buf++;
+        hash *= 0x100000001b3ULL;
+    }
+    return(hash);
+}
+
+
+/// @brief Hash or copy the sectors of a LIF file
+/// Reads LIF_INDEX_BUFFER bytes at a time, in place when the image is mapped
+/// @param[in] *LIF: LIF image
+/// @param[in] start: file start sector
+/// @param[in] sectors: file size in sectors
+/// @param[in,out] *hash: hash to update, NULL if not needed
+/// @param[in] *fo: file to copy the sectors to, NULL if not needed
+/// @return bytes read, short if the file extends past the end of the image, -1 on write error
+MEMSPACE
+long lif_index_stream(lif_t *LIF, uint32_t start, uint32_t sectors, uint64_t *hash, FILE *fo)
+{
+    static uint8_t buf[LIF_INDEX_BUFFER];
+    uint8_t *ptr;
+    long offset, left, size, done = 0;
+
+    offset = start * (long) LIF_SECTOR_SIZE;
+    left = sectors * (long) LIF_SECTOR_SIZE;
+    while(left > 0)
+    {
+        size = left < LIF_INDEX_BUFFER ? left : LIF_INDEX_BUFFER;
+        ptr = lif_map_ptr(LIF, offset, size);
+        if(ptr == NULL)
+        {
+            size = lif_read(LIF, buf, offset, size);
+            if(size <= 0)
+                break;
+            ptr = buf;
+        }
+        if(hash != NULL)
+            *hash = lif_index_hash(*hash, ptr, size);
+        if(fo != NULL && fwrite(ptr, 1, size, fo) != (size_t) size)
+            return(-1);
+        offset += size;
+        left -= size;
+        done += size;
+    }
+    return(done);
+}
+
+
+/// @brief Add an image to an index
+/// @param[in,out] *X: index
+/// @param[in] *path: image path name
+/// @param[in] mtime: image modification time
+/// @param[in] size: image size in bytes
+/// @return new image or NULL when out of memory
+MEMSPACE
+lifindex_image_t *lif_index_add_image(lifindex_t *X, char *path, int64_t mtime, int64_t size)
+{
+    lifindex_image_t *I;
+
+    if(X->images == X->maximages)
+    {
+        X->maximages = X->maximages ? X->maximages * 2 : 256;
+        I = realloc(X->image, X->maximages * sizeof(lifindex_image_t));
+        if(I == NULL)
+        {
+            printf("lif_index: out of memory\n");
+            return(NULL);
+        }
+        X->image = I;
+    }
+    I = &X->image[X->images++];
+    memset(I, 0, sizeof(lifindex_image_t));
+    I->path = strdup(path);
+    I->mtime = mtime;
+    I->size = size;
+    return(I);
+}
+
+
+/// @brief Add a file to an index
+/// @param[in,out] *X: index
+/// @return new file or NULL when out of memory
+MEMSPACE
+lifindex_file_t *lif_index_add_file(lifindex_t *X)
+{
+    lifindex_file_t *F;
+
+    if(X->files == X->maxfiles)
+    {
+        X->maxfiles = X->maxfiles ? X->maxfiles * 2 : 1024;
+        F = realloc(X->file, X->maxfiles * sizeof(lifindex_file_t));
+        if(F == NULL)
+        {
+            printf("lif_index: out of memory\n");
+            return(NULL);
+        }
+        X->file = F;
+    }
+    F = &X->file[X->files++];
+    memset(F, 0, sizeof(lifindex_file_t));
+    return(F);
+}
+
+
+/// @brief Free an index
+/// @param[in,out] *X: index
+/// @return void
+MEMSPACE
+void lif_index_free(lifindex_t *X)
+{
+    uint32_t i;
+
+    for(i = 0; i < X->images; ++i)
+        free(X->image[i].path);
+    free(X->image);
+    free(X->file);
+    memset(X, 0, sizeof(lifindex_t));
+}
+
+
+/// @brief Add every .lif image in a directory tree to an index
+/// @param[in,out] *X: index
+/// @param[in] *dir: directory to scan
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_index_scan(lifindex_t *X, char *dir)
+{
+    DIR *dp;
+    struct dirent *de;
+    stat_t sb;
+    char **names = NULL;
+    char path[LIF_INDEX_PATH];
+    int count = 0, max = 0;
+    int i, len, ret = 1;
+
+    dp = opendir(dir);
+    if(dp == NULL)
+    {
+        printf("lif_index: can not open directory:[%s]\n", dir);
+        return(0);
+    }
+    while((de = readdir(dp)) != NULL)
+    {
+        if(de->d_name[0] == '.')
+            continue;
+        if(count == max)
+        {
+            max = max ? max * 2 : 64;
+            names = realloc(names, max * sizeof(char *));
+            if(names == NULL)
+            {
+                printf("lif_index: out of memory\n");
+                closedir(dp);
+                return(0);
+            }
+        }
+        names[count++] = strdup(de->d_name);
+    }
+    closedir(dp);
+
+    for(i = 0; i < count && ret; ++i)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        if(stat(path, &sb) < 0)
+            continue;
+        if(S_ISDIR(sb.st_mode))
+        {
+            ret = lif_index_scan(X, path);
+            continue;
+        }
+        len = strlen(names[i]);
+        if(len < 5 || strcasecmp(names[i] + len - 4, ".lif") != 0)
+            continue;
+        if(lif_index_add_image(X, path, (int64_t) sb.st_mtime, (int64_t) sb.st_size) == NULL)
+            ret = 0;
+    }
+
+    for(i = 0; i < count; ++i)
+        free(names[i]);
+    free(names);
+    return(ret);
+}
+
+
+/// @brief Store a 64 bit value LSB first
+/// @param[out] *B: buffer
+/// @param[in] index: offset in B
+/// @param[in] val: value
+/// @return void
+MEMSPACE
+void lif_index_put64(uint8_t *B, int index, uint64_t val)
+{
+    V2B_LSB(B, index, 4, (uint32_t) val);
+    V2B_LSB(B, index + 4, 4, (uint32_t) (val >> 32));
+}
+
+
+/// @brief Read a 64 bit value stored LSB first
+/// @param[in] *B: buffer
+/// @param[in] index: offset in B
+/// @return value
+MEMSPACE
+uint64_t lif_index_get64(uint8_t *B, int index)
+{
+    return( (uint64_t) B2V_LSB(B, index, 4) | ((uint64_t) B2V_LSB(B, index + 4, 4) << 32) );
+}
+
+
+///@brief Files being sorted by lif_index_type_cmp() and lif_index_hash_cmp()
+static lifindex_file_t *lif_index_sort;
+
+/// @brief Sort files by name, then image and start sector
+MEMSPACE
+int lif_index_file_cmp(const void *a, const void *b)
+{
+    lifindex_file_t *A = (lifindex_file_t *) a;
+    lifindex_file_t *B = (lifindex_file_t *) b;
+    int ret;
+
+    ret = strcasecmp(A->name, B->name);
+    if(ret)
+        return(ret);
+    if(A->image != B->image)
+        return(A->image < B->image ? -1 : 1);
+    if(A->start != B->start)
+        return(A->start < B->start ? -1 : 1);
+    return(0);
+}
+
+
+/// @brief Sort file numbers by type, then file number which is name order
+MEMSPACE
+int lif_index_type_cmp(const void *a, const void *b)
+{
+    uint32_t A = *(uint32_t *) a;
+    uint32_t B = *(uint32_t *) b;
+
+    if(lif_index_sort[A].type != lif_index_sort[B].type)
+        return(lif_index_sort[A].type < lif_index_sort[B].type ? -1 : 1);
+    return(A < B ? -1 : (A > B));
+}
+
+
+/// @brief Sort file numbers by hash, then file number which is name order
+MEMSPACE
+int lif_index_hash_cmp(const void *a, const void *b)
+{
+    uint32_t A = *(uint32_t *) a;
+    uint32_t B = *(uint32_t *) b;
+
+    if(lif_index_sort[A].hash != lif_index_sort[B].hash)
+        return(lif_index_sort[A].hash < lif_index_sort[B].hash ? -1 : 1);
+    return(A < B ? -1 : (A > B));
+}
+
+
+/// @brief Write an index file
+/// Images must already be in path name order, files are sorted here
+/// The index is written to name.tmp and renamed so readers never see a partial index
+/// @param[in] *name: index file name
+/// @param[in,out] *X: index
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_index_write(char *name, lifindex_t *X)
+{
+    FILE *fp;
+    uint8_t *buf, *B;
+    uint32_t *post;
+    uint32_t i, strings, str;
+    long imagetab, filetab, types, hashes, stringtab, size;
+    char tmp[LIF_INDEX_TMP];
+    int len;
+
+    qsort(X->file, X->files, sizeof(lifindex_file_t), lif_index_file_cmp);
+
+    strings = 0;
+    for(i = 0; i < X->images; ++i)
+        strings += strlen(X->image[i].path) + 1;
+
+    imagetab = LIF_INDEX_HEADER_SIZE;
+    filetab = imagetab + (long) X->images * LIF_INDEX_IMAGE_SIZE;
+    types = filetab + (long) X->files * LIF_INDEX_FILE_SIZE;
+    hashes = types + (long) X->files * 4;
+    stringtab = hashes + (long) X->files * 4;
+    size = stringtab + strings;
+
+    buf = calloc(size, 1);
+    post = calloc(X->files + 1, sizeof(uint32_t));
+    if(buf == NULL || post == NULL)
+    {
+        printf("lif_index: out of memory\n");
+        free(buf);
+        free(post);
+        return(0);
+    }
+
+    memcpy(buf, LIF_INDEX_MAGIC, LIF_INDEX_MAGIC_SIZE);
+    V2B_LSB(buf, 8, 2, LIF_INDEX_VERSION);
+    V2B_LSB(buf, 10, 4, X->images);
+    V2B_LSB(buf, 14, 4, X->files);
+    V2B_LSB(buf, 18, 4, imagetab);
+    V2B_LSB(buf, 22, 4, filetab);
+    V2B_LSB(buf, 26, 4, types);
+    V2B_LSB(buf, 30, 4, hashes);
+    V2B_LSB(buf, 34, 4, stringtab);
+    V2B_LSB(buf, 38, 4, strings);
+
+    str = 0;
+    for(i = 0; i < X->images; ++i)
+    {
+        B = buf + imagetab + (long) i * LIF_INDEX_IMAGE_SIZE;
+        len = strlen(X->image[i].path) + 1;
+        memcpy(buf + stringtab + str, X->image[i].path, len);
+        V2B_LSB(B, 0, 4, str);
+        str += len;
+        lif_index_put64(B, 4, (uint64_t) X->image[i].mtime);
+        lif_index_put64(B, 12, (uint64_t) X->image[i].size);
+        memcpy(B + 20, X->image[i].label, strlen(X->image[i].label));
+        V2B_LSB(B, 26, 2, X->image[i].flags);
+        V2B_LSB(B, 28, 4, X->image[i].files);
+    }
+
+    for(i = 0; i < X->files; ++i)
+    {
+        B = buf + filetab + (long) i * LIF_INDEX_FILE_SIZE;
+        memcpy(B, X->file[i].name, strlen(X->file[i].name));
+        V2B_LSB(B, 10, 2, X->file[i].type);
+        V2B_LSB(B, 12, 4, X->file[i].image);
+        V2B_LSB(B, 16, 4, X->file[i].start);
+        V2B_LSB(B, 20, 4, X->file[i].sectors);
+        V2B_LSB(B, 24, 4, X->file[i].bytes);
+        memcpy(B + 28, X->file[i].date, 6);
+        lif_index_put64(B, 36, X->file[i].hash);
+    }
+
+// Postings are file numbers into the name sorted file table
+    lif_index_sort = X->file;
+    for(i = 0; i < X->files; ++i)
+        post[i] = i;
+    qsort(post, X->files, sizeof(uint32_t), lif_index_type_cmp);
+    for(i = 0; i < X->files; ++i)
+        V2B_LSB(buf, types + (long) i * 4, 4, post[i]);
+    qsort(post, X->files, sizeof(uint32_t), lif_index_hash_cmp);
+    for(i = 0; i < X->files; ++i)
+        V2B_LSB(buf, hashes + (long) i * 4, 4, post[i]);
+    free(post);
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+    fp = fopen(tmp, "wb");
+    if(fp == NULL)
+    {
+        printf("lif_index: can not create:[%s]\n", tmp);
+        free(buf);
+        return(0);
+    }
+    if(fwrite(buf, 1, size, fp) != (size_t) size || fclose(fp) != 0)
+    {
+        printf("lif_index: write error:[%s]\n", tmp);
+        unlink(tmp);
+        free(buf);
+        return(0);
+    }
+    free(buf);
+    if(rename(tmp, name) < 0)
+    {
+        printf("lif_index: can not rename:[%s] to:[%s]\n", tmp, name);
+        unlink(tmp);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Read an index file into memory for queries
+/// @param[in] *name: index file name
+/// @param[out] *M: loaded index
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_index_open(char *name, lifindex_map_t *M)
+{
+    FILE *fp;
+    stat_t sb;
+    long imagetab, filetab, types, hashes, stringtab;
+
+    memset(M, 0, sizeof(lifindex_map_t));
+
+    if(stat(name, &sb) < 0 || sb.st_size < LIF_INDEX_HEADER_SIZE)
+        return(0);
+    fp = fopen(name, "rb");
+    if(fp == NULL)
+        return(0);
+    M->size = sb.st_size;
+    M->buf = malloc(M->size);
+    if(M->buf == NULL || fread(M->buf, 1, M->size, fp) != (size_t) M->size)
+    {
+        fclose(fp);
+        lif_index_close(M);
+        return(0);
+    }
+    fclose(fp);
+
+    if(memcmp(M->buf, LIF_INDEX_MAGIC, LIF_INDEX_MAGIC_SIZE) != 0 ||
+        B2V_LSB(M->buf, 8, 2) != LIF_INDEX_VERSION)
+    {
+        printf("lif_index:[%s] is not a LIF index\n", name);
+        lif_index_close(M);
+        return(0);
+    }
+
+    M->images = B2V_LSB(M->buf, 10, 4);
+    M->files = B2V_LSB(M->buf, 14, 4);
+    imagetab = B2V_LSB(M->buf, 18, 4);
+    filetab = B2V_LSB(M->buf, 22, 4);
+    types = B2V_LSB(M->buf, 26, 4);
+    hashes = B2V_LSB(M->buf, 30, 4);
+    stringtab = B2V_LSB(M->buf, 34, 4);
+    M->stringsize = B2V_LSB(M->buf, 38, 4);
+
+    if(imagetab + (long) M->images * LIF_INDEX_IMAGE_SIZE > M->size ||
+        filetab + (long) M->files * LIF_INDEX_FILE_SIZE > M->size ||
+        types + (long) M->files * 4 > M->size ||
+        hashes + (long) M->files * 4 > M->size ||
+        stringtab + (long) M->stringsize > M->size ||
+        (M->stringsize && M->buf[stringtab + M->stringsize - 1] != 0))
+    {
+        printf("lif_index:[%s] is damaged, run lif index build again\n", name);
+        lif_index_close(M);
+        return(0);
+    }
+
+    M->image = M->buf + imagetab;
+    M->file = M->buf + filetab;
+    M->types = M->buf + types;
+    M->hashes = M->buf + hashes;
+    M->strings = (char *) M->buf + stringtab;
+    return(1);
+}
+
+
+/// @brief Free an index read by lif_index_open()
+/// @param[in,out] *M: loaded index
+/// @return void
+MEMSPACE
+void lif_index_close(lifindex_map_t *M)
+{
+    free(M->buf);
+    memset(M, 0, sizeof(lifindex_map_t));
+}
+
+
+/// @brief Read an existing index file so unchanged images need not be scanned again
+/// @param[in] *name: index file name
+/// @param[out] *X: index
+/// @return 1 on success, 0 if there is no usable index
+MEMSPACE
+int lif_index_load(char *name, lifindex_t *X)
+{
+    lifindex_map_t M;
+    lifindex_image_t *I;
+    lifindex_file_t *F;
+    uint8_t *B;
+    uint32_t i, str, images, files;
+
+    memset(X, 0, sizeof(lifindex_t));
+    if(!lif_index_open(name, &M))
+        return(0);
+
+    for(i = 0; i < M.images; ++i)
+    {
+        B = M.image + (long) i * LIF_INDEX_IMAGE_SIZE;
+        str = B2V_LSB(B, 0, 4);
+        if(str >= M.stringsize)
+            break;
+        I = lif_index_add_image(X, M.strings + str,
+            (int64_t) lif_index_get64(B, 4), (int64_t) lif_index_get64(B, 12));
+        if(I == NULL)
+            break;
+        memcpy(I->label, B + 20, 6);
+        I->flags = B2V_LSB(B, 26, 2);
+        I->files = B2V_LSB(B, 28, 4);
+    }
+    for(i = 0; i < M.files && X->images == M.images; ++i)
+    {
+        B = M.file + (long) i * LIF_INDEX_FILE_SIZE;
+        F = lif_index_add_file(X);
+        if(F == NULL)
+            break;
+        memcpy(F->name, B, 10);
+        F->type = B2V_LSB(B, 10, 2);
+        F->image = B2V_LSB(B, 12, 4);
+// lif_index_build() uses the image number as an array index
+        if(F->image >= M.images)
+            break;
+        F->start = B2V_LSB(B, 16, 4);
+        F->sectors = B2V_LSB(B, 20, 4);
+        F->bytes = B2V_LSB(B, 24, 4);
+        memcpy(F->date, B + 28, 6);
+        F->hash = lif_index_get64(B, 36);
+    }
+    images = M.images;
+    files = M.files;
+    lif_index_close(&M);
+
+    if(X->images != images || X->files != files)
+    {
+        printf("lif_index:[%s] is damaged, every image will be scanned again\n", name);
+        lif_index_free(X);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Catalog one LIF image, run in a worker process by lif_parallel()
+/// Writes an image record followed by its file records to J->out
+/// Files that are not LIF images are recorded with LIF_INDEX_NOTLIF
+/// @param[in,out] *J: work item
+/// @param[in] *source: not used
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_index_image(lifjob_t *J, char *source)
+{
+    lif_t *LIF;
+    lifdir_t *DIR;
+    lifindex_image_t I;
+    lifindex_file_t F;
+    FILE *fo;
+    long size;
+
+    fo = fopen(J->out, "wb");
+    if(fo == NULL)
+    {
+        printf("lif_index: can not create:[%s]\n", J->out);
+        ++J->errors;
+        return(0);
+    }
+
+    memset(&I, 0, sizeof(I));
+    fwrite(&I, sizeof(I), 1, fo);
+
+    LIF = lif_open_volume(J->image, "rb");
+    if(LIF == NULL)
+    {
+        printf("lif_index:[%s] is not a LIF image\n", J->image);
+        I.flags = LIF_INDEX_NOTLIF;
+    }
+    else
+    {
+        snprintf(I.label, sizeof(I.label), "%s", (char *) LIF->VOL.Label);
+        while((DIR = lif_readdir(LIF)) != NULL)
+        {
+            memset(&F, 0, sizeof(F));
+            snprintf(F.name, sizeof(F.name), "%s", (char *) DIR->filename);
+            F.type = DIR->FileType;
+            F.start = DIR->FileStartSector;
+            F.sectors = DIR->FileSectors;
+            F.bytes = DIR->FileBytes;
+            memcpy(F.date, DIR->date, 6);
+
+            F.hash = LIF_INDEX_HASH_INIT;
+            size = lif_index_stream(LIF, F.start, F.sectors, &F.hash, NULL);
+            if(size != F.sectors * (long) LIF_SECTOR_SIZE)
+            {
+                printf("lif_index:[%s] file:[%s] extends past the end of the image\n", J->image, F.name);
+                ++J->errors;
+            }
+
+            fwrite(&F, sizeof(F), 1, fo);
+            ++I.files;
+        }
+        lif_closedir(LIF);
+    }
+
+    rewind(fo);
+    fwrite(&I, sizeof(I), 1, fo);
+    if(fclose(fo) != 0)
+    {
+        printf("lif_index: write error:[%s]\n", J->out);
+        ++J->errors;
+        return(0);
+    }
+    J->files = I.files;
+    return(1);
+}
+
+
+/// @brief Sort images by path name
+static int lif_index_path_cmp(const void *a, const void *b)
+{
+    return(strcmp(((lifindex_image_t *) a)->path, ((lifindex_image_t *) b)->path));
+}
+
+
+/// @brief Index file name for a directory or index file
+/// @param[in] *dir: indexed directory or index file name
+/// @param[out] *name: index file name
+/// @param[in] size: size of name
+/// @return void
+MEMSPACE
+void lif_index_name(char *dir, char *name, int size)
+{
+    stat_t sb;
+
+    if(stat(dir, &sb) == 0 && S_ISDIR(sb.st_mode))
+        snprintf(name, size, "%s/%s", dir, LIF_INDEX_NAME);
+    else
+        snprintf(name, size, "%s", dir);
+}
+
+
+/// @brief Build or update the index of every LIF image in a directory tree
+/// Images with the same modification time and size as in the existing index
+/// keep their entries, the rest are scanned by a pool of processes
+/// @param[in] *dir: directory tree of .lif images, the index is dir/lif.idx
+/// @param[in] jobs: processes, 0 = one per core
+/// @return number of images that failed, -1 on error
+MEMSPACE
+int lif_index_build(char *dir, int jobs)
+{
+    lifindex_t X, O;
+    lifindex_image_t key, *I, *P;
+    lifindex_file_t *F;
+    lifjobs_t L;
+    lifjob_t *J;
+    FILE *fi;
+    struct timespec start;
+    char name[LIF_INDEX_PATH];
+    char tmp[LIF_INDEX_TMP];
+    int32_t *map = NULL;
+    uint32_t *slot = NULL;
+    uint32_t i, n, reused = 0;
+    int k, failed = 0;
+
+    clock_gettime(0, &start);
+    snprintf(name, sizeof(name), "%s/%s", dir, LIF_INDEX_NAME);
+
+    memset(&X, 0, sizeof(X));
+    memset(&L, 0, sizeof(L));
+    if(!lif_index_scan(&X, dir))
+    {
+        lif_index_free(&X);
+        return(-1);
+    }
+    qsort(X.image, X.images, sizeof(lifindex_image_t), lif_index_path_cmp);
+
+    lif_index_load(name, &O);
+    map = calloc(O.images + 1, sizeof(int32_t));
+    slot = calloc(X.images + 1, sizeof(uint32_t));
+    if(map == NULL || slot == NULL)
+    {
+        printf("lif_index: out of memory\n");
+        failed = -1;
+        goto done;
+    }
+    for(i = 0; i < O.images; ++i)
+        map[i] = -1;
+
+// Unchanged images keep their entries, the rest are scanned
+    for(i = 0; i < X.images; ++i)
+    {
+        I = &X.image[i];
+        key.path = I->path;
+        P = bsearch(&key, O.image, O.images, sizeof(lifindex_image_t), lif_index_path_cmp);
+        if(P && P->mtime == I->mtime && P->size == I->size)
+        {
+            map[P - O.image] = i;
+            memcpy(I->label, P->label, sizeof(I->label));
+            I->flags = P->flags;
+            I->files = P->files;
+            ++reused;
+            continue;
+        }
+        J = lif_job_new(&L, I->path);
+        if(J == NULL)
+        {
+            failed = -1;
+            goto done;
+        }
+        snprintf(tmp, sizeof(tmp), "%s.%d.tmp", name, L.count - 1);
+        J->out = strdup(tmp);
+        snprintf(tmp, sizeof(tmp), "%s.%d.log", name, L.count - 1);
+        J->log = strdup(tmp);
+        slot[L.count - 1] = i;
+    }
+    for(i = 0; i < O.files; ++i)
+    {
+        if(map[O.file[i].image] < 0)
+            continue;
+        F = lif_index_add_file(&X);
+        if(F == NULL)
+        {
+            failed = -1;
+            goto done;
+        }
+        *F = O.file[i];
+        F->image = map[O.file[i].image];
+    }
+
+    if(L.count)
+        jobs = lif_parallel(&L, NULL, jobs, lif_index_image);
+
+// Collect worker results in image order
+    for(k = 0; k < L.count; ++k)
+    {
+        lifindex_image_t R;
+
+        J = &L.job[k];
+        I = &X.image[slot[k]];
+        fi = fopen(J->out, "rb");
+        if(J->status <= 0 || fi == NULL || fread(&R, sizeof(R), 1, fi) != 1)
+        {
+            printf("lif_index:[%s] failed, see %s\n", J->image, J->log);
+// Scan it again next time
+            I->mtime = 0;
+            I->flags = LIF_INDEX_NOTLIF;
+            ++failed;
+            if(fi)
+                fclose(fi);
+            unlink(J->out);
+            continue;
+        }
+        memcpy(I->label, R.label, sizeof(I->label));
+        I->flags = R.flags;
+        I->files = 0;
+        for(n = 0; n < R.files; ++n)
+        {
+            F = lif_index_add_file(&X);
+            if(F == NULL || fread(F, sizeof(lifindex_file_t), 1, fi) != 1)
+            {
+                if(F)
+                    --X.files;
+                break;
+            }
+            F->image = slot[k];
+            ++I->files;
+        }
+        if(J->errors)
+        {
+            printf("lif_index:[%s] has errors, see %s\n", J->image, J->log);
+            I->mtime = 0;
+            ++failed;
+        }
+        fclose(fi);
+        unlink(J->out);
+    }
+
+    if(!lif_index_write(name, &X))
+    {
+        failed = -1;
+        goto done;
+    }
+
+    printf("Indexed:[%s] %lu images, %lu unchanged, %d scanned, %d failed, %lu files, %ld ms\n",
+        name, (unsigned long) X.images, (unsigned long) reused, L.count, failed,
+        (unsigned long) X.files, lif_elapsed_us(&start) / 1000L);
+
+done:
+    free(map);
+    free(slot);
+    lif_jobs_free(&L);
+    lif_index_free(&O);
+    lif_index_free(&X);
+    return(failed);
+}
+
+
+/// @brief Display one file of a loaded index
+/// @param[in] *M: loaded index
+/// @param[in] n: file number
+/// @return void
+MEMSPACE
+void lif_index_print(lifindex_map_t *M, uint32_t n)
+{
+    uint8_t *B, *I;
+    char name[10+1];
+    char label[6+1];
+    uint32_t image, str;
+    uint8_t date[6];
+
+    B = M->file + (long) n * LIF_INDEX_FILE_SIZE;
+    memcpy(name, B, 10);
+    name[10] = 0;
+    memcpy(date, B + 28, 6);
+    image = B2V_LSB(B, 12, 4);
+    if(image >= M->images)
+        return;
+    I = M->image + (long) image * LIF_INDEX_IMAGE_SIZE;
+    str = B2V_LSB(I, 0, 4);
+    memcpy(label, I + 20, 6);
+    label[6] = 0;
+
+    printf("%-10s %04Xh %8lu %8lu  %s  %016llx  %s [%s]\n",
+        name,
+        (int) B2V_LSB(B, 10, 2),
+        (unsigned long) B2V_LSB(B, 20, 4),
+        (unsigned long) B2V_LSB(B, 24, 4),
+        lif_lifbcd2timestr(date),
+        (unsigned long long) lif_index_get64(B, 36),
+        str < M->stringsize ? M->strings + str : "?",
+        label);
+}
+
+
+/// @brief Find files in an index by name prefix, type or content hash
+/// @param[in] *dir: indexed directory or index file name
+/// @param[in] *what: name, type or hash
+/// @param[in] *value: name prefix, hex file type or hex hash
+/// @return number of matching files, -1 on error
+MEMSPACE
+int lif_index_query(char *dir, char *what, char *value)
+{
+    lifindex_map_t M;
+    struct timespec start;
+    char name[LIF_INDEX_PATH];
+    char fname[10+1];
+    uint32_t lo, hi, mid, n;
+    uint64_t hash = 0, h;
+    int type = 0, t;
+    int mode, len;
+    int count = 0;
+
+    if(MATCHI(what,"name"))
+        mode = 0;
+    else if(MATCHI(what,"type"))
+    {
+        mode = 1;
+        type = strtoul(value, NULL, 16);
+    }
+    else if(MATCHI(what,"hash"))
+    {
+        mode = 2;
+        hash = strtoull(value, NULL, 16);
+    }
+    else
+    {
+        printf("lif index query: expected name, type or hash\n");
+        return(-1);
+    }
+
+    lif_index_name(dir, name, sizeof(name));
+    if(!lif_index_open(name, &M))
+    {
+        printf("lif_index: can not read:[%s], run lif index build first\n", name);
+        return(-1);
+    }
+
+    clock_gettime(0, &start);
+    len = strlen(value);
+    fname[10] = 0;
+
+// Binary search for the first match, matches follow it
+    lo = 0;
+    hi = M.files;
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(mode == 0)
+        {
+            memcpy(fname, M.file + (long) mid * LIF_INDEX_FILE_SIZE, 10);
+            if(strncasecmp(fname, value, len) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        else if(mode == 1)
+        {
+            n = B2V_LSB(M.types, (long) mid * 4, 4);
+            if(n >= M.files)
+                break;
+            t = B2V_LSB(M.file + (long) n * LIF_INDEX_FILE_SIZE, 10, 2);
+            if(t < type)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        else
+        {
+            n = B2V_LSB(M.hashes, (long) mid * 4, 4);
+            if(n >= M.files)
+                break;
+            h = lif_index_get64(M.file + (long) n * LIF_INDEX_FILE_SIZE, 36);
+            if(h < hash)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+
+    for(mid = lo; mid < M.files; ++mid)
+    {
+        if(mode == 0)
+        {
+            n = mid;
+            memcpy(fname, M.file + (long) n * LIF_INDEX_FILE_SIZE, 10);
+            if(strncasecmp(fname, value, len) != 0)
+                break;
+        }
+        else if(mode == 1)
+        {
+            n = B2V_LSB(M.types, (long) mid * 4, 4);
+            if(n >= M.files || (int) B2V_LSB(M.file + (long) n * LIF_INDEX_FILE_SIZE, 10, 2) != type)
+                break;
+        }
+        else
+        {
+            n = B2V_LSB(M.hashes, (long) mid * 4, 4);
+            if(n >= M.files || lif_index_get64(M.file + (long) n * LIF_INDEX_FILE_SIZE, 36) != hash)
+                break;
+        }
+        lif_index_print(&M, n);
+        ++count;
+    }
+
+    printf("%d files, %lu images, %lu indexed files, %ld us\n",
+        count, (unsigned long) M.images, (unsigned long) M.files, lif_elapsed_us(&start));
+    lif_index_close(&M);
+    return(count);
+}
+
+
+/// @brief Report files with identical contents in a directory tree of LIF images
+/// Updates the index with lif_index_build() then walks the hash postings,
+/// files with the same hash are next to each other
+/// @param[in] *dir: directory tree of .lif images
+/// @param[in] jobs: processes, 0 = one per core
+/// @return number of duplicate sets, -1 on error
+MEMSPACE
+int lif_dedup_report(char *dir, int jobs)
+{
+    lifindex_map_t M;
+    struct timespec start;
+    char name[LIF_INDEX_PATH];
+    uint8_t *F;
+    uint64_t hash;
+    uint32_t i, j, k;
+    long size, copies;
+    long total = 0, unique = 0, uniquebytes = 0, dupfiles = 0, wasted = 0;
+    int sets = 0;
+
+    if(lif_index_build(dir, jobs) < 0)
+        return(-1);
+    lif_index_name(dir, name, sizeof(name));
+    if(!lif_index_open(name, &M))
+    {
+        printf("lif_dedup: can not read:[%s]\n", name);
+        return(-1);
+    }
+
+    clock_gettime(0, &start);
+    for(i = 0; i < M.files; i = j)
+    {
+        k = B2V_LSB(M.hashes, (long) i * 4, 4);
+        if(k >= M.files)
+            break;
+        F = M.file + (long) k * LIF_INDEX_FILE_SIZE;
+        hash = lif_index_get64(F, 36);
+        size = B2V_LSB(F, 20, 4) * (long) LIF_SECTOR_SIZE;
+
+        for(j = i + 1; j < M.files; ++j)
+        {
+            k = B2V_LSB(M.hashes, (long) j * 4, 4);
+            if(k >= M.files || lif_index_get64(M.file + (long) k * LIF_INDEX_FILE_SIZE, 36) != hash)
+                break;
+        }
+        copies = j - i;
+        total += copies * size;
+        ++unique;
+        uniquebytes += size;
+        if(copies < 2 || !size)
+            continue;
+
+        ++sets;
+        dupfiles += copies - 1;
+        wasted += (copies - 1) * size;
+        printf("\n%016llx %ld copies of %ld bytes, %ld bytes wasted\n",
+            (unsigned long long) hash, copies, size, (copies - 1) * size);
+        for(k = i; k < j; ++k)
+            lif_index_print(&M, B2V_LSB(M.hashes, (long) k * 4, 4));
+    }
+
+    printf("\n%lu files, %ld bytes\n", (unsigned long) M.files, total);
+    printf("%ld unique contents, %ld bytes\n", unique, uniquebytes);
+    printf("%d duplicate sets, %ld duplicate files, %ld bytes wasted (%ld%%), %ld us\n",
+        sets, dupfiles, wasted, total ? (wasted * 100L) / total : 0L, lif_elapsed_us(&start));
+    lif_index_close(&M);
+    return(sets);
+}
+
+
+/// @brief Name of the object holding file sectors with a given hash
+/// @param[in] *store: store directory
+/// @param[in] hash: hash of the file sectors
+/// @param[out] *name: object file name
+/// @param[in] size: size of name
+/// @return void
+MEMSPACE
+void lif_dedup_object(char *store, uint64_t hash, char *name, int size)
+{
+    snprintf(name, size, "%s/%s/%02x/%016llx",
+        store, LIF_DEDUP_OBJECTS, (int) (hash >> 56), (unsigned long long) hash);
+}
+
+
+/// @brief Store the files of one LIF image, run in a worker process by lif_parallel()
+/// Files are written to the store by hash unless an object with that hash is
+/// already there. J->out gets the lif build manifest lines that rebuild the image
+/// @param[in,out] *J: work item, J->dir is the rebuilt image name
+/// @param[in] *store: store directory
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_dedup_image(lifjob_t *J, char *store)
+{
+    lif_t *LIF;
+    lifdir_t *DIR;
+    FILE *fo, *fp;
+    stat_t sb;
+    uint8_t B[LIF_SECTOR_SIZE];
+    char hex[LIF_VOL_SIZE * 2 + 1];
+    char object[LIF_INDEX_PATH];
+    char tmp[LIF_INDEX_TMP];
+    char *ptr;
+    uint64_t hash;
+    long size, bytes;
+    int i;
+
+    LIF = lif_open_volume(J->image, "rb");
+    if(LIF == NULL)
+    {
+        printf("lif_dedup:[%s] is not a LIF image\n", J->image);
+        ++J->errors;
+        return(0);
+    }
+    fo = fopen(J->out, "w");
+    if(fo == NULL)
+    {
+        printf("lif_dedup: can not create:[%s]\n", J->out);
+        lif_closedir(LIF);
+        ++J->errors;
+        return(0);
+    }
+    fprintf(fo, "image \"%s\" \"%s\" %lu %lu dirstart %lu\n",
+        J->dir, (char *) LIF->VOL.Label, (unsigned long) LIF->VOL.DirSectors, (unsigned long) LIF->sectors,
+        (unsigned long) LIF->VOL.DirStartSector);
+
+// The raw header keeps the label, version, geometry and date as they were
+    if(lif_read(LIF, B, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+    {
+        printf("lif_dedup:[%s] can not read the volume header\n", J->image);
+        ++J->errors;
+    }
+    else
+    {
+        for(i = 0; i < LIF_VOL_SIZE; ++i)
+            sprintf(hex + i * 2, "%02x", B[i]);
+        fprintf(fo, "volume %s\n", hex);
+    }
+
+    while((DIR = lif_readdir(LIF)) != NULL)
+    {
+        size = DIR->FileSectors * (long) LIF_SECTOR_SIZE;
+        hash = LIF_INDEX_HASH_INIT;
+        if(lif_index_stream(LIF, DIR->FileStartSector, DIR->FileSectors, &hash, NULL) != size)
+        {
+            printf("lif_dedup:[%s] file:[%s] extends past the end of the image\n", J->image, DIR->filename);
+            ++J->errors;
+            continue;
+        }
+        lif_dedup_object(store, hash, object, sizeof(object));
+
+        if(stat(object, &sb) == 0)
+        {
+            if(sb.st_size != size)
+            {
+                printf("lif_dedup:[%s] file:[%s] hash %016llx is used by a %ld byte object\n",
+                    J->image, DIR->filename, (unsigned long long) hash, (long) sb.st_size);
+                ++J->errors;
+                continue;
+            }
+        }
+        else
+        {
+            snprintf(tmp, sizeof(tmp), "%s", object);
+            ptr = strrchr(tmp, '/');
+            *ptr = 0;
+            if(!lif_mkdirs(tmp))
+            {
+                ++J->errors;
+                continue;
+            }
+            snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", object, (long) getpid());
+            fp = fopen(tmp, "wb");
+            if(fp == NULL)
+            {
+                printf("lif_dedup: can not create:[%s]\n", tmp);
+                ++J->errors;
+                continue;
+            }
+            bytes = lif_index_stream(LIF, DIR->FileStartSector, DIR->FileSectors, NULL, fp);
+            if(fclose(fp) != 0 || bytes != size)
+            {
+                printf("lif_dedup: write error:[%s]\n", tmp);
+                unlink(tmp);
+                ++J->errors;
+                continue;
+            }
+// link() fails if another worker stored the same contents first
+            if(link(tmp, object) == 0)
+                J->stored += size;
+            else if(errno != EEXIST)
+            {
+                printf("lif_dedup: can not create:[%s]\n", object);
+                ++J->errors;
+            }
+            unlink(tmp);
+        }
+
+        lif_dir2str(LIF, B);
+        for(i = 0; i < LIF_DIR_SIZE; ++i)
+            sprintf(hex + i * 2, "%02x", B[i]);
+        fprintf(fo, "addraw \"%s\" \"%s\" %s\n", (char *) DIR->filename, object, hex);
+        J->bytes += size;
+        ++J->files;
+    }
+    lif_closedir(LIF);
+
+    if(fclose(fo) != 0)
+    {
+        printf("lif_dedup: write error:[%s]\n", J->out);
+        ++J->errors;
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Copy every LIF image in a directory tree into a content addressed store
+/// Each distinct file content is stored once under store/objects by its hash and
+/// store/manifest rebuilds all of the images under store/images with lif build
+/// Rebuilt images have the same files and directory records, files are packed
+/// so space left by deleted files is not kept
+/// @param[in] *dir: directory tree of .lif images
+/// @param[in] *store: store directory, may already hold objects
+/// @param[in] jobs: processes, 0 = one per core
+/// @return number of images that failed, -1 on error
+MEMSPACE
+int lif_dedup_store(char *dir, char *store, int jobs)
+{
+    lifindex_t X;
+    lifjobs_t L;
+    lifjob_t *J;
+    FILE *fi, *fo;
+    struct timespec start;
+    char name[LIF_INDEX_PATH];
+    char tmp[LIF_INDEX_TMP];
+    char buf[4096];
+    char *rel;
+    long files = 0, bytes = 0, stored = 0;
+    size_t size;
+    uint32_t i;
+    int k, failed = 0;
+
+    clock_gettime(0, &start);
+    memset(&X, 0, sizeof(X));
+    memset(&L, 0, sizeof(L));
+    if(!lif_index_scan(&X, dir))
+    {
+        lif_index_free(&X);
+        return(-1);
+    }
+    qsort(X.image, X.images, sizeof(lifindex_image_t), lif_index_path_cmp);
+    if(!X.images)
+    {
+        printf("lif_dedup:[%s] no LIF images\n", dir);
+        lif_index_free(&X);
+        return(-1);
+    }
+    if(!lif_mkdirs(store))
+    {
+        lif_index_free(&X);
+        return(-1);
+    }
+
+    snprintf(name, sizeof(name), "%s/%s", store, LIF_DEDUP_MANIFEST);
+    for(i = 0; i < X.images; ++i)
+    {
+        J = lif_job_new(&L, X.image[i].path);
+        if(J == NULL)
+        {
+            lif_jobs_free(&L);
+            lif_index_free(&X);
+            return(-1);
+        }
+        rel = X.image[i].path + strlen(dir);
+        while(*rel == '/')
+            ++rel;
+        snprintf(tmp, sizeof(tmp), "%s/%s/%s", store, LIF_DEDUP_IMAGES, rel);
+        J->dir = strdup(tmp);
+        snprintf(tmp, sizeof(tmp), "%s.%lu.tmp", name, (unsigned long) i);
+        J->out = strdup(tmp);
+        snprintf(tmp, sizeof(tmp), "%s.%lu.log", name, (unsigned long) i);
+        J->log = strdup(tmp);
+    }
+    lif_index_free(&X);
+
+    jobs = lif_parallel(&L, store, jobs, lif_dedup_image);
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+    fo = fopen(tmp, "w");
+    if(fo == NULL)
+    {
+        printf("lif_dedup: can not create:[%s]\n", tmp);
+        failed = -1;
+    }
+    else
+        fprintf(fo, "# lif dedup store of %s\n# lif build %s rebuilds the images\n", dir, name);
+
+// Join the worker manifests in image order, leaving out failed images
+    for(k = 0; k < L.count; ++k)
+    {
+        J = &L.job[k];
+        if(J->status <= 0 || J->errors)
+        {
+            printf("lif_dedup:[%s] failed, see %s\n", J->image, J->log);
+            if(failed >= 0)
+                ++failed;
+            unlink(J->out);
+            continue;
+        }
+        fi = fopen(J->out, "r");
+        if(fi != NULL && fo != NULL)
+        {
+            while((size = fread(buf, 1, sizeof(buf), fi)) > 0)
+                fwrite(buf, 1, size, fo);
+        }
+        if(fi != NULL)
+            fclose(fi);
+        unlink(J->out);
+        files += J->files;
+        bytes += J->bytes;
+        stored += J->stored;
+    }
+
+    if(fo != NULL)
+    {
+        if(fclose(fo) != 0 || rename(tmp, name) < 0)
+        {
+            printf("lif_dedup: write error:[%s]\n", name);
+            unlink(tmp);
+            failed = -1;
+        }
+    }
+
+    printf("Stored:[%s] %d images, %d failed, %ld files, %ld bytes, %ld bytes of new objects, %d jobs, %ld ms\n",
+        store, L.count, failed, files, bytes, stored, jobs, lif_elapsed_us(&start) / 1000L);
+    lif_jobs_free(&L);
+    return(failed);
+}
+#endif                                            // LIF_PARALLEL
+#endif                                            // LIF_STAND_ALONE
@@ -0,0 +1,166 @@
+/**
+ @file lif/lifindex.h
+
+ @brief Searchable catalog of the files in a library of LIF images, stand alone lif utility only
+
+ @par Edit History
+ - [1.0]   [Mike Gore]  Initial revision of file.
+
+ @par Copyright &copy; 2014-2020 Mike Gore, All rights reserved. GPL
+ @see http://github.com/magore/hp85disk
+ @see http://github.com/magore/hp85disk/COPYRIGHT.md for Copyright details
+
+*/
+
+#ifndef _LIFINDEX_H
+#define _LIFINDEX_H
+
+/**
+  @brief Index file layout
+  All values are stored LSB first
+
+    OFFSET  DESCRIPTION
+    ------  -----------------------------------------------------------
+    header (LIF_INDEX_HEADER_SIZE bytes)
+      0-7   Magic "LIFINDEX"
+      8-9   Version
+     10-13  Number of images
+     14-17  Number of files
+     18-21  File offset of the image table
+     22-25  File offset of the file table
+     26-29  File offset of the type postings
+     30-33  File offset of the hash postings
+     34-37  File offset of the string table
+     38-41  String table size in bytes
+
+    image table, LIF_INDEX_IMAGE_SIZE bytes per image, sorted by path name
+      0-3   String table offset of the image path name
+      4-11  Image modification time
+     12-19  Image size in bytes
+     20-25  Volume label, 0 padded
+     26-27  Flags, LIF_INDEX_NOTLIF
+     28-31  Number of files
+
+    file table, LIF_INDEX_FILE_SIZE bytes per file, sorted by name then image
+      0-9   File name, 0 padded
+     10-11  File type
+     12-15  Image number
+     16-19  Start sector
+     20-23  Sectors
+     24-27  LIF file bytes
+     28-33  Date, BCD (YY MM DD HH MM SS)
+     34-35  Reserved
+     36-43  FNV-1a 64 bit hash of the file sectors
+     44-47  Reserved
+
+    type postings   4 byte file numbers sorted by type then name
+    hash postings   4 byte file numbers sorted by hash
+    string table    0 terminated image path names
+
+  Name prefix, type and hash queries are binary searches of the file
+  table or one of the postings, the index is never parsed as a whole
+*/
+
+#define LIF_INDEX_MAGIC "LIFINDEX"
+#define LIF_INDEX_MAGIC_SIZE 8
+#define LIF_INDEX_VERSION 1
+#define LIF_INDEX_HEADER_SIZE 64
+#define LIF_INDEX_IMAGE_SIZE 32
+#define LIF_INDEX_FILE_SIZE 48
+///@brief Index file name inside the indexed directory
+#define LIF_INDEX_NAME "lif.idx"
+
+///@brief Path buffers, LIF_INDEX_TMP has room for the suffixes added to a path
+#define LIF_INDEX_PATH 1024
+#define LIF_INDEX_TMP (LIF_INDEX_PATH + 32)
+
+///@brief FNV-1a 64 bit hash starting value
+#define LIF_INDEX_HASH_INIT 0xcbf29ce484222325ULL
+///@brief Bytes read at a time when hashing or copying file sectors
+#define LIF_INDEX_BUFFER (LIF_SECTOR_SIZE * 256)
+
+///@brief lif dedup store directory layout
+#define LIF_DEDUP_MANIFEST "manifest"             // lif build manifest that rebuilds the images
+#define LIF_DEDUP_OBJECTS "objects"               // objects/hh/hhhhhhhhhhhhhhhh file sectors by hash
+#define LIF_DEDUP_IMAGES "images"                 // Where lif build puts the rebuilt images
+
+///@brief Image flags
+#define LIF_INDEX_NOTLIF 1                        // Not a LIF image, no files
+
+///@brief Image in an index
+typedef struct
+{
+    char     *path;                               // Image path name
+    int64_t  mtime;                               // Image modification time
+    int64_t  size;                                // Image size in bytes
+    char     label[6+1];                          // Volume label
+    uint16_t flags;                               // LIF_INDEX_NOTLIF
+    uint32_t files;                               // Files in the image
+} lifindex_image_t;
+
+///@brief File in an index
+typedef struct
+{
+    char     name[10+1];                          // File name
+    uint16_t type;                                // File type
+    uint32_t image;                               // Image number
+    uint32_t start;                               // Start sector
+    uint32_t sectors;                             // Sectors
+    uint32_t bytes;                               // LIF file bytes
+    uint8_t  date[6];                             // Date, BCD
+    uint64_t hash;                                // FNV-1a 64 bit hash of the file sectors
+} lifindex_file_t;
+
+///@brief Index being built
+typedef struct
+{
+    lifindex_image_t *image;
+    uint32_t images;
+    uint32_t maximages;
+    lifindex_file_t *file;
+    uint32_t files;
+    uint32_t maxfiles;
+} lifindex_t;
+
+///@brief Index loaded for queries
+typedef struct
+{
+    uint8_t  *buf;                                // Whole index file
+    long     size;                                // Index file size
+    uint32_t images;
+    uint32_t files;
+    uint8_t  *image;                              // Image table
+    uint8_t  *file;                               // File table
+    uint8_t  *types;                              // Type postings
+    uint8_t  *hashes;                             // Hash postings
+    char     *strings;                            // String table
+    uint32_t stringsize;
+} lifindex_map_t;
+
+/* lifindex.c */
+MEMSPACE uint64_t lif_index_hash ( uint64_t hash , uint8_t *buf , long len );
+MEMSPACE long lif_index_stream ( lif_t *LIF , uint32_t start , uint32_t sectors , uint64_t *hash , FILE *fo );
+MEMSPACE lifindex_image_t *lif_index_add_image ( lifindex_t *X , char *path , int64_t mtime , int64_t size );
+MEMSPACE lifindex_file_t *lif_index_add_file ( lifindex_t *X );
+MEMSPACE void lif_index_free ( lifindex_t *X );
+MEMSPACE int lif_index_scan ( lifindex_t *X , char *dir );
+MEMSPACE void lif_index_put64 ( uint8_t *B , int index , uint64_t val );
+MEMSPACE uint64_t lif_index_get64 ( uint8_t *B , int index );
+MEMSPACE int lif_index_file_cmp ( const void *a , const void *b );
+MEMSPACE int lif_index_type_cmp ( const void *a , const void *b );
+MEMSPACE int lif_index_hash_cmp ( const void *a , const void *b );
+MEMSPACE int lif_index_write ( char *name , lifindex_t *X );
+MEMSPACE int lif_index_open ( char *name , lifindex_map_t *M );
+MEMSPACE void lif_index_close ( lifindex_map_t *M );
+MEMSPACE int lif_index_load ( char *name , lifindex_t *X );
+MEMSPACE int lif_index_image ( lifjob_t *J , char *source );
+MEMSPACE void lif_index_name ( char *dir , char *name , int size );
+MEMSPACE int lif_index_build ( char *dir , int jobs );
+MEMSPACE void lif_index_print ( lifindex_map_t *M , uint32_t n );
+MEMSPACE int lif_index_query ( char *dir , char *what , char *value );
+MEMSPACE int lif_dedup_report ( char *dir , int jobs );
+MEMSPACE void lif_dedup_object ( char *store , uint64_t hash , char *name , int size );
+MEMSPACE int lif_dedup_image ( lifjob_t *J , char *store );
+MEMSPACE int lif_dedup_store ( char *dir , char *store , int jobs );
+
+#endif                                            // _LIFINDEX_H
@@ -25,6 +25,8 @@
 #include "../lib/parsing.c"
 #include "../gpib/vector.c"
 #include "../gpib/drives_sup.c"
+#include "../gpib/sparse.c"
+#include "../gpib/zimage.c"
 
 int debuglevel = 0x0001;
 
@@ -111,6 +113,8 @@ void copyright()
 }
 
 
+// liblif.a and liblif.so leave out main()
+#ifndef LIF_LIBRARY
 int main(int argc, char *argv[])
 {
 
@@ -145,4 +149,5 @@ int main(int argc, char *argv[])
 #endif
     }
 }
+#endif                                            // LIF_LIBRARY
 #endif
@@ -90,12 +90,15 @@ lif extract /amigo1.lif HELLO3 /HELLO3.BAS
 #include "user_config.h"
 #include "lifsup.h"
 #include "lifutils.h"
+#include "lifindex.h"
 #include "td02lif.h"
 
 #else
 #include "hardware/user_config.h"
 #include "vector.h"
 #include "drives_sup.h"
+#include "sparse.h"
+#include "zimage.h"
 #include "lifsup.h"
 #include "lifutils.h"
 #endif
@@ -103,6 +106,17 @@ lif extract /amigo1.lif HELLO3 /HELLO3.BAS
 extern int debuglevel;
 extern hpdir_t hpdir;
 
+///@brief lif_newdir() placement policy
+int lif_alloc_policy = LIF_ALLOC_FIRST;
+
+///@brief Leave out progress messages when creating images, set by liblif
+int lif_quiet = 0;
+
+#ifdef LIF_MMAP
+///@brief Map flat LIF images into memory, 0 = use stdio for everything
+int lif_mmap = 1;
+#endif
+
 /// @brief
 ///  Help Menu for User invoked GPIB functions and tasks
 ///  See: int gpib_tests(char *str)
@@ -117,16 +131,84 @@ void lif_help(int full)
         printf(
             "lif add lifimage lifname from_ascii_file\n"
             "lif addbin lifimage lifname from_lif_file\n"
-            "lif create lifimage label directory_sectors sectors\n"
-            "lif createdisk lifimage label model\n"
+            "lif batch lifimage script|-\n"
+            "    runs add, addbin, extract, extractbin, del, rename, renamevol and addraw\n"
+            "    lines from a script, - reads stdin, against one open image\n"
+            "lif create lifimage label directory_sectors sectors [sparse]\n"
+            "lif createdisk lifimage label model [sparse]\n"
+            "    sparse creates a thin provisioned image that only stores written sectors\n"
             "lif del lifimage name\n"
             "lif dir lifimage\n"
+            "lif free lifimage [sectors]\n"
+            "    free extents, fragmentation and where a file of this size would go\n"
             "lif extract lifimage lifname to_ascii_file\n"
             "lif extractbin lifimage lifname to_lif_file\n"
             "    extracts a file into a sigle file LIF image\n"
+            "lif pack lifimage [dryrun]\n"
+            "    moves files down to reclaim space left by deleted files\n"
+            "    an interrupted pack resumes when run again\n"
             "lif rename lifimage oldlifname newlifname\n"
             "lif renamevol lifimage name\n"
+            );
+#ifdef LIF_STAND_ALONE
+        printf(
+            "lif sparse flatimage sparseimage\n"
+            "    converts a flat image into a sparse image, command line tool only\n"
+            "lif unsparse sparseimage flatimage\n"
+            "    converts a sparse image into a flat image, command line tool only\n"
+            "lif sparseinfo sparseimage\n"
+            );
+#endif
+        printf(
+            "lif overlay baseimage overlayimage\n"
+            "    creates an empty copy on write overlay of a read only base image\n"
+            "lif commit overlayimage\n"
+            "    writes overlay changes into the base image and empties the overlay\n"
+            "lif discard overlayimage\n"
+            "    empties the overlay, the base image is not changed\n"
+            "lif e010bench textfile [loops]\n"
+            "    compares line at a time and streaming E010 conversion of a text file\n"
+            );
+#ifdef LIF_STAND_ALONE
+        printf(
+            "lif compress flatimage zimage\n"
+            "    creates a read only compressed image the emulator can mount, command line tool only\n"
+            "lif uncompress zimage flatimage\n"
+            "    command line tool only\n"
+            "lif zinfo zimage\n"
+            "lif zbench flatimage zimage [reads]\n"
+            "    compares sector read times of a flat image and its compressed image\n"
+            );
+#endif
+#ifdef LIF_MMAP
+        printf(
+            "lif bench loops image|directory ...\n"
+            "    compares stdio and mmap directory scans and file reads, command line tool only\n"
+            );
+#endif
+#ifdef LIF_PARALLEL
+        printf(
+            "lif build manifest [jobs]\n"
+            "    creates every image in a manifest, one process per image, jobs 0 = one per core\n"
+            "    image name label model|dirsectors sectors [sparse] [dirstart N] starts each image\n"
+            "    followed by volume header, dir directory and lif batch command lines\n"
+            "lif extractall lifdir targetdir [jobs]\n"
+            "    extracts every .lif image in a directory tree into a directory per image\n"
+            "lif index build dir [jobs]\n"
+            "    catalogs every .lif image in a directory tree into dir/lif.idx\n"
+            "    only images changed since the last build are scanned again\n"
+            "lif index query dir|indexfile name|type|hash value\n"
+            "    lists files by name prefix, hex file type or hex content hash\n"
+            "lif dedup report dir [jobs]\n"
+            "    lists files with identical contents and the space they waste\n"
+            "lif dedup store dir storedir [jobs]\n"
+            "    stores each distinct file content once, storedir/manifest rebuilds the images\n"
+            "    with lif build\n"
+            );
+#endif
+        printf(
             "Use -d  after 'lif' keyword to enable LIF filesystem debugging\n"
+            "Use -alloc first|best|append after 'lif' keyword to choose where new files go\n"
             "\n"
             );
     }
@@ -185,6 +267,19 @@ int lif_tests(int argc, char *argv[])
         ptr = argv[ind++];
     }
 
+// Free space placement policy for new files
+    if (MATCHARGS(ptr,"-alloc", (ind + 1) ,argc))
+    {
+        ptr = argv[ind++];
+        if(MATCHI(ptr,"best"))
+            lif_alloc_policy = LIF_ALLOC_BEST;
+        else if(MATCHI(ptr,"append"))
+            lif_alloc_policy = LIF_ALLOC_APPEND;
+        else
+            lif_alloc_policy = LIF_ALLOC_FIRST;
+        ptr = argv[ind++];
+    }
+
     if (MATCHARGS(ptr,"addbin", (ind + 3) ,argc))
     {
         lif_add_lif_file(argv[ind],argv[ind+1],argv[ind+2]);
@@ -204,6 +299,7 @@ int lif_tests(int argc, char *argv[])
         char *name = argv[ind];
         char *label = argv[ind+1];
         char *model = argv[ind+2];
+        int sparse = ( argc > (ind + 3) && MATCHI(argv[ind+3],"sparse") ) ? 1 : 0;
         if( MATCHI_LEN(model,"hp"))
             model +=2;
         if(hpdir_find_drive(model,0, 0))
@@ -211,16 +307,22 @@ int lif_tests(int argc, char *argv[])
             dir = lif_dir_count(hpdir.BLOCKS);
             sectors = hpdir.BLOCKS;
 			// NOTE: we could grab the directory size for non 0 entries in the hpdir.ini file - I use a computed value which is also fine
-            lif_create_image(name, label, dir, sectors);
+            lif_create_image(name, label, dir, sectors, sparse);
             return(1);
         }
         printf("Disk: %s not found in hpdir.ini\n", model);
         return(1);
     }
+    if (MATCHARGS(ptr,"batch", (ind + 2) ,argc))
+    {
+        lif_batch(argv[ind],argv[ind+1]);
+        return(1);
+    }
     if (MATCHARGS(ptr,"create", (ind + 4) ,argc))
     {
 ///@brief format LIF image
-        lif_create_image(argv[ind],argv[ind+1], atol(argv[ind+2]), atol(argv[ind+3]) );
+        int sparse = ( argc > (ind + 4) && MATCHI(argv[ind+4],"sparse") ) ? 1 : 0;
+        lif_create_image(argv[ind],argv[ind+1], atol(argv[ind+2]), atol(argv[ind+3]), sparse );
         return(1);
     }
     if (MATCHARGS(ptr,"del", (ind + 2) ,argc))
@@ -233,6 +335,14 @@ int lif_tests(int argc, char *argv[])
         lif_dir(argv[ind]);
         return(1);
     }
+    if (MATCHARGS(ptr,"free", (ind + 1) ,argc))
+    {
+        long sectors = 0;
+        if(argc > (ind + 1))
+            sectors = atol(argv[ind+1]);
+        lif_freemap_stats(argv[ind], sectors);
+        return(1);
+    }
     if (MATCHARGS(ptr,"extractbin", (ind + 3) ,argc))
     {
 
@@ -245,6 +355,12 @@ int lif_tests(int argc, char *argv[])
         lif_extract_e010_as_ascii(argv[ind],argv[ind+1],argv[ind+2]);
         return(1);
     }
+    if (MATCHARGS(ptr,"pack", (ind + 1) ,argc))
+    {
+        int dryrun = ( argc > (ind + 1) && MATCHI(argv[ind+1],"dryrun") ) ? 1 : 0;
+        lif_pack(argv[ind], dryrun);
+        return(1);
+    }
     if (MATCHARGS(ptr,"rename", (ind + 3) ,argc))
     {
         lif_rename_file(argv[ind],argv[ind+1],argv[ind+2]);
@@ -257,6 +373,135 @@ int lif_tests(int argc, char *argv[])
         return(1);
     }
 
+#ifdef LIF_STAND_ALONE
+    if (MATCHARGS(ptr,"sparseinfo", (ind + 1) ,argc))
+    {
+        sparse_info(argv[ind]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"sparse", (ind + 2) ,argc))
+    {
+        sparse_from_flat(argv[ind],argv[ind+1]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"unsparse", (ind + 2) ,argc))
+    {
+        sparse_to_flat(argv[ind],argv[ind+1]);
+        return(1);
+    }
+#endif
+
+    if (MATCHARGS(ptr,"overlay", (ind + 2) ,argc))
+    {
+        if(sparse_overlay_create(argv[ind],argv[ind+1]))
+            printf("\t%s: overlay of %s\n", argv[ind+1], argv[ind]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"commit", (ind + 1) ,argc))
+    {
+        sparse_overlay_commit(argv[ind]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"discard", (ind + 1) ,argc))
+    {
+        sparse_overlay_discard(argv[ind]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"e010bench", (ind + 1) ,argc))
+    {
+        long loops = 10;
+        if(argc > (ind + 1))
+            loops = atol(argv[ind+1]);
+        lif_e010_bench(argv[ind],loops);
+        return(1);
+    }
+
+#ifdef LIF_STAND_ALONE
+    if (MATCHARGS(ptr,"compress", (ind + 2) ,argc))
+    {
+        zimage_from_flat(argv[ind],argv[ind+1]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"uncompress", (ind + 2) ,argc))
+    {
+        zimage_to_flat(argv[ind],argv[ind+1]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"zinfo", (ind + 1) ,argc))
+    {
+        zimage_info(argv[ind]);
+        return(1);
+    }
+
+    if (MATCHARGS(ptr,"zbench", (ind + 2) ,argc))
+    {
+        long reads = 1000;
+        if(argc > (ind + 2))
+            reads = atol(argv[ind+2]);
+        zimage_bench(argv[ind],argv[ind+1],reads);
+        return(1);
+    }
+#endif
+
+#ifdef LIF_MMAP
+    if (MATCHARGS(ptr,"bench", (ind + 2) ,argc))
+    {
+        lif_bench(argc - (ind + 1), argv + ind + 1, atol(argv[ind]));
+        return(1);
+    }
+#endif
+
+#ifdef LIF_PARALLEL
+    if (MATCHARGS(ptr,"build", (ind + 1) ,argc))
+    {
+        int jobs = ( argc > (ind + 1) ) ? atoi(argv[ind+1]) : 0;
+        lif_build(argv[ind], jobs);
+        return(1);
+    }
+    if (MATCHARGS(ptr,"extractall", (ind + 2) ,argc))
+    {
+        int jobs = ( argc > (ind + 2) ) ? atoi(argv[ind+2]) : 0;
+        lif_extract_tree(argv[ind], argv[ind+1], jobs);
+        return(1);
+    }
+    if (MATCHARGS(ptr,"index", (ind + 2) ,argc))
+    {
+        if(MATCHI(argv[ind],"build"))
+        {
+            int jobs = ( argc > (ind + 2) ) ? atoi(argv[ind+2]) : 0;
+            lif_index_build(argv[ind+1], jobs);
+        }
+        else if(MATCHI(argv[ind],"query") && argc > (ind + 3))
+            lif_index_query(argv[ind+1], argv[ind+2], argv[ind+3]);
+        else
+            printf("lif index build dir [jobs]\nlif index query dir|indexfile name|type|hash value\n");
+        return(1);
+    }
+    if (MATCHARGS(ptr,"dedup", (ind + 2) ,argc))
+    {
+        if(MATCHI(argv[ind],"report"))
+        {
+            int jobs = ( argc > (ind + 2) ) ? atoi(argv[ind+2]) : 0;
+            lif_dedup_report(argv[ind+1], jobs);
+        }
+        else if(MATCHI(argv[ind],"store") && argc > (ind + 2))
+        {
+            int jobs = ( argc > (ind + 3) ) ? atoi(argv[ind+3]) : 0;
+            lif_dedup_store(argv[ind+1], argv[ind+2], jobs);
+        }
+        else
+            printf("lif dedup report dir [jobs]\nlif dedup store dir storedir [jobs]\n");
+        return(1);
+    }
+#endif
+
 	if(MATCHI_LEN(argv[0],"td02lif"))
 	{
 		if(MATCHI(ptr,"help") || MATCHI(ptr,"-help") || MATCHI(ptr,"-?") )
@@ -397,11 +642,35 @@ long lif_read(lif_t *LIF, void *buf, long offset, int bytes)
 {
     long len;
 
-    if(!lif_seek_msg(LIF->fp,offset,LIF->name))
-        return(0);
+// Sparse images map the offset through the allocation bitmap
+    if(LIF->sparse)
+    {
+        len = sparse_read(LIF->fp, LIF->sparse, offset, buf, bytes);
+        if(len < 0)
+            len = 0;
+    }
+#ifdef LIF_MMAP
+// Mapped images are a memory copy, short reads past the end like fread
+    else if(LIF->map)
+    {
+        len = 0;
+        if(offset >= 0 && offset < (long)LIF->mapbytes)
+        {
+            len = LIF->mapbytes - offset;
+            if(len > bytes)
+                len = bytes;
+            memcpy(buf, LIF->map + offset, len);
+        }
+    }
+#endif
+    else
+    {
+        if(!lif_seek_msg(LIF->fp,offset,LIF->name))
+            return(0);
 
 ///@brief Initial file position
-    len = fread(buf, 1, bytes, LIF->fp);
+        len = fread(buf, 1, bytes, LIF->fp);
+    }
     if( len != bytes)
     {
 
@@ -425,12 +694,37 @@ int lif_write(lif_t *LIF, void *buf, long offset, int bytes)
 {
     int len;
 
+#ifdef LIF_MMAP
+// Writes that grow the image, or to a read only mapping, go through stdio
+    if(LIF->map && (!LIF->mapwrite || !lif_map_ptr(LIF, offset, bytes)))
+        lif_unmap(LIF);
+#endif
+
+// Sparse images allocate blocks on first write
+    if(LIF->sparse)
+    {
+        len = sparse_write(LIF->fp, LIF->sparse, offset, buf, bytes);
+        if(len < 0)
+            len = 0;
+    }
+#ifdef LIF_MMAP
+// The mapping is written back by lif_unmap() when the image is closed
+    else if(LIF->map)
+    {
+        memcpy(LIF->map + offset, buf, bytes);
+        LIF->dirty = 1;
+        len = bytes;
+    }
+#endif
+    else
+    {
 // Seek to write position
-    if(!lif_seek_msg(LIF->fp, offset,LIF->name))
-        return(0);
+        if(!lif_seek_msg(LIF->fp, offset,LIF->name))
+            return(0);
 
 ///@brief Initial file position
-    len = fwrite(buf, 1, bytes, LIF->fp);
+        len = fwrite(buf, 1, bytes, LIF->fp);
+    }
     if( len != bytes)
     {
         if(debuglevel & LIF_DEBUG)
@@ -441,6 +735,81 @@ int lif_write(lif_t *LIF, void *buf, long offset, int bytes)
 }
 
 
+#ifdef LIF_MMAP
+/// @brief Pointer into a mapped LIF image
+/// @param[in] *LIF: lif_t structure
+/// @param[in] offset: image offset
+/// @param[in] bytes: number of bytes that must be inside the mapping
+/// @return pointer or NULL if the image is not mapped or out of range
+MEMSPACE
+uint8_t *lif_map_ptr(lif_t *LIF, long offset, long bytes)
+{
+    if(LIF == NULL || LIF->map == NULL)
+        return(NULL);
+    if(offset < 0 || bytes < 0 || offset + bytes > (long)LIF->mapbytes)
+        return(NULL);
+    return(LIF->map + offset);
+}
+
+
+/// @brief Map a flat LIF image into memory
+/// Sparse images and empty files stay on the stdio path
+/// @param[in] *LIF: lif_t structure with open file and imagebytes set
+/// @param[in] *mode: open mode used for LIF->fp - see fopen
+/// @return 1 if mapped, 0 if the stdio path should be used
+MEMSPACE
+int lif_map(lif_t *LIF, char *mode)
+{
+    int prot = PROT_READ;
+    void *p;
+
+    if(!lif_mmap || LIF->sparse || LIF->fp == NULL || LIF->imagebytes == 0)
+        return(0);
+
+    if(strchr(mode,'+') || strchr(mode,'w'))
+        prot |= PROT_WRITE;
+
+    fflush(LIF->fp);
+    p = mmap(NULL, LIF->imagebytes, prot, MAP_SHARED, fileno(LIF->fp), 0);
+    if(p == MAP_FAILED)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("lif_map:[%s] mmap failed, using stdio\n", LIF->name);
+        return(0);
+    }
+    LIF->map = p;
+    LIF->mapbytes = LIF->imagebytes;
+    LIF->mapwrite = (prot & PROT_WRITE) ? 1 : 0;
+    LIF->dirty = 0;
+    return(1);
+}
+
+
+/// @brief Write back and release a mapped LIF image
+/// The file stays open so later access falls back to stdio
+/// @param[in] *LIF: lif_t structure
+/// @return void
+MEMSPACE
+void lif_unmap(lif_t *LIF)
+{
+    if(LIF->map == NULL)
+        return;
+
+    if(LIF->dirty && msync(LIF->map, LIF->mapbytes, MS_SYNC) < 0)
+        printf("lif_unmap:[%s] msync failed\n", LIF->name);
+    munmap(LIF->map, LIF->mapbytes);
+    LIF->map = NULL;
+    LIF->mapbytes = 0;
+    LIF->mapwrite = 0;
+    LIF->dirty = 0;
+
+// Discard any stdio buffer read before the image was mapped
+    if(LIF->fp)
+        fseek(LIF->fp, 0, SEEK_SET);
+}
+#endif
+
+
 /// @brief Check if characters in a LIF volume or LIF file name are valid
 /// @param[in] c: character to test
 /// @param[in] index: index of character in volume or file name
@@ -797,6 +1166,19 @@ char *lif_lifbcd2timestr(uint8_t *bcd)
 }
 
 
+/// @brief Microseconds since start, used by the benchmarks and summaries
+/// @param[in] *start: start time from clock_gettime()
+/// @return elapsed microseconds
+MEMSPACE
+long lif_elapsed_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(0, &now);
+    return( (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L );
+}
+
+
 /// @brief File seek with error message
 
 /// @brief Clear LIF structure
@@ -1057,9 +1439,11 @@ int lif_check_dir(lif_t *LIF)
 /// @param[in] liflabel:   Volume Label
 /// @param[in] dirstart:   Directory start sector
 /// @param[in] dirsectors: Directory sectors
+/// @param[in] filesectors: File area sectors
+/// @param[in] sparse:     1 = create a sparse image, empty sectors are not written
 /// @return pointer to LIF structure
 MEMSPACE
-lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long dirsectors, long filesectors)
+lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long dirsectors, long filesectors, int sparse)
 {
     long size;
     long i;
@@ -1073,8 +1457,9 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
     if(LIF == NULL)
         return(NULL);
 
-    printf("Creating:%s, Label:[%s], Directory Start %ld, Directory Size: %ld, File Sectors:%ld\n",
-        imagename, liflabel, dirstart, dirsectors, filesectors );
+    if(!lif_quiet)
+        printf("Creating:%s, Label:[%s], Directory Start %ld, Directory Size: %ld, File Sectors:%ld\n",
+            imagename, liflabel, dirstart, dirsectors, filesectors );
 
     if(debuglevel & LIF_DEBUG)
         lif_dump_vol(LIF,"lif_create_volume");
@@ -1126,6 +1511,17 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
         return(NULL);
     }
 
+// Sparse images only store sectors that are not 0 so we skip writing empty sectors
+    if(sparse)
+    {
+        LIF->sparse = lif_calloc(sizeof(sparse_t));
+        if(LIF->sparse == NULL || !sparse_init(LIF->fp, LIF->sparse, LIF->sectors, 0))
+        {
+            lif_close_volume(LIF);
+            return(NULL);
+        }
+    }
+
     offset = 0;
     count = 0;
 
@@ -1142,7 +1538,7 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
     memset(buffer,0,LIF_SECTOR_SIZE);
 
 // Space BETWEEN Volume header and Directory area
-    for(i=1;i<dirstart;++i)
+    for(i=1;i<dirstart && !LIF->sparse;++i)
     {
         size = lif_write(LIF, buffer, offset, LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
@@ -1151,9 +1547,12 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
             return(NULL);
         }
         offset += size;
-        printf("\tWrote: %ld\r", count);
+        if(!lif_quiet)
+            printf("\tWrote: %ld\r", count);
         ++count;
     }
+// Sparse images skip the empty sectors but the directory still starts at dirstart
+    offset = dirstart * (long) LIF_SECTOR_SIZE;
 
 // Write Directory sectors
     lif_dir_clear(LIF);
@@ -1171,14 +1570,14 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
             return(NULL);
         }
         offset += size;
-        if((count % 100) == 0)
+        if(!lif_quiet && (count % 100) == 0)
             printf("\tWrote: %ld\r", count);
         ++count;
     }
 
 // File area sectors
     memset(buffer,0,LIF_SECTOR_SIZE);
-    for(i=0;i<filesectors;++i)
+    for(i=0;i<filesectors && !LIF->sparse;++i)
     {
         size = lif_write(LIF, buffer, offset, LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
@@ -1187,11 +1586,12 @@ lif_t *lif_create_volume(char *imagename, char *liflabel, long dirstart, long di
             return(NULL);
         }
         offset += size;
-        if((count % 100) == 0)
+        if(!lif_quiet && (count % 100) == 0)
             printf("\tWrote: %ld\r", count);
         ++count;
     }
-    printf("\tWrote: %ld\n", count);
+    if(!lif_quiet)
+        printf("\tWrote: %ld\n", count);
 
     lif_rewinddir(LIF);
 
@@ -1221,6 +1621,13 @@ void lif_close_volume(lif_t *LIF)
 {
     if(LIF)
     {
+#ifdef LIF_DIRCACHE
+        lif_dircache_flush(LIF);
+        lif_dircache_free(LIF);
+#endif
+#ifdef LIF_MMAP
+        lif_unmap(LIF);
+#endif
         if(LIF->fp)
         {
             fseek(LIF->fp, 0, SEEK_END);
@@ -1232,6 +1639,13 @@ void lif_close_volume(lif_t *LIF)
         if(LIF->name)
             lif_free(LIF->name);
 
+        if(LIF->sparse)
+        {
+            if(LIF->sparse->base)
+                lif_free(LIF->sparse->base);
+            lif_free(LIF->sparse);
+        }
+
         lif_vol_clear(LIF);
 
         lif_free(LIF);
@@ -1304,6 +1718,7 @@ int lif_readdirindex(lif_t *LIF, int index)
     uint32_t offset;
     uint32_t size;
     uint8_t dir[LIF_DIR_SIZE];
+    uint8_t *ptr = NULL;
 
 // Verify that the records is withing directory limits
     if( !lif_checkdirindex(LIF, index) )
@@ -1314,15 +1729,29 @@ int lif_readdirindex(lif_t *LIF, int index)
 // Compute offset
     offset = ((long)index * LIF_DIR_SIZE) + (LIF->VOL.DirStartSector * (long)LIF_SECTOR_SIZE);
 
-// read raw data
-    size = lif_read(LIF, dir, offset, sizeof(dir));
-    if(size  < (long)sizeof(dir) )
+#ifdef LIF_DIRCACHE
+// Decode from the directory cache
+    if(LIF->cache && index < LIF->cache->size)
+        ptr = LIF->cache->records + (long) index * LIF_DIR_SIZE;
+#endif
+#ifdef LIF_MMAP
+// Decode mapped images in place
+    if(ptr == NULL)
+        ptr = lif_map_ptr(LIF, offset, sizeof(dir));
+#endif
+    if(ptr == NULL)
     {
-        return(0);
+// read raw data
+        size = lif_read(LIF, dir, offset, sizeof(dir));
+        if(size  < (long)sizeof(dir) )
+        {
+            return(0);
+        }
+        ptr = dir;
     }
 
 // Convert into directory structure
-    lif_str2dir(dir, LIF);
+    lif_str2dir(ptr, LIF);
 
 // Update EOF index
     if( LIF->DIR.FileType == 0xffffUL )
@@ -1369,6 +1798,19 @@ int lif_writedirindex(lif_t *LIF, int index)
 
     offset = ((long)index * LIF_DIR_SIZE) + (LIF->VOL.DirStartSector * (long)LIF_SECTOR_SIZE);
 
+#ifdef LIF_DIRCACHE
+// Update the cache, the record is written back by lif_dircache_flush()
+    if(LIF->cache && index < LIF->cache->size)
+    {
+        lifdircache_t *C = LIF->cache;
+        lif_dircache_unlink(C, index);
+        lif_dir2str(LIF, C->records + (long) index * LIF_DIR_SIZE);
+        lif_dircache_link(C, index);
+        C->dirty[index>>3] |= (1 << (index & 7));
+        return(1);
+    }
+#endif
+
 // store LIF->DIR settings into dir
     lif_dir2str(LIF, dir);
 
@@ -1394,76 +1836,288 @@ int lif_writedirEOF(lif_t *LIF, int index)
 }
 
 
-/// @brief Read a directory records from LIF image advancind directory index
-/// @see lif_open_volume()
-/// nOte: skip all purged LIF directory records
-/// @param[in] *LIF: to LIF Volume/Diractoy structure
-/// @return directory structure or NULL
+#ifdef LIF_DIRCACHE
+/// @brief Hash a LIF file name, case is ignored
+/// @param[in] *name: file name without space padding
+/// @return hash value
 MEMSPACE
-lifdir_t *lif_readdir(lif_t *LIF)
+uint32_t lif_name_hash(char *name)
 {
-    while(1)
+    uint32_t hash = 2166136261UL;
+    while(*name)
     {
-// Advance index first
-// We start initialized at -1 by lif_open_volume() and lif_rewinddir()
-        LIF->dirindex++;
-
-        if( !lif_readdirindex(LIF, LIF->dirindex) )
-            break;
-
-        if( LIF->DIR.FileType == 0xffffUL )
-            break;
-
-        if(LIF->DIR.FileType)
-            return( (lifdir_t *) &LIF->DIR );
-
-// Skip purged records
+        hash ^= (uint8_t) toupper(*name++);
+        hash *= 16777619UL;
     }
-    return( NULL );
+    return(hash);
 }
 
 
-/// @brief Update free space
-/// @parameter[in] *LIF: LIF structure
-/// @return: LIF or NULL on error
+/// @brief Remove a directory record from its hash bucket
+/// Must be called before the record changes, the bucket comes from the old name
+/// @param[in] *C: directory cache
+/// @param[in] index: directory record number
+/// @return void
 MEMSPACE
-lif_t *lif_updatefree(lif_t *LIF)
+void lif_dircache_unlink(lifdircache_t *C, int index)
 {
-    int index = 0;
-    int purgeindex = -1;
-
-// Start of free space
-    uint32_t start = LIF->filestart;
-// Free sectors
-    LIF->freesectors = LIF->filesectors;
-// Used sectors
-    LIF->usedsectors = 0;
-// Purged files
-    LIF->purged= 0;
-// Files
-    LIF->files = 0;
-// Director pointer
-    LIF->dirindex = 0;
-// Directory EOF record
-    LIF->EOFindex = 0;
+    uint8_t name[10+1];
+    int32_t *p;
 
-/// Update free
-    while(1)
+    lif_B2S(C->records + (long) index * LIF_DIR_SIZE, name, 10);
+    p = &C->head[lif_name_hash((char *) name) & (C->buckets - 1)];
+    for( ; *p != -1; p = &C->next[*p])
     {
-        if( !lif_readdirindex(LIF,index) )
+        if(*p == index)
         {
-            return(NULL);
+            *p = C->next[index];
+            C->next[index] = -1;
+            return;
         }
+    }
+}
 
-        if(LIF->DIR.FileType == 0xffff)
-        {
-            LIF->EOFindex = index;
-            if(purgeindex != -1)
-            {
-                LIF->EOFindex = purgeindex;
 
-// Adjust purged file count
-                LIF->purged -= (index - purgeindex);
+/// @brief Add a directory record to its hash bucket if it is a valid file
+/// Purged and EOF records are not indexed
+/// @param[in] *C: directory cache
+/// @param[in] index: directory record number
+/// @return void
+MEMSPACE
+void lif_dircache_link(lifdircache_t *C, int index)
+{
+    uint8_t *B = C->records + (long) index * LIF_DIR_SIZE;
+    uint16_t type = B2V_MSB(B, 10, 2);
+    uint8_t name[10+1];
+    int bucket;
+
+    if(type == 0 || type == 0xffff)
+        return;
+
+    lif_B2S(B, name, 10);
+    bucket = lif_name_hash((char *) name) & (C->buckets - 1);
+    C->next[index] = C->head[bucket];
+    C->head[bucket] = index;
+}
+
+
+/// @brief Load the LIF directory into memory and index the file names
+/// Called by lif_open_volume(), on failure the directory is read from the image
+/// @param[in] *LIF: LIF structure with a valid volume header
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_dircache_load(lif_t *LIF)
+{
+    lifdircache_t *C;
+    long bytes;
+    int i;
+
+    bytes = LIF->VOL.DirSectors * (long) LIF_SECTOR_SIZE;
+    if(bytes <= 0 || bytes > (long) LIF->imagebytes)
+        return(0);
+
+    C = lif_calloc(sizeof(lifdircache_t));
+    if(C == NULL)
+        return(0);
+
+    C->size = bytes / LIF_DIR_SIZE;
+    C->buckets = 16;
+    while(C->buckets < C->size)
+        C->buckets <<= 1;
+
+    C->records = lif_calloc(bytes);
+    C->dirty = lif_calloc((C->size + 7) / 8);
+    C->head = lif_calloc(C->buckets * (long) sizeof(int32_t));
+    C->next = lif_calloc(C->size * (long) sizeof(int32_t));
+    LIF->cache = C;
+    if(!C->records || !C->dirty || !C->head || !C->next)
+    {
+        lif_dircache_free(LIF);
+        return(0);
+    }
+
+    if(lif_read(LIF, C->records, LIF->VOL.DirStartSector * (long) LIF_SECTOR_SIZE, bytes) < bytes)
+    {
+        lif_dircache_free(LIF);
+        return(0);
+    }
+
+    for(i=0;i<C->buckets;++i)
+        C->head[i] = -1;
+    for(i=0;i<C->size;++i)
+        C->next[i] = -1;
+
+// Index records up to the first EOF record
+    for(i=0;i<C->size;++i)
+    {
+        if(B2V_MSB(C->records + (long) i * LIF_DIR_SIZE, 10, 2) == 0xffff)
+            break;
+        lif_dircache_link(C, i);
+    }
+    return(1);
+}
+
+
+/// @brief Find a file name in the directory cache
+/// @param[in] *LIF: LIF structure
+/// @param[in] *liflabel: file name
+/// @return lowest directory index with this name or -1 if not found
+MEMSPACE
+int lif_dircache_find(lif_t *LIF, char *liflabel)
+{
+    lifdircache_t *C = LIF->cache;
+    uint8_t name[10+1];
+    int32_t i;
+    int index = -1;
+
+    for(i = C->head[lif_name_hash(liflabel) & (C->buckets - 1)]; i != -1; i = C->next[i])
+    {
+        lif_B2S(C->records + (long) i * LIF_DIR_SIZE, name, 10);
+        if(strcasecmp((char *) name, liflabel) == 0 && (index == -1 || i < index))
+            index = i;
+    }
+    return(index);
+}
+
+
+/// @brief Write changed directory records back to the image
+/// Changed records in the same sector are written with one lif_write()
+/// @param[in] *LIF: LIF structure
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_dircache_flush(lif_t *LIF)
+{
+    lifdircache_t *C = LIF->cache;
+    long offset;
+    int first, last, i, sector;
+    int status = 1;
+
+    if(C == NULL)
+        return(1);
+
+    for(sector = 0; sector < C->size; sector += LIF_DIR_RECORDS_PER_SECTOR)
+    {
+        first = -1;
+        last = -1;
+        for(i = sector; i < sector + LIF_DIR_RECORDS_PER_SECTOR && i < C->size; ++i)
+        {
+            if(C->dirty[i>>3] & (1 << (i & 7)))
+            {
+                if(first == -1)
+                    first = i;
+                last = i;
+                C->dirty[i>>3] &= ~(1 << (i & 7));
+            }
+        }
+        if(first == -1)
+            continue;
+
+        offset = (LIF->VOL.DirStartSector * (long) LIF_SECTOR_SIZE) + (long) first * LIF_DIR_SIZE;
+        i = (last - first + 1) * LIF_DIR_SIZE;
+        if(lif_write(LIF, C->records + (long) first * LIF_DIR_SIZE, offset, i) < i)
+        {
+            printf("lif_dircache_flush:[%s] directory write failed at:[%ld]\n", LIF->name, offset);
+            status = 0;
+        }
+    }
+    return(status);
+}
+
+
+/// @brief Release the directory cache without writing it back
+/// @param[in] *LIF: LIF structure
+/// @return void
+MEMSPACE
+void lif_dircache_free(lif_t *LIF)
+{
+    lifdircache_t *C = LIF->cache;
+
+    if(C == NULL)
+        return;
+    if(C->records)
+        lif_free(C->records);
+    if(C->dirty)
+        lif_free(C->dirty);
+    if(C->head)
+        lif_free(C->head);
+    if(C->next)
+        lif_free(C->next);
+    lif_free(C);
+    LIF->cache = NULL;
+}
+#endif
+
+
+/// @brief Read a directory records from LIF image advancind directory index
+/// @see lif_open_volume()
+/// nOte: skip all purged LIF directory records
+/// @param[in] *LIF: to LIF Volume/Diractoy structure
+/// @return directory structure or NULL
+MEMSPACE
+lifdir_t *lif_readdir(lif_t *LIF)
+{
+    while(1)
+    {
+// Advance index first
+// We start initialized at -1 by lif_open_volume() and lif_rewinddir()
+        LIF->dirindex++;
+
+        if( !lif_readdirindex(LIF, LIF->dirindex) )
+            break;
+
+        if( LIF->DIR.FileType == 0xffffUL )
+            break;
+
+        if(LIF->DIR.FileType)
+            return( (lifdir_t *) &LIF->DIR );
+
+// Skip purged records
+    }
+    return( NULL );
+}
+
+
+/// @brief Update free space
+/// @parameter[in] *LIF: LIF structure
+/// @return: LIF or NULL on error
+MEMSPACE
+lif_t *lif_updatefree(lif_t *LIF)
+{
+    int index = 0;
+    int purgeindex = -1;
+
+// Start of free space
+    uint32_t start = LIF->filestart;
+// Free sectors
+    LIF->freesectors = LIF->filesectors;
+// Used sectors
+    LIF->usedsectors = 0;
+// Purged files
+    LIF->purged= 0;
+// Files
+    LIF->files = 0;
+// Director pointer
+    LIF->dirindex = 0;
+// Directory EOF record
+    LIF->EOFindex = 0;
+
+/// Update free
+    while(1)
+    {
+        if( !lif_readdirindex(LIF,index) )
+        {
+            return(NULL);
+        }
+
+        if(LIF->DIR.FileType == 0xffff)
+        {
+            LIF->EOFindex = index;
+            if(purgeindex != -1)
+            {
+                LIF->EOFindex = purgeindex;
+
+// Adjust purged file count
+                LIF->purged -= (index - purgeindex);
 // update EOF
                 if(!lif_writedirEOF(LIF,purgeindex))
                 {
@@ -1499,177 +2153,438 @@ lif_t *lif_updatefree(lif_t *LIF)
 }
 
 
-/// @brief Allocate index of free directory record
-/// @param[in] *LIF: LIF pointer
-/// @param[in] sectors: try to find specified free space
-/// @return index or free record or -1 on error
+/// @brief Order free extents by size then start sector
+/// @param[in] *a: lifextent_t pointer
+/// @param[in] *b: lifextent_t pointer
+/// @return <0, 0, >0 as for qsort()
 MEMSPACE
-int lif_newdir(lif_t *LIF, long sectors)
+int lif_extent_size_cmp(const void *a, const void *b)
 {
-    int index;
-    long start;
+    const lifextent_t *A = (const lifextent_t *) a;
+    const lifextent_t *B = (const lifextent_t *) b;
 
-    int freestate, freeindex;
-    long freestart;
+    if(A->sectors != B->sectors)
+        return( A->sectors < B->sectors ? -1 : 1);
+    if(A->start != B->start)
+        return( A->start < B->start ? -1 : 1);
+    return(0);
+}
 
-// Directory index
-    index = 0;
 
-// Start of free space
-    start = LIF->filestart;
+/// @brief Release a free extent map
+/// @param[in] *F: free extent map
+/// @return void
+MEMSPACE
+void lif_freemap_free(liffree_t *F)
+{
+    if(F->ext)
+        lif_free(F->ext);
+    if(F->bysize)
+        lif_free(F->bysize);
+    memset(F, 0, sizeof(liffree_t));
+    F->tail = -1;
+}
 
-// Update all file information
-    if(lif_updatefree(LIF) == NULL)
-    {
-        printf("lif_newdir: not enough free space:[%ld] for size:[%ld]\n", (long)LIF->freesectors, (long) sectors);
-        return(-1);
-    }
 
-// Not enough room ?
-    if(sectors > (long)LIF->freesectors)
+/// @brief Build the free extent map from the directory
+/// Call lif_updatefree() first so LIF->files and LIF->EOFindex are current
+/// @param[in] *LIF: LIF structure
+/// @param[out] *F: free extent map, release with lif_freemap_free()
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_freemap_build(lif_t *LIF, liffree_t *F)
+{
+    lifextent_t *E;
+    uint32_t start, end;
+    int index, purged, max;
+
+    memset(F, 0, sizeof(liffree_t));
+    F->tail = -1;
+
+// There is at most one extent before each file and one after the last file
+    max = LIF->files + 1;
+    F->ext = lif_calloc(max * (long) sizeof(lifextent_t));
+    F->bysize = lif_calloc(max * (long) sizeof(lifextent_t));
+    if(!F->ext || !F->bysize)
     {
-        printf("lif_newdir: not enough free space:[%ld]\n", (long)LIF->freesectors);
-        return(-1);
+        lif_freemap_free(F);
+        return(0);
     }
 
-// 0 = reading valid records
-// 1 = found purged records
-// 2 = found pured records with enough space to reuse
-    freestate = 0;
-
-// Update free space and EOF pointers
-    while(1)
+    start = LIF->filestart;
+    purged = -1;
+    for(index = 0; ; ++index)
     {
-// Write new EOF after current one
-        if( !lif_readdirindex(LIF,index) )
+        if( !lif_readdirindex(LIF, index) )
         {
-#if 0
-            printf("lif_newdir: index:[%d] failed read at:[%ld] of [%ld] sectors, free:[%ld]\n",
-                (int) index, (long) start, (long)sectors, (long)LIF->freesectors);
-#endif
-            break;
+            lif_freemap_free(F);
+            return(0);
         }
-
-// We hit the EOF record
         if(LIF->DIR.FileType == 0xffff)
-        {
-
-// Was enough free space found in purged area ?
-// Do NOT need to update EOF!
-            if(freestate == 2)
-            {
-// Update free pace for new file
-                lif_dir_clear(LIF);
-                LIF->DIR.FileStartSector = freestart;
-                LIF->DIR.FileSectors = sectors;
-                LIF->usedsectors += sectors;
-                LIF->freesectors -= sectors;
-                LIF->files++;
-                LIF->purged--;
-                LIF->dirindex = freeindex;
-// Write new record (FileType is still EOF until data is updated by user)
-                if( !lif_writedirindex(LIF,freeindex))
-                {
-                    break;
-                }
-                return(freeindex);
-            }
-
-            if(debuglevel & LIF_DEBUG)
-                printf("lif_newdir: index:[%d] adding at:[%ld]to purged space:[%ld] sectors, free:[%ld]\n",
-                    (int) index,(long)start,(long) sectors, (long)LIF->freesectors);
-
-// Write new EOF after current one
-            if( !lif_writedirEOF(LIF,index+1) )
-            {
-                break;
-            }
-
-            lif_dir_clear(LIF);
-            LIF->DIR.FileStartSector = start;
-            LIF->DIR.FileSectors = sectors;
-            LIF->usedsectors += sectors;
-            LIF->freesectors -= sectors;
-            LIF->files++;
-            LIF->dirindex = index;
-// Write new record (FileType is still EOF until data is updated by user )
-            if( !lif_writedirindex(LIF,index))
-            {
-                break;
-            }
-            return(index);
-        }
-
-// PURGED records
+            break;
+// Remember the first purged record of a run
         if(LIF->DIR.FileType == 0)
         {
-            if(freestate == 0)
-            {
-                freeindex = index;
-                freestart = start;
-                freestate = 1;
-            }
-            ++index;
+            if(purged == -1)
+                purged = index;
             continue;
         }
-
-// VALID record
-        if(freestate == 1)
+        if(LIF->DIR.FileStartSector > start && F->count < max)
         {
-            long freesectors;
-// Compute sectors of purged space between valid records
-// Note: LIF specs prohibit using old purged file start and sectors!
-            freesectors = LIF->DIR.FileStartSector - start;
-            if(freesectors >= sectors )
-                freestate = 2;                    // Found free space in purged record
-            else
-                freestate = 0;                    // Try again
+            E = &F->ext[F->count++];
+            E->start = start;
+            E->sectors = LIF->DIR.FileStartSector - start;
+            E->index = purged;
         }
-
-// Computed start of next record
-// Note: MUST be <= actual start of next VALID record or we have overlapping records!
         start = LIF->DIR.FileStartSector + LIF->DIR.FileSectors;
-        ++index;
+        purged = -1;
+    }
+
+// Space after the last file uses the EOF record
+    end = LIF->filestart + LIF->filesectors;
+    if(end > start && F->count < max)
+    {
+        F->tail = F->count;
+        E = &F->ext[F->count++];
+        E->start = start;
+        E->sectors = end - start;
+        E->index = index;
+    }
+
+    for(index = 0; index < F->count; ++index)
+    {
+        E = &F->ext[index];
+        F->freesectors += E->sectors;
+        if(E->index == -1)
+            continue;
+        F->usable += E->sectors;
+        if(E->sectors > F->largest)
+            F->largest = E->sectors;
     }
-// ERROR
-    return(-1);
+
+    memcpy(F->bysize, F->ext, F->count * (long) sizeof(lifextent_t));
+    qsort(F->bysize, F->count, sizeof(lifextent_t), lif_extent_size_cmp);
+    return(1);
 }
 
 
-/// @brief Open LIF directory for reading
-/// @param[in] *name: file name of LIF image
-/// @param[in] *mode: "rb" = read, "rb+" = read/write
-/// @return LIF pointer on sucesses or NULL on error
+/// @brief Find a free extent for a new file
+/// @param[in] *F: free extent map
+/// @param[in] sectors: file size in sectors
+/// @param[in] policy: LIF_ALLOC_FIRST, LIF_ALLOC_BEST or LIF_ALLOC_APPEND
+/// @return extent or NULL if none fits
 MEMSPACE
-lif_t *lif_open_volume(char *name, char *mode)
+lifextent_t *lif_freemap_find(liffree_t *F, long sectors, int policy)
 {
-    lif_t *LIF;
-    stat_t sb, *sp;
-    uint8_t buffer[LIF_SECTOR_SIZE];
+    int lo, hi, mid, i;
 
-    sp = lif_stat(name, (stat_t *)&sb);
-    if(sp == NULL)
-        return(NULL);
-
-// To read LIF volume we must have at minimum two sectors
-// volume header a directory entry
-    if(sp->st_size < (long)LIF_SECTOR_SIZE*2)
+    if(policy == LIF_ALLOC_APPEND)
     {
-        if(debuglevel & LIF_DEBUG)
-            printf("lif_open_volume:[%s] error volume header area too small:[%ld]\n", name, (long)sp->st_size);
+        if(F->tail != -1 && (long) F->ext[F->tail].sectors >= sectors)
+            return(&F->ext[F->tail]);
         return(NULL);
     }
 
-// Allocate LIF structure
-    LIF = lif_calloc(sizeof(lif_t)+4);
-    if(!LIF)
+    if(policy == LIF_ALLOC_BEST)
+    {
+// Binary search for the first extent that is big enough
+        lo = 0;
+        hi = F->count;
+        while(lo < hi)
+        {
+            mid = (lo + hi) / 2;
+            if((long) F->bysize[mid].sectors < sectors)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for(i = lo; i < F->count; ++i)
+        {
+            if(F->bysize[i].index != -1)
+                return(&F->bysize[i]);
+        }
         return(NULL);
+    }
 
-    LIF->name = lif_stralloc(name);
-    if(!LIF->name)
+    for(i = 0; i < F->count; ++i)
     {
-        lif_closedir(LIF);
-        return(NULL);
+        if(F->ext[i].index != -1 && (long) F->ext[i].sectors >= sectors)
+            return(&F->ext[i]);
+    }
+    return(NULL);
+}
+
+
+/// @brief Keep a free extent if it suits the policy better than the one found so far
+/// @param[in] *X: free extent
+/// @param[in] sectors: file size in sectors
+/// @param[in] policy: LIF_ALLOC_FIRST or LIF_ALLOC_BEST
+/// @param[in,out] *E: extent found so far, E->index = -1 if none
+/// @return void
+MEMSPACE
+void lif_freemap_pick(lifextent_t *X, long sectors, int policy, lifextent_t *E)
+{
+    if(X->index == -1 || (long) X->sectors < sectors)
+        return;
+    if(E->index == -1 || (policy == LIF_ALLOC_BEST && X->sectors < E->sectors))
+        *E = *X;
+}
+
+
+/// @brief Find a free extent for a new file without building a free extent map
+/// Same result as lif_freemap_build() and lif_freemap_find() but only one
+/// extent is kept, so memory does not grow with the directory
+/// Call lif_updatefree() first so LIF->filestart and LIF->filesectors are current
+/// @param[in] *LIF: LIF structure
+/// @param[in] sectors: file size in sectors
+/// @param[in] policy: LIF_ALLOC_FIRST, LIF_ALLOC_BEST or LIF_ALLOC_APPEND
+/// @param[out] *E: extent found
+/// @param[out] *largest: largest usable extent, valid when none fits
+/// @return 1 if found, 0 if none fits, -1 on error
+MEMSPACE
+int lif_freemap_scan(lif_t *LIF, long sectors, int policy, lifextent_t *E, uint32_t *largest)
+{
+    lifextent_t X;
+    uint32_t start, end;
+    int index, purged;
+
+    E->index = -1;
+    *largest = 0;
+    start = LIF->filestart;
+    purged = -1;
+    for(index = 0; ; ++index)
+    {
+        if( !lif_readdirindex(LIF, index) )
+            return(-1);
+        if(LIF->DIR.FileType == 0xffff)
+            break;
+        if(LIF->DIR.FileType == 0)
+        {
+            if(purged == -1)
+                purged = index;
+            continue;
+        }
+        if(LIF->DIR.FileStartSector > start && purged != -1)
+        {
+            X.start = start;
+            X.sectors = LIF->DIR.FileStartSector - start;
+            X.index = purged;
+            if(X.sectors > *largest)
+                *largest = X.sectors;
+            if(policy != LIF_ALLOC_APPEND)
+                lif_freemap_pick(&X, sectors, policy, E);
+// The first fit can not be improved on
+            if(policy == LIF_ALLOC_FIRST && E->index != -1)
+                return(1);
+        }
+        start = LIF->DIR.FileStartSector + LIF->DIR.FileSectors;
+        purged = -1;
+    }
+
+// Space after the last file uses the EOF record
+    end = LIF->filestart + LIF->filesectors;
+    if(end > start)
+    {
+        X.start = start;
+        X.sectors = end - start;
+        X.index = index;
+        if(X.sectors > *largest)
+            *largest = X.sectors;
+        lif_freemap_pick(&X, sectors, policy, E);
+    }
+    return(E->index != -1);
+}
+
+
+/// @brief Display free space fragmentation and allocation times
+/// @param[in] lifimagename: LIF disk image name
+/// @param[in] sectors: show where each policy puts a file of this size, 0 = skip
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_freemap_stats(char *lifimagename, long sectors)
+{
+    static char *policies[] = { "first", "best", "append" };
+    struct timespec start;
+    lif_t *LIF;
+    liffree_t F;
+    lifextent_t *E;
+    long us, i, loops = 1000;
+    int p;
+
+    LIF = lif_open_volume(lifimagename,"rb");
+    if(LIF == NULL)
+        return(0);
+
+    clock_gettime(0, &start);
+    if( !lif_freemap_build(LIF, &F) )
+    {
+        lif_closedir(LIF);
+        return(0);
+    }
+    us = lif_elapsed_us(&start);
+
+    if(debuglevel & LIF_DEBUG)
+    {
+        for(i = 0; i < F.count; ++i)
+            printf("  start:%8lu sectors:%8lu index:%5d\n",
+                (unsigned long) F.ext[i].start, (unsigned long) F.ext[i].sectors, F.ext[i].index);
+    }
+
+    printf("%8d Files\n", LIF->files);
+    printf("%8d Free extents\n", F.count);
+    printf("%8lu Free sectors\n", (unsigned long) F.freesectors);
+    printf("%8lu Usable sectors, with a directory record\n", (unsigned long) F.usable);
+    printf("%8lu Largest usable extent\n", (unsigned long) F.largest);
+    printf("%8ld%% Fragmentation\n",
+        F.freesectors ? 100L - (long) ((F.largest * 100ULL) / F.freesectors) : 0L);
+    printf("%8ld us Build time\n", us);
+
+    for(p = LIF_ALLOC_FIRST; sectors > 0 && p <= LIF_ALLOC_APPEND; ++p)
+    {
+        clock_gettime(0, &start);
+        for(i = 0; i < loops; ++i)
+            E = lif_freemap_find(&F, sectors, p);
+        us = lif_elapsed_us(&start);
+        if(E)
+            printf("%-6s %ld sectors at:%lu index:%d, %ld ns/find\n", policies[p],
+                sectors, (unsigned long) E->start, E->index, (us * 1000L) / loops);
+        else
+            printf("%-6s %ld sectors does not fit, %ld ns/find\n", policies[p],
+                sectors, (us * 1000L) / loops);
+    }
+
+    lif_freemap_free(&F);
+    lif_closedir(LIF);
+    return(1);
+}
+
+
+/// @brief Allocate index of free directory record
+/// @param[in] *LIF: LIF pointer
+/// @param[in] sectors: try to find specified free space
+/// @return index or free record or -1 on error
+MEMSPACE
+int lif_newdir(lif_t *LIF, long sectors)
+{
+#ifdef LIF_STAND_ALONE
+    liffree_t F;
+    lifextent_t *E;
+#else
+    lifextent_t E;
+    uint32_t largest;
+    int ret;
+#endif
+    uint32_t start;
+    int index;
+
+// Update all file information
+    if(lif_updatefree(LIF) == NULL)
+    {
+        printf("lif_newdir: not enough free space:[%ld] for size:[%ld]\n", (long)LIF->freesectors, (long) sectors);
+        return(-1);
+    }
+
+// Not enough room ?
+    if(sectors > (long)LIF->freesectors)
+    {
+        printf("lif_newdir: not enough free space:[%ld]\n", (long)LIF->freesectors);
+        return(-1);
+    }
+
+#ifdef LIF_STAND_ALONE
+    if( !lif_freemap_build(LIF, &F) )
+        return(-1);
+
+    E = lif_freemap_find(&F, sectors, lif_alloc_policy);
+    if(E == NULL)
+    {
+        printf("lif_newdir: no free extent for:[%ld] sectors, largest:[%ld], free:[%ld]\n",
+            (long) sectors, (long) F.largest, (long)LIF->freesectors);
+        lif_freemap_free(&F);
+        return(-1);
+    }
+    start = E->start;
+    index = E->index;
+    lif_freemap_free(&F);
+#else
+// The firmware has no room for a map of a large directory
+    ret = lif_freemap_scan(LIF, sectors, lif_alloc_policy, &E, &largest);
+    if(ret < 0)
+        return(-1);
+    if(ret == 0)
+    {
+        printf("lif_newdir: no free extent for:[%ld] sectors, largest:[%ld], free:[%ld]\n",
+            (long) sectors, (long) largest, (long)LIF->freesectors);
+        return(-1);
+    }
+    start = E.start;
+    index = E.index;
+#endif
+
+    if(index == LIF->EOFindex)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("lif_newdir: index:[%d] adding at:[%ld] sectors:[%ld], free:[%ld]\n",
+                (int) index,(long)start,(long) sectors, (long)LIF->freesectors);
+
+// Write new EOF after current one
+        if( !lif_writedirEOF(LIF,index+1) )
+            return(-1);
+    }
+    else
+    {
+// Reuse a purged record, the EOF does not move
+        LIF->purged--;
+    }
+
+    lif_dir_clear(LIF);
+    LIF->DIR.FileStartSector = start;
+    LIF->DIR.FileSectors = sectors;
+    LIF->usedsectors += sectors;
+    LIF->freesectors -= sectors;
+    LIF->files++;
+    LIF->dirindex = index;
+// Write new record (FileType is still EOF until data is updated by user)
+    if( !lif_writedirindex(LIF,index))
+        return(-1);
+    return(index);
+}
+
+
+/// @brief Open LIF directory for reading
+/// @param[in] *name: file name of LIF image
+/// @param[in] *mode: "rb" = read, "rb+" = read/write
+/// @return LIF pointer on sucesses or NULL on error
+MEMSPACE
+lif_t *lif_open_volume(char *name, char *mode)
+{
+    lif_t *LIF;
+    stat_t sb, *sp;
+    uint8_t buffer[LIF_SECTOR_SIZE];
+
+    sp = lif_stat(name, (stat_t *)&sb);
+    if(sp == NULL)
+        return(NULL);
+
+// To read LIF volume we must have at minimum two sectors
+// volume header a directory entry
+    if(sp->st_size < (long)LIF_SECTOR_SIZE*2)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("lif_open_volume:[%s] error volume header area too small:[%ld]\n", name, (long)sp->st_size);
+        return(NULL);
+    }
+
+// Allocate LIF structure
+    LIF = lif_calloc(sizeof(lif_t)+4);
+    if(!LIF)
+        return(NULL);
+
+    LIF->name = lif_stralloc(name);
+    if(!LIF->name)
+    {
+        lif_closedir(LIF);
+        return(NULL);
     }
 
     LIF->imagebytes = sp->st_size;
@@ -1682,6 +2597,51 @@ lif_t *lif_open_volume(char *name, char *mode)
         return(NULL);
     }
 
+#ifdef LIF_MMAP
+// Map the image, everything below then works on the mapping
+// A sparse image is unmapped again once its header has been read
+    lif_map(LIF, mode);
+#endif
+
+// Sparse image size comes from the sparse header
+    {
+        sparse_t S;
+        int sparse = 1;
+#ifdef LIF_MMAP
+// Mapped images only read the header when the magic matches
+        if(LIF->map && memcmp(LIF->map, SPARSE_MAGIC, SPARSE_MAGIC_SIZE) != 0)
+            sparse = 0;
+#endif
+        if(sparse && sparse_read_header(LIF->fp, &S))
+        {
+#ifdef LIF_MMAP
+            lif_unmap(LIF);
+#endif
+            LIF->sparse = lif_calloc(sizeof(sparse_t));
+            if(!LIF->sparse)
+            {
+                lif_closedir(LIF);
+                return(NULL);
+            }
+            *LIF->sparse = S;
+// Overlays read unwritten sectors from their base image
+            if(S.flags & SPARSE_OVERLAY)
+            {
+                char *base = lif_calloc(SPARSE_BASE_SIZE);
+                if(!base || !sparse_read_base_name(LIF->fp, LIF->sparse, base, SPARSE_BASE_SIZE))
+                {
+                    if(base)
+                        lif_free(base);
+                    printf("lif_open_volume:[%s] overlay base name missing\n", name);
+                    lif_closedir(LIF);
+                    return(NULL);
+                }
+            }
+            LIF->imagebytes = S.blocks * (long) S.blocksize;
+            LIF->sectors = lif_bytes2sectors(LIF->imagebytes);
+        }
+    }
+
 // Volume header must be it least one sector
     if( lif_read(LIF, buffer, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
     {
@@ -1713,6 +2673,11 @@ lif_t *lif_open_volume(char *name, char *mode)
     LIF->dirindex = 0;
     LIF->EOFindex = 0;
 
+#ifdef LIF_DIRCACHE
+// Read the directory once, lookups and updates then stay in memory
+    lif_dircache_load(LIF);
+#endif
+
     if( lif_updatefree(LIF) == NULL)
     {
         if(debuglevel & LIF_DEBUG)
@@ -1832,6 +2797,17 @@ int lif_find_file(lif_t *LIF, char *liflabel)
     if(LIF == NULL)
         return(-1);
 
+#ifdef LIF_DIRCACHE
+// Hash lookup, the record is then read like the linear search does
+    if(LIF->cache)
+    {
+        index = lif_dircache_find(LIF, liflabel);
+        if(index == -1 || !lif_readdirindex(LIF,index))
+            return(-1);
+        return(index);
+    }
+#endif
+
     index = 0;
     while(1)
     {
@@ -1907,21 +2883,19 @@ int lif_e010_pad_sector(long offset, uint8_t *wbuf)
 }
 
 
-///@brief Convert an ASCII string into HP85 E010 format
-/// @param[in] str: ASCII string to write
+///@brief Convert a string into HP85 E010 format
+/// @param[in] str: string to write, need not be 0 terminated
+/// @param[in] len: string size
 /// @param[in] offset: E010 data sector offset, only used in formatting wbuf with headers
 /// @param[in] wbuf: E010 data result
 /// @return size of E010 data
 /// FIXME assumes 256 byte secors
 MEMSPACE
-int lif_ascii_string_to_e010(char *str, long offset, uint8_t *wbuf)
+int lif_e010_encode(uint8_t *str, int len, long offset, uint8_t *wbuf)
 {
     int ind;
-    int len;
     int pos,rem;
-
-// String size
-    len = strlen(str);
+    int part;
 
 // Output buffer index
     ind = 0;
@@ -1959,8 +2933,8 @@ int lif_ascii_string_to_e010(char *str, long offset, uint8_t *wbuf)
         wbuf[ind++] = len & 0xff;
         wbuf[ind++] = (len >> 8) & 0xff;
 // Write string
-        while(*str)
-            wbuf[ind++] = *str++;
+        memcpy(wbuf + ind, str, len);
+        ind += len;
     }
     else                                          /* No enough room split string */
     {
@@ -1975,8 +2949,11 @@ int lif_ascii_string_to_e010(char *str, long offset, uint8_t *wbuf)
         wbuf[ind++] = len & 0xff;
         wbuf[ind++] = (len >>8) & 0xff;
 // Write as much of the string as we can in this sector
-        while(*str && ind<rem)
-            wbuf[ind++] = *str++;
+        part = rem - ind;
+        memcpy(wbuf + ind, str, part);
+        ind += part;
+        str += part;
+        len -= part;
 
 // NEW SECTOR
 // Debugging make sure we are at sector boundry
@@ -1987,23 +2964,63 @@ int lif_ascii_string_to_e010(char *str, long offset, uint8_t *wbuf)
             return(-1);
         }
 
-// Update remining string length
-        len = strlen(str);
 // 2nd Split string header
         wbuf[ind++] = 0x6F;
         wbuf[ind++] = (len & 0xff);
         wbuf[ind++] = (len>>8) & 0xff;
 // Write string
-        while(*str)
-            wbuf[ind++] = *str++;
+        memcpy(wbuf + ind, str, len);
+        ind += len;
     }
 
     return(ind);
 }
 
 
+///@brief Convert an ASCII string into HP85 E010 format
+/// @param[in] str: ASCII string to write
+/// @param[in] offset: E010 data sector offset, only used in formatting wbuf with headers
+/// @param[in] wbuf: E010 data result
+/// @return size of E010 data
+MEMSPACE
+int lif_ascii_string_to_e010(char *str, long offset, uint8_t *wbuf)
+{
+    return( lif_e010_encode((uint8_t *) str, strlen(str), offset, wbuf) );
+}
+
+
+/// @brief Write the whole sectors of an E010 output buffer
+/// @param[in] *LIF: Where to write, NULL only counts
+/// @param[in] *obuf: E010 data, obuf[0] is at a sector boundry
+/// @param[in,out] *offset: image offset of obuf[0]
+/// @param[in,out] *used: bytes in obuf, the partial sector is moved to the start
+/// @return 1 on success, 0 on write error
+MEMSPACE
+int lif_e010_flush(lif_t *LIF, uint8_t *obuf, long *offset, int *used)
+{
+    int size;
+
+    size = *used - (*used % LIF_SECTOR_SIZE);
+    if(!size)
+        return(1);
+    if(LIF)
+    {
+        if(lif_write(LIF, obuf, *offset, size) < size)
+            return(0);
+    }
+    *used -= size;
+    memmove(obuf, obuf + size, *used);
+    *offset += size;
+    return(1);
+}
+
+
 /// @brief Add ASCII file as E010 data to LIF image - or compute converted data size
 /// To find size of formatted result only, without writting, set LIF to NULL
+/// The user file is read in large blocks and the records are built in a
+/// multi sector buffer that is written in whole sectors, one write per buffer.
+/// Lines are split and trimmed exactly as fgets() with a 253 byte buffer
+/// followed by trim_tail() would, lines end with "\r" on the HP85.
 /// @param[in] userfile: User ASCII file source
 /// @param[in] *LIF: Where to write file if set (not NULL)
 /// @return size of formatted result
@@ -2012,84 +3029,102 @@ MEMSPACE
 long lif_add_ascii_file_as_e010_wrapper(lif_t *LIF, uint32_t offset, char *username)
 {
     long bytes;
-    int count;
-    int size;
-    int len;
+    long base;
+    int used;
+    int have, pos;
+    int eof;
+    int n, len, size;
+    uint8_t *ptr, *end;
+    uint8_t save;
     FILE *fi;
 
-// strings are limited to less then this
-    char str[LIF_SECTOR_SIZE+1];
-// output buffer must be larger then a single sectors because of either headers or padding
-    uint8_t obuf[LIF_SECTOR_SIZE*2];
+// Input blocks, one spare byte for the "\r" added to the last line
+    uint8_t ibuf[LIF_E010_SECTORS * LIF_SECTOR_SIZE + 1];
+// Output sectors plus room for one more record
+    uint8_t obuf[LIF_E010_SECTORS * LIF_SECTOR_SIZE + LIF_E010_RECORD];
 
     fi = lif_open(username, "rb");
     if(fi == NULL)
         return(-1);
 
-    bytes = 0;
-    count = 0;
+    base = offset;
+    used = 0;
+    have = 0;
+    pos = 0;
+    eof = 0;
 
-// Read user file and write LIF records
-// reserve 3 + LIF header bytes + 1 (EOS)
-    while( fgets((char *)str,(int)sizeof(str) - 4, fi) != NULL )
+    while(1)
     {
-        trim_tail((char *)str);
-
-        strcat((char *)str,"\r");                 // HP85 lines end with "\r"
-
-        size = lif_ascii_string_to_e010(str, offset, obuf);
-// Write string
-// Now Write string
-        if(LIF)
+// Keep at least one full line in the input buffer
+        if(!eof && have - pos < LIF_E010_LINE)
         {
-            len = lif_write(LIF, obuf, offset, size);
-            if(len < size)
+            have -= pos;
+            memmove(ibuf, ibuf + pos, have);
+            pos = 0;
+            while(!eof && have < (int) sizeof(ibuf) - 1)
             {
-                fclose(fi);
-                return(-1);
+                n = fread(ibuf + have, 1, sizeof(ibuf) - 1 - have, fi);
+                if(n <= 0)
+                    eof = 1;
+                else
+                    have += n;
             }
         }
+        if(pos >= have)
+            break;
 
-        offset += size;
-        bytes += size;
-        count += size;
+// Same line as fgets() - up to and including '\n', at most LIF_E010_LINE bytes
+        ptr = ibuf + pos;
+        n = have - pos;
+        if(n > LIF_E010_LINE)
+            n = LIF_E010_LINE;
+        end = memchr(ptr, '\n', n);
+        if(end)
+            n = end - ptr + 1;
+        pos += n;
+
+// Same length as strlen() and trim_tail()
+        end = memchr(ptr, 0, n);
+        len = end ? end - ptr : n;
+        while(len && (char) ptr[len-1] <= ' ')
+            --len;
+
+// HP85 lines end with "\r", the byte after the line is restored after encoding
+        save = ptr[len];
+        ptr[len] = '\r';
+        size = lif_e010_encode(ptr, len + 1, base + used, obuf + used);
+        ptr[len] = save;
+        if(size < 0)
+        {
+            fclose(fi);
+            return(-1);
+        }
+        used += size;
 
-        if(count > 256)
+        if(used >= LIF_E010_SECTORS * LIF_SECTOR_SIZE)
         {
-            count = 0;
+            if(!lif_e010_flush(LIF, obuf, &base, &used))
+            {
+                fclose(fi);
+                return(-1);
+            }
             if(LIF)
-                printf("\tWrote: %8ld\r", (long)bytes);
+                printf("\tWrote: %8ld\r", (long)(base + used - offset));
         }
     }
 
     fclose(fi);
 
-// Write EOF
-    str[0] = 0;
-// We only want to return the count of bytes in the file NOT the padding at the end
 // Write EOF string with padding
-    size = lif_ascii_string_to_e010(str, offset,obuf);
-
-    if(LIF)
-    {
-        printf("\tWrote: %8ld\r", (long)bytes);
-        len = lif_write(LIF, obuf, offset, size);
-        if(len < size)
-            return(-1);
-
-    }
+    used += lif_e010_encode(ibuf, 0, base + used, obuf + used);
 
-    offset += size;
-    bytes += size;
+// We only want to return the count of bytes in the file NOT the padding at the end
+    bytes = base + used - offset;
 
 // PAD
-    size = lif_e010_pad_sector(offset, obuf);
-    if(LIF)
-    {
-        len = lif_write(LIF, obuf, offset, size);
-        if(len < size)
-            return(-1);
-    }
+    used += lif_e010_pad_sector(base + used, obuf + used);
+    if(!lif_e010_flush(LIF, obuf, &base, &used))
+        return(-1);
 
     if(LIF)
         printf("\tWrote: %8ld\r",(long)bytes);
@@ -2098,66 +3133,43 @@ long lif_add_ascii_file_as_e010_wrapper(lif_t *LIF, uint32_t offset, char *usern
 }
 
 
-/// @brief Convert and add ASCII file to the LIF image as type E010 format
-/// The basename of the lifname, without extensions, is used as the LIF file name
-/// @param[in] lifimagename: LIF image name
+/// @brief Convert and add ASCII file to an open LIF image as type E010 format
+/// @param[in] *LIF: LIF image opened for writing
 /// @param[in] lifname: LIF file name
 /// @param[in] userfile: userfile name
 /// @return size of data written into to LIF image, or -1 on error
 /// FIXME assumes 256 byte secors
 MEMSPACE
-long lif_add_ascii_file_as_e010(char *lifimagename, char *lifname, char *userfile)
+long lif_add_e010(lif_t *LIF, char *lifname, char *userfile)
 {
     long bytes;
     long sectors;
     long offset;
     int index;
-    lif_t *LIF;
     stat_t st, *sp;
 
-    if(!*lifimagename)
+//Get size and date info
+    sp = lif_stat(userfile, (stat_t *)&st);
+    if(!sp)
     {
-        printf("lif_add_ascii_file_as_e010: lifimagename is empty\n");
-        return(-1);
-    }
-    if(!*lifname)
-    {
-        printf("lif_add_ascii_file_as_e010: lifname is empty\n");
-        return(-1);
-    }
-    if(!*userfile)
-    {
-        printf("lif_add_ascii_file_as_e010: userfile is empty\n");
-        return(-1);
-    }
-
-//Get size and date info
-    sp = lif_stat(userfile, (stat_t *)&st);
-    if(!sp)
-    {
-        printf("lif_add_ascii_file_as_e010: userfile not found\n");
+        printf("lif_add_ascii_file_as_e010: userfile not found\n");
         return(-1);
     }
 
     if(debuglevel & LIF_DEBUG)
         printf("LIF image:[%s], LIF name:[%s], user file:[%s]\n",
-            lifimagename, lifname, userfile);
+            LIF->name, lifname, userfile);
 
 // Find out how big converted file will be
     bytes = lif_add_ascii_file_as_e010_wrapper(NULL,0,userfile);
     sectors = lif_bytes2sectors(bytes);
 
-    LIF = lif_open_volume(lifimagename,"r+");
-    if(LIF == NULL)
-        return(-1);
-
 // Now find free record
     index = lif_newdir(LIF, sectors);
     if(index == -1)
     {
         printf("LIF image:[%s], not enough free space for:[%s]\n",
-            lifimagename, userfile);
-        lif_closedir(LIF);
+            LIF->name, userfile);
         return(-1);
     }
 
@@ -2189,149 +3201,181 @@ long lif_add_ascii_file_as_e010(char *lifimagename, char *lifname, char *userfil
 // Write directory record
 // Note: lif_newdir alrwady did the new EOF
     if( !lif_writedirindex(LIF,index))
+        return(-1);
+
+    printf("\tWrote: %8ld\n", bytes);
+
+// Return file size
+    return(bytes);
+}
+
+
+/// @brief Convert and add ASCII file to the LIF image as type E010 format
+/// The basename of the lifname, without extensions, is used as the LIF file name
+/// @param[in] lifimagename: LIF image name
+/// @param[in] lifname: LIF file name
+/// @param[in] userfile: userfile name
+/// @return size of data written into to LIF image, or -1 on error
+MEMSPACE
+long lif_add_ascii_file_as_e010(char *lifimagename, char *lifname, char *userfile)
+{
+    long bytes;
+    lif_t *LIF;
+
+    if(!*lifimagename)
     {
-        lif_closedir(LIF);
+        printf("lif_add_ascii_file_as_e010: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!*lifname)
+    {
+        printf("lif_add_ascii_file_as_e010: lifname is empty\n");
+        return(-1);
+    }
+    if(!*userfile)
+    {
+        printf("lif_add_ascii_file_as_e010: userfile is empty\n");
         return(-1);
     }
 
-    lif_closedir(LIF);
+    LIF = lif_open_volume(lifimagename,"r+");
+    if(LIF == NULL)
+        return(-1);
 
-    printf("\tWrote: %8ld\n", bytes);
+    bytes = lif_add_e010(LIF, lifname, userfile);
 
-// Return file size
+    lif_closedir(LIF);
     return(bytes);
 }
 
 
-/// @brief Extract E010 type file from LIF image and save as user ASCII file
-/// @param[in] lifimagename: LIF disk image name
+/// @brief Extract E010 type file from an open LIF image and save as user ASCII file
+/// The file is read in runs of LIF_E010_SECTORS sectors, or used in place
+/// when the image is mapped, and decoded one sector at a time
+/// @param[in] *LIF: LIF image
 /// @param[in] lifname:  name of file in LIF image
 /// @param[in] username: name to call the extracted image
 /// @return 1 on sucess or 0 on error
 /// FIXME assumes 256 byte secors
 MEMSPACE
-int lif_extract_e010_as_ascii(char *lifimagename, char *lifname, char *username)
+int lif_extract_e010(lif_t *LIF, char *lifname, char *username)
 {
-    lif_t *LIF;
-    uint32_t start, end;                          // sectors
+    uint32_t sector, end;                         // sectors
     long offset, bytes;                           // bytes
     int index;
-    int i, len,size;
+    int run, s;
+    int len, n, size;
     int status = 1;
     int done = 0;
 
     time_t t;
 
     int ind,wind;
+    uint8_t *buf, *sbuf;
     FILE *fo;
 
-// read buffer
-    uint8_t buf[LIF_SECTOR_SIZE+4];
+// read buffer, 4 spare bytes for a header at the end of a sector
+    uint8_t rbuf[LIF_E010_SECTORS * LIF_SECTOR_SIZE + 4];
 // Write buffer, FYI: will ALWAYS be smaller then the read data buffer
-    uint8_t wbuf[LIF_SECTOR_SIZE+4];
-
-    LIF = lif_open_volume(lifimagename,"r");
-    if(LIF == NULL)
-    {
-        printf("LIF image not found:%s\n", lifimagename);
-        return(0);
-    }
+    uint8_t wbuf[LIF_E010_SECTORS * LIF_SECTOR_SIZE];
 
     index = lif_find_file(LIF, lifname);
     if(index == -1)
     {
         printf("LIF File not found:%s\n", lifname);
-        lif_closedir(LIF);
         return(0);
     }
 
     if((LIF->DIR.FileType & 0xFFFC) != 0xE010)
     {
         printf("File %s has wrong type:[%04XH] expected 0xE010..0xE013\n", username, (int) LIF->DIR.FileType);
-        lif_closedir(LIF);
         return(0);
     }
 
-    start = LIF->DIR.FileStartSector;
-    end = start + LIF->DIR.FileSectors;
+    sector = LIF->DIR.FileStartSector;
+    end = sector + LIF->DIR.FileSectors;
 
     t = lif_lifbcd2time(LIF->DIR.date);
 
-    offset = start * (long) LIF_SECTOR_SIZE;
-
     fo = lif_open(username,"wb");
     if(fo == NULL)
-    {
-        lif_closedir(LIF);
         return(0);
-    }
 
     printf("Extracting: %s\n", username);
 
     bytes = 0;
     wind = 0;
-    ind = 0;
+    memset(rbuf + sizeof(rbuf) - 4, 0, 4);
 
-    while(lif_bytes2sectors(offset) <= end)
+    while(sector < end && !done)
     {
+        run = end - sector;
+        if(run > LIF_E010_SECTORS)
+            run = LIF_E010_SECTORS;
+        offset = sector * (long) LIF_SECTOR_SIZE;
+
 // LIF images are always multiples of LIF_SECTOR_SIZE
-        size = lif_read(LIF, buf, offset, LIF_SECTOR_SIZE);
-        if(size < LIF_SECTOR_SIZE)
+        buf = NULL;
+#ifdef LIF_MMAP
+        buf = lif_map_ptr(LIF, offset, (long) run * LIF_SECTOR_SIZE + 4);
+#endif
+        if(buf == NULL)
         {
-            status = 0;
-            break;
+            size = lif_read(LIF, rbuf, offset, run * LIF_SECTOR_SIZE);
+            if(size < run * LIF_SECTOR_SIZE)
+            {
+                status = 0;
+                break;
+            }
+            buf = rbuf;
         }
+        sector += run;
 
-        ind = 0;
-        while(ind < LIF_SECTOR_SIZE && !done)
+// Records never cross a sector, a split record continues with a 6f record
+        for(s = 0; s < run && !done; ++s)
         {
-            if(buf[ind] == 0xDF || buf[ind] == 0xCF || buf[ind] == 0x6F)
+            sbuf = buf + s * LIF_SECTOR_SIZE;
+            ind = 0;
+            while(ind < LIF_SECTOR_SIZE && !done)
             {
-                ++ind;
-                len = buf[ind++] & 0xff;
-                len |= ((buf[ind++] & 0xff) <<8);
-// EOF ?
-                if(len == 0)
+                if(sbuf[ind] == 0xDF || sbuf[ind] == 0xCF || sbuf[ind] == 0x6F)
                 {
-                    done = 1;
-                    break;
+                    ++ind;
+                    len = sbuf[ind++] & 0xff;
+                    len |= ((sbuf[ind++] & 0xff) <<8);
+// EOF ?
+                    if(len == 0)
+                    {
+                        done = 1;
+                        break;
+                    }
+                    if(len >= LIF_SECTOR_SIZE)
+                    {
+                        printf("lif_extract_e010_as_ascii: string too big size = %d\n", (int)len);
+                        status = 0;
+                        done = 1;
+                        break;
+                    }
                 }
-                if(len >= LIF_SECTOR_SIZE)
+                else if(sbuf[ind] == 0xEF)
                 {
-                    printf("lif_extract_e010_as_ascii: string too big size = %d\n", (int)len);
-                    status = 0;
-                    done = 1;
-                    break;
-                }
-            }
-            else if(buf[ind] == 0xEF)
-            {
 // skip remaining bytes in sector
-                ind = 0;
-                break;
-            }
-            else
-            {
-                printf("lif_extract_e010_as_ascii: unexpected control byte:[%02XH] @ offset: %8lx, ind:%02XH\n", (int)buf[ind], offset, (int)ind);
-                status = 0;
-                done = 1;
-                break;
-            }
-// write string
-            for(i=0;i <len && ind < LIF_SECTOR_SIZE;++i)
-            {
-                if(buf[ind] == '\r' && i == len-1)
-                {
-                    wbuf[wind++] = '\n';
-                    ++ind;
                     break;
                 }
                 else
                 {
-                    wbuf[wind++] = buf[ind++];
+                    printf("lif_extract_e010_as_ascii: unexpected control byte:[%02XH] @ offset: %8lx, ind:%02XH\n",
+                        (int)sbuf[ind], offset + s * (long) LIF_SECTOR_SIZE, (int)ind);
+                    status = 0;
+                    done = 1;
+                    break;
                 }
 
-                if(wind >= LIF_SECTOR_SIZE)
+// write string, the part of a split record in this sector
+                n = len;
+                if(n > LIF_SECTOR_SIZE - ind)
+                    n = LIF_SECTOR_SIZE - ind;
+                if(wind + n > (int) sizeof(wbuf))
                 {
                     size = fwrite(wbuf,1,wind,fo);
                     if(size < wind)
@@ -2345,16 +3389,16 @@ int lif_extract_e010_as_ascii(char *lifimagename, char *lifname, char *username)
                     printf("\tWrote: %8ld\r", bytes);
                     wind = 0;
                 }
+                memcpy(wbuf + wind, sbuf + ind, n);
+                wind += n;
+                ind += n;
+// HP85 lines end with "\r"
+                if(n == len && wbuf[wind-1] == '\r')
+                    wbuf[wind-1] = '\n';
+            }                                     // while(ind < LIF_SECTOR_SIZE && !done)
+        }                                         // for(s = 0; s < run && !done; ++s)
+    }                                             // while(sector < end && !done)
 
-            }                                     // for(i=0;i <len && ind < LIF_SECTOR_SIZE;++i)
-
-        }                                         // while(ind < LIF_SECTOR_SIZE && status)
-
-        offset += (long) LIF_SECTOR_SIZE;
-
-    }                                             // while(offset <= end)
-
-    lif_closedir(LIF);
 // Flush any remaining bytes
     if(wind)
     {
@@ -2380,17 +3424,194 @@ int lif_extract_e010_as_ascii(char *lifimagename, char *lifname, char *username)
 }
 
 
-/// @brief Extract a file from LIF image entry as standalone LIF image
-/// @param[in] lifimagename: LIF disk image name to extract file from
+/// @brief Extract E010 type file from LIF image and save as user ASCII file
+/// @param[in] lifimagename: LIF disk image name
+/// @param[in] lifname:  name of file in LIF image
+/// @param[in] username: name to call the extracted image
+/// @return 1 on sucess or 0 on error
+MEMSPACE
+int lif_extract_e010_as_ascii(char *lifimagename, char *lifname, char *username)
+{
+    lif_t *LIF;
+    int status;
+
+    LIF = lif_open_volume(lifimagename,"r");
+    if(LIF == NULL)
+    {
+        printf("LIF image not found:%s\n", lifimagename);
+        return(0);
+    }
+
+    status = lif_extract_e010(LIF, lifname, username);
+
+    lif_closedir(LIF);
+    return(status);
+}
+
+
+/// @brief Line at a time ASCII to E010 conversion, for lif_e010_bench()
+/// One fgets(), one record and one write per line - how E010 files used to be added
+/// @param[in] *LIF: Where to write file if set (not NULL)
+/// @param[in] offset: image offset to write at
+/// @param[in] username: User ASCII file source
+/// @return size of formatted result, -1 on error
+MEMSPACE
+long lif_e010_bench_line(lif_t *LIF, long offset, char *username)
+{
+    long bytes = 0;
+    int size;
+    FILE *fi;
+    char str[LIF_SECTOR_SIZE+1];
+    uint8_t obuf[LIF_SECTOR_SIZE*2];
+
+    fi = lif_open(username, "rb");
+    if(fi == NULL)
+        return(-1);
+
+    while( fgets((char *)str,(int)sizeof(str) - 4, fi) != NULL )
+    {
+        trim_tail((char *)str);
+        strcat((char *)str,"\r");
+        size = lif_ascii_string_to_e010(str, offset, obuf);
+        if(LIF && lif_write(LIF, obuf, offset, size) < size)
+        {
+            fclose(fi);
+            return(-1);
+        }
+        offset += size;
+        bytes += size;
+    }
+    fclose(fi);
+
+    size = lif_ascii_string_to_e010("", offset, obuf);
+    bytes += size;
+    size += lif_e010_pad_sector(offset + size, obuf + size);
+    if(LIF && lif_write(LIF, obuf, offset, size) < size)
+        return(-1);
+    return(bytes);
+}
+
+
+/// @brief Checksum of E010 data in a LIF image, for lif_e010_bench()
+/// @param[in] *LIF: LIF image
+/// @param[in] offset: image offset
+/// @param[in] sectors: number of sectors
+/// @return checksum
+MEMSPACE
+uint32_t lif_e010_bench_sum(lif_t *LIF, long offset, long sectors)
+{
+    uint8_t buf[LIF_SECTOR_SIZE];
+    uint32_t sum = 0;
+    long s;
+    int i;
+
+    for(s = 0; s < sectors; ++s)
+    {
+        if(lif_read(LIF, buf, offset + s * LIF_SECTOR_SIZE, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+            break;
+        for(i = 0; i < LIF_SECTOR_SIZE; ++i)
+            sum = (sum << 1 | sum >> 31) + buf[i];
+    }
+    return(sum);
+}
+
+
+/// @brief Compare line at a time and streaming E010 conversion of a text file
+/// Both converters must produce the same E010 data, the timed add includes
+/// the size pass lif_add_e010() does before it writes
+/// Uses the scratch files e010bench.lif and e010bench.txt
+/// @param[in] *textfile: ASCII text file
+/// @param[in] loops: number of times to convert
+/// @return 1 on success, 0 on error or data mismatch
+MEMSPACE
+int lif_e010_bench(char *textfile, long loops)
+{
+    lif_t *LIF;
+    struct timespec start;
+    long bytes, sectors, offset, l;
+    long us[3];
+    uint32_t sum[2];
+    int status = 1;
+    char *image = "e010bench.lif";
+    char *text = "e010bench.txt";
+
+    if(loops <= 0)
+        loops = 10;
+
+    bytes = lif_add_ascii_file_as_e010_wrapper(NULL, 0, textfile);
+    if(bytes < 0)
+        return(0);
+    sectors = lif_bytes2sectors(bytes);
+
+    if(lif_create_image(image, "BENCH", 1, sectors + 4, 0) < 0)
+        return(0);
+    LIF = lif_open_volume(image,"rb+");
+    if(LIF == NULL)
+        return(0);
+    if(lif_add_e010(LIF, "BENCH", textfile) < 0)
+    {
+        lif_closedir(LIF);
+        return(0);
+    }
+    offset = LIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE;
+
+// pass 0 line at a time, pass 1 streaming
+    clock_gettime(0, &start);
+    for(l = 0; l < loops; ++l)
+    {
+        lif_e010_bench_line(NULL, offset, textfile);
+        lif_e010_bench_line(LIF, offset, textfile);
+    }
+    us[0] = lif_elapsed_us(&start);
+    sum[0] = lif_e010_bench_sum(LIF, offset, sectors);
+
+    clock_gettime(0, &start);
+    for(l = 0; l < loops; ++l)
+    {
+        lif_add_ascii_file_as_e010_wrapper(NULL, offset, textfile);
+        lif_add_ascii_file_as_e010_wrapper(LIF, offset, textfile);
+    }
+    us[1] = lif_elapsed_us(&start);
+    sum[1] = lif_e010_bench_sum(LIF, offset, sectors);
+
+    clock_gettime(0, &start);
+    for(l = 0; l < loops; ++l)
+    {
+        if(!lif_extract_e010(LIF, "BENCH", text))
+            status = 0;
+    }
+    us[2] = lif_elapsed_us(&start);
+
+    lif_closedir(LIF);
+    unlink(image);
+    unlink(text);
+
+    printf("\n%ld E010 bytes, %ld loops\n", bytes, loops);
+    printf("add     line:   %9ld us, %7ld KB/s\n", us[0], us[0] ? bytes * loops / 1024L * 1000000L / us[0] : 0L);
+    printf("add     stream: %9ld us, %7ld KB/s\n", us[1], us[1] ? bytes * loops / 1024L * 1000000L / us[1] : 0L);
+    if(us[1])
+        printf("speedup: %ld.%02ldx\n", us[0] / us[1], (us[0] * 100L / us[1]) % 100L);
+    printf("extract stream: %9ld us, %7ld KB/s\n", us[2], us[2] ? bytes * loops / 1024L * 1000000L / us[2] : 0L);
+
+    if(sum[0] != sum[1])
+    {
+        printf("lif_e010_bench: data mismatch line:%08lx stream:%08lx\n",
+            (unsigned long) sum[0], (unsigned long) sum[1]);
+        status = 0;
+    }
+    return(status);
+}
+
+
+/// @brief Extract a file from an open LIF image as standalone LIF image
+/// @param[in] *LIF: LIF image to extract file from
 /// @param[in] lifname:  name of file in LIF image we want to extract
 /// @param[in] username: new LIF file to create
 /// @return 1 on sucess or 0 on error
 /// FIXME assumes 256 byte secors
 MEMSPACE
-int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
+int lif_extract_lif(lif_t *LIF, char *lifname, char *username)
 {
-// Master image lif_t structure
-    lif_t *LIF;
     lif_t *ULIF;
 
     long offset, uoffset, bytes;
@@ -2400,30 +3621,19 @@ int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
 
     uint8_t buf[LIF_SECTOR_SIZE+4];
 
-    LIF = lif_open_volume(lifimagename,"r");
-    if(LIF == NULL)
-    {
-        printf("LIF image not found:%s\n", lifimagename);
-        return(0);
-    }
-
     index = lif_find_file(LIF, lifname);
     if(index == -1)
     {
         printf("File not found:%s\n", lifname);
-        lif_closedir(LIF);
         return(0);
     }
 
     sectors = LIF->DIR.FileSectors;
 
 //Initialize the user file lif_t structure
-    ULIF = lif_create_volume(username, "HFSLIF",1,1,sectors);
+    ULIF = lif_create_volume(username, "HFSLIF",1,1,sectors,0);
     if(ULIF == NULL)
-    {
-        lif_closedir(LIF);
         return(0);
-    }
 
 // Only the start sector changes
 
@@ -2435,13 +3645,11 @@ int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
 
     if( !lif_writedirindex(ULIF,0))
     {
-        lif_closedir(LIF);
         lif_closedir(ULIF);
         return(0);
     }
     if( !lif_writedirEOF(ULIF,1) )
     {
-        lif_closedir(LIF);
         lif_closedir(ULIF);
         return(0);
     }
@@ -2457,7 +3665,6 @@ int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
         size = lif_read(LIF, buf, offset,LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
         {
-            lif_closedir(LIF);
             lif_closedir(ULIF);
             return(0);
         }
@@ -2465,7 +3672,6 @@ int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
         lif_write(ULIF,buf,uoffset,LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
         {
-            lif_closedir(LIF);
             lif_closedir(ULIF);
             return(0);
         }
@@ -2474,24 +3680,46 @@ int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
         uoffset += size;
         printf("\tWrote: %8ld\r", bytes);
     }
-    lif_closedir(LIF);
     lif_closedir(ULIF);
     printf("\tWrote: %8ld\n", bytes);
     return(1);
 }
 
 
-/// @brief Add LIF file from another LIF image
-/// @param[in] lifimagename: LIF image name
-/// @param[in] lifname: LIF file name to copy file to
+/// @brief Extract a file from LIF image entry as standalone LIF image
+/// @param[in] lifimagename: LIF disk image name to extract file from
+/// @param[in] lifname:  name of file in LIF image we want to extract
+/// @param[in] username: new LIF file to create
+/// @return 1 on sucess or 0 on error
+MEMSPACE
+int lif_extract_lif_as_lif(char *lifimagename, char *lifname, char *username)
+{
+    lif_t *LIF;
+    int status;
+
+    LIF = lif_open_volume(lifimagename,"r");
+    if(LIF == NULL)
+    {
+        printf("LIF image not found:%s\n", lifimagename);
+        return(0);
+    }
+
+    status = lif_extract_lif(LIF, lifname, username);
+
+    lif_closedir(LIF);
+    return(status);
+}
+
+
+/// @brief Add LIF file from another LIF image to an open LIF image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] lifname: LIF file name to copy file to
 /// @param[in] userfile: LIF mage name copy file from
 /// @return size of data written into to LIF image, or -1 on error
 /// FIXME assumes 256 byte secors
 MEMSPACE
-long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
+long lif_add_lif(lif_t *LIF, char *lifname, char *userfile)
 {
-// Master image lif_t structure
-    lif_t *LIF;
     lif_t *ULIF;
     int index = 0;
     long offset, uoffset, start, bytes;
@@ -2499,25 +3727,9 @@ long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
 
     uint8_t buf[LIF_SECTOR_SIZE+4];
 
-    if(!*lifimagename)
-    {
-        printf("lif_add: lifimagename is empty\n");
-        return(-1);
-    }
-    if(!*lifname)
-    {
-        printf("lif_add: lifname is empty\n");
-        return(-1);
-    }
-    if(!*userfile)
-    {
-        printf("lif_add: userfile is empty\n");
-        return(-1);
-    }
-
     if(debuglevel & LIF_DEBUG)
         printf("LIF image:[%s], LIF name:[%s], user file:[%s]\n",
-            lifimagename, lifname, userfile);
+            LIF->name, lifname, userfile);
 
 // open  userfile as LIF image
     ULIF = lif_open_volume(userfile,"rb+");
@@ -2533,17 +3745,12 @@ long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
         return(0);
     }
 
-    LIF = lif_open_volume(lifimagename,"rb+");
-    if(LIF == NULL)
-        return(-1);
-
 // Now find a new free record that is big enough
     index = lif_newdir(LIF, ULIF->DIR.FileSectors);
     if(index == -1)
     {
         printf("LIF image:[%s], not enough free space for:[%s]\n",
-            lifimagename, userfile);
-        lif_closedir(LIF);
+            LIF->name, userfile);
         lif_closedir(ULIF);
         return(-1);
     }
@@ -2562,14 +3769,31 @@ long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
 // User lif image file start in bytes
     uoffset = ULIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE;
     bytes = 0;
+
+#ifdef LIF_MMAP
+// Both images mapped - copy the whole file at once
+    {
+        long len = LIF->DIR.FileSectors * (long) LIF_SECTOR_SIZE;
+        uint8_t *src = lif_map_ptr(ULIF, uoffset, len);
+        uint8_t *dst = LIF->mapwrite ? lif_map_ptr(LIF, offset, len) : NULL;
+        if(src && dst)
+        {
+            memcpy(dst, src, len);
+            LIF->dirty = 1;
+            offset += len;
+            uoffset += len;
+            bytes = len;
+        }
+    }
+#endif
+
 // Copy file data
-    for(i=0;i<(int)LIF->DIR.FileSectors;++i)
+    for(i=bytes/LIF_SECTOR_SIZE;i<(int)LIF->DIR.FileSectors;++i)
     {
 // Read
         size = lif_read(ULIF, buf, uoffset, LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
         {
-            lif_closedir(LIF);
             lif_closedir(ULIF);
             return(-1);
         }
@@ -2578,7 +3802,6 @@ long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
         size = lif_write(LIF, buf, offset, LIF_SECTOR_SIZE);
         if(size < LIF_SECTOR_SIZE)
         {
-            lif_closedir(LIF);
             lif_closedir(ULIF);
             return(-1);
         }
@@ -2591,246 +3814,1950 @@ long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
 
 // Write directory record
     if( !lif_writedirindex(LIF,index))
+        return(-1);
+    printf("\tWrote: %8ld\n", bytes);
+    return(bytes);
+}
+
+
+/// @brief Add LIF file from another LIF image
+/// @param[in] lifimagename: LIF image name
+/// @param[in] lifname: LIF file name to copy file to
+/// @param[in] userfile: LIF mage name copy file from
+/// @return size of data written into to LIF image, or -1 on error
+MEMSPACE
+long lif_add_lif_file(char *lifimagename, char *lifname, char *userfile)
+{
+    lif_t *LIF;
+    long bytes;
+
+    if(!*lifimagename)
     {
-        lif_closedir(LIF);
+        printf("lif_add: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!*lifname)
+    {
+        printf("lif_add: lifname is empty\n");
+        return(-1);
+    }
+    if(!*userfile)
+    {
+        printf("lif_add: userfile is empty\n");
+        return(-1);
+    }
+
+    LIF = lif_open_volume(lifimagename,"rb+");
+    if(LIF == NULL)
+        return(-1);
+
+    bytes = lif_add_lif(LIF, lifname, userfile);
+
+    lif_closedir(LIF);
+    return(bytes);
+}
+
+
+/// @brief Add a file from its raw sectors and directory record to an open LIF image
+/// Used to rebuild images from a lif dedup store, payload files hold the
+/// file sectors and direntry keeps the type, date and implementation bytes
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] lifname: LIF file name, replaces the name in direntry
+/// @param[in] payload: file holding the LIF file sectors
+/// @param[in] direntry: 32 byte LIF directory record as 64 hex digits, start sector is ignored
+/// @return size of data written into to LIF image, or -1 on error
+MEMSPACE
+long lif_add_raw(lif_t *LIF, char *lifname, char *payload, char *direntry)
+{
+    FILE *fp;
+    stat_t sb;
+    uint8_t B[LIF_DIR_SIZE];
+    uint8_t buf[LIF_SECTOR_SIZE];
+    unsigned int val;
+    long offset, bytes, sectors;
+    int i, index, size;
+
+    if(strlen(direntry) != LIF_DIR_SIZE * 2)
+    {
+        printf("lif_add_raw: direntry must be %d hex digits\n", LIF_DIR_SIZE * 2);
+        return(-1);
+    }
+    for(i = 0; i < LIF_DIR_SIZE; ++i)
+    {
+        if(sscanf(direntry + i * 2, "%2x", &val) != 1)
+        {
+            printf("lif_add_raw: direntry must be %d hex digits\n", LIF_DIR_SIZE * 2);
+            return(-1);
+        }
+        B[i] = val;
+    }
+    if(!lif_checkname(lifname) || strlen(lifname) > 10)
+    {
+        printf("lif_add_raw: invalid LIF name:[%s]\n", lifname);
+        return(-1);
+    }
+
+    sectors = B2V_MSB(B, 16, 4);
+    if(stat(payload, &sb) < 0 || sb.st_size != sectors * (long) LIF_SECTOR_SIZE)
+    {
+        printf("lif_add_raw: payload:[%s] is not %ld sectors\n", payload, sectors);
+        return(-1);
+    }
+    fp = fopen(payload, "rb");
+    if(fp == NULL)
+    {
+        printf("lif_add_raw: can not open:[%s]\n", payload);
+        return(-1);
+    }
+
+    index = lif_newdir(LIF, sectors);
+    if(index == -1)
+    {
+        printf("LIF image:[%s], not enough free space for:[%s]\n",
+            LIF->name, payload);
+        fclose(fp);
+        return(-1);
+    }
+
+// Keep the start sector lif_newdir() found
+    offset = LIF->DIR.FileStartSector;
+    lif_str2dir(B, LIF);
+    LIF->DIR.FileStartSector = offset;
+    memset(LIF->DIR.filename, 0, sizeof(LIF->DIR.filename));
+    strcpy((char *) LIF->DIR.filename, lifname);
+
+    offset *= (long) LIF_SECTOR_SIZE;
+    for(bytes = 0; bytes < sectors * (long) LIF_SECTOR_SIZE; bytes += LIF_SECTOR_SIZE)
+    {
+        if(fread(buf, 1, LIF_SECTOR_SIZE, fp) != LIF_SECTOR_SIZE)
+        {
+            fclose(fp);
+            return(-1);
+        }
+        size = lif_write(LIF, buf, offset, LIF_SECTOR_SIZE);
+        if(size < LIF_SECTOR_SIZE)
+        {
+            fclose(fp);
+            return(-1);
+        }
+        offset += (long) LIF_SECTOR_SIZE;
+    }
+    fclose(fp);
+
+// Write directory record
+    if( !lif_writedirindex(LIF,index))
+        return(-1);
+    return(bytes);
+}
+
+
+/// @brief Replace the volume header of an open LIF image
+/// Used to rebuild images from a lif dedup store, keeps the label, version,
+/// disk geometry and date of the original image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] volume: first LIF_VOL_SIZE bytes of sector 0 as hex digits
+/// @return 1 on success, -1 on error
+MEMSPACE
+int lif_set_volume(lif_t *LIF, char *volume)
+{
+    uint8_t B[LIF_SECTOR_SIZE];
+    unsigned int val;
+    int i;
+
+    if(strlen(volume) != LIF_VOL_SIZE * 2)
+    {
+        printf("lif_set_volume: volume must be %d hex digits\n", LIF_VOL_SIZE * 2);
+        return(-1);
+    }
+    if(lif_read(LIF, B, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+        return(-1);
+    for(i = 0; i < LIF_VOL_SIZE; ++i)
+    {
+        if(sscanf(volume + i * 2, "%2x", &val) != 1)
+        {
+            printf("lif_set_volume: volume must be %d hex digits\n", LIF_VOL_SIZE * 2);
+            return(-1);
+        }
+        B[i] = val;
+    }
+
+// The image was created with this layout, the header can not move it
+    if(B2V_MSB(B,8,4) != LIF->VOL.DirStartSector || B2V_MSB(B,16,4) != LIF->VOL.DirSectors)
+    {
+        printf("lif_set_volume:[%s] volume directory does not match the image\n", LIF->name);
+        return(-1);
+    }
+
+    if(lif_write(LIF, B, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+        return(-1);
+    lif_str2vol(B, LIF);
+    return(1);
+}
+
+
+/// @brief Delete LIF file in LIF image
+/// @param[in] lifimagename: LIF image name
+/// @param[in] lifname: LIF file name
+/// @return 1 if deleted, 0 if not found, -1 error
+MEMSPACE
+int lif_del_file(char *lifimagename, char *lifname)
+{
+    lif_t *LIF;
+    int index;
+
+    if(!*lifimagename)
+    {
+        printf("lif_del_file: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!*lifname)
+    {
+        printf("lif_del_file: lifname is empty\n");
+        return(-1);
+    }
+    if(debuglevel & LIF_DEBUG)
+        printf("LIF image:[%s], LIF name:[%s]\n",
+            lifimagename, lifname);
+
+    LIF = lif_open_volume(lifimagename,"rb+");
+    if(LIF == NULL)
+        return(-1);
+
+    index = lif_del(LIF, lifname);
+
+    lif_closedir(LIF);
+    return(index);
+}
+
+
+/// @brief Delete LIF file in an open LIF image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] lifname: LIF file name
+/// @return 1 if deleted, 0 if not found, -1 error
+MEMSPACE
+int lif_del(lif_t *LIF, char *lifname)
+{
+    int index;
+
+// Now find file record
+    index = lif_find_file(LIF, lifname);
+    if(index == -1)
+    {
+        printf("LIF image:[%s] lif name:[%s] not found\n", LIF->name, lifname);
+        return(0);
+    }
+
+// IF the next record is EOF then update EOF
+    if(index >= LIF->EOFindex-1)
+        LIF->DIR.FileType = 0xffff;
+    else
+        LIF->DIR.FileType = 0;
+
+// re-Write directory record
+    if( !lif_writedirindex(LIF,index) )
+        return(-1);
+
+    lif_updatefree(LIF);
+
+    printf("Deleted: %10s\n", lifname);
+
+    return(1);
+}
+
+
+/// @brief Rename LIF file in LIF image
+/// @param[in] lifimagename: LIF image name
+/// @param[in] oldlifname: old LIF file name
+/// @param[in] newlifname: new LIF file name
+/// @return 1 if renamed, 0 if not found, -1 error
+MEMSPACE
+int lif_rename_file(char *lifimagename, char *oldlifname, char *newlifname)
+{
+    int index;
+    lif_t *LIF;
+
+    if(!*lifimagename)
+    {
+        printf("lif_rename_file: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!*oldlifname)
+    {
+        printf("lif_rename_file: old lifname is empty\n");
         return(-1);
     }
-    lif_closedir(LIF);
-    printf("\tWrote: %8ld\n", bytes);
-    return(bytes);
+    if(!*newlifname)
+    {
+        printf("lif_rename_file: new lifname is empty\n");
+        return(-1);
+    }
+
+    if(!lif_checkname(newlifname))
+    {
+        printf("lif_rename_file: new lifname contains bad characters\n");
+        return(-1);
+
+    }
+
+    LIF = lif_open_volume(lifimagename,"rb+");
+    if(LIF == NULL)
+        return(-1);
+
+    index = lif_rename(LIF, oldlifname, newlifname);
+
+    lif_closedir(LIF);
+    return(index);
+}
+
+
+/// @brief Rename LIF file in an open LIF image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] oldlifname: old LIF file name
+/// @param[in] newlifname: new LIF file name
+/// @return 1 if renamed, 0 if not found, -1 error
+MEMSPACE
+int lif_rename(lif_t *LIF, char *oldlifname, char *newlifname)
+{
+    int index;
+
+    if(!lif_checkname(newlifname))
+    {
+        printf("lif_rename_file: new lifname contains bad characters\n");
+        return(-1);
+    }
+
+// Now find file record
+    index = lif_find_file(LIF, oldlifname);
+    if(index == -1)
+    {
+        printf("lif_rename:[%s] lif name:[%s] not found\n", LIF->name, oldlifname);
+        return(0);
+    }
+    lif_fixname(LIF->DIR.filename, newlifname, 10);
+
+// re-Write directory record
+    if( !lif_writedirindex(LIF,index))
+        return(-1);
+    printf("renamed: %10s to %10s\n", oldlifname,newlifname);
+
+    return(1);
+}
+
+
+/// @brief Rename LIF VOLUME NAME
+/// @param[in] lifimagename: LIF image name
+/// @param[in] volname: new LIF Volume name
+/// @return 1 if renamed, 0 if not found, -1 error
+MEMSPACE
+int lif_rename_volume(char *lifimagename, char *volname)
+{
+    lif_t *LIF;
+    int status;
+
+
+    if(!*lifimagename)
+    {
+        printf("lif_rename_file: lifimagename is empty\n");
+        return(-1);
+    }
+
+    if(!*volname)
+    {
+        printf("lif_rename_file: new Volume name empty\n");
+        return(-1);
+    }
+
+    if(!lif_checkname(volname))
+    {
+        printf("lif_rename_file: new lifname contains bad characters\n");
+        return(-1);
+
+    }
+
+    LIF = lif_open_volume(lifimagename,"rb+");
+    if(LIF == NULL)
+        return(-1);
+
+    status = lif_renamevol(LIF, volname);
+
+    lif_close_volume(LIF);
+    return(status);
+}
+
+
+/// @brief Rename the volume of an open LIF image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in] volname: new volume name
+/// @return 1 if renamed, -1 error
+MEMSPACE
+int lif_renamevol(lif_t *LIF, char *volname)
+{
+	uint8_t buffer[LIF_SECTOR_SIZE+1];
+
+    if(!lif_checkname(volname))
+    {
+        printf("lif_rename_file: new lifname contains bad characters\n");
+        return(-1);
+    }
+
+	// Update volume name
+    lif_fixname(LIF->VOL.Label, volname, 6);
+
+// Validate basic Volume headers
+    if( !lif_check_volume(LIF) )
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("lif_rename_volume:[%s] error volume validate failed\n", LIF->name);
+        return(-1);
+    }
+
+	// clear sector buffer
+    memset(buffer,0,LIF_SECTOR_SIZE);
+	// created update volume header sector from LIF structure
+	lif_vol2str(LIF,buffer);
+
+// Volume header must be it least one sector
+    if( lif_write(LIF, buffer, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+    {
+        if(debuglevel & LIF_DEBUG)
+            printf("lif_rename_volume:[%s] error write volume header failed\n", LIF->name);
+        return(-1);
+    }
+
+    return(1);
+}
+
+/// @brief lif_batch() command names, in LIF_BATCH_ADD .. LIF_BATCH_RENAMEVOL order
+char *lif_batch_names[LIF_BATCH_OPS] =
+{
+    "add", "addbin", "extract", "extractbin", "del", "rename", "renamevol", "addraw"
+};
+
+/// @brief lif_batch() arguments needed by each command, including the command
+int lif_batch_needs[LIF_BATCH_OPS] = { 3, 3, 3, 3, 2, 3, 2, 4 };
+
+
+/// @brief Run one lif_batch() command against an open LIF image
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in,out] *B: per command counts and times
+/// @param[in] argc: argument count
+/// @param[in] *argv[]: command and arguments
+/// @return 1 on success, 0 if the command failed, -1 if it is not a command
+MEMSPACE
+int lif_batch_command(lif_t *LIF, lifbatch_t *B, int argc, char *argv[])
+{
+    struct timespec t;
+    long ret;
+    int op;
+
+    for(op = 0; op < LIF_BATCH_OPS; ++op)
+    {
+        if(MATCHI(argv[0],lif_batch_names[op]))
+            break;
+    }
+    if(op == LIF_BATCH_OPS || argc < lif_batch_needs[op])
+    {
+        ++B->errors;
+        return(-1);
+    }
+
+    clock_gettime(0, &t);
+    switch(op)
+    {
+        case LIF_BATCH_ADD:
+            ret = lif_add_e010(LIF, argv[1], argv[2]);
+            break;
+        case LIF_BATCH_ADDBIN:
+            ret = lif_add_lif(LIF, argv[1], argv[2]);
+            break;
+        case LIF_BATCH_EXTRACT:
+            ret = lif_extract_e010(LIF, argv[1], argv[2]);
+            break;
+        case LIF_BATCH_EXTRACTBIN:
+            ret = lif_extract_lif(LIF, argv[1], argv[2]);
+            break;
+        case LIF_BATCH_DEL:
+            ret = lif_del(LIF, argv[1]);
+            break;
+        case LIF_BATCH_RENAME:
+            ret = lif_rename(LIF, argv[1], argv[2]);
+            break;
+        case LIF_BATCH_RENAMEVOL:
+            ret = lif_renamevol(LIF, argv[1]);
+            break;
+        default:
+            ret = lif_add_raw(LIF, argv[1], argv[2], argv[3]);
+            break;
+    }
+    B->us[op] += lif_elapsed_us(&t);
+    ++B->count[op];
+    ++B->commands;
+
+    if(ret <= 0)
+    {
+        ++B->failed[op];
+        ++B->errors;
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Display lif_batch() counts and times
+/// @param[in] *B: per command counts and times
+/// @param[in] closeus: time spent closing the image
+/// @param[in] total: total time
+/// @return void
+MEMSPACE
+void lif_batch_summary(lifbatch_t *B, long closeus, long total)
+{
+    int op;
+
+    printf("\n%-12s %8s %8s %12s %10s\n", "Operation", "Count", "Failed", "Total us", "us/op");
+    for(op = 0; op < LIF_BATCH_OPS; ++op)
+    {
+        if(!B->count[op])
+            continue;
+        printf("%-12s %8ld %8ld %12ld %10ld\n",
+            lif_batch_names[op], B->count[op], B->failed[op], B->us[op], B->us[op] / B->count[op]);
+    }
+    printf("%-12s %8s %8s %12ld\n", "close", "", "", closeus);
+    printf("%-12s %8ld %8ld %12ld\n", "total", B->commands, B->errors, total);
+}
+
+
+/// @brief Run a script of LIF commands against one open LIF image
+/// Each line is one of
+///   add lifname from_ascii_file
+///   addbin lifname from_lif_file
+///   extract lifname to_ascii_file
+///   extractbin lifname to_lif_file
+///   del lifname
+///   rename oldlifname newlifname
+///   renamevol name
+///   addraw lifname payload_file direntry
+/// Blank lines and lines starting with # are ignored
+/// The image is opened once so the volume header and directory are only read
+/// once and changed directory records are written when the image is closed
+/// @param[in] lifimagename: LIF disk image name
+/// @param[in] script: script file name, "-" reads stdin
+/// @return number of commands run, -1 on error
+MEMSPACE
+int lif_batch(char *lifimagename, char *script)
+{
+    lif_t *LIF;
+    FILE *fp;
+    lifbatch_t B;
+    char line[LIF_BATCH_LINE];
+    char *argv[LIF_BATCH_ARGS];
+    long total;
+    long closeus;
+    int argc, lines, ret;
+    struct timespec start, t;
+
+    if(!*lifimagename)
+    {
+        printf("lif_batch: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!*script)
+    {
+        printf("lif_batch: script is empty\n");
+        return(-1);
+    }
+
+    if(MATCH(script,"-"))
+        fp = stdin;
+    else
+    {
+        fp = fopen(script,"r");
+        if(fp == NULL)
+        {
+            printf("lif_batch: can not open:[%s]\n", script);
+            return(-1);
+        }
+    }
+
+    clock_gettime(0, &start);
+
+    LIF = lif_open_volume(lifimagename,"rb+");
+    if(LIF == NULL)
+    {
+        if(fp != stdin)
+            fclose(fp);
+        return(-1);
+    }
+
+    memset(&B, 0, sizeof(B));
+    lines = 0;
+    while(fgets(line, sizeof(line)-1, fp) != NULL)
+    {
+        ++lines;
+        trim_tail(line);
+        argc = split_args(line, argv, LIF_BATCH_ARGS);
+        if(!argc || argv[0][0] == '#')
+            continue;
+
+        ret = lif_batch_command(LIF, &B, argc, argv);
+        if(ret < 0)
+            printf("lif_batch:[%s] line %d: bad command:[%s]\n", script, lines, argv[0]);
+        else if(ret == 0)
+            printf("lif_batch:[%s] line %d: %s failed\n", script, lines, argv[0]);
+    }
+
+    if(fp != stdin)
+        fclose(fp);
+
+// Writes the changed directory records
+    clock_gettime(0, &t);
+    lif_close_volume(LIF);
+    closeus = lif_elapsed_us(&t);
+    total = lif_elapsed_us(&start);
+
+    lif_batch_summary(&B, closeus, total);
+
+    if(B.errors)
+        return(-1);
+    return(B.commands);
+}
+
+/// @brief Create/Format a LIF new disk image
+/// This can take a while to run, about 1 min for 10,000,000 bytes
+/// @param[in] lifimagename: LIF disk image name
+/// @param[in] liflabel: LIF Volume Label name
+/// @param[in] dirsectors: Number of LIF directory sectors
+/// @param[in] sectors: total disk image size in sectors
+/// @param[in] sparse: 1 = create a sparse image that only stores written sectors
+///@return bytes writting to disk image
+MEMSPACE
+long lif_create_image(char *lifimagename, char *liflabel, uint32_t dirsectors, uint32_t sectors, int sparse)
+{
+    return(lif_create_image_at(lifimagename, liflabel, 2, dirsectors, sectors, sparse));
+}
+
+
+/// @brief Create/Format a LIF new disk image with the directory at a given sector
+/// lif build uses this to rebuild images that do not start the directory at sector 2
+/// @param[in] lifimagename: LIF disk image name
+/// @param[in] liflabel: LIF Volume Label name, may be empty
+/// @param[in] dirstart: Directory start sector
+/// @param[in] dirsectors: Number of LIF directory sectors
+/// @param[in] sectors: total disk image size in sectors
+/// @param[in] sparse: 1 = create a sparse image that only stores written sectors
+///@return bytes writting to disk image
+MEMSPACE
+long lif_create_image_at(char *lifimagename, char *liflabel, uint32_t dirstart, uint32_t dirsectors, uint32_t sectors, int sparse)
+{
+    uint32_t filestart,filesectors,end;
+    lif_t *LIF;
+
+    if(!*lifimagename)
+    {
+        printf("lif_create_image: lifimagename is empty\n");
+        return(-1);
+    }
+    if(!dirstart)
+    {
+        printf("lif_create_image: dirstart is 0\n");
+        return(-1);
+    }
+    if(!dirsectors)
+    {
+        printf("lif_create_image: dirsectors is 0\n");
+        return(-1);
+    }
+    if(!sectors)
+    {
+        printf("lif_create_image: sectors is 0\n");
+        return(-1);
+    }
+
+    if(dirstart + dirsectors >= sectors)
+    {
+        printf("lif_create_image: directory does not fit in %lu sectors\n", (unsigned long) sectors);
+        return(-1);
+    }
+
+    filestart = dirstart + dirsectors;
+    filesectors = sectors - filestart;
+    end = filestart + filesectors;
+
+    LIF = lif_create_volume(lifimagename, liflabel, dirstart, dirsectors, filesectors, sparse);
+    if(LIF == NULL)
+        return(-1);
+    lif_close_volume(LIF);
+
+    if(!lif_quiet)
+        printf("\tFormatting: wrote %ld sectors\n", (long)end);
+    return(end);
+}
+
+
+/// @brief Flush writes to the image so later writes can not pass them
+/// Used by lif_pack() to order data, journal and directory writes
+/// @param[in] *LIF: LIF structure
+/// @return void
+MEMSPACE
+void lif_sync(lif_t *LIF)
+{
+#ifdef LIF_MMAP
+    if(LIF->map)
+    {
+        if(LIF->dirty && msync(LIF->map, LIF->mapbytes, MS_SYNC) < 0)
+            printf("lif_sync:[%s] msync failed\n", LIF->name);
+        LIF->dirty = 0;
+        return;
+    }
+#endif
+    if(LIF->fp == NULL)
+        return;
+    fflush(LIF->fp);
+#ifdef LIF_STAND_ALONE
+#ifndef __MINGW32__
+    fsync(fileno(LIF->fp));
+#endif
+#else
+    syncfs(fileno(LIF->fp));
+#endif
+}
+
+
+/// @brief Read the lif_pack() journal sector
+/// @param[in] *LIF: LIF structure
+/// @param[out] *J: journal, phase 0 if there is no journal
+/// @return 1 if the journal sector is a journal or empty, 0 if it is in use or on error
+MEMSPACE
+int lif_pack_journal_read(lif_t *LIF, lifpack_t *J)
+{
+    uint8_t buf[LIF_SECTOR_SIZE];
+    int i;
+
+    memset(J, 0, sizeof(lifpack_t));
+
+// The journal needs the unused sector between the volume header and the directory
+    if(LIF->VOL.DirStartSector <= LIF_PACK_JOURNAL)
+    {
+        printf("lif_pack:[%s] no free sector for the journal\n", LIF->name);
+        return(0);
+    }
+    if(lif_read(LIF, buf, LIF_PACK_JOURNAL * (long) LIF_SECTOR_SIZE, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+        return(0);
+
+    if(memcmp(buf, LIF_PACK_MAGIC, LIF_PACK_MAGIC_SIZE) == 0)
+    {
+        J->phase = buf[8];
+        J->file = B2V_LSB(buf, 12, 4);
+        J->done = B2V_LSB(buf, 16, 4);
+        J->out = B2V_LSB(buf, 20, 4);
+        J->in = B2V_LSB(buf, 24, 4);
+        J->target = B2V_LSB(buf, 28, 4);
+        J->records = buf[32];
+        if(J->records > LIF_PACK_RECORDS)
+            J->records = LIF_PACK_RECORDS;
+        memcpy(J->rec, buf + 64, sizeof(J->rec));
+        return(1);
+    }
+
+    for(i = 0; i < LIF_SECTOR_SIZE; ++i)
+    {
+        if(buf[i])
+        {
+            printf("lif_pack:[%s] sector %d is in use, can not write the journal\n",
+                LIF->name, LIF_PACK_JOURNAL);
+            return(0);
+        }
+    }
+    return(1);
+}
+
+
+/// @brief Write the lif_pack() journal sector and flush it to the image
+/// @param[in] *LIF: LIF structure
+/// @param[in] *J: journal, phase 0 clears the journal sector
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_pack_journal_write(lif_t *LIF, lifpack_t *J)
+{
+    uint8_t buf[LIF_SECTOR_SIZE];
+
+    memset(buf, 0, sizeof(buf));
+    if(J->phase)
+    {
+        memcpy(buf, LIF_PACK_MAGIC, LIF_PACK_MAGIC_SIZE);
+        buf[8] = J->phase;
+        V2B_LSB(buf, 12, 4, J->file);
+        V2B_LSB(buf, 16, 4, J->done);
+        V2B_LSB(buf, 20, 4, J->out);
+        V2B_LSB(buf, 24, 4, J->in);
+        V2B_LSB(buf, 28, 4, J->target);
+        buf[32] = J->records;
+        memcpy(buf + 64, J->rec, sizeof(J->rec));
+    }
+    if(lif_write(LIF, buf, LIF_PACK_JOURNAL * (long) LIF_SECTOR_SIZE, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+    {
+        printf("lif_pack:[%s] journal write failed\n", LIF->name);
+        return(0);
+    }
+    lif_sync(LIF);
+    return(1);
+}
+
+
+/// @brief Move file data down to its packed position
+/// Chunks never overlap their own source so an interrupted chunk can be redone
+/// @param[in] *LIF: LIF structure
+/// @param[in] *J: journal, file and done are updated after each chunk
+/// @param[in] *buf: LIF_PACK_CHUNK sector buffer
+/// @param[in] src: file start sector
+/// @param[in] dst: packed start sector, below src
+/// @param[in] sectors: file size in sectors
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_pack_move(lif_t *LIF, lifpack_t *J, uint8_t *buf, uint32_t src, uint32_t dst, uint32_t sectors)
+{
+    long count, bytes;
+
+    while(J->done < sectors)
+    {
+        count = sectors - J->done;
+        if(count > LIF_PACK_CHUNK)
+            count = LIF_PACK_CHUNK;
+        if(count > (long) (src - dst))
+            count = src - dst;
+        bytes = count * LIF_SECTOR_SIZE;
+
+        if(lif_read(LIF, buf, (src + J->done) * (long) LIF_SECTOR_SIZE, bytes) < bytes)
+            return(0);
+        if(lif_write(LIF, buf, (dst + J->done) * (long) LIF_SECTOR_SIZE, bytes) < bytes)
+            return(0);
+        lif_sync(LIF);
+
+        J->done += count;
+        if( !lif_pack_journal_write(LIF, J) )
+            return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Pack a LIF image, moving files down to close the space left by deleted files
+/// Purged directory records are removed and the directory is rewritten once at the end
+/// A journal in sector 1 lets an interrupted pack resume by running it again
+/// @param[in] lifimagename: LIF image name
+/// @param[in] dryrun: 1 = only report what would be done
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_pack(char *lifimagename, int dryrun)
+{
+    lif_t *LIF;
+    lifpack_t J;
+    uint8_t *buf = NULL;
+    uint32_t target, moved = 0, movedfiles = 0, files = 0, gaps = 0;
+    uint32_t start, sectors, end;
+    uint32_t ordinal;
+    int index, purged = 0;
+    int last = 0;
+
+    LIF = lif_open_volume(lifimagename, dryrun ? "rb" : "rb+");
+    if(LIF == NULL)
+        return(0);
+
+    if( !lif_pack_journal_read(LIF, &J) )
+    {
+        lif_closedir(LIF);
+        return(0);
+    }
+
+// Plan - the packed position of a file only depends on the sizes of the files before it
+    target = LIF->filestart;
+    end = LIF->filestart;
+    for(index = 0; J.phase != 2; ++index)
+    {
+        if( !lif_readdirindex(LIF, index) || LIF->DIR.FileType == 0xffff)
+            break;
+        if(LIF->DIR.FileType == 0)
+        {
+            ++purged;
+            continue;
+        }
+        if(LIF->DIR.FileStartSector < target)
+        {
+            printf("lif_pack:[%s] file:[%s] overlaps the file before it\n", LIF->name, LIF->DIR.filename);
+            lif_closedir(LIF);
+            return(0);
+        }
+        if(LIF->DIR.FileStartSector != target)
+        {
+            moved += LIF->DIR.FileSectors;
+            ++movedfiles;
+        }
+// Space between this file and the one before it
+        gaps += LIF->DIR.FileStartSector - end;
+        end = LIF->DIR.FileStartSector + LIF->DIR.FileSectors;
+        target += LIF->DIR.FileSectors;
+        ++files;
+    }
+
+    if(J.phase)
+        printf("Resuming interrupted pack of:[%s], phase %d\n", LIF->name, J.phase);
+    if(J.phase != 2)
+    {
+        printf("%8ld Files, %ld moved\n", (long) files, (long) movedfiles);
+        printf("%8ld Bytes moved\n", (long) moved * LIF_SECTOR_SIZE);
+        printf("%8ld Sectors reclaimed\n", (long) gaps);
+        printf("%8d Purged directory records removed\n", purged);
+    }
+
+    if(dryrun)
+    {
+        lif_closedir(LIF);
+        return(1);
+    }
+
+#ifdef LIF_DIRCACHE
+// Directory writes must reach the image in journal order
+    lif_dircache_flush(LIF);
+    lif_dircache_free(LIF);
+#endif
+
+    buf = lif_calloc(LIF_PACK_CHUNK * (long) LIF_SECTOR_SIZE);
+    if(buf == NULL)
+    {
+        lif_closedir(LIF);
+        return(0);
+    }
+
+// Phase 1 - move file data, the directory still has the old start sectors
+    if(J.phase == 0)
+    {
+        J.phase = 1;
+        if( !lif_pack_journal_write(LIF, &J) )
+            goto error;
+    }
+
+    if(J.phase == 1)
+    {
+        target = LIF->filestart;
+        ordinal = 0;
+        for(index = 0; ; ++index)
+        {
+            if( !lif_readdirindex(LIF, index) || LIF->DIR.FileType == 0xffff)
+                break;
+            if(LIF->DIR.FileType == 0)
+                continue;
+            start = LIF->DIR.FileStartSector;
+            sectors = LIF->DIR.FileSectors;
+            if(ordinal >= J.file && start != target)
+            {
+                if(ordinal != J.file)
+                {
+                    J.file = ordinal;
+                    J.done = 0;
+                }
+                if( !lif_pack_move(LIF, &J, buf, start, target, sectors) )
+                    goto error;
+                printf("\tMoved: %-10s %8ld to %8ld\r", LIF->DIR.filename, (long) start, (long) target);
+            }
+            target += sectors;
+            ++ordinal;
+        }
+        printf("\n");
+
+        memset(&J, 0, sizeof(J));
+        J.phase = 2;
+        J.target = LIF->filestart;
+        if( !lif_pack_journal_write(LIF, &J) )
+            goto error;
+    }
+
+// Phase 2 - rewrite the directory without purged records
+// Records are journaled before they are written, output never passes input
+    if(J.records)
+    {
+        if(lif_write(LIF, J.rec, LIF->VOL.DirStartSector * (long) LIF_SECTOR_SIZE + J.out * (long) LIF_DIR_SIZE,
+                J.records * LIF_DIR_SIZE) < J.records * LIF_DIR_SIZE)
+            goto error;
+        lif_sync(LIF);
+        J.out += J.records;
+        J.records = 0;
+    }
+
+    while(!last)
+    {
+        while(J.records < LIF_PACK_RECORDS)
+        {
+            if( !lif_readdirindex(LIF, J.in) || LIF->DIR.FileType == 0xffff)
+            {
+                last = 1;
+                break;
+            }
+            ++J.in;
+            if(LIF->DIR.FileType == 0)
+                continue;
+            LIF->DIR.FileStartSector = J.target;
+            J.target += LIF->DIR.FileSectors;
+            lif_dir2str(LIF, J.rec + J.records * LIF_DIR_SIZE);
+            ++J.records;
+        }
+        if(J.records == 0)
+            break;
+        if( !lif_pack_journal_write(LIF, &J) )
+            goto error;
+        if(lif_write(LIF, J.rec, LIF->VOL.DirStartSector * (long) LIF_SECTOR_SIZE + J.out * (long) LIF_DIR_SIZE,
+                J.records * LIF_DIR_SIZE) < J.records * LIF_DIR_SIZE)
+            goto error;
+        lif_sync(LIF);
+        J.out += J.records;
+        J.records = 0;
+    }
+
+    if( !lif_writedirEOF(LIF, J.out) )
+        goto error;
+    lif_sync(LIF);
+
+// Done - clear the journal
+    memset(&J, 0, sizeof(J));
+    if( !lif_pack_journal_write(LIF, &J) )
+        goto error;
+
+    lif_free(buf);
+    lif_updatefree(LIF);
+    printf("Packed:[%s] %ld files, %ld free sectors\n", LIF->name, (long) LIF->files, (long) LIF->freesectors);
+    lif_closedir(LIF);
+    return(1);
+
+error:
+    printf("lif_pack:[%s] failed, run pack again to resume\n", lifimagename);
+    if(buf)
+        lif_free(buf);
+    lif_closedir(LIF);
+    return(0);
+}
+
+
+#ifdef LIF_MMAP
+/// @brief Benchmark one LIF image
+/// Each loop opens the image, scans the directory, finds every file by name
+/// and reads all of its sectors - the same access pattern as dir, extract and add
+/// @param[in] *name: LIF image name
+/// @param[in] loops: number of times to repeat
+/// @param[in,out] *sum: checksum of the data read, must match between stdio and mmap
+/// @return files found or -1 on error
+MEMSPACE
+int lif_bench_image(char *name, long loops, uint32_t *sum)
+{
+    lif_t *LIF;
+    lifdir_t *DIR;
+    char lifname[12];
+    uint8_t buf[LIF_SECTOR_SIZE];
+    long offset, l;
+    uint32_t i, sectors;
+    int files = 0;
+
+    for(l = 0; l < loops; ++l)
+    {
+        LIF = lif_open_volume(name, "rb");
+        if(LIF == NULL)
+            return(-1);
+
+        files = 0;
+        while((DIR = lif_readdir(LIF)) != NULL)
+        {
+            strcpy(lifname, (char *) DIR->filename);
+            if(lif_find_file(LIF, lifname) == -1)
+            {
+                printf("lif_bench:[%s] file:[%s] not found\n", name, lifname);
+                lif_closedir(LIF);
+                return(-1);
+            }
+            offset = LIF->DIR.FileStartSector * (long) LIF_SECTOR_SIZE;
+            sectors = LIF->DIR.FileSectors;
+            for(i = 0; i < sectors; ++i)
+            {
+                if(lif_read(LIF, buf, offset, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+                    break;
+                *sum += buf[0] + buf[LIF_SECTOR_SIZE-1] + i;
+                offset += LIF_SECTOR_SIZE;
+            }
+            ++files;
+        }
+        lif_closedir(LIF);
+    }
+    return(files);
+}
+
+
+/// @brief Run lif_bench_image() over a list of images and directories
+/// Directories are scanned for files ending in .lif
+/// @param[in] argc: number of names
+/// @param[in] *argv[]: image or directory names
+/// @param[in] loops: number of times to repeat each image
+/// @param[out] *images: images benchmarked
+/// @param[out] *files: files found
+/// @param[out] *sum: checksum of the data read
+/// @return void
+MEMSPACE
+void lif_bench_pass(int argc, char *argv[], long loops, long *images, long *files, uint32_t *sum)
+{
+    DIR *dp;
+    struct dirent *de;
+    stat_t sb;
+    char path[1024];
+    int i, len, ret;
+
+    *images = 0;
+    *files = 0;
+    *sum = 0;
+
+    for(i = 0; i < argc; ++i)
+    {
+        if(stat(argv[i], &sb) < 0)
+        {
+            printf("lif_bench: Can't stat:%s\n", argv[i]);
+            continue;
+        }
+        if(!S_ISDIR(sb.st_mode))
+        {
+            ret = lif_bench_image(argv[i], loops, sum);
+            if(ret >= 0)
+            {
+                ++*images;
+                *files += ret;
+            }
+            continue;
+        }
+        dp = opendir(argv[i]);
+        if(dp == NULL)
+            continue;
+        while((de = readdir(dp)) != NULL)
+        {
+            len = strlen(de->d_name);
+            if(len < 5 || strcasecmp(de->d_name + len - 4, ".lif") != 0)
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", argv[i], de->d_name);
+            ret = lif_bench_image(path, loops, sum);
+            if(ret >= 0)
+            {
+                ++*images;
+                *files += ret;
+            }
+        }
+        closedir(dp);
+    }
+}
+
+
+/// @brief Compare stdio and mmap LIF image access
+/// @param[in] argc: number of names
+/// @param[in] *argv[]: image or directory names
+/// @param[in] loops: number of times to repeat each image
+/// @return 1 on success, 0 if the two methods read different data
+MEMSPACE
+int lif_bench(int argc, char *argv[], long loops)
+{
+    struct timespec start;
+    long images, files, us[2];
+    uint32_t sum[2];
+    int save = lif_mmap;
+    int pass;
+
+    if(loops <= 0)
+        loops = 100;
+
+// pass 0 stdio, pass 1 mmap
+    for(pass = 0; pass < 2; ++pass)
+    {
+        lif_mmap = pass;
+        clock_gettime(0, &start);
+        lif_bench_pass(argc, argv, loops, &images, &files, &sum[pass]);
+        us[pass] = lif_elapsed_us(&start);
+        printf("%-6s %4ld images, %5ld files, %6ld loops, %9ld us, %7ld us/image\n",
+            pass ? "mmap" : "stdio", images, files, loops, us[pass],
+            images ? us[pass] / (images * loops) : 0L);
+    }
+    lif_mmap = save;
+
+    if(us[1])
+        printf("speedup: %ld.%02ldx\n", us[0] / us[1], (us[0] * 100L / us[1]) % 100L);
+
+    if(sum[0] != sum[1])
+    {
+        printf("lif_bench: data mismatch stdio:%08lx mmap:%08lx\n",
+            (unsigned long) sum[0], (unsigned long) sum[1]);
+        return(0);
+    }
+    return(1);
+}
+#endif
+
+
+#ifdef LIF_PARALLEL
+/// @brief Add a work item to a lif build or lif extractall work list
+/// @param[in,out] *L: work list
+/// @param[in] *image: LIF image name
+/// @return new work item or NULL when out of memory
+MEMSPACE
+lifjob_t *lif_job_new(lifjobs_t *L, char *image)
+{
+    lifjob_t *J;
+
+    if(L->count == L->max)
+    {
+        L->max = L->max ? L->max * 2 : 64;
+        J = realloc(L->job, L->max * sizeof(lifjob_t));
+        if(J == NULL)
+        {
+            printf("lif: out of memory\n");
+            return(NULL);
+        }
+        L->job = J;
+    }
+    J = &L->job[L->count++];
+    memset(J, 0, sizeof(lifjob_t));
+    J->image = strdup(image);
+    return(J);
+}
+
+
+/// @brief Free a lif build or lif extractall work list
+/// @param[in,out] *L: work list
+/// @return void
+MEMSPACE
+void lif_jobs_free(lifjobs_t *L)
+{
+    int i;
+
+    for(i = 0; i < L->count; ++i)
+    {
+        free(L->job[i].image);
+        free(L->job[i].dir);
+        free(L->job[i].log);
+        free(L->job[i].out);
+        free(L->job[i].line);
+    }
+    free(L->job);
+    L->job = NULL;
+    L->count = 0;
+    L->max = 0;
+}
+
+
+/// @brief Sort helper for directory names
+MEMSPACE
+int lif_name_cmp(const void *a, const void *b)
+{
+    return(strcmp(*(char **) a, *(char **) b));
+}
+
+
+/// @brief Create a directory and any missing parent directories
+/// @param[in] *path: directory name
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_mkdirs(char *path)
+{
+    char tmp[1024];
+    char *ptr;
+
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for(ptr = tmp + 1; *ptr; ++ptr)
+    {
+        if(*ptr != '/')
+            continue;
+        *ptr = 0;
+        mkdir(tmp, 0777);
+        *ptr = '/';
+    }
+    if(mkdir(tmp, 0777) < 0 && errno != EEXIST)
+    {
+        printf("lif: can not create directory:[%s]\n", path);
+        return(0);
+    }
+    return(1);
+}
+
+
+/// @brief Run work on every image in a list using a pool of processes
+/// Each image is handled by its own forked process with at most jobs running
+/// at once, so every worker has its own buffers and open images.
+/// Worker output goes to the image log file which is removed when the image
+/// has no errors. Each worker sends its result through its own pipe and the
+/// results are stored by image so the summary order does not depend on which
+/// worker finishes first.
+/// A worker that is killed, or exits without a result, marks its image failed.
+/// @param[in,out] *L: work list, results are stored in each work item
+/// @param[in] *source: passed to work, the build manifest name
+/// @param[in] jobs: processes, 0 = one per core
+/// @param[in] work: function run for each image, returns 1 on success
+/// @return number of processes used, -1 on error
+MEMSPACE
+int lif_parallel(lifjobs_t *L, char *source, int jobs, int (*work)(lifjob_t *J, char *source))
+{
+    lifresult_t R;
+    lifjob_t *J;
+    lifworker_t *W;
+    struct timespec start;
+    int fd[2];
+    int i, next, running, status;
+    pid_t pid;
+
+    if(jobs <= 0)
+        jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if(jobs <= 0)
+        jobs = 1;
+    if(jobs > L->count)
+        jobs = L->count;
+    if(jobs <= 0)
+        return(0);
+
+    W = calloc(jobs, sizeof(lifworker_t));
+    if(W == NULL)
+    {
+        printf("lif: not enough memory for %d jobs\n", jobs);
+        return(-1);
+    }
+
+    fflush(stdout);
+    next = 0;
+    running = 0;
+    while(next < L->count || running)
+    {
+        while(running < jobs && next < L->count)
+        {
+            if(pipe(fd) < 0)
+            {
+                perror("lif: pipe");
+                break;
+            }
+            pid = fork();
+            if(pid < 0)
+            {
+                perror("lif: fork");
+                close(fd[0]);
+                close(fd[1]);
+                break;
+            }
+            if(pid == 0)
+            {
+                J = &L->job[next];
+                close(fd[0]);
+                for(i = 0; i < running; ++i)
+                    close(W[i].fd);
+                clock_gettime(0, &start);
+                if(freopen(J->log, "w", stdout) == NULL)
+                    freopen("/dev/null", "w", stdout);
+                R.index = next;
+                R.status = work(J, source);
+                R.files = J->files;
+                R.errors = J->errors;
+                R.bytes = J->bytes;
+                R.stored = J->stored;
+                R.us = lif_elapsed_us(&start);
+                fclose(stdout);
+                if(R.status > 0 && !R.errors)
+                    unlink(J->log);
+                if(write(fd[1], &R, sizeof(R)) != sizeof(R))
+                    _exit(1);
+                _exit(0);
+            }
+            close(fd[1]);
+            W[running].pid = pid;
+            W[running].fd = fd[0];
+            W[running].index = next;
+            ++running;
+            ++next;
+        }
+// pipe or fork failed with nothing left running
+        if(!running)
+            break;
+
+        pid = waitpid(-1, &status, 0);
+        if(pid < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            perror("lif: waitpid");
+            break;
+        }
+        for(i = 0; i < running; ++i)
+        {
+            if(W[i].pid == pid)
+                break;
+        }
+        if(i == running)
+            continue;
+
+// The worker has exited so its pipe holds the whole result or nothing
+        J = &L->job[W[i].index];
+        if(WIFEXITED(status) && WEXITSTATUS(status) == 0
+                && read(W[i].fd, &R, sizeof(R)) == sizeof(R) && R.index == W[i].index)
+        {
+            J->status = R.status;
+            J->files = R.files;
+            J->errors = R.errors;
+            J->bytes = R.bytes;
+            J->stored = R.stored;
+            J->us = R.us;
+        }
+        else
+        {
+            J->status = 0;
+            ++J->errors;
+            if(WIFSIGNALED(status))
+                printf("lif: worker for:[%s] killed by signal %d\n", J->image, WTERMSIG(status));
+            else
+                printf("lif: worker for:[%s] exited without a result\n", J->image);
+        }
+        close(W[i].fd);
+        W[i] = W[--running];
+    }
+
+// Only reached early when pipe(), fork() or waitpid() failed
+    for(i = 0; i < running; ++i)
+    {
+        waitpid(W[i].pid, &status, 0);
+        close(W[i].fd);
+        L->job[W[i].index].status = 0;
+    }
+    free(W);
+    return(jobs);
+}
+
+
+/// @brief Display lif build and lif extractall results in work list order
+/// @param[in] *L: work list
+/// @param[in] jobs: processes used
+/// @param[in] us: total time
+/// @return number of images that failed
+MEMSPACE
+int lif_jobs_summary(lifjobs_t *L, int jobs, long us)
+{
+    lifjob_t *J;
+    long files = 0;
+    int i, failed = 0;
+
+    printf("\n%-40s %8s %8s %10s  %s\n", "Image", "Files", "Errors", "ms", "Status");
+    for(i = 0; i < L->count; ++i)
+    {
+        J = &L->job[i];
+        files += J->files;
+        if(J->status > 0 && !J->errors)
+        {
+            printf("%-40s %8ld %8ld %10ld  ok\n", J->image, J->files, J->errors, J->us / 1000L);
+            continue;
+        }
+        ++failed;
+        printf("%-40s %8ld %8ld %10ld  FAILED, see %s\n", J->image, J->files, J->errors, J->us / 1000L, J->log);
+    }
+    printf("%d images, %d failed, %ld files, %d jobs, %ld ms\n",
+        L->count, failed, files, jobs, us / 1000L);
+    return(failed);
 }
 
 
-/// @brief Delete LIF file in LIF image
-/// @param[in] lifimagename: LIF image name
-/// @param[in] lifname: LIF file name
-/// @return 1 if deleted, 0 if not found, -1 error
+/// @brief Add every text and LIF file in a directory to an open LIF image
+/// The same rules as lif_add_files in sdcard/scripts/lif-functions.sh
+/// .txt files are added as E010 files and .lif files with addbin, each in name order,
+/// the LIF file name is the file name up to the first '.'
+/// @param[in] *LIF: LIF image opened for writing
+/// @param[in,out] *B: per command counts and times
+/// @param[in] *dir: directory name
+/// @return number of files that failed, -1 on error
 MEMSPACE
-int lif_del_file(char *lifimagename, char *lifname)
+int lif_build_dir(lif_t *LIF, lifbatch_t *B, char *dir)
 {
-    lif_t *LIF;
-    int index;
+    DIR *dp;
+    struct dirent *de;
+    char **names = NULL;
+    char *argv[3];
+    char lifname[LIF_BATCH_LINE];
+    char path[1024];
+    char *ptr;
+    int count = 0, max = 0;
+    int i, len, pass, failed = 0;
 
-    if(!*lifimagename)
-    {
-        printf("lif_del_file: lifimagename is empty\n");
-        return(-1);
-    }
-    if(!*lifname)
+    dp = opendir(dir);
+    if(dp == NULL)
     {
-        printf("lif_del_file: lifname is empty\n");
+        printf("lif_build: can not open directory:[%s]\n", dir);
         return(-1);
     }
-    if(debuglevel & LIF_DEBUG)
-        printf("LIF image:[%s], LIF name:[%s]\n",
-            lifimagename, lifname);
-
-    LIF = lif_open_volume(lifimagename,"rb+");
-    if(LIF == NULL)
-        return(-1);
-
-// Now find file record
-    index = lif_find_file(LIF, lifname);
-    if(index == -1)
+    while((de = readdir(dp)) != NULL)
     {
-        lif_closedir(LIF);
-        printf("LIF image:[%s] lif name:[%s] not found\n", lifimagename, lifname);
-        return(0);
+        len = strlen(de->d_name);
+        if(len < 5)
+            continue;
+        if(strcasecmp(de->d_name + len - 4, ".txt") != 0 && strcasecmp(de->d_name + len - 4, ".lif") != 0)
+            continue;
+        if(count == max)
+        {
+            max = max ? max * 2 : 64;
+            names = realloc(names, max * sizeof(char *));
+            if(names == NULL)
+            {
+                printf("lif: out of memory\n");
+                closedir(dp);
+                return(-1);
+            }
+        }
+        names[count++] = strdup(de->d_name);
     }
+    closedir(dp);
+    qsort(names, count, sizeof(char *), lif_name_cmp);
 
-// IF the next record is EOF then update EOF
-    if(index >= LIF->EOFindex-1)
-        LIF->DIR.FileType = 0xffff;
-    else
-        LIF->DIR.FileType = 0;
-
-// re-Write directory record
-    if( !lif_writedirindex(LIF,index) )
+// pass 0 text files, pass 1 LIF files
+    for(pass = 0; pass < 2; ++pass)
     {
-        lif_closedir(LIF);
-        return(-1);
+        for(i = 0; i < count; ++i)
+        {
+            len = strlen(names[i]);
+            if(strcasecmp(names[i] + len - 4, pass ? ".lif" : ".txt") != 0)
+                continue;
+            snprintf(lifname, sizeof(lifname), "%s", names[i]);
+            ptr = strchr(lifname, '.');
+            if(ptr)
+                *ptr = 0;
+            snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+            argv[0] = pass ? "addbin" : "add";
+            argv[1] = lifname;
+            argv[2] = path;
+            if(lif_batch_command(LIF, B, 3, argv) <= 0)
+            {
+                printf("lif_build: %s %s %s failed\n", argv[0], argv[1], argv[2]);
+                ++failed;
+            }
+        }
     }
 
-    lif_updatefree(LIF);
-
-    lif_closedir(LIF);
-    printf("Deleted: %10s\n", lifname);
-
-    return(1);
+    for(i = 0; i < count; ++i)
+        free(names[i]);
+    free(names);
+    return(failed);
 }
 
 
-/// @brief Rename LIF file in LIF image
-/// @param[in] lifimagename: LIF image name
-/// @param[in] oldlifname: old LIF file name
-/// @param[in] newlifname: new LIF file name
-/// @return 1 if renamed, 0 if not found, -1 error
+/// @brief Create one image from a lif build manifest, run in a worker process
+/// @param[in,out] *J: work item, image line and manifest offset of its contents
+/// @param[in] *manifest: manifest file name
+/// @return 1 on success, 0 on error
 MEMSPACE
-int lif_rename_file(char *lifimagename, char *oldlifname, char *newlifname)
+int lif_build_image(lifjob_t *J, char *manifest)
 {
-    int index;
     lif_t *LIF;
-
-    if(!*lifimagename)
+    lifbatch_t B;
+    FILE *fp;
+    char line[LIF_BATCH_LINE];
+    char *argv[LIF_BATCH_ARGS];
+    char *model;
+    long dir, sectors, dirstart;
+    int argc, lineno, sparse, ret, i;
+    struct timespec start;
+
+    clock_gettime(0, &start);
+
+// image name label model [sparse]
+// image name label dirsectors sectors [sparse] [dirstart N]
+    dirstart = 2;
+    if(J->argc >= 5 && !MATCHI(J->args[4],"sparse"))
     {
-        printf("lif_rename_file: lifimagename is empty\n");
-        return(-1);
+        dir = atol(J->args[3]);
+        sectors = atol(J->args[4]);
+        sparse = 0;
+        for(i = 5; i < J->argc; ++i)
+        {
+            if(MATCHI(J->args[i],"sparse"))
+                sparse = 1;
+            else if(MATCHI(J->args[i],"dirstart") && i + 1 < J->argc)
+                dirstart = atol(J->args[++i]);
+        }
     }
-    if(!*oldlifname)
+    else
     {
-        printf("lif_rename_file: old lifname is empty\n");
-        return(-1);
+        model = J->args[3];
+        if( MATCHI_LEN(model,"hp"))
+            model +=2;
+        if(!hpdir_find_drive(model,0, 0))
+        {
+            printf("Disk: %s not found in hpdir.ini\n", model);
+            ++J->errors;
+            return(0);
+        }
+        dir = lif_dir_count(hpdir.BLOCKS);
+        sectors = hpdir.BLOCKS;
+        sparse = ( J->argc > 4 && MATCHI(J->args[4],"sparse") ) ? 1 : 0;
     }
-    if(!*newlifname)
+
+    if(lif_create_image_at(J->image, J->args[2], dirstart, dir, sectors, sparse) < 0)
     {
-        printf("lif_rename_file: new lifname is empty\n");
-        return(-1);
+        ++J->errors;
+        return(0);
     }
 
-    if(!lif_checkname(newlifname))
+    fp = fopen(manifest, "r");
+    if(fp == NULL)
     {
-        printf("lif_rename_file: new lifname contains bad characters\n");
-        return(-1);
-
+        printf("lif_build: can not open:[%s]\n", manifest);
+        ++J->errors;
+        return(0);
     }
+    fseek(fp, J->offset, SEEK_SET);
 
-    LIF = lif_open_volume(lifimagename,"rb+");
+    LIF = lif_open_volume(J->image,"rb+");
     if(LIF == NULL)
-        return(-1);
-
-// Now find file record
-    index = lif_find_file(LIF, oldlifname);
-    if(index == -1)
     {
-        printf("lif_rename:[%s] lif name:[%s] not found\n", lifimagename, oldlifname);
-        lif_closedir(LIF);
+        fclose(fp);
+        ++J->errors;
         return(0);
     }
-    lif_fixname(LIF->DIR.filename, newlifname, 10);
 
-// re-Write directory record
-    if( !lif_writedirindex(LIF,index))
+    memset(&B, 0, sizeof(B));
+    lineno = J->lineno;
+    while(fgets(line, sizeof(line)-1, fp) != NULL)
     {
-        lif_closedir(LIF);
-        return(-1);
+        ++lineno;
+        trim_tail(line);
+        argc = split_args(line, argv, LIF_BATCH_ARGS);
+        if(!argc || argv[0][0] == '#')
+            continue;
+        if(MATCHI(argv[0],"image"))
+            break;
+        if(MATCHI(argv[0],"dir") && argc >= 2)
+        {
+            if(lif_build_dir(LIF, &B, argv[1]) < 0)
+                ++B.errors;
+            continue;
+        }
+        if(MATCHI(argv[0],"volume") && argc >= 2)
+        {
+            if(lif_set_volume(LIF, argv[1]) < 0)
+            {
+                printf("lif_build:[%s] line %d: volume failed\n", manifest, lineno);
+                ++B.errors;
+            }
+            continue;
+        }
+        ret = lif_batch_command(LIF, &B, argc, argv);
+        if(ret < 0)
+            printf("lif_build:[%s] line %d: bad command:[%s]\n", manifest, lineno, argv[0]);
+        else if(ret == 0)
+            printf("lif_build:[%s] line %d: %s failed\n", manifest, lineno, argv[0]);
     }
-    printf("renamed: %10s to %10s\n", oldlifname,newlifname);
+    fclose(fp);
 
-    lif_closedir(LIF);
+    J->files = LIF->files;
+    J->errors += B.errors;
+    lif_close_volume(LIF);
 
+    lif_batch_summary(&B, 0, lif_elapsed_us(&start));
     return(1);
 }
 
 
-/// @brief Rename LIF VOLUME NAME
-/// @param[in] lifimagename: LIF image name
-/// @param[in] volname: new LIF Volume name
-/// @return 1 if renamed, 0 if not found, -1 error
+/// @brief Build every image in a manifest using a pool of processes
+/// Manifest lines
+///   image name label model [sparse]
+///   image name label dirsectors sectors [sparse] [dirstart N]
+///     starts a new image, the lines that follow up to the next image line are its contents
+///     the label may be "", dirstart defaults to 2
+///   volume header
+///     replaces the volume header with LIF_VOL_SIZE bytes of hex, see lif_set_volume()
+///   dir directory
+///     adds every .txt and .lif file in the directory, see lif_build_dir()
+///   add, addbin, extract, extractbin, del, rename, renamevol, addraw
+///     any lif_batch() command
+/// Blank lines and lines starting with # are ignored
+/// @param[in] *manifest: manifest file name
+/// @param[in] jobs: processes, 0 = one per core
+/// @return number of images that failed, -1 on error
 MEMSPACE
-int lif_rename_volume(char *lifimagename, char *volname)
+int lif_build(char *manifest, int jobs)
 {
-    lif_t *LIF;
-	uint8_t buffer[LIF_SECTOR_SIZE+1];
-
+    lifjobs_t L;
+    lifjob_t *J = NULL;
+    FILE *fp;
+    char line[LIF_BATCH_LINE];
+    char *argv[LIF_BATCH_ARGS];
+    char copy[LIF_BATCH_LINE];
+    char log[1024];
+    char *ptr;
+    int argc, lineno, errors = 0;
+    struct timespec start;
 
-    if(!*lifimagename)
+    fp = fopen(manifest, "r");
+    if(fp == NULL)
     {
-        printf("lif_rename_file: lifimagename is empty\n");
+        printf("lif_build: can not open:[%s]\n", manifest);
         return(-1);
     }
 
-    if(!*volname)
+    clock_gettime(0, &start);
+    memset(&L, 0, sizeof(L));
+    lineno = 0;
+    while(fgets(line, sizeof(line)-1, fp) != NULL)
     {
-        printf("lif_rename_file: new Volume name empty\n");
-        return(-1);
+        ++lineno;
+        trim_tail(line);
+        strcpy(copy, line);
+        argc = split_args(line, argv, LIF_BATCH_ARGS);
+        if(!argc || argv[0][0] == '#')
+            continue;
+        if(!MATCHI(argv[0],"image"))
+        {
+            if(J == NULL)
+            {
+                printf("lif_build:[%s] line %d: [%s] before the first image line\n", manifest, lineno, argv[0]);
+                ++errors;
+            }
+            continue;
+        }
+        if(argc < 4)
+        {
+            printf("lif_build:[%s] line %d: expected image name label model|dirsectors sectors [sparse] [dirstart N]\n",
+                manifest, lineno);
+            ++errors;
+            J = NULL;
+            continue;
+        }
+        J = lif_job_new(&L, argv[1]);
+        if(J == NULL)
+        {
+            ++errors;
+            break;
+        }
+// Create the directory the image and its log go in
+        ptr = strrchr(argv[1], '/');
+        if(ptr != NULL && ptr != argv[1])
+        {
+            *ptr = 0;
+            lif_mkdirs(argv[1]);
+            *ptr = '/';
+        }
+        snprintf(log, sizeof(log), "%s.log", argv[1]);
+        J->log = strdup(log);
+        J->lineno = lineno;
+        J->offset = ftell(fp);
+
+// Keep the image line for the worker, split_args() has cut up line
+        J->line = strdup(copy);
+        J->argc = split_args(J->line, J->args, LIF_BATCH_ARGS);
     }
+    fclose(fp);
 
-    if(!lif_checkname(volname))
+    if(errors || !L.count)
     {
-        printf("lif_rename_file: new lifname contains bad characters\n");
+        if(!L.count)
+            printf("lif_build:[%s] no images\n", manifest);
+        lif_jobs_free(&L);
         return(-1);
-
     }
 
-    LIF = lif_open_volume(lifimagename,"rb+");
-    if(LIF == NULL)
-        return(-1);
+    jobs = lif_parallel(&L, manifest, jobs, lif_build_image);
+    errors = lif_jobs_summary(&L, jobs, lif_elapsed_us(&start));
+    lif_jobs_free(&L);
+    return(errors);
+}
 
-	// Update volume name
-    lif_fixname(LIF->VOL.Label, volname, 6);
 
-// Validate basic Volume headers
-    if( !lif_check_volume(LIF) )
+/// @brief Extract every file in one LIF image, run in a worker process
+/// E010 .. E013 files are extracted as text files, all others as single file LIF images,
+/// the same rules as lif_extract_all in sdcard/scripts/lif-functions.sh
+/// @param[in,out] *J: work item, image and target directory
+/// @param[in] *source: not used
+/// @return 1 on success, 0 on error
+MEMSPACE
+int lif_extract_image(lifjob_t *J, char *source)
+{
+    lif_t *LIF;
+    lifdir_t *DIR;
+    lifbatch_t B;
+    char (*names)[12];
+    uint16_t *types;
+    char *argv[3];
+    char path[1024];
+    long count = 0;
+    long i;
+    struct timespec start;
+
+    clock_gettime(0, &start);
+
+    LIF = lif_open_volume(J->image,"rb");
+    if(LIF == NULL)
     {
-        if(debuglevel & LIF_DEBUG)
-            printf("lif_rename_volume:[%s] error volume validate failed\n", LIF->name);
-        lif_closedir(LIF);
-        return(-1);
+        printf("lif_extractall:[%s] is not a LIF image\n", J->image);
+        ++J->errors;
+        return(0);
     }
 
-	// clear sector buffer
-    memset(buffer,0,LIF_SECTOR_SIZE);
-	// created update volume header sector from LIF structure
-	lif_vol2str(LIF,buffer);
+    if(!lif_mkdirs(J->dir))
+    {
+        lif_closedir(LIF);
+        ++J->errors;
+        return(0);
+    }
 
-// Volume header must be it least one sector
-    if( lif_write(LIF, buffer, 0, LIF_SECTOR_SIZE) < LIF_SECTOR_SIZE)
+// Extracting moves the directory position so collect the names first
+    names = calloc(LIF->files + 1, sizeof(*names));
+    types = calloc(LIF->files + 1, sizeof(uint16_t));
+    if(names == NULL || types == NULL)
     {
-        if(debuglevel & LIF_DEBUG)
-            printf("lif_rename_volume:[%s] error write volume header failed\n", LIF->name);
+        printf("lif: out of memory\n");
+        free(names);
+        free(types);
         lif_closedir(LIF);
-        return(-1);
+        ++J->errors;
+        return(0);
+    }
+    while(count < (long) LIF->files && (DIR = lif_readdir(LIF)) != NULL)
+    {
+        snprintf(names[count], sizeof(names[count]), "%s", (char *) DIR->filename);
+        types[count] = DIR->FileType;
+        ++count;
     }
 
-    lif_close_volume(LIF);
+    memset(&B, 0, sizeof(B));
+    for(i = 0; i < count; ++i)
+    {
+        if((types[i] & 0xFFFC) == 0xE010)
+        {
+            snprintf(path, sizeof(path), "%s/%s.txt", J->dir, names[i]);
+            argv[0] = "extract";
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/%s.lif", J->dir, names[i]);
+            argv[0] = "extractbin";
+        }
+        argv[1] = names[i];
+        argv[2] = path;
+        if(lif_batch_command(LIF, &B, 3, argv) <= 0)
+            printf("lif_extractall: %s %s %s failed\n", argv[0], argv[1], argv[2]);
+    }
+
+    J->files = count;
+    J->errors += B.errors;
+    lif_closedir(LIF);
+    free(names);
+    free(types);
 
+    lif_batch_summary(&B, 0, lif_elapsed_us(&start));
     return(1);
 }
 
-/// @brief Create/Format a LIF new disk image
-/// This can take a while to run, about 1 min for 10,000,000 bytes
-/// @param[in] lifimagename: LIF disk image name
-/// @param[in] liflabel: LIF Volume Label name
-/// @param[in] dirsectors: Number of LIF directory sectors
-/// @param[in] sectors: total disk image size in sectors
-///@return bytes writting to disk image
+
+/// @brief Find every .lif image in a directory tree, in name order
+/// Image dir/sub/name.lif is extracted into outdir/sub/name
+/// @param[in,out] *L: work list
+/// @param[in] *srcdir: directory to scan
+/// @param[in] *outdir: target directory for this level
+/// @return 1 on success, 0 on error
 MEMSPACE
-long lif_create_image(char *lifimagename, char *liflabel, uint32_t dirsectors, uint32_t sectors)
+int lif_extract_scan(lifjobs_t *L, char *srcdir, char *outdir)
 {
-    uint32_t dirstart,filestart,filesectors,end;
-    lif_t *LIF;
-
-    if(!*lifimagename)
+    DIR *dp;
+    struct dirent *de;
+    stat_t sb;
+    lifjob_t *J;
+    char **names = NULL;
+    char path[1024];
+    char out[1024];
+    int count = 0, max = 0;
+    int i, len, ret = 1;
+
+    dp = opendir(srcdir);
+    if(dp == NULL)
     {
-        printf("lif_create_image: lifimagename is empty\n");
-        return(-1);
+        printf("lif_extractall: can not open directory:[%s]\n", srcdir);
+        return(0);
     }
-    if(!*liflabel)
+    while((de = readdir(dp)) != NULL)
     {
-        printf("lif_create_image: liflabel is empty\n");
-        return(-1);
+        if(de->d_name[0] == '.')
+            continue;
+        if(count == max)
+        {
+            max = max ? max * 2 : 64;
+            names = realloc(names, max * sizeof(char *));
+            if(names == NULL)
+            {
+                printf("lif: out of memory\n");
+                closedir(dp);
+                return(0);
+            }
+        }
+        names[count++] = strdup(de->d_name);
     }
-    if(!dirsectors)
+    closedir(dp);
+    qsort(names, count, sizeof(char *), lif_name_cmp);
+
+    for(i = 0; i < count && ret; ++i)
     {
-        printf("lif_create_image: dirsectors is 0\n");
-        return(-1);
+        snprintf(path, sizeof(path), "%s/%s", srcdir, names[i]);
+        if(stat(path, &sb) < 0)
+            continue;
+        if(S_ISDIR(sb.st_mode))
+        {
+            snprintf(out, sizeof(out), "%s/%s", outdir, names[i]);
+            ret = lif_extract_scan(L, path, out);
+            continue;
+        }
+        len = strlen(names[i]);
+        if(len < 5 || strcasecmp(names[i] + len - 4, ".lif") != 0)
+            continue;
+// The log is written before the worker creates the image directory
+        if(!lif_mkdirs(outdir))
+        {
+            ret = 0;
+            continue;
+        }
+        J = lif_job_new(L, path);
+        if(J == NULL)
+        {
+            ret = 0;
+            continue;
+        }
+        snprintf(out, sizeof(out), "%s/%.*s", outdir, len - 4, names[i]);
+        J->dir = strdup(out);
+        snprintf(out, sizeof(out), "%s/%.*s.log", outdir, len - 4, names[i]);
+        J->log = strdup(out);
     }
-    if(!sectors)
+
+    for(i = 0; i < count; ++i)
+        free(names[i]);
+    free(names);
+    return(ret);
+}
+
+
+/// @brief Extract every LIF image in a directory tree using a pool of processes
+/// @param[in] *srcdir: directory tree of .lif images
+/// @param[in] *outdir: target directory, gets one directory per image
+/// @param[in] jobs: processes, 0 = one per core
+/// @return number of images that failed, -1 on error
+MEMSPACE
+int lif_extract_tree(char *srcdir, char *outdir, int jobs)
+{
+    lifjobs_t L;
+    struct timespec start;
+    int errors;
+
+    clock_gettime(0, &start);
+    memset(&L, 0, sizeof(L));
+    if(!lif_extract_scan(&L, srcdir, outdir) || !L.count)
     {
-        printf("lif_create_image: sectors is 0\n");
+        if(!L.count)
+            printf("lif_extractall:[%s] no LIF images\n", srcdir);
+        lif_jobs_free(&L);
         return(-1);
     }
-
-    dirstart = 2;
-    filestart = dirstart + dirsectors;
-    filesectors = sectors - filestart;
-    end = filestart + filesectors;
-
-    LIF = lif_create_volume(lifimagename, liflabel, dirstart, dirsectors, filesectors);
-    if(LIF == NULL)
+    if(!lif_mkdirs(outdir))
+    {
+        lif_jobs_free(&L);
         return(-1);
-    lif_close_volume(LIF);
+    }
 
-    printf("\tFormatting: wrote %ld sectors\n", (long)end);
-    return(end);
+    jobs = lif_parallel(&L, NULL, jobs, lif_extract_image);
+    errors = lif_jobs_summary(&L, jobs, lif_elapsed_us(&start));
+    lif_jobs_free(&L);
+    return(errors);
 }
+#endif
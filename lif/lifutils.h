@@ -27,6 +27,8 @@ typedef struct stat stat_t;
 
 ///@brief LIF directory entry size
 #define LIF_DIR_SIZE 32
+///@brief Volume header bytes at the start of sector 0
+#define LIF_VOL_SIZE 42
 #define LIF_DIR_RECORDS_PER_SECTOR (LIF_SECTOR_SIZE/LIF_DIR_SIZE)
 
 /**
@@ -106,6 +108,166 @@ typedef struct
     uint16_t SectorSize;                          // 30
 } lifdir_t;
 
+///@brief lif_newdir() placement policies
+#define LIF_ALLOC_FIRST  0                        // Lowest free extent that fits
+#define LIF_ALLOC_BEST   1                        // Smallest free extent that fits
+#define LIF_ALLOC_APPEND 2                        // Only after the last file
+
+///@brief Free extent between two files, or after the last file
+/// LIF files must stay in directory order so an extent between two files can
+/// only be used if a purged directory record lies between them
+typedef struct
+{
+    uint32_t start;                               // First free sector
+    uint32_t sectors;                             // Free sectors
+    int      index;                               // Directory record to use, -1 = none
+} lifextent_t;
+
+///@brief Free extent map built from the directory by lif_freemap_build()
+typedef struct
+{
+    lifextent_t *ext;                             // Extents sorted by start sector
+    lifextent_t *bysize;                          // Same extents sorted by size
+    int      count;                               // Number of extents
+    int      tail;                                // ext[] index of the extent after the last file, -1 = none
+    uint32_t freesectors;                         // Sum of all extents
+    uint32_t usable;                              // Sum of extents that have a directory record
+    uint32_t largest;                             // Largest usable extent
+} liffree_t;
+
+///@brief lif_pack() journal, kept in the unused sector between the volume header and directory
+/// All values are stored LSB first
+///   0-7   Magic "LIFPACK"
+///     8   Phase, 1 = moving file data, 2 = writing the directory
+///  12-15  Phase 1: file being moved, counting only valid files
+///  16-19  Phase 1: sectors of that file already moved
+///  20-23  Phase 2: directory index the journaled records go to
+///  24-27  Phase 2: next directory index to read
+///  28-31  Phase 2: packed start sector of the next file
+///    32   Phase 2: number of journaled records
+///  64-191 Phase 2: journaled records
+#define LIF_PACK_MAGIC "LIFPACK"
+#define LIF_PACK_MAGIC_SIZE 8
+#define LIF_PACK_JOURNAL 1
+#define LIF_PACK_RECORDS 4
+#ifdef LIF_STAND_ALONE
+#define LIF_PACK_CHUNK 128                        // Sectors moved per read and write
+#else
+#define LIF_PACK_CHUNK 2
+#endif
+
+///@brief E010 conversion, sectors read or written at once
+#ifdef LIF_STAND_ALONE
+#define LIF_E010_SECTORS 64
+#else
+#define LIF_E010_SECTORS 1
+#endif
+///@brief Longest line in one E010 record, fgets() with a 253 byte buffer, not counting the "\r"
+#define LIF_E010_LINE 252
+///@brief Largest E010 record, padding, split headers, line and "\r"
+#define LIF_E010_RECORD 264
+
+///@brief lif_pack() journal
+typedef struct
+{
+    int      phase;
+    uint32_t file;
+    uint32_t done;
+    uint32_t out;
+    uint32_t in;
+    uint32_t target;
+    int      records;
+    uint8_t  rec[LIF_PACK_RECORDS * LIF_DIR_SIZE];
+} lifpack_t;
+
+///@brief lif_batch() script limits
+#define LIF_BATCH_LINE 256
+#define LIF_BATCH_ARGS 8
+
+///@brief lif_batch() operations
+#define LIF_BATCH_ADD        0
+#define LIF_BATCH_ADDBIN     1
+#define LIF_BATCH_EXTRACT    2
+#define LIF_BATCH_EXTRACTBIN 3
+#define LIF_BATCH_DEL        4
+#define LIF_BATCH_RENAME     5
+#define LIF_BATCH_RENAMEVOL  6
+#define LIF_BATCH_ADDRAW     7
+#define LIF_BATCH_OPS        8
+
+///@brief lif_batch() per command counts and times
+typedef struct
+{
+    long count[LIF_BATCH_OPS];
+    long failed[LIF_BATCH_OPS];
+    long us[LIF_BATCH_OPS];
+    long commands;
+    long errors;
+} lifbatch_t;
+
+///@brief lif build and lif extractall work item, one per image
+typedef struct
+{
+    char *image;                                  // LIF image built or extracted
+    char *dir;                                    // extractall target directory
+    char *log;                                    // Worker output, removed when the image has no errors
+    char *out;                                    // index and dedup worker results
+    char *line;                                   // build manifest image line
+    char *args[LIF_BATCH_ARGS];                   // build image line arguments
+    int  argc;
+    long offset;                                  // build manifest offset of the first content line
+    int  lineno;                                  // build manifest line number
+    int  status;                                  // 1 done, 0 failed
+    long files;                                   // Files in the image when done
+    long errors;                                  // Commands that failed
+    long bytes;                                   // dedup file sectors in bytes
+    long stored;                                  // dedup bytes of new store objects
+    long us;                                      // Time spent on this image
+} lifjob_t;
+
+///@brief lif build and lif extractall work list
+typedef struct
+{
+    lifjob_t *job;
+    int count;
+    int max;
+} lifjobs_t;
+
+///@brief Result a worker process sends back through the pipe
+typedef struct
+{
+    int  index;
+    int  status;
+    long files;
+    long errors;
+    long bytes;
+    long stored;
+    long us;
+} lifresult_t;
+
+#ifdef LIF_PARALLEL
+///@brief Running lif_parallel() worker process
+typedef struct
+{
+    pid_t pid;
+    int   fd;                                     // Read end of the worker result pipe
+    int   index;                                  // Work item
+} lifworker_t;
+#endif
+
+///@brief In memory copy of the LIF directory with a hash on file names
+/// Directory writes only update the copy, changed records are written back
+/// by lif_dircache_flush(), one write per sector covering the changed records
+typedef struct
+{
+    uint8_t  *records;                            // Raw directory records
+    uint8_t  *dirty;                              // One bit per record changed since the last flush
+    int32_t  *head;                               // First record index in each hash bucket, -1 = empty
+    int32_t  *next;                               // Next record index in the same bucket, -1 = end
+    int      size;                                // Directory size in records
+    int      buckets;                             // Hash buckets, power of 2
+} lifdircache_t;
+
 ///@brief Master LIF data structure
 /// Contains image file name
 /// Volume Structure
@@ -127,6 +289,16 @@ typedef struct
     int      EOFindex;                            // Position of EOF directory record
     lifvol_t VOL;                                 // LIF Volume header
     lifdir_t DIR;                                 // LIF directory entry
+    struct _sparse *sparse;                       // Sparse image header, NULL for flat images
+#ifdef LIF_DIRCACHE
+    lifdircache_t *cache;                         // Directory copy, NULL when reading the image
+#endif
+#ifdef LIF_MMAP
+    uint8_t *map;                                 // Mapped image, NULL when using stdio
+    uint32_t mapbytes;                            // Mapped size in bytes
+    int      mapwrite;                            // Mapping is writable
+    int      dirty;                               // Mapping written since open
+#endif
 } lif_t;
 
 // =============================================
@@ -143,6 +315,9 @@ MEMSPACE stat_t *lif_stat ( char *name , stat_t *p );
 MEMSPACE int lif_seek_msg ( FILE *fp , long offset , char *msg );
 MEMSPACE long lif_read ( lif_t *LIF , void *buf , long offset , int bytes );
 MEMSPACE int lif_write ( lif_t *LIF , void *buf , long offset , int bytes );
+MEMSPACE uint8_t *lif_map_ptr ( lif_t *LIF , long offset , long bytes );
+MEMSPACE int lif_map ( lif_t *LIF , char *mode );
+MEMSPACE void lif_unmap ( lif_t *LIF );
 MEMSPACE int lif_chars ( int c , int index __attribute__ ((unused )));
 MEMSPACE int lif_B2S ( uint8_t *B , uint8_t *name , int size );
 MEMSPACE int lif_checkname ( char *name );
@@ -158,13 +333,14 @@ MEMSPACE void lif_time2lifbcd ( time_t t , uint8_t *bcd );
 MEMSPACE time_t lif_lifbcd2time ( uint8_t *bcd );
 MEMSPACE char *lif_ctime_gmt ( time_t *tp );
 MEMSPACE char *lif_lifbcd2timestr ( uint8_t *bcd );
+MEMSPACE long lif_elapsed_us ( struct timespec *start );
 MEMSPACE void lif_image_clear ( lif_t *LIF );
 MEMSPACE void lif_dir_clear ( lif_t *LIF );
 MEMSPACE void lif_vol_clear ( lif_t *LIF );
 MEMSPACE void lif_dump_vol ( lif_t *LIF , char *msg );
 MEMSPACE int lif_check_volume ( lif_t *LIF );
 MEMSPACE int lif_check_dir ( lif_t *LIF );
-MEMSPACE lif_t *lif_create_volume ( char *imagename , char *liflabel , long dirstart , long dirsectors , long filesectors );
+MEMSPACE lif_t *lif_create_volume ( char *imagename , char *liflabel , long dirstart , long dirsectors , long filesectors , int sparse );
 MEMSPACE void lif_close_volume ( lif_t *LIF );
 MEMSPACE uint32_t lif_bytes2sectors ( uint32_t bytes );
 MEMSPACE void lif_rewinddir ( lif_t *LIF );
@@ -173,21 +349,73 @@ MEMSPACE int lif_checkdirindex ( lif_t *LIF , int index );
 MEMSPACE int lif_readdirindex ( lif_t *LIF , int index );
 MEMSPACE int lif_writedirindex ( lif_t *LIF , int index );
 MEMSPACE int lif_writedirEOF ( lif_t *LIF , int index );
+MEMSPACE uint32_t lif_name_hash ( char *name );
+MEMSPACE void lif_dircache_unlink ( lifdircache_t *C , int index );
+MEMSPACE void lif_dircache_link ( lifdircache_t *C , int index );
+MEMSPACE int lif_dircache_load ( lif_t *LIF );
+MEMSPACE int lif_dircache_find ( lif_t *LIF , char *liflabel );
+MEMSPACE int lif_dircache_flush ( lif_t *LIF );
+MEMSPACE void lif_dircache_free ( lif_t *LIF );
 MEMSPACE lifdir_t *lif_readdir ( lif_t *LIF );
 MEMSPACE lif_t *lif_updatefree ( lif_t *LIF );
+MEMSPACE int lif_extent_size_cmp ( const void *a , const void *b );
+MEMSPACE void lif_freemap_free ( liffree_t *F );
+MEMSPACE int lif_freemap_build ( lif_t *LIF , liffree_t *F );
+MEMSPACE lifextent_t *lif_freemap_find ( liffree_t *F , long sectors , int policy );
+MEMSPACE void lif_freemap_pick ( lifextent_t *X , long sectors , int policy , lifextent_t *E );
+MEMSPACE int lif_freemap_scan ( lif_t *LIF , long sectors , int policy , lifextent_t *E , uint32_t *largest );
+MEMSPACE int lif_freemap_stats ( char *lifimagename , long sectors );
 MEMSPACE int lif_newdir ( lif_t *LIF , long sectors );
 MEMSPACE lif_t *lif_open_volume ( char *name , char *mode );
 MEMSPACE void lif_dir ( char *lifimagename );
 MEMSPACE int lif_find_file ( lif_t *LIF , char *liflabel );
 MEMSPACE int lif_e010_pad_sector ( long offset , uint8_t *wbuf );
+MEMSPACE int lif_e010_encode ( uint8_t *str , int len , long offset , uint8_t *wbuf );
 MEMSPACE int lif_ascii_string_to_e010 ( char *str , long offset , uint8_t *wbuf );
+MEMSPACE int lif_e010_flush ( lif_t *LIF , uint8_t *obuf , long *offset , int *used );
 MEMSPACE long lif_add_ascii_file_as_e010_wrapper ( lif_t *LIF , uint32_t offset , char *username );
+MEMSPACE long lif_add_e010 ( lif_t *LIF , char *lifname , char *userfile );
 MEMSPACE long lif_add_ascii_file_as_e010 ( char *lifimagename , char *lifname , char *userfile );
+MEMSPACE int lif_extract_e010 ( lif_t *LIF , char *lifname , char *username );
 MEMSPACE int lif_extract_e010_as_ascii ( char *lifimagename , char *lifname , char *username );
+MEMSPACE long lif_e010_bench_line ( lif_t *LIF , long offset , char *username );
+MEMSPACE uint32_t lif_e010_bench_sum ( lif_t *LIF , long offset , long sectors );
+MEMSPACE int lif_e010_bench ( char *textfile , long loops );
+MEMSPACE int lif_extract_lif ( lif_t *LIF , char *lifname , char *username );
 MEMSPACE int lif_extract_lif_as_lif ( char *lifimagename , char *lifname , char *username );
+MEMSPACE long lif_add_lif ( lif_t *LIF , char *lifname , char *userfile );
 MEMSPACE long lif_add_lif_file ( char *lifimagename , char *lifname , char *userfile );
+MEMSPACE long lif_add_raw ( lif_t *LIF , char *lifname , char *payload , char *direntry );
+MEMSPACE int lif_set_volume ( lif_t *LIF , char *volume );
 MEMSPACE int lif_del_file ( char *lifimagename , char *lifname );
+MEMSPACE int lif_del ( lif_t *LIF , char *lifname );
 MEMSPACE int lif_rename_file ( char *lifimagename , char *oldlifname , char *newlifname );
+MEMSPACE int lif_rename ( lif_t *LIF , char *oldlifname , char *newlifname );
 MEMSPACE int lif_rename_volume ( char *lifimagename , char *volname );
-MEMSPACE long lif_create_image ( char *lifimagename , char *liflabel , uint32_t dirsectors , uint32_t sectors );
+MEMSPACE int lif_renamevol ( lif_t *LIF , char *volname );
+MEMSPACE int lif_batch_command ( lif_t *LIF , lifbatch_t *B , int argc , char *argv []);
+MEMSPACE void lif_batch_summary ( lifbatch_t *B , long closeus , long total );
+MEMSPACE int lif_batch ( char *lifimagename , char *script );
+MEMSPACE long lif_create_image ( char *lifimagename , char *liflabel , uint32_t dirsectors , uint32_t sectors , int sparse );
+MEMSPACE long lif_create_image_at ( char *lifimagename , char *liflabel , uint32_t dirstart , uint32_t dirsectors , uint32_t sectors , int sparse );
+MEMSPACE void lif_sync ( lif_t *LIF );
+MEMSPACE int lif_pack_journal_read ( lif_t *LIF , lifpack_t *J );
+MEMSPACE int lif_pack_journal_write ( lif_t *LIF , lifpack_t *J );
+MEMSPACE int lif_pack_move ( lif_t *LIF , lifpack_t *J , uint8_t *buf , uint32_t src , uint32_t dst , uint32_t sectors );
+MEMSPACE int lif_pack ( char *lifimagename , int dryrun );
+MEMSPACE int lif_bench_image ( char *name , long loops , uint32_t *sum );
+MEMSPACE void lif_bench_pass ( int argc , char *argv [], long loops , long *images , long *files , uint32_t *sum );
+MEMSPACE int lif_bench ( int argc , char *argv [], long loops );
+MEMSPACE lifjob_t *lif_job_new ( lifjobs_t *L , char *image );
+MEMSPACE void lif_jobs_free ( lifjobs_t *L );
+MEMSPACE int lif_name_cmp ( const void *a , const void *b );
+MEMSPACE int lif_mkdirs ( char *path );
+MEMSPACE int lif_parallel ( lifjobs_t *L , char *source , int jobs , int (*work )(lifjob_t *J , char *source ));
+MEMSPACE int lif_jobs_summary ( lifjobs_t *L , int jobs , long us );
+MEMSPACE int lif_build_dir ( lif_t *LIF , lifbatch_t *B , char *dir );
+MEMSPACE int lif_build_image ( lifjob_t *J , char *manifest );
+MEMSPACE int lif_build ( char *manifest , int jobs );
+MEMSPACE int lif_extract_image ( lifjob_t *J , char *source );
+MEMSPACE int lif_extract_scan ( lifjobs_t *L , char *srcdir , char *outdir );
+MEMSPACE int lif_extract_tree ( char *srcdir , char *outdir , int jobs );
 #endif                                            // #ifndef _LIFUTILS_H
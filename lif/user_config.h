@@ -6,11 +6,13 @@
 #include <stdint.h>
 #include <string.h>
 #include <strings.h>
+#include <ctype.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <libgen.h>
 #include <sys/types.h>
 #include <utime.h>
+#include <unistd.h>
 
 #define MEMSPACE                                  /**/
 #define WEAK_ATR                                  /**/
@@ -19,8 +21,24 @@ typedef struct tm tm_t;
 #define safefree(a) free(a)
 #define sync()
 
+///@brief Host builds keep the LIF directory in memory, see lifdircache_t
+#define LIF_DIRCACHE
+
+///@brief Host builds map LIF images into memory, the AVR build uses stdio
+#ifndef __MINGW32__
+#define LIF_MMAP
+#include <sys/mman.h>
+#include <dirent.h>
+///@brief Host builds can build and extract many images at once, see lif_parallel()
+#define LIF_PARALLEL
+#include <errno.h>
+#include <sys/wait.h>
+#endif
+
 #include "../lib/parsing.h"
 #include "../gpib/vector.h"
 #include "../gpib/drives_sup.h"
+#include "../gpib/sparse.h"
+#include "../gpib/zimage.h"
 #include "../gpib/debug.h"
 #endif
@@ -28,6 +28,7 @@
 #include "gpib/printer.h"
 #include "gpib/amigo.h"
 #include "gpib/ss80.h"
+#include "gpib/evlog.h"
 #ifdef POSIX_TESTS
 #include "posix/posix_tests.h"
 #endif
@@ -89,15 +90,6 @@ uint8_t _line2 [21] = { ' ' };
 /// ======================================
 #ifdef LCD_SUPPORT
 
-///@brief LCD timer counter incremented at 1000HZ
-static int16_t lcd_display_time = 0;
-
-///@brief LCD timer function called at 1000HZ
-void lcd_task()
-{
-	++lcd_display_time;
-}
-
 /// @brief Convert tm_t *t structure into POSIX asctime() ASCII string *buf.
 ///
 /// @param[in] t: tm_t structure pointer.
@@ -151,9 +143,6 @@ void lcd_setup()
 
     printf("I2C LCD initialization start\n");
 
-	if(set_timers(lcd_task,1) == -1)
-        printf("lcd_task init failed\n");
-
 	i2c_init(100000);
 
 	i2c_task_init();
@@ -188,6 +177,7 @@ void lcd_setup()
 
 ///@brief Update the LCD wile the system is running
 /// Display SD card fault status and the current time
+/// Run every 100 ms by the scheduler, see user_tasks_init()
 void i2c_lcd_task()
 {
 	char buf[32];
@@ -214,30 +204,34 @@ void i2c_lcd_task()
 #endif	// LCD_SUPPORT
 
 /// ======================================
-#ifdef LCD_SUPPORT
-///@brief GPIB callback from gpib_read_byte()
-/// This function gets called evry time trough the read loop
-/// This task run in the forground - is not an interrupt task
-void gpib_user_task()
+///@brief evlog_task() for the scheduler
+static void evlog_sched_task()
 {
-	uint8_t sreg = SREG;
+	evlog_task();
+}
 
-	cli();
-	if(lcd_display_time > 100) // increments at 1000HZ
-	{
-		lcd_display_time = 0;
-		SREG = sreg;
-		i2c_lcd_task();
-		return;
-	}
-	SREG = sreg;
+///@brief Foreground tasks run by sched_run()
+/// name, function, period in ms, budget in us
+/// Work that must keep time stays on the 1000HZ interrupt, see set_timers()
+void user_tasks_init()
+{
+	sched_init();
+	sched_add("printer", printer_task, 1, 5000);  // Spooled plot data, see printer_task()
+	sched_add("evlog", evlog_sched_task, 1, 2000);
+	sched_add("boot", gpib_boot_report, 50, 2000);
+#ifdef LCD_SUPPORT
+	sched_add("lcd", i2c_lcd_task, 100, 1000);
+#endif
 }
-#else // LCD_SUPPORT
+
+///@brief GPIB callback from gpib_read_byte()
+/// Called only before the read loop releases NRFD for the next byte,
+/// never during a byte handshake
+/// This task run in the forground - is not an interrupt task
 void gpib_user_task()
 {
+	sched_run();
 }
-
-#endif	// LCD_SUPPORT
 /// ======================================
 
 
@@ -291,6 +285,11 @@ void help()
 #endif
         "input   - Toggle input parsing debugging\n"
         "mem     - Display free memory\n"
+        "uart [drop|block] - UART transmit overflow policy\n"
+        "tasks [reset] - Display task run times\n"
+#ifdef PRINTF_BENCH
+        "printf bench [N] - integer conversion benchmark\n"
+#endif
         );
 #ifdef PORTIO_TESTS
 	portio_help(0);
@@ -362,6 +361,7 @@ void user_task(uint8_t gpib)
 
     else if ( MATCHI(ptr,"reset") )
     {
+        uart_tx_flush(0);
         cli();
         uart_rx_flush(0);
         cli();
@@ -466,6 +466,37 @@ void user_task(uint8_t gpib)
         result = 1;
 
     }
+    else if ( MATCHI(ptr,"tasks") )
+    {
+        ptr = argv[ind];
+        if(ptr && MATCHI(ptr,"reset"))
+            sched_stats_reset();
+        else
+            sched_stats();
+        result = 1;
+    }
+    else if ( MATCHI(ptr,"uart") )
+    {
+        ptr = argv[ind];
+        if(ptr && MATCHI(ptr,"drop"))
+            uart_tx_policy(0, TX_DROP);
+        else if(ptr && MATCHI(ptr,"block"))
+            uart_tx_policy(0, TX_BLOCK);
+        printf("UART transmit: %s when full, %u dropped\n",
+            uart_tx_policy(0, -1) == TX_DROP ? "drop" : "block",
+            (unsigned int) uart_tx_dropped(0));
+        result = 1;
+    }
+#ifdef PRINTF_BENCH
+    else if ( MATCHI(ptr,"printf") && argv[ind] && MATCHI(argv[ind],"bench") )
+    {
+        long loops = 1000L;
+        if(argv[ind+1])
+            loops = get_value(argv[ind+1]);
+        printf_bench(loops);
+        result = 1;
+    }
+#endif
 #ifdef PORTIO_TESTS
 	if( (ret = portio_tests(argc,argv)) )
     {
@@ -524,7 +555,7 @@ int main(void)
     actual = uart_init(0, baud);                  // Serial Port Initialize
 
 ///@brief Power up delay
-    delayms(200);
+    delayms(GPIB_BOOT_DELAY_MS);
 
     sep();
     printf("Start\n");
@@ -602,6 +633,11 @@ int main(void)
     printf("GPIB State init done\n");
     sep();
 
+///@brief Start foreground tasks run while waiting for the GPIB bus
+    user_tasks_init();
+    printf("Tasks initialized\n");
+    sep();
+
 ///@brief Display Address Summary
     display_Addresses(0);
     sep();
@@ -61,6 +61,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 - truncate
 - write
 - fclose
+- setvbuf
+- fflush
 
 - POSIX file information functions
 - dump_stat - NOT POSIX
@@ -97,6 +99,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 - fdevopen  - NOT POSIX
 
 - FatFS to POSIX bridge functions - NOT POSIX
+- fbuf_sync
+- fbuf_fill
+- fbuf_getc
+- fbuf_putc
 - fatfs_getc
 - fatfs_putc
 - fatfs_to_errno
@@ -300,16 +306,16 @@ fputc(int c, FILE *stream)
     wdt_reset();
 #endif
 
-    if(stream != stdout && stream != stderr)
+    if ((stream->flags & __SWR) == 0)
+        return EOF;
+
+    if(stream->flags & __SFILE)
     {
         return(fatfs_putc(c,stream));
     }
 
 // TTY outputs
 
-    if ((stream->flags & __SWR) == 0)
-        return EOF;
-
     if (stream->flags & __SSTR)
     {
         if (stream->len < stream->size)
@@ -324,7 +330,11 @@ fputc(int c, FILE *stream)
             printf("fputc stream->put NULL\n");
             return(EOF);
         }
-        ret = stream->put(c, stream);
+// setvbuf() may have given the device an output buffer
+        if(stream->flags & __SNBF)
+            ret = stream->put(c, stream);
+        else
+            ret = fbuf_putc(c, stream);
         if(ret != EOF)
             stream->len++;
         return(ret);
@@ -612,7 +622,10 @@ long ftell(FILE *stream)
         return(-1);
     }
 
-    return( fh->fptr );
+// Characters waiting in the stream buffer
+    if(stream->flags & __SWBUF)
+        return( fh->fptr + stream->bpos );
+    return( fh->fptr - (stream->blen - stream->bpos) );
 }
 
 
@@ -648,7 +661,11 @@ off_t lseek(int fileno, off_t position, int whence)
         return(-1);
 
     stream = fileno_to_stream(fileno);
-    stream->flags |= __SUNGET;
+    stream->flags &= ~(__SUNGET | __SEOF);
+
+// Write pending data and give back read ahead so fptr is the stream position
+    if(fbuf_sync(stream) < 0)
+        return(-1);
 
     if(whence == SEEK_END)
         position += f_size(fh);
@@ -703,6 +720,7 @@ int close(int fileno)
     FILE *stream;
     FIL *fh;
     int res;
+    int ret;
 
     errno = 0;
 
@@ -719,6 +737,8 @@ int close(int fileno)
     {
         return(-1);
     }
+// Write any buffered data, free_file_descriptor() frees the buffer
+    ret = fbuf_sync(stream);
     res = f_close(fh);
     free_file_descriptor(fileno);
     if (res != FR_OK)
@@ -726,7 +746,7 @@ int close(int fileno)
         errno = fatfs_to_errno(res);
         return(-1);
     }
-    return(0);
+    return(ret);
 }
 
 
@@ -811,6 +831,10 @@ FILE *fopen(const char *path, const char *mode)
 /// @brief POSIX read nmemb elements from buf, size bytes each, to the stream fd.
 ///
 /// - man page fread (3).
+/// - FatFs files: characters already in the stream buffer are copied first,
+///   the rest is one f_read() directly into ptr, only reads smaller than
+///   the stream buffer go through the buffer.
+/// - No end of line translation is done.
 ///
 /// @param[in] ptr: buffer.
 /// @param[in] nmemb: number of items to read.
@@ -823,15 +847,92 @@ MEMSPACE
 size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
 {
     size_t count = size * nmemb;
-    int fn = fileno(stream);
+    size_t done = 0;
+    uint8_t *p = (uint8_t *) ptr;
     ssize_t ret;
+    FIL *fh;
+    UINT bytes;
+    int res;
+    int n;
+
+    errno = 0;
+
+    if(stream == NULL)
+    {
+        errno = EBADF;
+        return(0);
+    }
+    if(count == 0)
+        return(0);
 
+// TTY devices
+    if(!(stream->flags & __SFILE))
+    {
 // read() checks for fn out of bounds
-    ret = read(fn, ptr, count);
-    if(ret < 0)
+        ret = read(fileno(stream), ptr, count);
+        if(ret < 0)
+            return(0);
+        return((size_t) ret / size);
+    }
+
+    fh = (FIL *) fdev_get_udata(stream);
+    if(fh == NULL)
+    {
+        errno = EBADF;
         return(0);
+    }
 
-    return((size_t) ret);
+// Switch from writing to reading
+    if(stream->flags & __SWBUF)
+    {
+        if(fbuf_sync(stream) < 0)
+            return(0);
+    }
+
+    while(done < count)
+    {
+// Characters already in the stream buffer
+        n = stream->blen - stream->bpos;
+        if(n > 0)
+        {
+            if((size_t) n > count - done)
+                n = count - done;
+            memcpy(p + done, stream->buf + stream->bpos, n);
+            stream->bpos += n;
+            done += n;
+            continue;
+        }
+
+        if(stream->buf == NULL)
+            (void) setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+
+// The buffer is empty, large reads go straight to the caller
+        if(count - done >= (size_t) stream->size)
+        {
+            res = f_read(fh, p + done, count - done, &bytes);
+            if(res != FR_OK)
+            {
+                errno = fatfs_to_errno(res);
+                stream->flags |= __SERR;
+                break;
+            }
+            done += bytes;
+            if(done < count)
+                stream->flags |= __SEOF;
+            break;
+        }
+
+// Small reads refill the buffer
+        n = fbuf_fill(stream);
+        if(n <= 0)
+        {
+            if(n == 0)
+                stream->flags |= __SEOF;
+            break;
+        }
+    }
+
+    return(done / size);
 }
 
 
@@ -859,6 +960,8 @@ int ftruncate(int fd, off_t length)
     {
         return(-1);
     }
+    if(fbuf_sync(fileno_to_stream(fd)) < 0)
+        return(-1);
     rc = f_lseek(fh, length);
     if (rc != FR_OK)
     {
@@ -878,6 +981,9 @@ int ftruncate(int fd, off_t length)
 /// @brief POSIX write nmemb elements from buf, size bytes each, to the stream fd.
 ///
 /// - man page write (2).
+/// - FatFs files: writes smaller than the stream buffer are collected in it,
+///   when the buffer is empty larger writes are one f_write() directly from ptr.
+/// - Line buffered streams are written out if ptr contains a '\n'.
 ///
 /// @param[in] ptr: buffer.
 /// @param[in] nmemb: number of items to write.
@@ -890,16 +996,93 @@ MEMSPACE
 size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
 {
     size_t count = size * nmemb;
-    int fn = fileno(stream);
+    size_t done = 0;
+    uint8_t *p = (uint8_t *) ptr;
     ssize_t ret;
+    FIL *fh;
+    UINT bytes;
+    int res;
+    int n;
 
+    errno = 0;
+
+    if(stream == NULL)
+    {
+        errno = EBADF;
+        return(0);
+    }
+    if(count == 0)
+        return(0);
+
+// TTY devices
+    if(!(stream->flags & __SFILE))
+    {
 // write () checks for fn out of bounds
-    ret =  write(fn, ptr, count);
+        ret =  write(fileno(stream), ptr, count);
+        if(ret < 0)
+            return(0);
+        return((size_t) ret / size);
+    }
 
-    if(ret < 0)
+    fh = (FIL *) fdev_get_udata(stream);
+    if(fh == NULL)
+    {
+        errno = EBADF;
         return(0);
+    }
 
-    return((size_t) ret);
+// Switch from reading to writing, give back any read ahead
+    if(!(stream->flags & __SWBUF))
+    {
+        if(fbuf_sync(stream) < 0)
+            return(0);
+    }
+
+    if(stream->buf == NULL)
+        (void) setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+
+    while(done < count)
+    {
+// The buffer is empty, large writes go straight from the caller
+        if(stream->bpos == 0 && count - done >= (size_t) stream->size)
+        {
+            res = f_write(fh, p + done, count - done, &bytes);
+            done += bytes;
+            if(res != FR_OK)
+            {
+                errno = fatfs_to_errno(res);
+                stream->flags |= __SERR;
+            }
+            else if(done < count)
+            {
+                errno = ENOSPC;                   // Disk full
+                stream->flags |= __SERR;
+            }
+            break;
+        }
+
+        n = stream->size - stream->bpos;
+        if((size_t) n > count - done)
+            n = count - done;
+        memcpy(stream->buf + stream->bpos, p + done, n);
+        stream->flags |= __SWBUF;
+        stream->bpos += n;
+        done += n;
+
+        if(stream->bpos >= stream->size)
+        {
+            if(fbuf_sync(stream) < 0)
+                break;
+        }
+    }
+
+    if((stream->flags & __SLBF) && memchr(ptr, '\n', done) != NULL)
+    {
+        if(fbuf_sync(stream) < 0)
+            return(0);
+    }
+
+    return(done / size);
 }
 
 
@@ -993,23 +1176,30 @@ int open(const char *pathname, int flags)
 // FIXME fdevopen should do this
         stream->put = fatfs_putc;
         stream->get = fatfs_getc;
-        stream->flags = _FDEV_SETUP_RW;
+        stream->flags = _FDEV_SETUP_RW | __SRW | __SFILE;
     }
     else if((flags & O_ACCMODE) == O_RDONLY)
     {
 // FIXME fdevopen should do this
         stream->put = NULL;
         stream->get = fatfs_getc;
-        stream->flags = _FDEV_SETUP_READ;
+        stream->flags = _FDEV_SETUP_READ | __SFILE;
     }
     else
     {
 // FIXME fdevopen should do this
         stream->put = fatfs_putc;
         stream->get = NULL;
-        stream->flags = _FDEV_SETUP_WRITE;
+        stream->flags = _FDEV_SETUP_WRITE | __SFILE;
     }
 
+// The stream buffer is allocated on the first fatfs_getc() or fatfs_putc()
+// so files only accessed with read() and write() never use one
+    stream->buf = NULL;
+    stream->size = 0;
+    stream->bpos = 0;
+    stream->blen = 0;
+
     return(fileno);
 }
 
@@ -1046,7 +1236,7 @@ ssize_t read(int fd, const void *buf, size_t count)
     {
         char *ptr = (char *) buf;
 // ungetc is undefined for read
-        stream->flags |= __SUNGET;
+        stream->flags &= ~__SUNGET;
         size = 0;
         while(count--)
         {
@@ -1072,6 +1262,9 @@ ssize_t read(int fd, const void *buf, size_t count)
         return(-1);
     }
 
+    if(fbuf_sync(stream) < 0)
+        return(-1);
+
     res = f_read(fh, (void *) buf, bytes, &size);
     if(res != FR_OK)
     {
@@ -1130,8 +1323,10 @@ int syncfs(int fd)
         return(-1);
     }
     stream = fileno_to_stream(fd);
+    if(stream == NULL)
+        return(-1);
 // reset unget on sync
-    stream->flags |= __SUNGET;
+    stream->flags &= ~__SUNGET;
 
 // fileno_to_fatfs checks for fd out of bounds
     fh = fileno_to_fatfs(fd);
@@ -1141,6 +1336,9 @@ int syncfs(int fd)
         return(-1);
     }
 
+    if(fbuf_sync(stream) < 0)
+        return(-1);
+
     res  = f_sync ( fh );
     if (res != FR_OK)
     {
@@ -1219,7 +1417,7 @@ ssize_t write(int fd, const void *buf, size_t count)
             int c,ret;
             c = *ptr++;
             ret = fputc(c, stream);
-            if(c != ret)
+            if(ret == EOF)
                 break;
 
             ++size;
@@ -1239,6 +1437,9 @@ ssize_t write(int fd, const void *buf, size_t count)
         return(-1);
     }
 
+    if(fbuf_sync(stream) < 0)
+        return(-1);
+
     res = f_write(fh, buf, bytes, &size);
     if(res != FR_OK)
     {
@@ -1268,6 +1469,110 @@ int fclose(FILE *stream)
 }
 
 
+/// @brief POSIX set the buffer and buffering mode of a stream.
+///
+/// - man page setvbuf (3).
+/// - Any pending write data is written first.
+/// - Device streams from fdevopen() only buffer output.
+///
+/// @param[in] stream: POSIX stream pointer.
+/// @param[in] buf: buffer, NULL allocates size bytes.
+/// @param[in] mode: _IOFBF, _IOLBF or _IONBF.
+/// @param[in] size: buffer size, 0 uses BUFSIZ.
+///
+/// @return  0 on sucess.
+/// @return  -1 on error with errno set, the stream is left unbuffered.
+MEMSPACE
+int setvbuf(FILE *stream, char *buf, int mode, size_t size)
+{
+    errno = 0;
+
+    if(stream == NULL || (stream->flags & __SSTR))
+    {
+        errno = EBADF;
+        return(-1);
+    }
+    if(mode != _IOFBF && mode != _IOLBF && mode != _IONBF)
+    {
+        errno = EINVAL;
+        return(-1);
+    }
+
+    if(fbuf_sync(stream) < 0)
+        return(-1);
+
+    if(stream->buf != NULL && (stream->flags & __SMBF))
+        safefree(stream->buf);
+
+    stream->flags &= ~(__SLBF | __SNBF | __SMBF);
+    stream->buf = (char *) &stream->nbuf;
+    stream->size = 1;
+
+    if(mode == _IONBF)
+    {
+        stream->flags |= __SNBF;
+        return(0);
+    }
+
+    if(size == 0)
+        size = BUFSIZ;
+
+    if(buf == NULL)
+    {
+        buf = safecalloc(size, 1);
+        if(buf == NULL)
+        {
+            stream->flags |= __SNBF;
+            errno = ENOMEM;
+            return(-1);
+        }
+        stream->flags |= __SMBF;
+    }
+
+    stream->buf = buf;
+    stream->size = size;
+    if(mode == _IOLBF)
+        stream->flags |= __SLBF;
+    return(0);
+}
+
+
+/// @brief POSIX write any buffered data of a stream.
+///
+/// - man page fflush (3).
+/// - Unread buffered data of a file is discarded and the file position
+///   moved back to the stream position.
+/// - Data is written to FatFs, use syncfs() or sync() to update the card.
+///
+/// @param[in] stream: POSIX stream pointer, NULL flushes all streams.
+///
+/// @return  0 on sucess.
+/// @return  EOF on error witrh errno set.
+MEMSPACE
+int fflush(FILE *stream)
+{
+    int i;
+    int ret = 0;
+
+    if(stream == NULL)
+    {
+        for(i=0;i<MAX_FILES;++i)
+        {
+            if(__iob[i] != NULL && fflush(__iob[i]) != 0)
+                ret = EOF;
+        }
+        return(ret);
+    }
+
+    if(stream->flags & __SSTR)
+        return(0);
+
+    if(fbuf_sync(stream) < 0)
+        return(EOF);
+    return(0);
+}
+
+
 // =============================================
 // =============================================
 ///  - POSIX file information functions
@@ -1921,6 +2226,10 @@ fdevopen(int (*put)(char, FILE *), int (*get)(FILE *))
         return 0;
 
     s->flags = __SMALLOC;
+// Devices are unbuffered unless setvbuf() is called
+    s->flags |= __SNBF;
+    s->buf = (char *) &s->nbuf;
+    s->size = 1;
 
     if (get != 0)
     {
@@ -2016,13 +2325,181 @@ int mkfs(char *name)
 }
 
 
+/// @brief Empty the stream buffer so the device or file matches the stream position
+/// NOT POSIX
+///
+/// - Write state: write the pending characters.
+/// - Read state: seek back over the characters not yet read.
+///
+/// @param[in] stream: POSIX stream pointer.
+///
+/// @return 0 on sucess.
+/// @return EOF on error with errno set.
+MEMSPACE
+int fbuf_sync(FILE *stream)
+{
+    FIL *fh;
+    UINT size;
+    int res;
+    int i;
+    int count;
+
+    if(stream == NULL)
+    {
+        errno = EBADF;                            // Bad File Number
+        return(EOF);
+    }
+
+    count = (stream->flags & __SWBUF) ? stream->bpos : stream->blen - stream->bpos;
+    stream->bpos = 0;
+    stream->blen = 0;
+
+    if(count == 0)
+    {
+        stream->flags &= ~__SWBUF;
+        return(0);
+    }
+
+    if(!(stream->flags & __SFILE))
+    {
+// Devices never read ahead
+        stream->flags &= ~__SWBUF;
+        for(i=0;i<count;++i)
+        {
+            if(stream->put(stream->buf[i], stream) == EOF)
+            {
+                stream->flags |= __SERR;
+                return(EOF);
+            }
+        }
+        return(0);
+    }
+
+    fh = (FIL *) fdev_get_udata(stream);
+    if(fh == NULL)
+    {
+        errno = EBADF;                            // Bad File Number
+        return(EOF);
+    }
+
+    if(stream->flags & __SWBUF)
+    {
+        stream->flags &= ~__SWBUF;
+        res = f_write(fh, stream->buf, count, (UINT *) &size);
+        if(res == FR_OK && size != count)
+        {
+            errno = ENOSPC;                       // Disk full
+            stream->flags |= __SERR;
+            return(EOF);
+        }
+    }
+    else
+    {
+        res = f_lseek(fh, f_tell(fh) - count);
+    }
+    if(res != FR_OK)
+    {
+        errno = fatfs_to_errno(res);
+        stream->flags |= __SERR;
+        return(EOF);
+    }
+    return(0);
+}
+
+
+/// @brief Refill an empty FatFs file stream buffer
+/// NOT POSIX
+///
+/// - Any characters left in the buffer are discarded.
+///
+/// @param[in] stream: POSIX stream pointer.
+///
+/// @return characters read into the buffer.
+/// @return 0 at end of file.
+/// @return EOF on error with errno set.
+MEMSPACE
+int fbuf_fill(FILE *stream)
+{
+    FIL *fh;
+    UINT size;
+    int res;
+
+    fh = (FIL *) fdev_get_udata(stream);
+    stream->bpos = 0;
+    stream->blen = 0;
+    res = f_read(fh, stream->buf, stream->size, (UINT *) &size);
+    if(res != FR_OK)
+    {
+        errno = fatfs_to_errno(res);
+        stream->flags |= __SERR;
+        return(EOF);
+    }
+    stream->blen = size;
+    return(size);
+}
+
+
+/// @brief Get the next raw byte from a FatFs file stream buffer, refill when empty
+/// NOT POSIX
+///
+/// - The buffer is always empty when it is refilled so it never discards data.
+///
+/// @param[in] stream: POSIX stream pointer.
+///
+/// @return character.
+/// @return EOF at end of file or on error with errno set.
+MEMSPACE
+int fbuf_getc(FILE *stream)
+{
+    if(stream->bpos >= stream->blen)
+    {
+        if(fbuf_fill(stream) <= 0)
+            return(EOF);
+    }
+    return(stream->buf[stream->bpos++] & 0xff);
+}
+
+
+/// @brief Put a byte into a stream buffer, write it out when full
+/// NOT POSIX
+///
+/// - Line buffered streams are also written out after '\n'.
+/// - Unbuffered streams use a one byte buffer so they are written out every time.
+///
+/// @param[in] c: character.
+/// @param[in] stream: POSIX stream pointer.
+///
+/// @return character.
+/// @return EOF on error with errno set.
+MEMSPACE
+int fbuf_putc(int c, FILE *stream)
+{
+    if(!(stream->flags & __SWBUF))
+    {
+// Switch from reading to writing, give back any read ahead
+        if(fbuf_sync(stream) < 0)
+            return(EOF);
+        stream->flags |= __SWBUF;
+    }
+
+    stream->buf[stream->bpos++] = c;
+
+    if(stream->bpos >= stream->size || (c == '\n' && (stream->flags & __SLBF)) )
+    {
+        if(fbuf_sync(stream) < 0)
+            return(EOF);
+    }
+    return(c & 0xff);
+}
+
+
 /// @brief Private FatFs function called by fgetc() to get a byte from file stream
-/// FIXME buffer this function call
 /// NOT POSIX
 /// open() assigns stream->get = fatfs_getc()
 ///
 /// - man page fgetc (3).
 /// - Notes: fgetc does all tests prior to caling us, including ungetc.
+/// - Reads are done BUFSIZ bytes at a time into the stream buffer, see setvbuf().
 ///
 /// @param[in] stream: POSIX stream pointer.
 ///
@@ -2032,10 +2509,7 @@ MEMSPACE
 int  fatfs_getc(FILE *stream)
 {
     FIL *fh;
-    UINT size;
-    int res;
-    uint8_t c;
-    long pos;
+    int c;
 
     errno = 0;
 
@@ -2052,10 +2526,20 @@ int  fatfs_getc(FILE *stream)
         return(EOF);
     }
 
-    res = f_read(fh, &c, 1, (UINT *) &size);
-    if( res != FR_OK || size != 1)
+// Allocate the default buffer on first use, unbuffered if we are out of memory
+    if(stream->buf == NULL)
+        (void) setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+
+// Switch from writing to reading
+    if(stream->flags & __SWBUF)
+    {
+        if(fbuf_sync(stream) < 0)
+            return(EOF);
+    }
+
+    c = fbuf_getc(stream);
+    if(c == EOF)
     {
-        errno = fatfs_to_errno(res);
         stream->flags |= __SEOF;
         return(EOF);
     }
@@ -2085,22 +2569,13 @@ int  fatfs_getc(FILE *stream)
 // Note: char != '\n'
     if(c == '\r')
     {
-// PEEK forward 1 character
-        pos = f_tell(fh);
-// Check for trailing '\n' or EOF
-        res = f_read(fh, &c, 1, (UINT *) &size);
-        if(res != FR_OK || size != 1)
-        {
+// PEEK forward 1 character in the buffer
+// '\r' was the last buffered character so a refill discards nothing
+        c = fbuf_getc(stream);
+// This file must be '\r' ONLY for end of line - leave the character in the buffer
+        if(c != EOF && c != '\n')
+            stream->bpos--;
 // '\r' with EOF impiles '\n'
-            return('\n');
-        }
-// This file must be '\r' ONLY for end of line
-        if(c != '\n')
-        {
-// Not '\n' or EOF o move file pointer back to just after the '\r'
-            f_lseek(fh, pos);
-            return('\n');
-        }
         c = '\n';
     }
     return(c & 0xff);
@@ -2113,6 +2588,7 @@ int  fatfs_getc(FILE *stream)
 ///
 /// - man page fputc (3).
 /// - Notes: fputc does all tests prior to caling us.
+/// - Writes are collected in the stream buffer, see setvbuf() and fflush().
 ///
 /// @param[in] c: character.
 /// @param[in] stream: POSIX stream pointer.
@@ -2122,9 +2598,7 @@ int  fatfs_getc(FILE *stream)
 MEMSPACE
 int fatfs_putc(char c, FILE *stream)
 {
-    int res;
     FIL *fh;
-    UINT size;
 
     errno = 0;
     if(stream == NULL)
@@ -2140,10 +2614,12 @@ int fatfs_putc(char c, FILE *stream)
         return(EOF);
     }
 
-    res = f_write(fh, &c, 1, (UINT *)  &size);
-    if( res != FR_OK || size != 1)
+// Allocate the default buffer on first use, unbuffered if we are out of memory
+    if(stream->buf == NULL)
+        (void) setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+
+    if(fbuf_putc(c, stream) == EOF)
     {
-        errno = fatfs_to_errno(res);
         stream->flags |= __SEOF;
         return(EOF);
     }
@@ -2384,7 +2860,7 @@ int free_file_descriptor(int fileno)
         safefree(fh);
     }
 
-    if(stream->buf != NULL && stream->flags & __SMALLOC)
+    if(stream->buf != NULL && stream->flags & __SMBF)
     {
         safefree(stream->buf);
     }
@@ -159,7 +159,8 @@ struct __file
 {
     char    *buf;                                 /* buffer pointer */
     unsigned char unget;                          /* ungetc() buffer */
-    uint8_t flags;                                /* flags, see below */
+    unsigned char nbuf;                           /* _IONBF one byte buffer */
+    uint16_t flags;                               /* flags, see below */
 #define __SRD   0x0001                        /* OK to read */
 #define __SWR   0x0002                        /* OK to write */
 #define __SSTR  0x0004                        /* this is an sprintf/snprintf string */
@@ -168,20 +169,38 @@ struct __file
 #define __SEOF  0x0020                        /* found EOF */
 #define __SUNGET 0x040                        /* ungetc() happened */
 #define __SMALLOC 0x80                        /* handle is malloc()ed */
-#if 0
-/* possible future extensions, will require uint16_t flags */
 #define __SRW   0x0100                        /* open for reading & writing */
 #define __SLBF  0x0200                        /* line buffered */
 #define __SNBF  0x0400                        /* unbuffered */
 #define __SMBF  0x0800                        /* buf is from malloc */
-#endif
+#define __SWBUF 0x1000                        /* buf holds unwritten data */
+#define __SFILE 0x2000                        /* FatFs file, udata is a FIL * */
     int size;                                     /* size of buffer */
     int len;                                      /* characters read or written so far */
+    int bpos;                                     /* buf index of the next character */
+    int blen;                                     /* characters read into buf */
     int (*put)(char, struct __file *);            /* write one char to device */
     int (*get)(struct __file *);                  /* read one char from device */
 // FIXME add all low level functions here like _open, _close, ... like newlib does
     void    *udata;                               /* User defined and accessible data. */
 };
+
+///@brief Stream buffer modes, see setvbuf()
+/// - FatFs files default to _IOFBF with a BUFSIZ buffer allocated on first use
+/// - fdevopen() devices default to _IONBF, setvbuf() only buffers their output
+///
+/// Buffer states
+/// - read:  buf[bpos .. blen-1] not yet read, the file pointer is at the end of buf
+/// - write: buf[0 .. bpos-1] not yet written, __SWBUF set, the file pointer is at the start of buf
+#undef BUFSIZ
+#undef _IOFBF
+#undef _IOLBF
+#undef _IONBF
+#define BUFSIZ 128                                /*< default stream buffer size */
+#define _IOFBF 0                                  /*< fully buffered */
+#define _IOLBF 1                                  /*< line buffered */
+#define _IONBF 2                                  /*< unbuffered */
+
 // =============================================
 ///@brief POSIX open modes  - no other combination are allowed.
 /// - man page open(2)
@@ -343,6 +362,8 @@ MEMSPACE int syncfs ( int fd );
 MEMSPACE int truncate ( const char *path , off_t length );
 MEMSPACE ssize_t write ( int fd , const void *buf , size_t count );
 MEMSPACE int fclose ( FILE *stream );
+MEMSPACE int setvbuf ( FILE *stream , char *buf , int mode , size_t size );
+MEMSPACE int fflush ( FILE *stream );
 MEMSPACE void dump_stat ( struct stat *sp );
 
 #if 0
@@ -377,6 +398,10 @@ MEMSPACE char WEAK_ATR *strerror ( int errnum );
 MEMSPACE char *strerror_r ( int errnum , char *buf , size_t buflen );
 MEMSPACE FILE *fdevopen ( int (*put )(char ,FILE *), int (*get )(FILE *));
 MEMSPACE int mkfs(char *name );
+MEMSPACE int fbuf_sync ( FILE *stream );
+MEMSPACE int fbuf_fill ( FILE *stream );
+MEMSPACE int fbuf_getc ( FILE *stream );
+MEMSPACE int fbuf_putc ( int c , FILE *stream );
 MEMSPACE int fatfs_getc ( FILE *stream );
 MEMSPACE int fatfs_putc ( char c , FILE *stream );
 MEMSPACE int fatfs_to_errno ( FRESULT Result );
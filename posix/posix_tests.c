@@ -52,6 +52,7 @@ void posix_help(int full)
             "Note: posix prefix is optional\n"
     #ifdef POSIX_EXTENDED_TESTS
             "posix chmod file NNN\n"
+            "posix bench file [kbytes]\n"
     #endif
             "posix cat file [-p]\n"
             "posix cd dir\n"
@@ -123,6 +124,21 @@ for(i=0;i<argc;++i)
         }
     }
 
+#ifdef POSIX_EXTENDED_TESTS
+    if (MATCHARGS(ptr,"bench", (ind + 1), argc))
+    {
+        long kbytes = 0;
+        if((ind+2) <= argc)
+            kbytes = strtol(argv[ind+1],NULL,10);
+        if( posix_bench(argv[ind], kbytes) == 0)
+        {
+            printf("bench %s FAILED\n", argv[ind]);
+            return(-1);
+        }
+        return(1);
+    }
+    else
+#endif
     if (MATCHARGS(ptr,"cat", (ind + 1), argc))
     {
         int i;
@@ -793,3 +809,133 @@ long upload(char *name)
     return(size);
 }
 #endif
+
+#ifdef POSIX_EXTENDED_TESTS
+/// @brief Microseconds since start
+/// @param[in] *start: start time from clock_gettime()
+/// @return elapsed microseconds
+MEMSPACE
+long posix_bench_elapsed_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(0, &now);
+    return( (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L );
+}
+
+
+/// @brief Bytes per second
+/// Divides first, bytes * 1000 overflows a 32 bit long past 2M bytes
+/// @param[in] bytes: bytes transfered
+/// @param[in] us: elapsed microseconds
+/// @return bytes per second
+MEMSPACE
+long posix_bench_rate(long bytes, long us)
+{
+    long ms = us / 1000L;
+    if(ms < 1)
+        ms = 1;
+    return( (bytes / ms) * 1000L + ((bytes % ms) * 1000L) / ms );
+}
+
+
+/// @brief Compare fread() and fwrite() throughput for 1, 32, 256 and 4096 byte operations
+/// Each operation size writes a scratch file and then reads it back and checks it
+/// @param[in] *name: scratch file name, removed when done
+/// @param[in] kbytes: file size in K bytes for each test
+/// @return 1 on success, 0 on error
+MEMSPACE
+int posix_bench(char *name, long kbytes)
+{
+    static const int sizes[] = { 1, 32, 256, 4096 };
+    struct timespec start;
+    FILE *fp;
+    uint8_t *buf;
+    long total, done;
+    long wus, rus;
+    int i, j, size, max;
+    int errors = 0;
+
+    if(kbytes <= 0)
+        kbytes = 32;
+    total = kbytes * 1024L;
+
+    max = 4096;
+    buf = safecalloc(max,1);
+    if(buf == NULL)
+    {
+        max = 256;
+        buf = safecalloc(max,1);
+        if(buf == NULL)
+            return(0);
+        printf("posix_bench: not enough memory for 4096 byte operations\n");
+    }
+
+    for(i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); ++i)
+    {
+        size = sizes[i];
+        if(size > max)
+            break;
+
+        fp = fopen(name, "wb");
+        if(fp == NULL)
+        {
+            printf("posix_bench: Can't open: %s\n", name);
+            safefree(buf);
+            return(0);
+        }
+        clock_gettime(0, &start);
+        for(done = 0; done < total; done += size)
+        {
+            for(j = 0; j < size; ++j)
+                buf[j] = (done + j) & 0xff;
+            if((int) fwrite(buf, 1, size, fp) != size)
+            {
+                printf("posix_bench: Write error\n");
+                ++errors;
+                break;
+            }
+        }
+        fclose(fp);
+        wus = posix_bench_elapsed_us(&start);
+
+        fp = fopen(name, "rb");
+        if(fp == NULL)
+        {
+            printf("posix_bench: Can't open: %s\n", name);
+            safefree(buf);
+            return(0);
+        }
+        clock_gettime(0, &start);
+        for(done = 0; done < total; done += size)
+        {
+            if((int) fread(buf, 1, size, fp) != size)
+            {
+                printf("posix_bench: Read error\n");
+                ++errors;
+                break;
+            }
+            if(buf[0] != (done & 0xff) || buf[size-1] != ((done + size - 1) & 0xff))
+                ++errors;
+        }
+        fclose(fp);
+        rus = posix_bench_elapsed_us(&start);
+
+        printf("%5d byte ops: write %8ld bytes/sec, read %8ld bytes/sec\n",
+            size, posix_bench_rate(total, wus), posix_bench_rate(total, rus));
+
+#ifdef ESP8266
+        optimistic_yield(1000);
+        wdt_reset();
+#endif
+    }
+
+    unlink(name);
+    sync();
+    safefree(buf);
+
+    if(errors)
+        printf("posix_bench: %d data errors\n", errors);
+    return(errors ? 0 : 1);
+}
+#endif
@@ -38,5 +38,8 @@ MEMSPACE int ls ( char *name , int verbose );
 MEMSPACE long logfile ( char *name , char *str );
 MEMSPACE uint16_t sum ( char *name );
 MEMSPACE long upload ( char *name );
+MEMSPACE long posix_bench_elapsed_us ( struct timespec *start );
+MEMSPACE long posix_bench_rate ( long bytes , long us );
+MEMSPACE int posix_bench ( char *name , long kbytes );
 
 #endif
@@ -127,6 +127,7 @@ MEMSPACE int pch_ind ( p_ch_t *p );
 MEMSPACE int pch_max_ind ( p_ch_t *p );
 MEMSPACE void print_flags ( f_t f );
 MEMSPACE int p_ntoa ( uint8_t *nump , int numsize , char *str , int strmax , int radix , int width , int prec , f_t f );
+MEMSPACE int p_fast_ntoa ( unsigned long num , char *str , int strmax , int radix , int upper , int width , f_t f );
 MEMSPACE int p_ftoa ( double val , char *str , int max , int width , int prec , f_t f );
 MEMSPACE int p_etoa ( double val , char *str , int max , int width , int prec , f_t f );
 MEMSPACE void _puts_pad ( printf_t *fn , char *s , int width , int count , int left );
@@ -145,6 +146,12 @@ MEMSPACE int sprintf_P ( char *str , __memx const char *format , ...);
 MEMSPACE int printf_P ( __memx const char *format , ...);
 #endif
 
+///@brief Integer fast paths enabled, see _printf_fn()
+extern uint8_t printf_fast;
+
+/* test_printf.c */
+int printf_bench ( long loops );
+
 /* sscanf.c */
 int sscanf ( const char *strp , const char *fmt , ...);
 #endif                                            // ifndef _MATHIO_H_
@@ -38,6 +38,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "mathio.h"
 
+/// @brief Use the integer fast paths in _printf_fn, 0 forces bin2num() for every integer
+/// Used by the test_printf benchmark to compare both paths
+uint8_t printf_fast = 1;
+
 // =============================================
 
 // Below we included functions that are defined elsewhere
@@ -370,6 +374,95 @@ int p_ntoa(uint8_t *nump, int numsize, char *str, int strmax, int radix, int wid
 }
 
 
+/// @brief Fast decimal or hex number to ASCII with optional sign
+/// Gives the same result as p_ntoa() for %d %u %x %X without a precision
+/// Digits are made with native divides and shifts instead of bin2num()
+/// Decimal numbers switch to 16 bit and then 8 bit divides as soon as
+/// the remaining value fits - much faster on AVR than 32 bit divides
+/// @param[in] num: number, negative numbers are made positive and f.b.neg set
+/// @param[out] *str: string result
+/// @param[in] strmax: maximum length of string result
+/// @param[in] radix:  10 or 16
+/// @param[in] upper:  upper case hex digits
+/// @param[in] width:  Width of result
+/// @param[in] f:  flags, see p_ntoa()
+/// @return size of string
+MEMSPACE
+int p_fast_ntoa(unsigned long num, char *str, int strmax, int radix, int upper, int width, f_t f)
+{
+    int ind;
+    int digits;
+    int sign_ch;
+    uint8_t d;
+    uint16_t num16;
+    uint8_t num8;
+
+    sign_ch = 0;
+    if(f.b.neg)
+        sign_ch = '-';
+    else if(f.b.plus)
+        sign_ch = '+';
+    else if(f.b.space)
+        sign_ch = ' ';
+
+// Zero fill to width, less room for the sign - 0 is ignored for left align
+    digits = 1;
+    if(f.b.width && f.b.zero && !f.b.left)
+    {
+        digits = width;
+        if(sign_ch)
+            --digits;
+    }
+    if(digits > strmax - 2)
+        digits = strmax - 2;
+
+// Digits are generated LSB first then reversed
+    ind = 0;
+    if(radix == 16)
+    {
+        do
+        {
+            d = num & 0x0f;
+            if(d < 10)
+                str[ind++] = '0' + d;
+            else
+                str[ind++] = (upper ? 'A' : 'a') - 10 + d;
+            num >>= 4;
+        } while(num);
+    }
+    else
+    {
+        while(num > 0xffffUL)
+        {
+            str[ind++] = '0' + (num % 10);
+            num /= 10;
+        }
+        num16 = num;
+        while(num16 > 0xff)
+        {
+            str[ind++] = '0' + (num16 % 10);
+            num16 /= 10;
+        }
+        num8 = num16;
+        do
+        {
+            str[ind++] = '0' + (num8 % 10);
+            num8 /= 10;
+        } while(num8);
+    }
+
+    while(ind < digits)
+        str[ind++] = '0';
+
+    if(sign_ch && ind <= (strmax - 2))
+        str[ind++] = sign_ch;
+    str[ind] = 0;
+
+    reverse(str);
+    return(ind);
+}
+
+
 #ifdef FLOATIO
 /// @brief float to ASCII
 /// @param[in] val: value
@@ -1073,6 +1166,25 @@ Since the prototype doesn
                 break;
         }
 
+// Fast path for %d %u %x %X up to long size without a precision
+        if(printf_fast && !f.b.prec && size <= (int) sizeof(long) &&
+            (spec == 'd' || spec == 'D' || spec == 'u' || spec == 'U' || spec == 'x' || spec == 'X'))
+        {
+            unsigned long numul;
+
+            if(size == sizeof(short))
+                numul = (unsigned short) nums;
+            else if(size == sizeof(int))
+                numul = (unsigned int) numi;
+            else
+                numul = (unsigned long) numl;
+
+            count = p_fast_ntoa(numul, buff, sizeof(buff), (spec == 'x' || spec == 'X') ? 16 : 10,
+                spec == 'X', width, f);
+            _puts_pad(fn,buff, width, count, f.b.left);
+            continue;
+        }
+
         switch(spec)
         {
             case 'u':
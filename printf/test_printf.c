@@ -771,6 +771,10 @@ int main(int argc, char *argv[])
     f_t f;
 
     char *intops = "duxXo";
+
+// test_printf bench [loops] - only run the integer conversion benchmark
+    if(argc > 1 && strcmp(argv[1],"bench") == 0)
+        return( printf_bench( argc > 2 ? atol(argv[2]) : 1000000L ) ? 1 : 0 );
     char *sizeops[] = { "short", "int", "long", "long long", NULL };
     char *floatops = "fe";
 
@@ -913,3 +917,179 @@ int main(int argc, char *argv[])
     return(0);
 }
 #endif
+
+#if defined(PRINTF_TEST) || defined(PRINTF_BENCH)
+#ifndef PRINTF_TEST
+#include "user_config.h"
+#else
+#include <time.h>
+#endif
+
+/// @brief Benchmark formats - the common console, trace and log formats
+/// type 0 is an int argument, 1 is a long argument
+typedef struct
+{
+    const char *fmt;
+    uint8_t type;
+} printf_bench_t;
+
+static const printf_bench_t printf_bench_fmts[] =
+{
+    { "%02X", 0 },
+    { "%04X", 0 },
+    { "%08lX", 1 },
+    { "%lx", 1 },
+    { "%d", 0 },
+    { "%5u", 0 },
+    { "%ld", 1 },
+    { "%+010ld", 1 },
+    { "%-8ld", 1 },
+    { NULL, 0 }
+};
+
+
+/// @brief printf_bench output function, only counts characters
+/// @param[in] *p: structure with pointers to track number of bytes written
+/// @param[in] ch: character to write
+/// @return void
+static void _putc_count_fn(struct _printf_t *p, char ch)
+{
+    p->sent++;
+}
+
+
+/// @brief Format one value with _printf_fn for printf_bench
+/// @param[out] str: result string, NULL only counts the characters
+/// @param[in] size: size of str
+/// @param[in] format: printf format string
+/// @return number of characters
+static int printf_bench_fmt(char *str, int size, const char *format, ...)
+{
+    printf_t fn;
+    va_list va;
+
+    if(str)
+    {
+        *str = 0;
+        fn.put = _putc_buffer_fn;
+        fn.len = size - 1;
+        fn.buffer = (void *) str;
+    }
+    else
+    {
+        fn.put = _putc_count_fn;
+        fn.len = 0;
+        fn.buffer = NULL;
+    }
+    fn.sent = 0;
+
+    va_start(va, format);
+    _printf_fn(&fn, format, va);
+    va_end(va);
+
+    return(fn.sent);
+}
+
+
+/// @brief Benchmark test value for loop i
+/// Spreads values over the full 32 bit range with both signs
+/// @param[in] i: loop count
+/// @return test value
+static long printf_bench_value(long i)
+{
+    unsigned long val = ((unsigned long) i * 2654435761UL) & 0xffffffffUL;
+
+// Small values are common in trace output
+    if(i & 2)
+        val &= 0xffUL;
+    if(i & 1)
+        return( - (long) (val >> 1) );
+    return( (long) (val >> 1) );
+}
+
+
+/// @brief Elapsed time in microseconds
+/// @param[in] *start: start time from clock_gettime()
+/// @return microseconds since start
+static long printf_bench_elapsed_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(0, &now);
+    return( (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L );
+}
+
+
+/// @brief Compare the integer fast paths with the generic bin2num() path
+/// Every format is first checked for identical results on both paths
+/// then timed with the output discarded
+/// @param[in] loops: conversions per format and path
+/// @return number of formats with mismatched results
+int printf_bench(long loops)
+{
+    const printf_bench_t *B;
+    struct timespec start;
+    char str1[32];
+    char str2[32];
+    long i;
+    long val;
+    long us[2];
+    int pass;
+    int errors = 0;
+    uint8_t save = printf_fast;
+
+    if(loops < 1)
+        loops = 1;
+
+    printf("printf integer conversion benchmark, %ld conversions per test\n", loops);
+    printf("%-10s %12s %12s %8s\n", "format", "generic us", "fast us", "speedup");
+
+    for(B = printf_bench_fmts; B->fmt; ++B)
+    {
+// check both paths give the same result
+        for(i = 0; i < 1000; ++i)
+        {
+            val = printf_bench_value(i);
+            printf_fast = 0;
+            if(B->type)
+                printf_bench_fmt(str1, sizeof(str1), B->fmt, val);
+            else
+                printf_bench_fmt(str1, sizeof(str1), B->fmt, (int) val);
+            printf_fast = 1;
+            if(B->type)
+                printf_bench_fmt(str2, sizeof(str2), B->fmt, val);
+            else
+                printf_bench_fmt(str2, sizeof(str2), B->fmt, (int) val);
+            if(strcmp(str1, str2) != 0)
+            {
+                printf("%-10s MISMATCH generic:[%s] fast:[%s]\n", B->fmt, str1, str2);
+                ++errors;
+                break;
+            }
+        }
+
+        for(pass = 0; pass < 2; ++pass)
+        {
+            printf_fast = pass;
+            clock_gettime(0, &start);
+            for(i = 0; i < loops; ++i)
+            {
+                val = printf_bench_value(i);
+                if(B->type)
+                    printf_bench_fmt(NULL, 0, B->fmt, val);
+                else
+                    printf_bench_fmt(NULL, 0, B->fmt, (int) val);
+            }
+            us[pass] = printf_bench_elapsed_us(&start);
+        }
+        printf("%-10s %12ld %12ld %7ld.%ldx\n", B->fmt, us[0], us[1],
+            us[1] ? us[0] / us[1] : 0L,
+            us[1] ? ((us[0] * 10L) / us[1]) % 10L : 0L);
+    }
+
+    printf_fast = save;
+    if(errors)
+        printf("printf_bench: %d formats MISMATCHED\n", errors);
+    return(errors);
+}
+#endif                                            // PRINTF_TEST || PRINTF_BENCH
@@ -9,6 +9,7 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <sys/stat.h>
 
 #define MAXLINE 256
 #define bool int
@@ -182,8 +183,9 @@ void config_list( int ppr, int address, char *lifname, int detail)
 ///@return void
 void usage(char *ptr)
 {
-    printf("%s [-list]| [-m model [-b]|[-d]] [-a address]\n", ptr);
+    printf("%s [-list]|[-compile]| [-m model [-b]|[-d]] [-a address]\n", ptr);
     printf("   -list lists all of the drives in the hpdir.ini file\n");
+    printf("   -compile rebuilds hpdir.bin, the binary drive database, from hpdir.ini\n");
     printf("   -a hpdir address 0..7\n");
     printf("   -m model only, list hphpdir.cfg format hpdir configuration\n");
     printf("   -s short hphpdir.cfg format\n");
@@ -238,6 +240,10 @@ int main(int argc, char *argv[])
             list = 1;
             continue;
         }
+        if(MATCH(ptr,"-compile"))
+        {
+            return(hpdir_compile(1) < 0 ? 1 : 0);
+        }
         if(MATCH(ptr,"-s"))
         {
             detail = 0;
@@ -29,34 +29,47 @@ SDCARD="$BINHOME/.."
 CONFIGS="$SDCARD/configs"
 
 # Note the LIF image file names and generated configuration files must match in each section below
+# All images are built by one "lif build" call that works on several images at once
 echo "Creating AMIGO and SS80 disks"
+declare MANIFEST="everything.manifest"
+: >"$MANIFEST"
 declare D
 for D in 0 1 2 3
 do
 	# The generated file name below must match these LIF images 
-	# runlog lif create "amigo"$D.lif "AMIGO"$D 14 1120
-	# runlog lif create "ss80-"$D.lif "SS80-"$D 256 58176
-	runlog lif createdisk "amigo"$D.lif "AMIGO"$D 9121
-	runlog lif createdisk "ss80-"$D.lif "SS80-"$D 9134d
-done
-
-echo "Adding files"
-for D in 0 1 2 3
-do
+	# image "amigo"$D.lif "AMIGO"$D 14 1120
+	# image "ss80-"$D.lif "SS80-"$D 256 58176
+	echo "image ss80-$D.lif SS80-$D 9134d" >>"$MANIFEST"
 	declare S
 	for S in $@
 	do
 		if [ -d "$S" ]
 		then
-			echo "Adding Directory:[$S]"
-			lif_add_files "ss80-"$D.lif "$S"
-			echo "Adding Directory:[$S]"
-			lif_add_files "amigo"$D.lif "$S"
-		else
-			echo "Skipping file: $S"
+			echo "dir \"$S\"" >>"$MANIFEST"
 		fi
 	done
+	echo "image amigo$D.lif AMIGO$D 9121" >>"$MANIFEST"
+	for S in $@
+	do
+		if [ -d "$S" ]
+		then
+			echo "dir \"$S\"" >>"$MANIFEST"
+		fi
+	done
+done
+
+echo "Adding files"
+for S in $@
+do
+	if [ -d "$S" ]
+	then
+		echo "Adding Directory:[$S]"
+	else
+		echo "Skipping file: $S"
+	fi
 done
+runlog lif build "$MANIFEST"
+rm -f "$MANIFEST"
 
 echo "Listing files"
 declare D
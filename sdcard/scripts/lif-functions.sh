@@ -112,17 +112,16 @@ lif_add_files()
 	then
 		echo "Files:[$TXT]"
 	fi
+	# All files are added by one "lif batch" call so the image is only opened once
+	declare SCRIPT=""
+
 	# We can convert TXT format to E010 DTA8x ASCII BASIC LIF file
 	for i in $TXT
 	do
 		
 		declare NAME=$(basename $i | sed -s "s/\..*$//")
-		runlog lif add "$LIF" $NAME "$DIR/$i"
+		SCRIPT+="add $NAME \"$DIR/$i\""$'\n'
 	done
-	if [ -n "$TXT" ]
-	then
-		echo 
-	fi
 
 	# Copy single file LIF image source files into new LIF image
 	# We assume that you are adding HP85 programs 
@@ -135,10 +134,13 @@ lif_add_files()
 	for i in $LIFS
 	do
 		declare NAME=$(basename $i | sed -s "s/\..*$//")
-		runlog lif addbin "$LIF" "$NAME" "$DIR"/"$i"
+		SCRIPT+="addbin $NAME \"$DIR/$i\""$'\n'
 	done
-	if [ -n "$LIFS" ]
+
+	if [ -n "$SCRIPT" ]
 	then
+		echo -n "$SCRIPT"
+		echo -n "$SCRIPT" | lif batch "$LIF" -
 		echo 
 	fi
 }